@@ -31,6 +31,8 @@ namespace aslam {
 
       /// \brief solve the system storing the solution in outDx and returning true on success.
       bool solveSystem(Eigen::VectorXd& outDx) override;
+      /// \brief solve the system of the last solveSystem() call for another right-hand side
+      bool solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx) override;
 
       /// \brief return the Hessian matrix if avaliable. Null if not available.
       const Matrix* Hessian() const override {
@@ -8,26 +8,62 @@
 #ifndef INCLUDE_ASLAM_BACKEND_CACHEINTERFACE_HPP_
 #define INCLUDE_ASLAM_BACKEND_CACHEINTERFACE_HPP_
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <aslam/backend/DesignVariable.hpp>
+
 namespace aslam {
 namespace backend {
 
 /**
  * @class CacheInterface
  * @brief Interface for caching expressions
+ *
+ * The version of a cache is the sum of the update counts of its design variables. As the counts only
+ * increase, the sum changes whenever one of the design variables changes. A cached value is valid if the
+ * version it was computed for, published with release semantics, equals the current version. Checking a
+ * valid cache therefore takes no locks, and design variables do not need to know their caches.
  */
 class CacheInterface {
  public:
+  typedef std::uint64_t version_t;
+
   /// \brief Constructor
-  CacheInterface() : _isCacheValidV(false), _isCacheValidJ(false) { }
+  CacheInterface() : _versionV(invalidVersion()), _versionJ(invalidVersion()) { }
   /// \brief Destructor
   virtual ~CacheInterface() { }
   /// \brief Invalidates the cache, derived classes should update the data
   void invalidate() {
-    _isCacheValidV = _isCacheValidJ = false;
+    _versionV.store(invalidVersion(), std::memory_order_release);
+    _versionJ.store(invalidVersion(), std::memory_order_release);
   }
+  /// \brief Bring the cached value and Jacobians up to date with the design variables
+  virtual void updateCache() const = 0;
  protected:
-  mutable bool _isCacheValidV; /// \brief Is the cache for the error valid?
-  mutable bool _isCacheValidJ; /// \brief Is the cache for the Jacobian valid?
+  /// \brief Set the design variables the cached value depends on
+  void setCacheDesignVariables(const DesignVariable::set_t & designVariables) {
+    _designVariables.assign(designVariables.begin(), designVariables.end());
+  }
+  /// \brief The version of the current values of the design variables
+  version_t currentVersion() const {
+    version_t version = 0;
+    for (const DesignVariable* dv : _designVariables)
+      version += dv->updateCount();
+    return version;
+  }
+  /// \brief Is the cache with version \p cached valid for \p version?
+  static bool isValid(const std::atomic<version_t> & cached, version_t version) {
+    return cached.load(std::memory_order_acquire) == version;
+  }
+  static constexpr version_t invalidVersion() { return std::numeric_limits<version_t>::max(); }
+
+  mutable std::atomic<version_t> _versionV; /// \brief Version of the cached error
+  mutable std::atomic<version_t> _versionJ; /// \brief Version of the cached Jacobian
+ private:
+  std::vector<const DesignVariable*> _designVariables;
 };
 
 } /* namespace aslam */
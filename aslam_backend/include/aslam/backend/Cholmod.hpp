@@ -46,6 +46,9 @@ namespace aslam {
       spqr_factor* analyzeQR(cholmod_sparse* J);
 #endif
 
+      /// \brief Wraps the cholmod_copy_factor function. The copy must be freed using Cholmod::free() of this instance.
+      cholmod_factor* copy(cholmod_factor* L);
+
       /// \brief Wraps the cholmod_factorize function. Returns true for success.
       bool factorize(cholmod_sparse* A, cholmod_factor* L);
 
@@ -82,6 +85,12 @@ namespace aslam {
                            cholmod_factor* L,
                            cholmod_dense* b);
 
+      /// \brief solve a linear system with an already factorized L (no refactorization).
+      ///
+      /// If the solution is successful, the solution is returned (otherwise NULL)
+      /// The return value must be freed with Cholmod::free()
+      cholmod_dense* solve(cholmod_factor* L, cholmod_dense* b);
+
 #ifndef QRSOLVER_DISABLED
       cholmod_dense* solve(cholmod_sparse* A, spqr_factor* L, cholmod_dense* b,
                            double tol = SPQR_DEFAULT_TOL, bool norm = true,
@@ -3,22 +3,52 @@
 
 #include "JacobianBuilder.hpp"
 #include "CompressedColumnMatrix.hpp"
+#include "ErrorTermBatch.hpp"
 
 namespace aslam {
   namespace backend {
 
+    /// \brief The number of columns and nonzeros of a block of \f$ \mathbf J^T \f$
+    struct JacobianTransposeBlockSize {
+      size_t cols = 0;
+      size_t nnz = 0;
+      JacobianTransposeBlockSize& operator+=(const JacobianTransposeBlockSize& other) {
+        cols += other.cols;
+        nnz += other.nnz;
+        return *this;
+      }
+    };
+
+    /// \brief The layout of \f$ \mathbf J^T \f$ independent of its index type. The block of each error term
+    ///        starts after the columns and nonzeros of all error terms before it.
+    struct JacobianTransposeStructure {
+      /// \brief The first column and value index of the block of every error term
+      std::vector<JacobianTransposeBlockSize> offsets;
+      /// \brief The columns and nonzeros of all error terms
+      JacobianTransposeBlockSize total;
+      /// \brief The number of rows, i.e. the dimension of the design variables
+      size_t rows = 0;
+
+      /// \brief the number of nonzeros including the room for a diagonal block
+      size_t numNonZeros() const { return total.nnz + rows; }
+    };
+
     /**
      * \class CompressedColumnJacobianTransposeBuilder
      *
      * Multithreaded code for building \f$ \mathbf J^T \f$ from the list of errors.
+     * The values of \f$ \mathbf J^T \f$ are stored as VALUE_T.
      */
-    template<typename INDEX_T = int>
+    template<typename INDEX_T = int, typename VALUE_T = double>
     class CompressedColumnJacobianTransposeBuilder {
     public:
 
       /// \brief the index type of the matrix
       typedef INDEX_T index_t;
 
+      /// \brief the value type of the matrix
+      typedef VALUE_T value_t;
+
       CompressedColumnJacobianTransposeBuilder();
       virtual ~CompressedColumnJacobianTransposeBuilder();
 
@@ -27,26 +57,60 @@ namespace aslam {
       /// This function assumes that all the design variables in the DV container are active
       /// and that the container is sorted by order of block index such that dv[i]->blockIndex() == i
       ///
-      virtual void initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors);
+      /// The columns and nonzeros of the error terms are counted by a parallel prefix sum and the structure
+      /// of each error term is written to its preallocated slice of the matrix by nThreads threads.
+      ///
+      virtual void initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, size_t nThreads = 1);
+
+      /// \brief initialize the internal structure of the matrix from the layout computed by computeStructure().
+      void initMatrixStructure(const JacobianTransposeStructure& structure, const std::vector<ErrorTerm*>& errors, size_t nThreads = 1);
+
+      /// \brief count the columns and nonzeros of the error terms by a parallel prefix sum with nThreads threads.
+      ///
+      /// The layout does not depend on the index type, its numNonZeros() can be used to choose the index type
+      /// before passing it to initMatrixStructure().
+      static JacobianTransposeStructure computeStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, size_t nThreads = 1);
 
       /// \brief build the large, sparse internal Jacobian matrix from the error terms.
       virtual void buildSystem(size_t nThreads, bool useMEstimator);
 
+      /// \brief re-evaluate only the Jacobians of the error terms i with refreshErrorTerm[i] != 0 and keep the others.
+      void buildSystem(size_t nThreads, bool useMEstimator, const std::vector<char>& refreshErrorTerm);
+
+      /// \brief update the Jacobians without evaluating them by a sparse Broyden step.
+      ///
+      /// \param dx the state change since the Jacobians were evaluated
+      /// \param dr the change of the weighted errors since the Jacobians were evaluated
+      void broydenUpdate(size_t nThreads, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr);
+
+      /// \brief Error terms with an MEstimator weight below this threshold get zero Jacobians without evaluating them.
+      ///        Only applies if the MEstimator is used. Zero (the default) disables skipping.
+      void setMEstimatorWeightThreshold(double threshold) { _mEstimatorWeightThreshold = threshold; }
+      double getMEstimatorWeightThreshold() const { return _mEstimatorWeightThreshold; }
+
+      /// \brief The number of error terms whose Jacobian evaluation was skipped by the last buildSystem() call.
+      size_t numSkippedJacobians() const { return _numSkippedJacobians; }
+
       /// \brief Get a view of the transpose of the Jacobian as a cholmod sparse matrix.
       virtual cholmod_sparse getJacobianTransposeView();
 
       /// \brief Get a const version of the compressed column matrix.
-      CompressedColumnMatrix<index_t> & J_transpose();
+      CompressedColumnMatrix<index_t, value_t> & J_transpose();
 
       /// \brief Get a const version of the compressed column matrix.
-        const CompressedColumnMatrix<index_t> & J_transpose() const;
+        const CompressedColumnMatrix<index_t, value_t> & J_transpose() const;
 
     private:
       /// \brief a function to be run by a single thread.
-      void evaluateJacobians(int threadId, int startIdx, int endIdx, bool useMEstimator);
+      /// If refreshErrorTerm is not null, only the error terms flagged in it are evaluated.
+      /// Returns the number of error terms skipped due to a small MEstimator weight.
+      size_t evaluateJacobians(int threadId, int startIdx, int endIdx, bool useMEstimator, const std::vector<char>* refreshErrorTerm);
+
+      /// \brief a function to be run by a single thread.
+      void broydenUpdateJacobians(int threadId, int startIdx, int endIdx, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr);
 
       /// \brief The transpose of the Jacobian matrix has better cache coherency.
-      CompressedColumnMatrix<index_t> _J_transpose;
+      CompressedColumnMatrix<index_t, value_t> _J_transpose;
 
       /// \brief The Jacobian, transposed, transposed.
       boost::shared_ptr<cholmod_sparse> _J;
@@ -68,11 +132,33 @@ namespace aslam {
       /// \brief An array parallel to the error term array that maps error terms to parts of the Jacobian.
       std::vector<Evaluator> _jacobianPointers;
 
+      /// \brief Writes the Jacobians of a run of batch members starting with error term \p firstErrorTerm into \f$ \mathbf J^T \f$.
+      class BatchJacobianWriter : public ErrorTermBatch::JacobianSink {
+      public:
+        BatchJacobianWriter(CompressedColumnJacobianTransposeBuilder& builder, size_t firstErrorTerm, size_t firstMember)
+            : _builder(builder), _firstErrorTerm(firstErrorTerm), _firstMember(firstMember) { }
+        void write(std::size_t member, const Eigen::Ref<const Eigen::MatrixXd>& J, const Eigen::Ref<const Eigen::VectorXd>& /* weightedError */) override {
+          const Evaluator& ev = _builder._jacobianPointers[_firstErrorTerm + (member - _firstMember)];
+          _builder._J_transpose.writeJacobians(ev.errorTerm->designVariables(), J, ev.jcp);
+        }
+      private:
+        CompressedColumnJacobianTransposeBuilder& _builder;
+        size_t _firstErrorTerm;
+        size_t _firstMember;
+      };
+
       /// \brief have we built the Jacobian from the transpose?
       bool _isJacobianBuiltFromJacobianTranspose;
 
-      template<typename MEMBER_FUNCTION_PTR>
-      void setupThreadedJob(MEMBER_FUNCTION_PTR ptr, size_t nThreads, bool useMEstimator);
+      /// \brief The MEstimator weight below which Jacobians are not evaluated
+      double _mEstimatorWeightThreshold;
+
+      /// \brief The number of skipped Jacobian evaluations of the last buildSystem() call
+      size_t _numSkippedJacobians;
+
+      /// \brief split job(threadId, startIdx, endIdx) across the error terms.
+      template<typename JOB>
+      void setupThreadedJob(const JOB& job, size_t nThreads);
 
     };
   } // namespace backend
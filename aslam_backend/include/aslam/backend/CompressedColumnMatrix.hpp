@@ -28,10 +28,22 @@ namespace aslam {
       size_t startValueIndex;
       size_t elementsPerColumn;
       size_t numActiveDesignVariables;
+
+      /// \brief The index in the value array of the element \p rowOffset of the column \p column of the block
+      size_t valueIndex(size_t column, size_t rowOffset) const {
+        return startValueIndex + column * elementsPerColumn + rowOffset;
+      }
     };
 
 
-    template<typename INDEX_T = int>
+    /**
+     * \class CompressedColumnMatrix
+     *
+     * A compressed column sparse matrix. The values are stored as VALUE_T
+     * (double by default). Storing them as float halves the memory traffic
+     * of the products, which always accumulate in double precision.
+     */
+    template<typename INDEX_T = int, typename VALUE_T = double>
     class CompressedColumnMatrix : public Matrix {
     public:
 
@@ -41,6 +53,9 @@ namespace aslam {
       /// \brief the index type of the matrix
       typedef INDEX_T index_t;
 
+      /// \brief the value type of the matrix
+      typedef VALUE_T value_t;
+
       //typedef Eigen::MappedCompressedColumnMatrix<value_t> eigen_sparse_t;
       CompressedColumnMatrix();
 
@@ -76,7 +91,7 @@ namespace aslam {
       size_t nnz() const;
 
       /// \brief Get the underlying values
-      const std::vector<double>& values() const;
+      const std::vector<value_t>& values() const;
 
       /// \brief Get the underlying row indices
       const std::vector<index_t>& row_ind() const;
@@ -103,9 +118,55 @@ namespace aslam {
        */
       JacobianColumnPointer appendJacobiansSymbolic(int Jrows, const std::vector<DesignVariable*>& dvs);
 
+      /**
+       * \brief Allocate \f$\mathbf J^T\f$ with all its columns to be filled by setJacobiansSymbolic().
+       *
+       * @param rows The number of rows
+       * @param cols The number of columns (corresponding to the total dimension of the error terms)
+       * @param nnz The number of nonzeros of all columns
+       * @param reserveNnz The number of nonzeros to reserve storage for, e.g. to push a diagonal block later on
+       */
+      void resizeSymbolic(size_t rows, size_t cols, size_t nnz, size_t reserveNnz);
+
+      /**
+       * \brief Set the structure of \f$\mathbf J^T\f$ in the columns startColumn .. startColumn + Jrows - 1 allocated by resizeSymbolic().
+       *
+       * The columns are stored at the value indices from startValueIndex on, which have to be the sum of the
+       * nonzeros of all columns left of startColumn. Disjoint column ranges can be set concurrently.
+       *
+       * @param startColumn The first column of the error term
+       * @param startValueIndex The first value index of the error term
+       * @param Jrows The number of rows in the Jacobian (corresponding to the number of elements in an error term)
+       * @param dvs The list of design variables with non-zero Jacobians in these columns.
+       * @return outColumnPointer A pointer to the value array of the Jacobian matrix.
+       */
+      JacobianColumnPointer setJacobiansSymbolic(size_t startColumn, size_t startValueIndex, int Jrows, const std::vector<DesignVariable*>& dvs);
+
       /// \brief Write the Jacobian values to the matrix using the pointer provided by appendJacobiansSymbolic()
       void writeJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc, const JacobianColumnPointer& cp);
 
+      /// \brief Write the Jacobian \p J of an error term with the design variables \p dvs to the matrix using the pointer
+      ///        provided by appendJacobiansSymbolic(). \p J has a block of columns for every design variable in \p dvs,
+      ///        the blocks of inactive design variables are ignored.
+      void writeJacobians(const std::vector<DesignVariable*>& dvs, const Eigen::Ref<const Eigen::MatrixXd>& J, const JacobianColumnPointer& cp);
+
+      /// \brief Set the Jacobian values written through \p cp to zero, e.g. for an error term with a negligible weight
+      void zeroJacobians(const JacobianColumnPointer& cp, int Jrows);
+
+      /**
+       * \brief Sparse Broyden (Schubert) update of the Jacobian block written through \p cp.
+       *
+       * Every column c of the block is corrected on its sparsity pattern only, such that
+       * its dot product with \p dx becomes dr[startRow + c]. Columns whose pattern did not move are left untouched.
+       *
+       * @param cp The pointer provided by appendJacobiansSymbolic()
+       * @param Jrows The number of rows in the Jacobian (corresponding to the number of elements in an error term)
+       * @param dx The state change since the Jacobian was evaluated
+       * @param dr The change of the residuals since the Jacobian was evaluated
+       * @param startRow The first row of the error term in \p dr
+       */
+      void broydenUpdateJacobians(const JacobianColumnPointer& cp, int Jrows, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr, size_t startRow);
+
       /// \brief A convenience function that calls appendJacobiansSymbolic() and then writeJacobians()
       void appendJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc);
 
@@ -159,9 +220,15 @@ namespace aslam {
     private:
       void checkMatrixDbg();
 
+      /// \brief Collect the active design variables sorted by block index and return their total minimal dimension.
+      size_t collectActiveDesignVariables(const std::vector<DesignVariable*>& dvs, std::vector<DesignVariable*>& activeDvs) const;
+
+      /// \brief Write the column pointers and row indices of the columns of one error term.
+      void writeJacobiansSymbolic(const std::vector<DesignVariable*>& activeDvs, size_t elementsPerColumn, int Jrows, size_t startColumn, size_t startValueIndex);
+
       size_t _rows;
       size_t _cols;
-      std::vector<double> _values;
+      std::vector<value_t> _values;
       std::vector<index_t> _row_ind;
       std::vector<index_t> _col_ptr;
 
@@ -25,6 +25,13 @@ namespace aslam {
 
       /// \brief solve the system storing the solution in outDx and returning true on success.
       bool solveSystem(Eigen::VectorXd& outDx) override;
+      /// \brief solve the least squares problem of the last solveSystem() call for the error vector e
+      bool solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx) override;
+      /// \brief solve the systems of the conditioners concurrently, every thread decomposes its own copy of the augmented Jacobian
+      void solveSystems(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx) override;
+
+      bool multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const override;
+      bool multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const override;
 
       /// \brief return the Jacobian matrix if available. Null if not available.
       const Matrix* Jacobian() const override;
@@ -2,6 +2,8 @@
 #define ASLAM_DESIGN_VARIABLE_HPP
 
 #include <sm/Id.hpp>
+#include <atomic>
+#include <cstdint>
 #include <unordered_set>
 #include <set>
 
@@ -9,18 +11,13 @@
 
 #include <aslam/Exceptions.hpp>
 #include <boost/shared_ptr.hpp>
-#include <boost/weak_ptr.hpp>
 
 namespace aslam {
   namespace backend {
-    class CacheInterface;
 
     class DesignVariable {
     public:
 
-      template <typename Expression>
-      friend Expression toCacheExpression(const Expression& expr);
-
       /**
        * \struct BlockIndexOrdering
        *
@@ -50,6 +47,11 @@ namespace aslam {
 
       DesignVariable();
 
+      /// \brief Copies the state, the copy starts with its own update count
+      DesignVariable(const DesignVariable& other);
+
+      DesignVariable& operator=(const DesignVariable& other);
+
       virtual ~DesignVariable();
 
       /// \brief what is the number of dimensions of the minimal perturbation.
@@ -110,6 +112,11 @@ namespace aslam {
       /// \brief Computes the minimal distance in tangent space between the current value of the DV and xHat and the jacobian
       void minimalDifferenceAndJacobian(const Eigen::MatrixXd& xHat, Eigen::VectorXd& outDifference, Eigen::MatrixXd& outJacobian) const;
 
+      /// \brief Number of changes of the value so far. Cache expressions compare it to the count their value was computed for.
+      std::uint64_t updateCount() const {
+        return _updateCount.load(std::memory_order_acquire);
+      }
+
     protected:
       /// \brief what is the number of dimensions of the perturbation variable.
       virtual int minimalDimensionsImplementation() const = 0;
@@ -134,20 +141,11 @@ namespace aslam {
       /// Computes the minimal distance in tangent space between the current value of the DV and xHat and the jacobian
       virtual void minimalDifferenceAndJacobianImplementation(const Eigen::MatrixXd& xHat, Eigen::VectorXd& outDifference, Eigen::MatrixXd& outJacobian) const;
 
-      /// Invalidates the cache
+      /// Invalidates the caches depending on this design variable. Has to be called after each change of the value.
       void invalidateCache() {
-        if (!_cacheNodes.empty())
-          invalidateCacheImplementation();
+        _updateCount.fetch_add(1, std::memory_order_release);
       }
 
-    private:
-
-      /// Registers a cache expression that has to be reset each time the design variable changes its value
-      void registerCacheExpressionNode(const boost::shared_ptr<CacheInterface>& cn);
-
-      /// Invalidates the cache
-      void invalidateCacheImplementation();
-
     private:
       /// \brief The block index used in the optimization routine.
       int _blockIndex;
@@ -164,8 +162,8 @@ namespace aslam {
       /// \brief The scaling of this design variable within the optimization.
       double _scaling;
 
-      /// \brief Cache expressions that have to be reseted
-      std::vector< boost::weak_ptr<CacheInterface> > _cacheNodes;
+      /// \brief Incremented on every change of the value
+      std::atomic<std::uint64_t> _updateCount;
     };
 
   } // namespace backend
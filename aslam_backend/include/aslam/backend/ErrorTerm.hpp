@@ -15,6 +15,7 @@
 namespace aslam {
   namespace backend {
     class MEstimator;
+    class ErrorTermBatch;
 
 
 
@@ -146,6 +147,12 @@ namespace aslam {
       void setTime(const sm::timing::NsecTime& t);
       sm::timing::NsecTime getTime() { return _timestamp; }
 
+      /// \brief The batch this error term is evaluated with, null if it is evaluated on its own.
+      ErrorTermBatch* batch() const { return _batch; }
+
+      /// \brief The index of this error term in its batch.
+      size_t batchIndex() const { return _batchIndex; }
+
     protected:
 
       /// \brief evaluate the error term and return the weighted squared error e^T invR e
@@ -201,6 +208,10 @@ namespace aslam {
       size_t _rowBase;
 
       sm::timing::NsecTime _timestamp;
+
+      friend class ErrorTermBatch;
+      ErrorTermBatch* _batch;
+      size_t _batchIndex;
     };
 
 
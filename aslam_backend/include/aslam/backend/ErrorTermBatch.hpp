@@ -0,0 +1,109 @@
+#ifndef ASLAM_BACKEND_ERROR_TERM_BATCH_HPP
+#define ASLAM_BACKEND_ERROR_TERM_BATCH_HPP
+
+#include <cstddef>
+
+#include <Eigen/Core>
+#include <aslam/backend/ErrorTerm.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    /**
+     * \class ErrorTermBatch
+     *
+     * \brief A set of structurally identical error terms evaluated together.
+     *
+     * The members of a batch are ordinary error terms added to the optimization problem one by one. Before the
+     * linear system solvers evaluate the errors of a range of error terms, they hand every run of consecutive
+     * members of a batch to prefetchErrors() (see forEachBatchRun()). The batch evaluates the run in one sweep,
+     * e.g. several members at a time with SIMD kernels, and the members return the prefetched results. Members
+     * evaluated on their own, e.g. outside of a solver, evaluate themselves as usual.
+     *
+     * Batches that implement evaluateJacobians() also evaluate the weighted Jacobians of a run at once. The
+     * CompressedColumnJacobianTransposeBuilder writes them straight into \f$ \mathbf J^T \f$ and the
+     * BlockCholeskyLinearSystemSolver adds them to the Hessian, without going through a JacobianContainer per member.
+     *
+     * Runs handed to a batch by different threads never overlap. Members must therefore be added to the
+     * problem in the order of their batch indices to be prefetched.
+     */
+    class ErrorTermBatch {
+    public:
+      /// \brief Receives the Jacobians of the members from evaluateJacobians()
+      class JacobianSink {
+      public:
+        virtual ~JacobianSink() { }
+
+        /// \brief Take the Jacobian of member \p member
+        ///
+        /// \param J the Jacobian \f$ \sqrt{w} \mathbf L^T \partial \mathbf e / \partial \mathbf x \f$, with the MEstimator
+        ///        weight \f$ w \f$ and \f$ \mathbf L \f$ = sqrtInvR(), as in ErrorTerm::getWeightedJacobians(). It has
+        ///        a block of columns for every design variable of the member, active or not, in the order of
+        ///        ErrorTerm::designVariables().
+        /// \param weightedError the error \f$ \sqrt{w} \mathbf L^T \mathbf e \f$ as in ErrorTerm::getWeightedError()
+        virtual void write(std::size_t member, const Eigen::Ref<const Eigen::MatrixXd>& J, const Eigen::Ref<const Eigen::VectorXd>& weightedError) = 0;
+      };
+
+      virtual ~ErrorTermBatch() { }
+
+      /// \brief The number of error terms in the batch
+      virtual std::size_t numErrorTerms() const = 0;
+
+      /// \brief Evaluate the errors of the members [begin, end)
+      virtual void prefetchErrors(std::size_t begin, std::size_t end) = 0;
+
+      /// \brief Does the batch implement evaluateJacobians()? Otherwise the Jacobians are evaluated per member.
+      virtual bool hasBatchJacobians() const { return false; }
+
+      /// \brief Evaluate the Jacobians of the members [begin, end) and pass them to \p sink in order. The errors of
+      ///        the members have to be evaluated before, as their MEstimator weights are used.
+      virtual void evaluateJacobians(std::size_t /* begin */, std::size_t /* end */, bool /* useMEstimator */, JacobianSink& /* sink */) { }
+
+    protected:
+      /// \brief Make \p errorTerm the member \p index of this batch
+      void setMember(ErrorTerm& errorTerm, std::size_t index) {
+        errorTerm._batch = this;
+        errorTerm._batchIndex = index;
+      }
+    };
+
+    /// \brief The end of the run of consecutive members of a batch starting with the error term \p errorTermAt(begin),
+    ///        which must be a batch member, and ending before \p end or an error term for which \p errorTermAt returns null.
+    template <typename ERROR_TERM_AT>
+    std::size_t findBatchRunEnd(std::size_t begin, std::size_t end, const ERROR_TERM_AT& errorTermAt)
+    {
+      const ErrorTerm* errorTerm = errorTermAt(begin);
+      const ErrorTermBatch* batch = errorTerm->batch();
+      const std::size_t first = errorTerm->batchIndex();
+      std::size_t j = begin + 1;
+      for (; j < end; ++j) {
+        const ErrorTerm* next = errorTermAt(j);
+        if (next == nullptr || next->batch() != batch || next->batchIndex() != first + (j - begin))
+          break;
+      }
+      return j;
+    }
+
+    /// \brief Call \p function(batch, begin, end) for every run of consecutive members [begin, end) of a batch
+    ///        found in the error terms \p errorTermAt(i), i in [begin, end). Error terms for which \p errorTermAt
+    ///        returns null interrupt runs.
+    template <typename ERROR_TERM_AT, typename FUNCTION>
+    void forEachBatchRun(std::size_t begin, std::size_t end, const ERROR_TERM_AT& errorTermAt, const FUNCTION& function)
+    {
+      for (std::size_t i = begin; i < end; ) {
+        const ErrorTerm* errorTerm = errorTermAt(i);
+        ErrorTermBatch* batch = errorTerm ? errorTerm->batch() : nullptr;
+        if (batch == nullptr) {
+          ++i;
+          continue;
+        }
+        const std::size_t j = findBatchRunEnd(i, end, errorTermAt);
+        function(*batch, errorTerm->batchIndex(), errorTerm->batchIndex() + (j - i));
+        i = j;
+      }
+    }
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_ERROR_TERM_BATCH_HPP */
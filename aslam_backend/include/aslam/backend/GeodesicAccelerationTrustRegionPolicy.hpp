@@ -0,0 +1,76 @@
+#ifndef ASLAM_BACKEND_GEODESIC_ACCELERATION_TRUST_REGION_POLICY_HPP
+#define ASLAM_BACKEND_GEODESIC_ACCELERATION_TRUST_REGION_POLICY_HPP
+
+#include <aslam/backend/LevenbergMarquardtTrustRegionPolicy.hpp>
+
+namespace sm {
+class ConstPropertyTree;
+} // namespace sm
+
+namespace aslam {
+    namespace backend {
+
+        /**
+         * \class GeodesicAccelerationTrustRegionPolicy
+         *
+         * Levenberg-Marquardt with geodesic acceleration (Transtrum and Sethna, "Improvements to the
+         * Levenberg-Marquardt algorithm for nonlinear least-squares minimization", 2012).
+         *
+         * The LM step \f$ \mathbf v \f$ is corrected by half the acceleration \f$ \mathbf a \f$ solving
+         * \f$ (\mathbf J^T \mathbf J + \lambda \mathbf I) \mathbf a = -\mathbf J^T \mathbf r_{vv} \f$, where the directional
+         * second derivative \f$ \mathbf r_{vv} = \frac{2}{h} \left( \frac{\mathbf r(\mathbf x + h \mathbf v) - \mathbf r(\mathbf x)}{h} - \mathbf J \mathbf v \right) \f$
+         * is a finite difference of the residuals along \f$ \mathbf v \f$. This costs one error evaluation and one more solve of
+         * the already factorized system per iteration. The correction is dropped if \f$ 2 \|\mathbf a\| / \|\mathbf v\| \f$ exceeds
+         * the maximum acceleration ratio.
+         *
+         * Requires the optimizer to set the state update functions and the solver to support the Jacobian product and
+         * solveSystemWithError(), otherwise it behaves like plain Levenberg-Marquardt. The probe counts as an error
+         * evaluation of the optimizer.
+         */
+        class GeodesicAccelerationTrustRegionPolicy : public LevenbergMarquardtTrustRegionPolicy
+        {
+        public:
+          GeodesicAccelerationTrustRegionPolicy();
+          GeodesicAccelerationTrustRegionPolicy(const sm::ConstPropertyTree & config);
+          GeodesicAccelerationTrustRegionPolicy(double lambdaInit, double finiteDifferenceStep = 0.1, double maxAccelerationRatio = 0.75);
+          ~GeodesicAccelerationTrustRegionPolicy() override;
+
+          /// \brief called by the optimizer when an optimization is starting
+          void optimizationStartingImplementation(double J) override;
+
+          // Returns true if the solution was successful
+          bool solveSystemImplementation(double J, bool previousIterationFailed, int nThreads, Eigen::VectorXd& outDx) override;
+
+          /// \brief print the current state to a stream (no newlines).
+          std::ostream & printState(std::ostream & out) const override;
+          std::string name() const override { return "geodesic_acceleration"; }
+
+          /// \brief The step h of the finite difference along the LM step, relative to the step
+          void setFiniteDifferenceStep(double h);
+          double getFiniteDifferenceStep() const { return _finiteDifferenceStep; }
+
+          /// \brief The acceleration is rejected if 2 |a| / |v| exceeds this ratio
+          void setMaxAccelerationRatio(double alpha);
+          double getMaxAccelerationRatio() const { return _maxAccelerationRatio; }
+
+          /// \brief Number of steps corrected by the acceleration since the optimization started
+          size_t getNumAcceleratedSteps() const { return _numAcceleratedSteps; }
+          /// \brief Number of accelerations rejected by the ratio test since the optimization started
+          size_t getNumRejectedAccelerations() const { return _numRejectedAccelerations; }
+        private:
+          /// \brief Computes the acceleration a along the LM step v, returns false if it is not available.
+          bool computeAcceleration(const Eigen::VectorXd& v, Eigen::VectorXd& outA);
+
+          double _finiteDifferenceStep;
+          double _maxAccelerationRatio;
+
+          size_t _numAcceleratedSteps;
+          size_t _numRejectedAccelerations;
+          double _lastAccelerationRatio;
+        };
+
+    } // namespace backend
+} // namespace aslam
+
+
+#endif /* ASLAM_BACKEND_GEODESIC_ACCELERATION_TRUST_REGION_POLICY_HPP */
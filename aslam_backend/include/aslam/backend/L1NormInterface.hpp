@@ -0,0 +1,27 @@
+#ifndef ASLAM_BACKEND_L1_NORM_INTERFACE_HPP
+#define ASLAM_BACKEND_L1_NORM_INTERFACE_HPP
+
+namespace aslam {
+  namespace backend {
+
+    /**
+     * \class L1NormInterface
+     *
+     * Interface of non-smooth error terms of the form \f$ w \sum_i |p_i| \f$, where \f$ p_i \f$ is the
+     * parameter of the i-th design variable of the error term. The design variables have to be scalar,
+     * i.e. their minimal dimension is one and an update adds to the parameter.
+     * Optimizers handling the non-smoothness explicitly (OptimizerOWLQN) detect L1 terms by this interface.
+     */
+    class L1NormInterface
+    {
+     public:
+      virtual ~L1NormInterface() { }
+
+      /// \brief The weight w of the L1 norm
+      virtual double getL1NormWeight() const = 0;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_L1_NORM_INTERFACE_HPP */
@@ -33,19 +33,43 @@ namespace aslam {
           std::ostream & printState(std::ostream & out) const override;
           bool requiresAugmentedDiagonal() const override;
           std::string name() const override { return "levenberg_marquardt"; }
+
+          /// \brief The number of damping values tried for one linearization. If the step of the current lambda is rejected,
+          ///        the optimizer evaluates the steps of the next numLambdaCandidates - 1 lambdas the policy would try after
+          ///        consecutive rejections and continues with the best one, without rebuilding the system. The steps of
+          ///        these lambdas are solved concurrently if the linear system solver supports it.
+          void setNumLambdaCandidates(size_t numLambdaCandidates);
+          size_t getNumLambdaCandidates() const { return _numLambdaCandidates; }
+
+          size_t numCandidates() const override { return _numLambdaCandidates; }
+          void solveCandidates(int nThreads, std::vector<Eigen::VectorXd>& outDx) override;
+          void selectCandidate(size_t i) override;
+        protected:
+          /// \brief The error vector of the last buildSystem() call.
+          const Eigen::VectorXd& linearizationError() const { return _linearizationError; }
+          /// \brief Solves the system without rebuilding it. The solver's error vector is reset to the one of the
+          ///        linearization point first, as the QR solvers solve for it and the error of trial states overwrites it.
+          bool resolveSystem(double lambda, Eigen::VectorXd& outDx);
         private:
+          /// \brief Rebuilds the linear system at the current state.
+          void buildSystem(int nThreads);
           double getLmRho(const Eigen::VectorXd & dx);
+          /// \brief Increase lambda and mu the way a rejected step does, i times.
+          void increaseDamping(size_t i, double& lambda, double& mu) const;
           double _lambdaInit;
           double _gammaInit;
           double _betaInit;
           int _pInit;
           double _muInit;
+          size_t _numLambdaCandidates;
           
           double _lambda;
           double _gamma;
           double _beta;
           int _p;
           double _mu;
+
+          Eigen::VectorXd _linearizationError;
         };
         
     } // namespace backend
@@ -43,6 +43,8 @@ THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
 #include <boost/function.hpp>
@@ -188,6 +190,7 @@ namespace aslam {
       std::size_t nMaxIterWolfe1 = 30; /// \brief Maximum number of iterations for method wolfe1
       std::size_t nMaxIterWolfe2 = 10; /// \brief Maximum number of iterations for method wolfe2
       std::size_t nMaxIterZoom = 10;   /// \brief Maximum number of iterations for the internal zoom method
+      bool lazyGradientEvaluation = true; /// \brief Whether wolfe1 only evaluates the error at trial steps violating the sufficient decrease condition and continues with zoom
 
       template<class Archive>
       inline void serialize(Archive & ar, const unsigned int version);
@@ -322,8 +325,42 @@ namespace aslam {
        */
       inline double getCurrentStepLength() const;
 
+      /**
+       * Number of error evaluations of the last line search, without the ones served from the trial cache
+       */
+      inline std::size_t getNumErrorEvaluations() const;
+
+      /**
+       * Number of gradient evaluations of the last line search, without the ones served from the trial cache
+       */
+      inline std::size_t getNumGradientEvaluations() const;
+
     private: // private methods
 
+      /// \brief Information evaluated at a trial step length of the current search direction
+      struct TrialPoint {
+        double stepLength;
+        double error;
+        bool hasGradient;
+        double derror;
+        RowVectorType gradient;
+      };
+
+      /// \brief Implementation of lineSearchWolfe1() without resetting the evaluation counters
+      bool wolfe1();
+
+      /// \brief Implementation of lineSearchWolfe2() without resetting the evaluation counters
+      bool wolfe2();
+
+      /// \brief Resets the evaluation counters at the start of a line search
+      void resetCounters();
+
+      /// \brief Returns the cached information at the current step length or nullptr
+      TrialPoint* findTrialPoint();
+
+      /// \brief Clears the trial cache and stores the current point as step length zero
+      void resetTrialCache();
+
       /**
        * Part of the optimization algorithm in scalarSearchWolfe2.
        */
@@ -358,6 +395,18 @@ namespace aslam {
       /// \brief Whether an update of the gradient-related information is neccesary
       bool _derrorOutdated = true;
 
+      /// \brief Error and gradient information at the step lengths already visited in the current search direction.
+      ///        wolfe2 often revisits steps that wolfe1 tried before, e.g. the initial step length.
+      std::vector<TrialPoint> _trialCache;
+
+      /// \brief Whether the state is the start of the search and whether it was reached with a single update from there
+      bool _atOrigin = true;
+      bool _exactState = true;
+
+      /// \brief Error and gradient evaluations of the last line search
+      std::size_t _numErrorEvaluations = 0;
+      std::size_t _numGradientEvaluations = 0;
+
       /// \brief Callback  that is called when the objective function is evaluated
       boost::function<void(void)> _evalErrorCallback;
 
@@ -399,6 +448,12 @@ namespace aslam {
     inline double LineSearch::getCurrentStepLength() const {
       return _stepLength;
     }
+    inline std::size_t LineSearch::getNumErrorEvaluations() const {
+      return _numErrorEvaluations;
+    }
+    inline std::size_t LineSearch::getNumGradientEvaluations() const {
+      return _numGradientEvaluations;
+    }
 
 
   } // namespace backend
@@ -21,6 +21,13 @@ namespace aslam {
     public:
       SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
 
+      /// \brief How buildSystem() updates a Jacobian that was evaluated by an earlier call.
+      enum JacobianUpdate {
+        JACOBIAN_FULL, /// \brief evaluate all Jacobians
+        JACOBIAN_BROYDEN, /// \brief correct the previous Jacobian by a sparse Broyden step, no Jacobian is evaluated
+        JACOBIAN_PARTIAL /// \brief evaluate only the Jacobians of error terms whose design variables moved more than a tolerance
+      };
+
       LinearSystemSolver();
 
       virtual ~LinearSystemSolver();
@@ -28,8 +35,8 @@ namespace aslam {
       /// \brief Evaluate the error using nThreads.
       double evaluateError(size_t nThreads, bool useMEstimator, callback::Manager * callback = nullptr);
 
-      /// \brief initialized the matrix structure for the problem with these error terms and errors.
-      void initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner);
+      /// \brief initialized the matrix structure for the problem with these error terms and errors using nThreads.
+      void initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner, size_t nThreads = 1);
 
       /// \brief build the system of equations.
       virtual void buildSystem(size_t nThreads, bool useMEstimator) = 0;
@@ -45,6 +52,27 @@ namespace aslam {
       /// \brief solve the system storing the solution in outDx and returning true on success.
       virtual bool solveSystem(Eigen::VectorXd& outDx) = 0;
 
+      /// \brief solve the system once per constant conditioner, as setConstantConditioner() followed by solveSystem() would.
+      ///        outDx[i] receives the solution for conditioners[i] and is left empty if that solution failed. The conditioner
+      ///        of the solver is not changed. The default implementation solves one system after the other. Solvers that can
+      ///        factor copies of their system concurrently override it and run up to nThreads solutions in parallel, these
+      ///        leave the factorization of the last solveSystem() call untouched.
+      virtual void solveSystems(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx);
+
+      /// \brief solve the system of the last solveSystem() call for another right-hand side.
+      ///        Returns false if not supported, which is the default.
+      virtual bool solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx);
+
+      /// \brief solve the system of the last solveSystem() call for the right-hand side \f$ \mathbf J^T \mathbf e \f$.
+      ///        The default implementation uses multiplyJacobianTranspose() and solveSystemWithRhs(). Returns false if not supported.
+      virtual bool solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx);
+
+      /// \brief compute \f$ \mathbf J \mathbf x \f$ with the Jacobian of the last buildSystem() call. Returns false if not supported.
+      virtual bool multiplyJacobian(const Eigen::VectorXd& /* x */, Eigen::VectorXd& /* outJx */) const { return false; }
+
+      /// \brief compute \f$ \mathbf J^T \mathbf y \f$ with the Jacobian of the last buildSystem() call. Returns false if not supported.
+      virtual bool multiplyJacobianTranspose(const Eigen::VectorXd& /* y */, Eigen::VectorXd& /* outJty */) const { return false; }
+
       virtual std::string name() const = 0;
 
       /// \brief return the right-hand side of the equation system.
@@ -63,6 +91,9 @@ namespace aslam {
       /// \brief return the full error vector
       virtual const Eigen::VectorXd& e() const;
 
+      /// \brief restore the error vector, e.g. after the error has been probed at a trial state.
+      void setErrorVector(const Eigen::VectorXd& e);
+
       /// \brief the number of rows in the Jacobian matrix
       size_t JRows() const;
 
@@ -77,6 +108,32 @@ namespace aslam {
         return _acceptConstantErrorTerms;
       }
       void setAcceptConstantErrorTerms(bool acceptConstantErrorTerms);
+
+      /// \brief Whether the solver can reuse its Jacobian as requested by setJacobianUpdate().
+      ///        Solvers that do not support it always evaluate the full Jacobian.
+      virtual bool supportsLazyJacobian() const { return false; }
+
+      /// \brief Set how buildSystem() updates the Jacobian. For JACOBIAN_PARTIAL, the Jacobians of an error term are
+      ///        re-evaluated once the summed max-norm motion of its design variables exceeds \p refreshTolerance.
+      void setJacobianUpdate(JacobianUpdate update, double refreshTolerance = 0.0);
+      JacobianUpdate getJacobianUpdate() const { return _jacobianUpdate; }
+
+      /// \brief Make the next buildSystem() call evaluate the full Jacobian.
+      void requestFullJacobian() { _fullJacobianRequested = true; }
+
+      /// \brief Notify the solver about a state update dx (-dx for a revert) to track the motion since the last Jacobian.
+      void notifyStateUpdate(const Eigen::VectorXd& dx);
+
+      /// \brief The number of lazy Jacobian updates since the last full evaluation.
+      size_t jacobianAge() const { return _jacobianAge; }
+
+      /// \brief Error terms with an MEstimator weight below this threshold get zero Jacobians without evaluating them.
+      ///        Only solvers supporting lazy Jacobians honor it. Zero (the default) disables skipping.
+      void setMEstimatorWeightThreshold(double threshold);
+      double getMEstimatorWeightThreshold() const { return _mEstimatorWeightThreshold; }
+
+      /// \brief The total number of Jacobian evaluations skipped due to a small MEstimator weight.
+      size_t numSkippedJacobians() const { return _numSkippedJacobians; }
     protected:
       /// \brief initialized the matrix structure for the problem with these error terms and errors.
       virtual void initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner) = 0;
@@ -94,6 +151,23 @@ namespace aslam {
       /// \brief Event hook to handle new value for the acceptConstantErrorTerms property
       virtual void handleNewAcceptConstantErrorTerms();
 
+      /// \brief Update the Jacobian of \p builder the way requested by setJacobianUpdate(). To be called by buildSystem().
+      ///        The builder must provide the interface of CompressedColumnJacobianTransposeBuilder.
+      template <typename JACOBIAN_BUILDER>
+      void buildJacobian(JACOBIAN_BUILDER& builder, size_t nThreads, bool useMEstimator);
+
+      /// \brief Decide on the update of the next Jacobian and flag the error terms to refresh.
+      JacobianUpdate beginJacobianUpdate(bool useMEstimator);
+
+      /// \brief Store the reference state of the Jacobian after it was updated.
+      void endJacobianUpdate(JacobianUpdate update, bool useMEstimator);
+
+      /// \brief The accumulated motion of the active design variables of error term i.
+      double errorTermMotion(size_t i) const;
+
+      /// \brief Does the builder write a zero Jacobian for error term i instead of evaluating it, due to its small MEstimator weight?
+      bool isJacobianSkipped(size_t i, bool useMEstimator) const;
+
       /// \brief the vector of error terms.
       std::vector<ErrorTerm*> _errorTerms;
 
@@ -120,8 +194,62 @@ namespace aslam {
 
       /// \brief The number of columns in the Jacobian matrix
       size_t _JCols;
+
+      /// \brief The number of threads the implementation of initMatrixStructure() may use
+      size_t _numThreadsInitMatrixStructure = 1;
+
+      /// \brief The requested Jacobian update and the refresh tolerance of JACOBIAN_PARTIAL
+      JacobianUpdate _jacobianUpdate;
+      double _jacobianRefreshTolerance;
+
+      /// \brief Is there a Jacobian from an earlier buildSystem() call, was a full one requested
+      bool _hasJacobian;
+      bool _fullJacobianRequested;
+
+      /// \brief The number of lazy updates since the last full Jacobian
+      size_t _jacobianAge;
+
+      /// \brief The state change since the last Jacobian update and the error vector at it
+      Eigen::VectorXd _dxSinceJacobian;
+      Eigen::VectorXd _eAtJacobian;
+
+      /// \brief The design variables, their max-norm displacements between consecutive Jacobian updates summed up,
+      ///        indexed by block index
+      std::vector<DesignVariable*> _designVariables;
+      std::vector<double> _designVariableMotion;
+
+      /// \brief Per error term: the motion of its design variables at its last Jacobian evaluation and the refresh flag
+      std::vector<double> _errorTermMotionAtJacobian;
+      std::vector<char> _refreshErrorTerm;
+
+      /// \brief Per error term: was its current Jacobian zero filled due to a small MEstimator weight?
+      std::vector<char> _zeroJacobian;
+
+      /// \brief The MEstimator weight below which Jacobians are not evaluated and the number of skipped evaluations
+      double _mEstimatorWeightThreshold;
+      size_t _numSkippedJacobians;
     };
 
+    template <typename JACOBIAN_BUILDER>
+    void LinearSystemSolver::buildJacobian(JACOBIAN_BUILDER& builder, size_t nThreads, bool useMEstimator)
+    {
+      const JacobianUpdate update = beginJacobianUpdate(useMEstimator);
+      builder.setMEstimatorWeightThreshold(_mEstimatorWeightThreshold);
+      switch (update) {
+        case JACOBIAN_BROYDEN:
+          // The errors are stored negated: dr = r - r_old = _eAtJacobian - _e
+          builder.broydenUpdate(nThreads, _dxSinceJacobian, _eAtJacobian - _e);
+          break;
+        case JACOBIAN_PARTIAL:
+          builder.buildSystem(nThreads, useMEstimator, _refreshErrorTerm);
+          break;
+        default:
+          builder.buildSystem(nThreads, useMEstimator);
+      }
+      _numSkippedJacobians += builder.numSkippedJacobians();
+      endJacobianUpdate(update, useMEstimator);
+    }
+
   } // namespace backend
 } // namespace aslam
 
@@ -10,6 +10,7 @@
 
 // standard includes
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 #include <utility> // std::move
 
@@ -134,7 +135,7 @@ namespace backend {
       {
         SM_ASSERT_EQ_DBG(Exception, this->numTopCols(), mat.rows(), "Incompatible matrix sizes");
         this->allocate(mat.cols()); // We allocate space for 1 more matrix. Stack wasn't empty before, so now we have at least 2.
-        this->top().noalias() = this->matrix(this->numMatrices()-2)*mat;
+        this->multiplyPrevious(mat, std::integral_constant<bool, DERIVED::RowsAtCompileTime != Eigen::Dynamic && DERIVED::ColsAtCompileTime != Eigen::Dynamic>());
       }
       else
       {
@@ -222,6 +223,37 @@ namespace backend {
       SM_ASSERT_TRUE_DBG(Exception, (uintptr_t)(&(_data[_headers.back().dataIndex])) % DataAlignment == 0, "Memory is not properly aligned");
     }
 
+    /// \brief Computes the top matrix as the product of the previous matrix and \p mat of dynamic size
+    template <typename DERIVED>
+    EIGEN_ALWAYS_INLINE void multiplyPrevious(const Eigen::MatrixBase<DERIVED>& mat, std::false_type /* isFixedSize */)
+    {
+      this->top().noalias() = this->matrix(this->numMatrices()-2)*mat;
+    }
+
+    /// \brief Computes the top matrix as the product of the previous matrix and the fixed size chain rule matrix \p mat,
+    ///        e.g. the 3x3, 3x6 and 6x6 matrices of the Euclidean, rotation and transformation expression nodes.
+    ///        The usual numbers of rows are dispatched to fully fixed size products Eigen unrolls and vectorizes.
+    template <typename DERIVED>
+    EIGEN_ALWAYS_INLINE void multiplyPrevious(const Eigen::MatrixBase<DERIVED>& mat, std::true_type /* isFixedSize */)
+    {
+      switch (this->numRows()) {
+        case 1: this->multiplyPrevious<1>(mat); break;
+        case 2: this->multiplyPrevious<2>(mat); break;
+        case 3: this->multiplyPrevious<3>(mat); break;
+        case 4: this->multiplyPrevious<4>(mat); break;
+        case 6: this->multiplyPrevious<6>(mat); break;
+        default: this->multiplyPrevious<Eigen::Dynamic>(mat); break;
+      }
+    }
+
+    /// \brief Computes the top matrix as the product of the previous matrix and \p mat with \p Rows rows
+    template <int Rows, typename DERIVED>
+    EIGEN_ALWAYS_INLINE void multiplyPrevious(const Eigen::MatrixBase<DERIVED>& mat)
+    {
+      this->top<Rows, DERIVED::ColsAtCompileTime>().noalias() =
+          this->matrix<Rows, DERIVED::RowsAtCompileTime>(this->numMatrices()-2)*mat;
+    }
+
     /// \brief Const getter for the \p i-th matrix in the stack
     template<int Rows = Eigen::Dynamic, int Cols = Eigen::Dynamic>
     EIGEN_ALWAYS_INLINE ConstMap<Rows, Cols> matrix(const std::size_t i) const
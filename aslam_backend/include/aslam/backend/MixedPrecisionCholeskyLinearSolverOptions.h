@@ -0,0 +1,52 @@
+/** \file MixedPrecisionCholeskyLinearSolverOptions.h
+    \brief This file defines the MixedPrecisionCholeskyLinearSolverOptions
+           class which contains specific options for the mixed precision
+           Cholesky linear solver.
+  */
+
+#ifndef ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SOLVER_OPTIONS_H
+#define ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SOLVER_OPTIONS_H
+
+namespace aslam {
+  namespace backend {
+
+    /** The class MixedPrecisionCholeskyLinearSolverOptions contains specific
+        options for the mixed precision Cholesky linear solver.
+        \brief Mixed precision Cholesky linear solver options
+      */
+    class MixedPrecisionCholeskyLinearSolverOptions {
+    public:
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Default constructor
+      MixedPrecisionCholeskyLinearSolverOptions();
+      /// Copy constructor
+      MixedPrecisionCholeskyLinearSolverOptions(
+        const MixedPrecisionCholeskyLinearSolverOptions& other);
+      /// Assignment operator
+      MixedPrecisionCholeskyLinearSolverOptions& operator =
+        (const MixedPrecisionCholeskyLinearSolverOptions& other);
+      /// Destructor
+      virtual ~MixedPrecisionCholeskyLinearSolverOptions();
+      /** @}
+        */
+
+      /** \name Members
+        @{
+        */
+      /// Maximum number of iterative refinement steps per solve
+      int maxRefinementSteps;
+      /// Relative residual of the normal equations at which the refinement stops
+      double refinementTolerance;
+      /// Verbose mode
+      bool verbose;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SOLVER_OPTIONS_H
@@ -0,0 +1,120 @@
+#ifndef ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SYSTEM_SOLVER_HPP
+#define ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SYSTEM_SOLVER_HPP
+
+#include "LinearSystemSolver.hpp"
+#include "CompressedColumnJacobianTransposeBuilder.hpp"
+
+#include <Eigen/SparseCholesky>
+
+#include "aslam/backend/MixedPrecisionCholeskyLinearSolverOptions.h"
+
+namespace sm {
+
+  class PropertyTree;
+
+}
+namespace aslam {
+  namespace backend {
+
+    /**
+     * \class MixedPrecisionCholeskyLinearSystemSolver
+     *
+     * A sparse Cholesky solver that stores \f$ \mathbf J^T \f$ and factorizes \f$ \mathbf J^T \mathbf J \f$ in single precision.
+     *
+     * \f$ \mathbf J^T \f$ is stored as float, which halves the memory and the memory traffic of its products.
+     * The products accumulate in double precision with the double precision errors. The upper triangle of
+     * \f$ \mathbf J^T \mathbf J \f$ is assembled in single precision, with the diagonal accumulated in double,
+     * and factorized by Eigen's simplicial LDLT, as cholmod only factorizes double matrices.
+     * The solution is then improved by iterative refinement. The residual of the normal equations is evaluated
+     * in double precision as \f$ \mathbf J^T (\mathbf J \mathbf x) \f$ instead of through the (squared and
+     * therefore worse conditioned) Hessian. The refinement recovers the solution for the rounded Jacobian, which
+     * differs from the all double solution by about the single precision of the Jacobian entries.
+     */
+    class MixedPrecisionCholeskyLinearSystemSolver : public LinearSystemSolver {
+    public:
+      typedef CompressedColumnJacobianTransposeBuilder<int, float> JacobianBuilder;
+      typedef Eigen::SparseMatrix<float, Eigen::ColMajor, int> HessianMatrix;
+
+      MixedPrecisionCholeskyLinearSystemSolver(const MixedPrecisionCholeskyLinearSolverOptions& options = MixedPrecisionCholeskyLinearSolverOptions());
+      MixedPrecisionCholeskyLinearSystemSolver(const sm::PropertyTree& config);
+      ~MixedPrecisionCholeskyLinearSystemSolver() override;
+
+      void buildSystem(size_t nThreads, bool useMEstimator) override;
+      bool solveSystem(Eigen::VectorXd& outDx) override;
+      /// \brief solve with the factorization of the last solveSystem() call, including the iterative refinement
+      bool solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx) override;
+
+      bool multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const override;
+      bool multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const override;
+
+      std::string name() const override { return "mixed_precision_cholesky"; }
+
+      bool supportsLazyJacobian() const override { return true; }
+
+      /// Returns the Jacobian transpose
+      const CompressedColumnMatrix<int, float>& getJacobianTranspose() const;
+      /// Returns the number of refinement steps done by the last solveSystem() call
+      int getNumRefinementSteps() const { return _numRefinementSteps; }
+      /// Returns the relative residual of the normal equations after the last solveSystem() call
+      double getRelativeResidual() const { return _relativeResidual; }
+
+      /// Returns the options
+      const MixedPrecisionCholeskyLinearSolverOptions& getOptions() const;
+      /// Returns the options
+      MixedPrecisionCholeskyLinearSolverOptions& getOptions();
+      /// Sets the options
+      void setOptions(const MixedPrecisionCholeskyLinearSolverOptions& options);
+
+      /// Helper Function for DogLeg implementation; returns parts required for the steepest descent solution
+      double rhsJtJrhs() override;
+
+    private:
+      void initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner) override;
+      void handleNewAcceptConstantErrorTerms() override;
+
+      /// \brief compute the sparsity pattern of the upper triangle of J^T J and the row wise index of J^T.
+      ///        Throws if its number of nonzeros exceeds the int indices.
+      void initHessianStructure();
+
+      /// \brief accumulate the columns [startCol, endCol) of the upper triangle of J^T J.
+      ///        Only reads the entries of J^T in the rows [startCol, endCol).
+      void assembleHessianColumns(size_t startCol, size_t endCol);
+
+      /// \brief compute (J^T J + D^2) x in double precision.
+      void multiplyNormalEquations(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const;
+
+      /// \brief solve with the current factorization and refine the solution.
+      void solveFactorizedSystem(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx);
+
+      JacobianBuilder _jacobianBuilder;
+
+      /// \brief Row wise index of J^T: the entries of row r are [_jtRowPtr[r], _jtRowPtr[r + 1]),
+      ///        each with its column of J^T and its position in the values of J^T.
+      std::vector<int> _jtRowPtr;
+      std::vector<int> _jtRowCol;
+      std::vector<int> _jtRowEntry;
+
+      /// \brief The upper triangle of J^T J + D^2 in single precision.
+      ///        The diagonal element is the last entry of every column.
+      HessianMatrix _hessian;
+
+      /// \brief The diagonal of J^T J without the conditioner, accumulated in double precision.
+      Eigen::VectorXd _jtjDiagonal;
+
+      Eigen::SimplicialLDLT<HessianMatrix, Eigen::Upper> _factor;
+      bool _isPatternAnalyzed;
+      bool _isFactorized;
+
+      /// \brief The residual of the normal equations used for the refinement.
+      Eigen::VectorXd _refinementResidual;
+
+      int _numRefinementSteps;
+      double _relativeResidual;
+
+      /// Options
+      MixedPrecisionCholeskyLinearSolverOptions _options;
+    };
+
+  } // namespace backend
+} // namespace aslam
+#endif /* ASLAM_BACKEND_MIXED_PRECISION_CHOLESKY_LINEAR_SYSTEM_SOLVER_HPP */
@@ -17,6 +17,10 @@ namespace aslam {
      *        only stores containers of design variables and error terms.
      *        This container owns the design variables and error terms and
      *        it will call delete on them when it goes out of scope.
+     *
+     *        Adding, removing and looking up design variables and error terms
+     *        takes constant time. Removing moves the last design variable or
+     *        error term into the slot of the removed one.
      */
     class OptimizationProblem : public OptimizationProblemBase {
     public:
@@ -56,6 +60,9 @@ namespace aslam {
       /// \brief clear the design variables and error terms.
       void clear();
 
+      /// \brief Reserve memory for the given numbers of design variables and error terms
+      void reserve(size_t numDesignVariables, size_t numErrorTerms, size_t numNonSquaredErrorTerms = 0);
+
       /// \brief used for debugging...is the design variable in the problem.
       bool isDesignVariableInProblem(const DesignVariable* dv);
 
@@ -76,16 +83,33 @@ namespace aslam {
       void getErrorsImplementation(const DesignVariable* dv, std::set<ErrorTerm*>& outErrorSet) override;
       void getNonSquaredErrorsImplementation(const DesignVariable* dv, std::set<ScalarNonSquaredErrorTerm*>& outErrorSet) override;
 
-      // \todo Replace these std::vectors by something better. The underlying algorithms that this object
-      //       supports suck with these containers. Blerg. See "removeDesignVariable()" for an example of
-      //       just how bad this is.
+      /// \brief Error terms of one type, indexed by their slots and by their design variables
+      template <typename ErrorTermType>
+      class ErrorTermIndex {
+      public:
+        void add(const boost::shared_ptr<ErrorTermType> & et);
+        void remove(const ErrorTermType* et);
+        void clear();
+        void reserve(size_t numErrorTerms, size_t numDesignVariables);
+        size_t size() const { return _errorTerms.size(); }
+        bool contains(const ErrorTermType* et) const { return _entries.count(et) > 0; }
+        ErrorTermType* at(size_t i) const { return _errorTerms[i].get(); }
+        /// \brief The error terms of the design variable, empty if there are none
+        const std::vector<ErrorTermType*> & errorTerms(const DesignVariable* dv) const;
+      private:
+        struct Entry {
+          size_t slot; ///< Index in _errorTerms
+          std::vector<size_t> positions; ///< Index in the error term list of each design variable of the error term
+        };
+        std::vector< boost::shared_ptr<ErrorTermType> > _errorTerms;
+        std::unordered_map<const ErrorTermType*, Entry> _entries;
+        std::unordered_map<const DesignVariable*, std::vector<ErrorTermType*> > _errorTermsOfDesignVariable;
+      };
+
       std::vector< boost::shared_ptr<DesignVariable> > _designVariables;
-      std::vector< boost::shared_ptr<ErrorTerm> > _errorTerms;
-      std::vector< boost::shared_ptr<ScalarNonSquaredErrorTerm> > _sNSErrorTerms;
-      typedef std::unordered_multimap< DesignVariable*, ErrorTerm*> error_map_t;
-      typedef std::unordered_multimap< DesignVariable*, ScalarNonSquaredErrorTerm*> error_map_sns_t;
-      error_map_t _errorTermMap;
-      error_map_sns_t _errorTermMapSns;
+      std::unordered_map<const DesignVariable*, size_t> _designVariableSlots; ///< Index in _designVariables
+      ErrorTermIndex<ErrorTerm> _errorTerms;
+      ErrorTermIndex<ScalarNonSquaredErrorTerm> _sNSErrorTerms;
     };
 
 
@@ -58,6 +58,12 @@ namespace aslam {
       typedef Optimizer2Options Options;
       struct Status : public OptimizerStatus {
         SolutionReturnValue srv;
+        std::size_t numLazyJacobianUpdates = 0; /// \brief Number of Jacobians updated lazily instead of evaluated in full
+        std::size_t numFrozenDesignVariables = 0; /// \brief Number of times a design variable was frozen by the active set
+        std::size_t numReactivatedDesignVariables = 0; /// \brief Number of times a frozen design variable was activated again
+        std::size_t numActiveSetUpdates = 0; /// \brief Number of structure updates due to active set changes
+        std::size_t numSkippedJacobians = 0; /// \brief Number of error term Jacobians skipped due to a small MEstimator weight
+        std::size_t numCandidateSteps = 0; /// \brief Number of further candidate steps of the trust region policy evaluated after a rejected step
        private:
         void resetImplementation() override;
       };
@@ -154,13 +160,39 @@ namespace aslam {
       /// \brief Revert the last state update.
       void revertLastStateUpdate();
 
+      /// \brief Revert the last state update, which was \p dx. Without \p notifySolver the solver does not
+      ///        account the step as motion for lazy Jacobian updates.
+      void revertLastStateUpdate(const Eigen::VectorXd& dx, bool notifySolver = true);
+
       /// \brief Apply a state update.
       double applyStateUpdate();
 
+      /// \brief Apply the state update \p dx. Without \p notifySolver the solver does not account it as
+      ///        motion for lazy Jacobian updates.
+      double applyStateUpdate(const Eigen::VectorXd& dx, bool notifySolver = true);
+
       /// \brief issue callback for given event
       template<typename Event>
       void issueCallback();
 
+      /// \brief Evaluate the further candidate steps of the trust region policy after the step _dx was rejected.
+      ///        Continues with the best candidate and returns true if it decreases the error,
+      ///        otherwise the state is reverted and false is returned.
+      bool evaluateCandidateSteps();
+
+      /// \brief Set up the active set bookkeeping for the currently active design variables.
+      void initializeActiveSet();
+
+      /// \brief Freeze and reactivate design variables according to the last accepted update _dx.
+      ///        The structure is updated at most every activeSetUpdateInterval calls.
+      void updateActiveSet();
+
+      /// \brief Activate all frozen design variables again.
+      void releaseActiveSet();
+
+      /// \brief Update the problem manager and the linear system structure after the active set changed.
+      void updateActiveSetStructure();
+
       void optimizeImplementation() override;
 
       void initializeImplementation() override;
@@ -183,6 +215,22 @@ namespace aslam {
 
       /// \brief A class that manages the optimizer callbacks
       callback::Manager _callbackManager;
+
+      /// \brief The design variables managed by the active set and the indices of the design variables sharing an error term with them
+      std::vector<DesignVariable*> _activeSetDesignVariables;
+      std::vector<std::vector<size_t> > _activeSetNeighbours;
+
+      /// \brief Per managed design variable: the number of consecutive small updates, whether it is frozen and whether
+      ///        it waits for the next structure update to be activated again
+      std::vector<int> _activeSetQuietIterations;
+      std::vector<char> _isFrozen;
+      std::vector<char> _isPendingReactivation;
+
+      /// \brief The number of active set updates since the last structure update
+      int _activeSetIterationsSinceUpdate = 0;
+
+      /// \brief The acceptConstantErrorTerms setting of the solver before the active set enabled it
+      bool _solverAcceptedConstantErrorTerms = false;
     };
 
 } // namespace backend
@@ -5,17 +5,28 @@
 #include <boost/shared_ptr.hpp>
 
 #include <aslam/backend/OptimizerBase.hpp>
+#include <aslam/backend/LinearSystemSolver.hpp>
 
 namespace aslam {
   namespace backend {
-  class LinearSystemSolver;
   class TrustRegionPolicy;
   
     struct Optimizer2Options : public OptimizerOptionsBase {
       Optimizer2Options() :
         doSchurComplement(false),
         verbose(false),
-        linearSolverMaximumFails(0)
+        linearSolverMaximumFails(0),
+        jacobianUpdate(LinearSystemSolver::JACOBIAN_FULL),
+        maxJacobianAge(5),
+        jacobianStallRatio(0.1),
+        jacobianRefreshTolerance(1e-3),
+        useActiveSet(false),
+        activeSetFreezeThreshold(1e-6),
+        activeSetFreezeIterations(3),
+        activeSetReactivationThreshold(1e-3),
+        activeSetUpdateInterval(5),
+        activeSetMinFreezeFraction(0.1),
+        mEstimatorWeightThreshold(0.0)
       {
         convergenceDeltaError = 1e-3;
         convergenceDeltaX = 1e-3;
@@ -31,6 +42,41 @@ namespace aslam {
       /// \brief The number of times the linear solver may fail before the optimization is aborted. (>0 only if a fall back is available!)
       int linearSolverMaximumFails;
 
+      /// \brief How the Jacobian is updated after an accepted step. Lazy updates are only done by linear solvers supporting them.
+      LinearSystemSolver::JacobianUpdate jacobianUpdate;
+
+      /// \brief The maximum number of consecutive lazy Jacobian updates before a full Jacobian is evaluated.
+      int maxJacobianAge;
+
+      /// \brief A full Jacobian is evaluated if the error decrease of a step with a lazy Jacobian is below this ratio times the previous decrease.
+      double jacobianStallRatio;
+
+      /// \brief The design variable motion (max-norm, summed over the steps) above which JACOBIAN_PARTIAL re-evaluates the Jacobians of an error term.
+      double jacobianRefreshTolerance;
+
+      /// \brief Should converged design variables be frozen (deactivated) to shrink the system? Their error terms keep contributing
+      ///        a constant residual, so the linear system solver has to support constant error terms. All frozen design
+      ///        variables are activated again when the optimization ends.
+      bool useActiveSet;
+
+      /// \brief A design variable is frozen once the max-norm of its update stayed below this threshold for activeSetFreezeIterations accepted steps.
+      double activeSetFreezeThreshold;
+      int activeSetFreezeIterations;
+
+      /// \brief Frozen design variables sharing an error term with a design variable whose update exceeds this threshold are activated again.
+      double activeSetReactivationThreshold;
+
+      /// \brief The minimum number of accepted steps between two structure updates of the active set. Freezes and reactivations
+      ///        found in between are collected and applied together, since every update rebuilds the linear system structure.
+      int activeSetUpdateInterval;
+
+      /// \brief Freezes alone only trigger a structure update if they remove at least this fraction of the active design variables.
+      double activeSetMinFreezeFraction;
+
+      /// \brief Error terms whose MEstimator weight is below this threshold get zero Jacobians without evaluating them,
+      ///        saving the Jacobian work of suppressed outliers. Zero disables skipping. Requires a solver supporting lazy Jacobians.
+      double mEstimatorWeightThreshold;
+
       boost::shared_ptr<LinearSystemSolver> linearSystemSolver;
       boost::shared_ptr<TrustRegionPolicy> trustRegionPolicy;
     };
@@ -41,6 +87,17 @@ namespace aslam {
       out << "\tdoSchurComplement: " << options.doSchurComplement << std::endl;
       out << "\tverbose: " << options.verbose << std::endl;
       out << "\tlinearSolverMaximumFails: " << options.linearSolverMaximumFails << std::endl;
+      out << "\tjacobianUpdate: " << options.jacobianUpdate << std::endl;
+      out << "\tmaxJacobianAge: " << options.maxJacobianAge << std::endl;
+      out << "\tjacobianStallRatio: " << options.jacobianStallRatio << std::endl;
+      out << "\tjacobianRefreshTolerance: " << options.jacobianRefreshTolerance << std::endl;
+      out << "\tuseActiveSet: " << options.useActiveSet << std::endl;
+      out << "\tactiveSetFreezeThreshold: " << options.activeSetFreezeThreshold << std::endl;
+      out << "\tactiveSetFreezeIterations: " << options.activeSetFreezeIterations << std::endl;
+      out << "\tactiveSetReactivationThreshold: " << options.activeSetReactivationThreshold << std::endl;
+      out << "\tactiveSetUpdateInterval: " << options.activeSetUpdateInterval << std::endl;
+      out << "\tactiveSetMinFreezeFraction: " << options.activeSetMinFreezeFraction << std::endl;
+      out << "\tmEstimatorWeightThreshold: " << options.mEstimatorWeightThreshold << std::endl;
       return out;
     }
   } // namespace backend
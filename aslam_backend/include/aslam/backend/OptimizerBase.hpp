@@ -95,6 +95,9 @@ struct OptimizerStatus
   std::size_t numIterations = 0; /// \brief Number of iterations run
   std::size_t numJacobianEvaluations = 0; /// \brief Number of Jacobian/gradient evaluations performed
   std::size_t numErrorEvaluations = 0; /// \brief Number of objective/error evaluations performed
+  std::size_t numLineSearches = 0; /// \brief Number of line searches performed
+  std::size_t numLineSearchErrorEvaluations = 0; /// \brief Number of objective/error evaluations performed inside line searches
+  std::size_t numLineSearchGradientEvaluations = 0; /// \brief Number of gradient evaluations performed inside line searches
   double gradientNorm = std::numeric_limits<double>::signaling_NaN(); /// \brief Norm of the gradient
   double maxDeltaX = std::numeric_limits<double>::signaling_NaN(); /// \brief Maximum absolute value of change in design variables
   double error = std::numeric_limits<double>::max(); /// \brief Current error/objective value. numeric_limits<double>::max() if error is not evaluated.
@@ -60,6 +60,11 @@ struct LINEAR_SYSTEM_SOLVED : Event {
   using Event::Event;
 };
 
+/// \brief Right after the update of the design variables has been computed, before it is applied.
+struct DESIGN_VARIABLE_UPDATE_COMPUTED : Event {
+  using Event::Event;
+};
+
 /// \brief Right after the design variables (X) have been updated.
 struct DESIGN_VARIABLES_UPDATED : Event {
   using Event::Event;
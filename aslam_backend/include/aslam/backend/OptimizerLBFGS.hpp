@@ -0,0 +1,129 @@
+#ifndef ASLAM_BACKEND_OPTIMIZER_LBFGS_HPP
+#define ASLAM_BACKEND_OPTIMIZER_LBFGS_HPP
+
+#include <aslam/backend/util/OptimizerProblemManagerBase.hpp>
+#include <aslam/backend/LineSearch.hpp>
+
+namespace sm {
+  class PropertyTree;
+}
+
+namespace aslam {
+  namespace backend {
+
+    struct OptimizerOptionsLBFGS : public OptimizerOptionsBase
+    {
+      OptimizerOptionsLBFGS();
+      OptimizerOptionsLBFGS(const sm::PropertyTree& config);
+      LineSearchOptions linesearch; /// \brief Linesearch options
+      bool useDenseJacobianContainer = true; /// \brief Whether or not to use a dense Jacobian container
+      int historySize = 10; /// \brief Number of correction pairs used to approximate the inverse Hessian
+
+      void check() const override;
+
+      template<class Archive>
+      inline void serialize(Archive & ar, const unsigned int version);
+    };
+
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsLBFGS& options);
+
+    typedef OptimizerStatus OptimizerStatusLBFGS;
+
+    /**
+     * \class OptimizerLBFGS
+     *
+     * Limited-memory Broyden-Fletcher-Goldfarb-Shannon algorithm implementation for the ASLAM framework.
+     * The inverse Hessian approximation is never formed. The search direction is computed from the last
+     * historySize correction pairs with the two-loop recursion (Nocedal and Wright, Algorithm 7.4), so
+     * memory and time per iteration are O(historySize * numOptParameters).
+     */
+    class OptimizerLBFGS : public OptimizerProblemManagerBase
+    {
+     public:
+      typedef boost::shared_ptr<OptimizerLBFGS> Ptr;
+      typedef boost::shared_ptr<const OptimizerLBFGS> ConstPtr;
+      typedef OptimizerOptionsLBFGS Options;
+      typedef OptimizerStatusLBFGS Status;
+
+     public:
+      /// \brief Constructor with default options
+      OptimizerLBFGS();
+      /// \brief Constructor with custom options
+      OptimizerLBFGS(const Options& options);
+      /// \brief Constructor from property tree
+      OptimizerLBFGS(const sm::PropertyTree& config);
+      /// \brief Destructor
+      ~OptimizerLBFGS() override;
+
+      /// \brief Return the status
+      const Status& getStatus() const override { return _status; }
+
+      /// \brief Get the optimizer options.
+      const Options& getOptions() const override { return _options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const Options& options) { _options = options; _linesearch.options() = _options.linesearch; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const OptimizerOptionsBase& options) override { static_cast<OptimizerOptionsBase&>(_options) = options; }
+
+      /// \brief Const getter for the linesearch object
+      const LineSearch& getLineSearch() const { return _linesearch; }
+
+      /// \brief Number of correction pairs currently stored
+      std::size_t getHistorySize() const { return _numPairs; }
+
+    private:
+
+      /// \brief Run the optimization
+      void optimizeImplementation() override;
+
+      /// \brief Reset information
+      void resetImplementation() override;
+
+      /// \brief Update the status
+      void updateStatus(bool lineSearchSuccess);
+
+      /// \brief Compute the search direction -H_k * gradient with the two-loop recursion
+      void computeSearchDirection(const RowVectorType& gradient, RowVectorType& outDirection);
+
+      /// \brief Store a correction pair, dropping the oldest one if the history is full
+      void addCorrectionPair(const RowVectorType& sk, const RowVectorType& yk);
+
+      /// \brief Drop all stored correction pairs
+      void clearHistory();
+
+    private:
+
+      /// \brief the current set of options
+      Options _options;
+
+      /// \brief Ring buffer of the last parameter differences s_i, one per column
+      Eigen::MatrixXd _S;
+
+      /// \brief Ring buffer of the last gradient differences y_i, one per column
+      Eigen::MatrixXd _Y;
+
+      /// \brief 1 / (y_i^T s_i) for the stored pairs
+      Eigen::VectorXd _rho;
+
+      /// \brief Column of the oldest stored pair
+      std::size_t _firstPair = 0;
+
+      /// \brief Number of stored pairs
+      std::size_t _numPairs = 0;
+
+      /// \brief Line-search class
+      LineSearch _linesearch;
+
+      /// \brief Status of the optimizer
+      Status _status;
+
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#include "implementation/OptimizerLBFGSImpl.hpp"
+
+#endif /* ASLAM_BACKEND_OPTIMIZER_LBFGS_HPP */
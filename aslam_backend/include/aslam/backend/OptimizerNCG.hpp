@@ -0,0 +1,116 @@
+#ifndef ASLAM_BACKEND_OPTIMIZER_NCG_HPP
+#define ASLAM_BACKEND_OPTIMIZER_NCG_HPP
+
+#include <aslam/backend/util/OptimizerProblemManagerBase.hpp>
+#include <aslam/backend/LineSearch.hpp>
+
+namespace sm {
+  class PropertyTree;
+}
+
+namespace aslam {
+  namespace backend {
+
+    struct OptimizerOptionsNCG : public OptimizerOptionsBase
+    {
+      enum Method { POLAK_RIBIERE_PLUS, HAGER_ZHANG };
+
+      OptimizerOptionsNCG();
+      OptimizerOptionsNCG(const sm::PropertyTree& config);
+      LineSearchOptions linesearch; /// \brief Linesearch options
+      bool useDenseJacobianContainer = true; /// \brief Whether or not to use a dense Jacobian container
+      Method method = POLAK_RIBIERE_PLUS; /// \brief Formula for the conjugate direction update
+      int restartInterval = 0; /// \brief Restart with steepest descent every n iterations. 0 restarts every numOptParameters iterations, -1 never.
+      double restartOrthogonalityThreshold = 0.1; /// \brief Powell restart if |g_k^T g_k-1| >= threshold * |g_k|^2. 0 disables this restart.
+      double hagerZhangEta = 0.01; /// \brief Lower bound parameter eta of the Hager-Zhang update
+
+      void check() const override;
+
+      template<class Archive>
+      inline void serialize(Archive & ar, const unsigned int version);
+    };
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsNCG::Method& method);
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsNCG& options);
+
+    struct OptimizerStatusNCG : public OptimizerStatus
+    {
+      std::size_t numRestarts = 0; /// \brief Number of restarts with the steepest descent direction
+     private:
+      void resetImplementation() override { numRestarts = 0; }
+    };
+
+    /**
+     * \class OptimizerNCG
+     *
+     * Nonlinear conjugate gradient implementation for the ASLAM framework.
+     * Only the current gradient and search direction are stored, so memory is O(numOptParameters).
+     * Supports the Polak-Ribiere+ and the Hager-Zhang update (Hager and Zhang, "A new conjugate gradient method with
+     * guaranteed descent and an efficient line search", 2005). The iteration is restarted with steepest descent
+     * periodically, if consecutive gradients are far from orthogonal (Powell) or if the update is not a descent direction.
+     */
+    class OptimizerNCG : public OptimizerProblemManagerBase
+    {
+     public:
+      typedef boost::shared_ptr<OptimizerNCG> Ptr;
+      typedef boost::shared_ptr<const OptimizerNCG> ConstPtr;
+      typedef OptimizerOptionsNCG Options;
+      typedef OptimizerStatusNCG Status;
+
+     public:
+      /// \brief Constructor with default options
+      OptimizerNCG();
+      /// \brief Constructor with custom options
+      OptimizerNCG(const Options& options);
+      /// \brief Constructor from property tree
+      OptimizerNCG(const sm::PropertyTree& config);
+      /// \brief Destructor
+      ~OptimizerNCG() override;
+
+      /// \brief Return the status
+      const Status& getStatus() const override { return _status; }
+
+      /// \brief Get the optimizer options.
+      const Options& getOptions() const override { return _options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const Options& options) { _options = options; _linesearch.options() = _options.linesearch; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const OptimizerOptionsBase& options) override { static_cast<OptimizerOptionsBase&>(_options) = options; }
+
+      /// \brief Const getter for the linesearch object
+      const LineSearch& getLineSearch() const { return _linesearch; }
+
+    private:
+
+      /// \brief Run the optimization
+      void optimizeImplementation() override;
+
+      /// \brief Reset information
+      void resetImplementation() override;
+
+      /// \brief Update the status
+      void updateStatus(bool lineSearchSuccess);
+
+      /// \brief Computes the conjugate direction update factor beta
+      double computeBeta(const RowVectorType& gfkp1, const RowVectorType& gfk, const RowVectorType& pk) const;
+
+    private:
+
+      /// \brief the current set of options
+      Options _options;
+
+      /// \brief Line-search class
+      LineSearch _linesearch;
+
+      /// \brief Status of the optimizer
+      Status _status;
+
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#include "implementation/OptimizerNCGImpl.hpp"
+
+#endif /* ASLAM_BACKEND_OPTIMIZER_NCG_HPP */
@@ -0,0 +1,186 @@
+#ifndef ASLAM_BACKEND_OPTIMIZER_OWLQN_HPP
+#define ASLAM_BACKEND_OPTIMIZER_OWLQN_HPP
+
+#include <aslam/backend/util/OptimizerProblemManagerBase.hpp>
+
+namespace sm {
+  class PropertyTree;
+}
+
+namespace aslam {
+  namespace backend {
+
+    struct OptimizerOptionsOWLQN : public OptimizerOptionsBase
+    {
+      OptimizerOptionsOWLQN();
+      OptimizerOptionsOWLQN(const sm::PropertyTree& config);
+      bool useDenseJacobianContainer = true; /// \brief Whether or not to use a dense Jacobian container
+      int historySize = 10; /// \brief Number of correction pairs used to approximate the inverse Hessian of the smooth part
+      double armijoFactor = 1e-4; /// \brief Sufficient decrease parameter of the backtracking line search
+      double backtrackingFactor = 0.5; /// \brief The step length is multiplied by this factor after every rejected trial step
+      int maxBacktrackingSteps = 30; /// \brief The line search fails after this number of rejected trial steps
+      boost::shared_ptr<ScalarNonSquaredErrorTerm> regularizer = NULL; /// \brief Regularizer, has to implement the L1NormInterface
+
+      void check() const override;
+
+      template<class Archive>
+      inline void serialize(Archive & ar, const unsigned int version);
+    };
+
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsOWLQN& options);
+
+    struct OptimizerStatusOWLQN : public OptimizerStatus
+    {
+      std::size_t numL1Parameters = 0; /// \brief Number of parameters with an L1 weight
+      std::size_t numZeroParameters = 0; /// \brief Number of parameters with an L1 weight that are exactly zero
+      std::size_t numBacktrackingSteps = 0; /// \brief Accumulated number of rejected trial steps of the line search
+     private:
+      void resetImplementation() override { numL1Parameters = 0; numZeroParameters = 0; numBacktrackingSteps = 0; }
+    };
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerStatusOWLQN& status);
+
+    /**
+     * \class OptimizerOWLQN
+     *
+     * Orthant-wise limited-memory quasi-Newton optimizer (Andrew and Gao, "Scalable Training of L1-Regularized
+     * Log-Linear Models", 2007) for problems of the form \f$ f(\mathbf x) + \sum_i w_i |x_i| \f$.
+     *
+     * The L1 terms are the non-squared error terms of the problem implementing the L1NormInterface and the
+     * optional regularizer of the options. All other error terms form the smooth part \f$ f \f$, which is
+     * evaluated through the ProblemManager. The L-BFGS direction is computed from the pseudo-gradient of the
+     * objective and constrained to its orthant, and the trial steps of the backtracking line search are
+     * projected onto that orthant. Parameters crossing zero are therefore set to exactly zero instead of
+     * zigzagging around it, and the L-BFGS history only models the smooth part.
+     *
+     * The design variable scaling is ignored, the state updates are applied in parameter space.
+     */
+    class OptimizerOWLQN : public OptimizerProblemManagerBase
+    {
+     public:
+      typedef boost::shared_ptr<OptimizerOWLQN> Ptr;
+      typedef boost::shared_ptr<const OptimizerOWLQN> ConstPtr;
+      typedef OptimizerOptionsOWLQN Options;
+      typedef OptimizerStatusOWLQN Status;
+
+     public:
+      /// \brief Constructor with default options
+      OptimizerOWLQN();
+      /// \brief Constructor with custom options
+      OptimizerOWLQN(const Options& options);
+      /// \brief Constructor from property tree
+      OptimizerOWLQN(const sm::PropertyTree& config);
+      /// \brief Destructor
+      ~OptimizerOWLQN() override;
+
+      /// \brief Return the status
+      const Status& getStatus() const override { return _status; }
+
+      /// \brief Get the optimizer options.
+      const Options& getOptions() const override { return _options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const Options& options) { options.check(); _options = options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const OptimizerOptionsBase& options) override { static_cast<OptimizerOptionsBase&>(_options) = options; }
+
+      /// \brief Number of correction pairs currently stored
+      std::size_t getHistorySize() const { return _numPairs; }
+
+    private:
+
+      /// \brief Run the optimization
+      void optimizeImplementation() override;
+
+      /// \brief Reset information
+      void resetImplementation() override;
+
+      /// \brief Collects the L1 weights per parameter and the error term indices of the smooth part
+      void initializeL1Terms();
+
+      /// \brief Adds the L1 weight of \p e to its design variables
+      void addL1Term(const ScalarNonSquaredErrorTerm& e, double weight);
+
+      /// \brief Reads the current values of the parameters with an L1 weight into _x
+      void readL1Parameters();
+
+      /// \brief Evaluates the smooth part of the objective
+      double evaluateSmoothError();
+
+      /// \brief Computes the gradient of the smooth part of the objective into \p outGrad
+      void computeSmoothGradient(RowVectorType& outGrad);
+
+      /// \brief The L1 part of the objective at _x
+      double evaluateL1Error() const;
+
+      /// \brief Computes the pseudo-gradient, the minimum norm subgradient of the objective
+      void computePseudoGradient(const RowVectorType& gradient, RowVectorType& outPseudoGradient) const;
+
+      /// \brief Compute the search direction -H_k * pseudoGradient with the two-loop recursion
+      void computeSearchDirection(const RowVectorType& pseudoGradient, RowVectorType& outDirection);
+
+      /// \brief Backtracking line search along \p direction projected onto the orthant \p orthant. On success, the
+      ///        design variables, _x and \p inOutError are at the accepted point and \p outStep is the applied step.
+      bool lineSearch(const RowVectorType& direction, const RowVectorType& pseudoGradient, const Eigen::VectorXd& orthant,
+                      double initialStepLength, double& inOutError, RowVectorType& outStep);
+
+      /// \brief Applies the step to the design variables without design variable scaling
+      void applyStep(const RowVectorType& step);
+
+      /// \brief Store a correction pair, dropping the oldest one if the history is full
+      void addCorrectionPair(const RowVectorType& sk, const RowVectorType& yk);
+
+      /// \brief Drop all stored correction pairs
+      void clearHistory();
+
+      /// \brief Update the status
+      void updateStatus(bool lineSearchSuccess);
+
+    private:
+
+      /// \brief the current set of options
+      Options _options;
+
+      /// \brief L1 weight of every parameter, zero for the smooth parameters
+      Eigen::VectorXd _l1Weights;
+
+      /// \brief Columns of the parameters with an L1 weight and their design variables
+      std::vector<std::size_t> _l1Columns;
+      std::vector<DesignVariable*> _l1DesignVariables;
+
+      /// \brief Current value of every parameter with an L1 weight, zero for the smooth parameters
+      Eigen::VectorXd _x;
+
+      /// \brief Indices of the error terms of the smooth part (see ProblemManager::evaluateError()), i.e. of all
+      ///        error terms not implementing L1NormInterface. Empty only if every error term is an L1 term.
+      std::vector<std::size_t> _smoothErrorTerms;
+
+      /// \brief Per thread gradient accumulators of the smooth part
+      std::vector<RowVectorType> _threadGradients;
+
+      /// \brief Ring buffer of the last parameter differences s_i, one per column
+      Eigen::MatrixXd _S;
+
+      /// \brief Ring buffer of the last gradient differences y_i of the smooth part, one per column
+      Eigen::MatrixXd _Y;
+
+      /// \brief 1 / (y_i^T s_i) for the stored pairs
+      Eigen::VectorXd _rho;
+
+      /// \brief Column of the oldest stored pair
+      std::size_t _firstPair = 0;
+
+      /// \brief Number of stored pairs
+      std::size_t _numPairs = 0;
+
+      /// \brief Status of the optimizer
+      Status _status;
+
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#include "implementation/OptimizerOWLQNImpl.hpp"
+
+#endif /* ASLAM_BACKEND_OPTIMIZER_OWLQN_HPP */
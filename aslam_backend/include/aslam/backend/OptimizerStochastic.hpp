@@ -0,0 +1,168 @@
+#ifndef ASLAM_BACKEND_OPTIMIZER_STOCHASTIC_HPP
+#define ASLAM_BACKEND_OPTIMIZER_STOCHASTIC_HPP
+
+#include <random>
+
+#include <aslam/backend/util/OptimizerProblemManagerBase.hpp>
+
+namespace sm {
+  class PropertyTree;
+}
+
+namespace aslam {
+  namespace backend {
+
+    struct OptimizerOptionsStochastic : public OptimizerOptionsBase
+    {
+      enum Method { SGD_MOMENTUM, ADAM, SVRG };
+
+      OptimizerOptionsStochastic();
+      OptimizerOptionsStochastic(const sm::PropertyTree& config);
+      Method method = ADAM; /// \brief Update rule
+      std::size_t batchSize = 64; /// \brief Number of error terms per mini-batch
+      double learningRate = 1e-3; /// \brief Step size
+      double learningRateDecay = 0.0; /// \brief The step size in epoch k is learningRate / (1 + learningRateDecay * k)
+      double momentum = 0.9; /// \brief Momentum of SGD_MOMENTUM
+      double beta1 = 0.9; /// \brief Decay rate of the first moment estimate of ADAM
+      double beta2 = 0.999; /// \brief Decay rate of the second moment estimate of ADAM
+      double epsilon = 1e-8; /// \brief Denominator offset of ADAM
+      unsigned int seed = 0; /// \brief Seed of the mini-batch sampler
+      bool useDenseJacobianContainer = true; /// \brief Whether or not to use a dense Jacobian container for non-squared error terms
+      boost::shared_ptr<OptimizerBase> polishingOptimizer; /// \brief If set, this optimizer is run on the problem after the stochastic phase, e.g. an Optimizer2
+
+      void check() const override;
+
+      template<class Archive>
+      inline void serialize(Archive & ar, const unsigned int version);
+    };
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsStochastic::Method& method);
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsStochastic& options);
+
+    struct OptimizerStatusStochastic : public OptimizerStatus
+    {
+      std::size_t numBatches = 0; /// \brief Number of mini-batch steps
+      std::size_t numErrorTermGradients = 0; /// \brief Number of single error term gradients evaluated, including full gradients
+      double termsPerSecond = 0.0; /// \brief Throughput of the mini-batch steps in error term gradients per second
+      std::size_t numPolishingIterations = 0; /// \brief Iterations of the polishing optimizer
+     private:
+      void resetImplementation() override { numBatches = 0; numErrorTermGradients = 0; termsPerSecond = 0.0; numPolishingIterations = 0; }
+    };
+    std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerStatusStochastic& status);
+
+    /**
+     * \class OptimizerStochastic
+     *
+     * First order optimizer working on randomly sampled mini-batches of error terms.
+     * Every epoch visits all error terms once in random order. One iteration is one epoch, after which the full
+     * error and gradient are evaluated for the convergence checks.
+     * Supports SGD with momentum, Adam (Kingma and Ba, "Adam: A Method for Stochastic Optimization", 2015) and
+     * SVRG (Johnson and Zhang, "Accelerating Stochastic Gradient Descent using Predictive Variance Reduction", 2013),
+     * which uses the full gradient of every epoch as snapshot.
+     * The mini-batch gradients are scaled by numErrorTerms / batchSize to estimate the full gradient.
+     */
+    class OptimizerStochastic : public OptimizerProblemManagerBase
+    {
+     public:
+      typedef boost::shared_ptr<OptimizerStochastic> Ptr;
+      typedef boost::shared_ptr<const OptimizerStochastic> ConstPtr;
+      typedef OptimizerOptionsStochastic Options;
+      typedef OptimizerStatusStochastic Status;
+
+     public:
+      /// \brief Constructor with default options
+      OptimizerStochastic();
+      /// \brief Constructor with custom options
+      OptimizerStochastic(const Options& options);
+      /// \brief Constructor from property tree
+      OptimizerStochastic(const sm::PropertyTree& config);
+      /// \brief Destructor
+      ~OptimizerStochastic() override;
+
+      /// \brief Return the status
+      const Status& getStatus() const override { return _status; }
+
+      /// \brief Get the optimizer options.
+      const Options& getOptions() const override { return _options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const Options& options) { options.check(); _options = options; }
+
+      /// \brief Set the optimizer options.
+      void setOptions(const OptimizerOptionsBase& options) override { static_cast<OptimizerOptionsBase&>(_options) = options; }
+
+    private:
+
+      /// \brief Run the optimization
+      void optimizeImplementation() override;
+
+      /// \brief Reset information
+      void resetImplementation() override;
+
+      /// \brief Evaluates the full error and gradient into the status and _fullGradient
+      void evaluateFull();
+
+      /// \brief Computes the scaled gradient of the current batch into \p outGrad
+      void computeBatchGradient(RowVectorType& outGrad);
+
+      /// \brief Computes the scaled gradient of the current batch at the SVRG snapshot into \p outGrad
+      void computeSnapshotBatchGradient(RowVectorType& outGrad);
+
+      /// \brief Computes the update _dx from the batch gradient
+      void computeStep(const RowVectorType& gradient, double learningRate);
+
+      /// \brief Runs the polishing optimizer
+      void polish();
+
+    private:
+
+      /// \brief the current set of options
+      Options _options;
+
+      /// \brief Status of the optimizer
+      Status _status;
+
+      /// \brief Random number generator of the sampler
+      std::mt19937 _rng;
+
+      /// \brief Permutation of the error term indices of the current epoch
+      std::vector<std::size_t> _permutation;
+
+      /// \brief Error term indices of the current batch
+      std::vector<std::size_t> _batch;
+
+      /// \brief Per thread gradient accumulators
+      std::vector<RowVectorType> _threadGradients;
+
+      /// \brief Full gradient at the last evaluation, the SVRG snapshot gradient
+      RowVectorType _fullGradient;
+
+      /// \brief Batch gradients at the current state and at the snapshot
+      RowVectorType _batchGradient, _snapshotBatchGradient;
+
+      /// \brief First (momentum) and second moment estimates
+      RowVectorType _m, _v;
+
+      /// \brief State update
+      ColumnVectorType _dx;
+
+      /// \brief Number of ADAM steps for the bias correction
+      std::size_t _numAdamSteps = 0;
+
+      /// \brief Accumulated time and error term gradients of the mini-batch steps for the throughput
+      double _batchSeconds = 0.0;
+      std::size_t _batchTermGradients = 0;
+
+      /// \brief SVRG snapshot and temporary storage of the design variable parameters, indexed by block index
+      std::vector<Eigen::MatrixXd> _snapshotParameters, _currentParameters;
+
+      /// \brief Design variables touched by the current batch and a flag per block index to remove duplicates
+      std::vector<DesignVariable*> _batchDesignVariables;
+      std::vector<char> _isBatchDesignVariable;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#include "implementation/OptimizerStochasticImpl.hpp"
+
+#endif /* ASLAM_BACKEND_OPTIMIZER_STOCHASTIC_HPP */
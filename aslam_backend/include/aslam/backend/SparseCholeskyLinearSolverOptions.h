@@ -33,6 +33,13 @@ namespace aslam {
       */
     class SparseCholeskyLinearSolverOptions {
     public:
+      /// The index type of the sparse matrices
+      enum IndexType {
+        INDEX_AUTOMATIC, ///< int, or SuiteSparse_long if J^T has too many nonzeros for int
+        INDEX_INT, ///< int (cholmod_*)
+        INDEX_LONG ///< SuiteSparse_long (cholmod_l_*)
+      };
+
       /** \name Constructors/destructor
         @{
         */
@@ -49,6 +56,14 @@ namespace aslam {
       /** @}
         */
 
+      /** \name Members
+        @{
+        */
+      /// Index type of the Jacobian and the factorization
+      IndexType indexType;
+      /** @}
+        */
+
     };
 
   }
@@ -23,6 +23,14 @@ namespace aslam {
 
       void buildSystem(size_t nThreads, bool useMEstimator) override;
       bool solveSystem(Eigen::VectorXd& outDx) override;
+      /// \brief back-substitution with the factorization of the last solveSystem() call
+      bool solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx) override;
+      /// \brief solve the systems of the conditioners concurrently. Every thread factors its own copy of the augmented
+      ///        Jacobian transpose with a copy of the symbolic analysis, the memory of the system is needed once per thread.
+      void solveSystems(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx) override;
+
+      bool multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const override;
+      bool multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const override;
 
       /// Returns the options
       const SparseCholeskyLinearSolverOptions& getOptions() const;
@@ -32,6 +40,12 @@ namespace aslam {
       void setOptions(const SparseCholeskyLinearSolverOptions& options);
 
       std::string name() const override {  return "sparse_cholesky"; };        
+
+      bool supportsLazyJacobian() const override { return true; }
+
+      /// Returns true if the Jacobian and the factorization use SuiteSparse_long indices
+      bool isUsingLongIndices() const { return _useLongIndices; }
+
       /// Helper Function for DogLeg implementation; returns parts required for the steepest descent solution
       double rhsJtJrhs() override;
    
@@ -40,9 +54,28 @@ namespace aslam {
       void initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner) override;
       void handleNewAcceptConstantErrorTerms() override;
 
+      /// \brief Frees the factor with the cholmod instance that allocated it.
+      void freeFactor();
+
+      /// \brief Returns the Jacobian builder / cholmod wrapper for the index type I.
+      template<typename I> CompressedColumnJacobianTransposeBuilder<I>& jacobianBuilder();
+      template<typename I> Cholmod<I>& cholmod();
+
+      template<typename I> void initCholmodViews();
+      template<typename I> void buildSystemImplementation(size_t nThreads, bool useMEstimator);
+      template<typename I> bool solveSystemImplementation(Eigen::VectorXd& outDx);
+      template<typename I> double rhsJtJrhsImplementation();
+      template<typename I> bool solveSystemWithRhsImplementation(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx);
+      template<typename I> void solveSystemsImplementation(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx);
+
+      /// \brief Only one of the builders is initialized, depending on _useLongIndices.
       CompressedColumnJacobianTransposeBuilder<int> _jacobianBuilder;
+      CompressedColumnJacobianTransposeBuilder<SuiteSparse_long> _jacobianBuilderLong;
 
-      Cholmod<> _cholmod;
+      Cholmod<int> _cholmod;
+      Cholmod<SuiteSparse_long> _cholmodLong;
+      /// \brief Use SuiteSparse_long instead of int indices
+      bool _useLongIndices;
       cholmod_sparse _cholmodLhs;
       cholmod_dense  _cholmodRhs;
       cholmod_factor* _factor;
@@ -25,11 +25,18 @@ namespace aslam {
       // virtual void evaluateError(size_t nThreads, bool useMEstimator);
       void buildSystem(size_t nThreads, bool useMEstimator) override;
       bool solveSystem(Eigen::VectorXd& outDx) override;
+      /// \brief solve the least squares problem of the last solveSystem() call for the error vector e
+      bool solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx) override;
+
+      bool multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const override;
+      bool multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const override;
       // virtual void solveConstantAugmentedSystem(double diagonalConditioner, Eigen::VectorXd & outDx);
       // virtual void solveAugmentedSystem(const Eigen::VectorXd & diagonalConditioner, Eigen::VectorXd & outDx);
 
       std::string name() const override { return "sparse_qr"; }
 
+      bool supportsLazyJacobian() const override { return true; }
+
       /// Returns the current Jacobian transpose
       const CompressedColumnMatrix<index_t>& getJacobianTranspose() const;
       /// Returns the current estimated numerical rank
@@ -66,6 +73,8 @@ namespace aslam {
       Cholmod<index_t> _cholmod;
       cholmod_sparse _cholmodLhs;
       cholmod_dense  _cholmodRhs;
+      /// \brief The error vector padded with zeros for the rows of the augmented diagonal
+      Eigen::VectorXd _eAugmented;
 #ifndef QRSOLVER_DISABLED
       SuiteSparseQR_factorization<double>* _factor;
       CompressedColumnMatrix<index_t> _R;
@@ -3,6 +3,7 @@
 
 #include <aslam/backend/LinearSystemSolver.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include "Optimizer2Options.hpp"
 #include <sm/eigen/assert_macros.hpp>
 #include <aslam/Exceptions.hpp>
@@ -13,11 +14,20 @@ namespace aslam {
         class TrustRegionPolicy
         {
         public:
+            /// \brief Applies a step in solver coordinates to the design variables
+            typedef boost::function<void(const Eigen::VectorXd&)> StateUpdateFunction;
+            /// \brief Evaluates the error at the current state into the solver's error vector
+            typedef boost::function<void()> ErrorEvaluationFunction;
+
             TrustRegionPolicy();
             virtual ~TrustRegionPolicy();
             
             /// \brief called by the optimizer when an optimization is starting
             virtual void optimizationStarting(double J);
+
+            /// \brief called by the optimizer when the design variables of the linear system changed during an optimization.
+            ///        The next solveSystem() call linearizes anew like the first iteration, the step size state is kept.
+            virtual void structureChanged();
             
             /// \brief Returns true if the solution was successful
             virtual bool solveSystem(double J, bool previousIterationFailed, int nThreads, Eigen::VectorXd& outDx);
@@ -35,6 +45,28 @@ namespace aslam {
             virtual std::ostream & printState(std::ostream & out) const = 0;
             virtual std::string name() const = 0;
             virtual bool requiresAugmentedDiagonal() const = 0;
+
+            /// \brief The number of candidate steps per linearization. Candidate 0 is the step of solveSystem(). If it is
+            ///        rejected, the optimizer evaluates the further candidates and continues with the best one.
+            virtual size_t numCandidates() const { return 1; }
+
+            /// \brief Solve for the candidates 1 .. numCandidates() - 1 at once reusing the linear system built by the last
+            ///        solveSystem() call, with up to nThreads threads. outDx[i - 1] receives the step of candidate i and is left
+            ///        empty if its solution failed.
+            virtual void solveCandidates(int /* nThreads */, std::vector<Eigen::VectorXd>& outDx) { outDx.clear(); }
+
+            /// \brief Continue from candidate i, either because it was accepted or because it was the last one rejected.
+            virtual void selectCandidate(size_t /* i */) { }
+
+            /// \brief Set by the optimizer to let the policy probe the error at trial states. The revert function
+            ///        receives the step passed to the last apply call. The probe steps are not reported to the solver
+            ///        via LinearSystemSolver::notifyStateUpdate(), so they do not trigger lazy Jacobian refreshes. The
+            ///        evaluation function counts as an error evaluation of the optimizer.
+            void setStateUpdateFunctions(const StateUpdateFunction& apply, const StateUpdateFunction& revert, const ErrorEvaluationFunction& evaluateError) {
+              _applyStateUpdate = apply;
+              _revertStateUpdate = revert;
+              _evaluateError = evaluateError;
+            }
         protected:
             double get_dJ();
             bool isFirstIteration(){ return _isFirstIteration; }
@@ -46,6 +78,11 @@ namespace aslam {
             virtual bool solveSystemImplementation(double J, bool previousIterationFailed, int nThreads, Eigen::VectorXd& outDx) = 0;
 
             boost::shared_ptr<LinearSystemSolver> _solver;
+
+            /// \brief State update functions provided by the optimizer, may be empty
+            StateUpdateFunction _applyStateUpdate;
+            StateUpdateFunction _revertStateUpdate;
+            ErrorEvaluationFunction _evaluateError;
             
         private:
             /// \brief the linear system solver.
@@ -60,6 +60,9 @@ namespace aslam {
       static int free_factor(cholmod_factor** A, cholmod_common* c) {
         return cholmod_free_factor(A, c);
       }
+      static cholmod_factor* copy_factor(cholmod_factor* L, cholmod_common* c) {
+        return cholmod_copy_factor(L, c);
+      }
       static void* free(size_t n, size_t size, void* p, cholmod_common* c) {
         return cholmod_free(n, size, p, c);
       }
@@ -107,6 +110,9 @@ namespace aslam {
       static int free_factor(cholmod_factor** A, cholmod_common* c) {
         return cholmod_l_free_factor(A, c);
       }
+      static cholmod_factor* copy_factor(cholmod_factor* L, cholmod_common* c) {
+        return cholmod_l_copy_factor(L, c);
+      }
       static void* free(size_t n, size_t size, void* p, cholmod_common* c) {
         return cholmod_l_free(n, size, p, c);
       }
@@ -245,6 +251,15 @@ namespace aslam {
 #endif
 
 
+    template<typename I>
+    cholmod_factor* Cholmod<I>::copy(cholmod_factor* L)
+    {
+      SM_ASSERT_TRUE(Exception, L != NULL, "Null input");
+      cholmod_factor* factor = CholmodIndexTraits<index_t>::copy_factor(L, &_cholmod);
+      SM_ASSERT_FALSE(Exception, factor == NULL, "cholmod_copy_factor returned a null factor");
+      return factor;
+    }
+
     template<typename I>
     void Cholmod<I>::free(cholmod_factor* factor)
     {
@@ -398,6 +413,13 @@ namespace aslam {
       return NULL;
     }
 
+    template<typename I>
+    cholmod_dense* Cholmod<I>::solve(cholmod_factor* L, cholmod_dense* b)
+    {
+      SM_ASSERT_TRUE(Exception, L != NULL, "Null input");
+      return CholmodIndexTraits<index_t>::solve(CHOLMOD_A, L, b, &_cholmod);
+    }
+
 
 #ifndef QRSOLVER_DISABLED
     template<typename I>
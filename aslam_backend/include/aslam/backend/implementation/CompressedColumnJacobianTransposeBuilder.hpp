@@ -1,66 +1,88 @@
 #include <aslam/backend/CompressedColumnJacobianTransposeBuilder.hpp>
+#include <aslam/backend/util/CommonDefinitions.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
+#include <aslam/backend/ErrorTermBatch.hpp>
 
 #include <future>
+#include <limits>
+#include <numeric>
 
 namespace aslam {
   namespace backend {
 
-    template<typename I>
-    CompressedColumnJacobianTransposeBuilder<I>::CompressedColumnJacobianTransposeBuilder() : _isInitialized(false)
+    template<typename I, typename V>
+    CompressedColumnJacobianTransposeBuilder<I, V>::CompressedColumnJacobianTransposeBuilder() : _isInitialized(false), _mEstimatorWeightThreshold(0.0), _numSkippedJacobians(0)
     {
     }
 
-    template<typename I>
-    CompressedColumnJacobianTransposeBuilder<I>::~CompressedColumnJacobianTransposeBuilder()
+    template<typename I, typename V>
+    CompressedColumnJacobianTransposeBuilder<I, V>::~CompressedColumnJacobianTransposeBuilder()
     {
     }
 
 
-    template<typename I>
-    void CompressedColumnJacobianTransposeBuilder<I>::initMatrixStructure(const std::vector<DesignVariable*> & dvs, const std::vector<ErrorTerm*> & errors)
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::initMatrixStructure(const std::vector<DesignVariable*> & dvs, const std::vector<ErrorTerm*> & errors, size_t nThreads)
     {
+      initMatrixStructure(computeStructure(dvs, errors, nThreads), errors, nThreads);
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::initMatrixStructure(const JacobianTransposeStructure& structure, const std::vector<ErrorTerm*> & errors, size_t nThreads)
+    {
+      typedef typename CompressedColumnMatrix<I, V>::Exception Exception;
+      SM_ASSERT_EQ(Exception, structure.offsets.size(), errors.size(), "The structure does not belong to the error terms");
+      const size_t nnz = structure.numNonZeros();
+      SM_ASSERT_LE(Exception, nnz, (size_t)std::numeric_limits<I>::max(),
+                   "The Jacobian has too many nonzeros for the index type. Use 64 bit indices.");
       _jacobianPointers.clear();
       _jacobianPointers.resize(errors.size());
       _J_transpose.clear();
       _J.reset();
-      size_t nnz = 0;
-      size_t num_cols = 0;
-      std::vector<ErrorTerm*>::const_iterator eit = errors.begin();
-      for (; eit != errors.end(); ++eit) {
-        size_t D = (*eit)->dimension();
-        num_cols += D;
-        const std::vector<DesignVariable*> & dxx = (*eit)->designVariables();
-        //std::cout << "Error term with dimension " << D << " and " << dxx.size() << " dvs " << std::endl;
-        std::vector<DesignVariable*>::const_iterator dit = dxx.begin();
-        for (; dit != dxx.end(); ++dit) {
-          nnz += D * (*dit)->minimalDimensions();
+      nThreads = std::max<size_t>(1, nThreads);
+
+      Timer symbolicTimer("CompressedColumnJacobianTransposeBuilder: Initialize---Symbolic");
+      _J_transpose.resizeSymbolic(structure.rows, structure.total.cols, structure.total.nnz, nnz);
+      const std::vector<JacobianTransposeBlockSize>& offsets = structure.offsets;
+      util::runThreadedJob([this, &errors, &offsets](size_t /* threadId */, size_t startIdx, size_t endIdx) {
+        for (size_t i = startIdx; i < endIdx; ++i) {
+          ErrorTerm* e = errors[i];
+          // The columns of J^T are the rows of J
+          _jacobianPointers[i].set(_J_transpose.setJacobiansSymbolic(offsets[i].cols, offsets[i].nnz, e->dimension(), e->designVariables()), e, offsets[i].cols);
         }
-      }
-      // Add room for a diagonal
-      nnz += dvs.back()->columnBase() + dvs.back()->minimalDimensions();
-      // std::cout << "Matrix storage: " << ((double)nnz * 64.0 * 1e-9) << " GB\n";
-      // Initialize the matrix to be the right size.
-      _J_transpose.init(dvs.back()->columnBase() + dvs.back()->minimalDimensions(), 0, nnz, num_cols);
-      std::vector<ErrorTerm*>::const_iterator it = errors.begin();
-      int i = 0;
-      size_t eRow = 0;
-      for (; it != errors.end(); ++it) {
-        _jacobianPointers[i++].set(_J_transpose.appendErrorJacobiansSymbolic(*(*it)), *it, eRow);
-        //std::cout << "Error " << i << "/" << errors.size() << ", Jacobian has " << ((double)_J_transpose.values().size() * (double)64 * (1e-9))  << " GB of data\n";
-        eRow += (*it)->dimension();
-      }
-      //_e.resize(eRow);
+      }, errors.size(), nThreads);
+      symbolicTimer.stop();
       _isInitialized = true;
     }
 
 
+    template<typename I, typename V>
+    JacobianTransposeStructure CompressedColumnJacobianTransposeBuilder<I, V>::computeStructure(const std::vector<DesignVariable*> & dvs, const std::vector<ErrorTerm*> & errors, size_t nThreads)
+    {
+      Timer countTimer("CompressedColumnJacobianTransposeBuilder: Initialize---Count nonzeros");
+      JacobianTransposeStructure structure;
+      structure.total = util::runThreadedExclusiveScan([&errors](size_t i) {
+        JacobianTransposeBlockSize size;
+        size.cols = errors[i]->dimension();
+        for (const DesignVariable* dv : errors[i]->designVariables()) {
+          if (dv->isActive())
+            size.nnz += size.cols * dv->minimalDimensions();
+        }
+        return size;
+      }, errors.size(), std::max<size_t>(1, nThreads), structure.offsets);
+      // The room for a diagonal block takes one nonzero per row
+      structure.rows = dvs.back()->columnBase() + dvs.back()->minimalDimensions();
+      countTimer.stop();
+      return structure;
+    }
 
-    template<typename I>
-    template<typename MEMBER_FUNCTION_PTR>
-    void CompressedColumnJacobianTransposeBuilder<I>::setupThreadedJob(MEMBER_FUNCTION_PTR ptr, size_t nThreads, bool useMEstimator)
+    template<typename I, typename V>
+    template<typename JOB>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::setupThreadedJob(const JOB& job, size_t nThreads)
     {
       if (nThreads <= 1) {
-        (this->*ptr)(0, 0, _jacobianPointers.size(), useMEstimator);
+        job(0, 0, _jacobianPointers.size());
       } else {
         nThreads = std::min(nThreads, _jacobianPointers.size());
         // Give some error terms to each thread.
@@ -75,8 +97,8 @@ namespace aslam {
         jobs.reserve(nThreads);
         for (unsigned i = 0; i < nThreads; ++i) {
           jobs.push_back(std::async(
-              std::launch::async, [this, ptr, i, &indices, useMEstimator]() {
-                (this->*ptr)(i, indices[i], indices[i + 1], useMEstimator);
+              std::launch::async, [&job, i, &indices]() {
+                job(i, indices[i], indices[i + 1]);
               }));
         }
         for (auto& j : jobs) {
@@ -87,23 +109,95 @@ namespace aslam {
 
 
     /// \brief build the large, sparse internal Jacobian matrix from the error terms.
-    template<typename I>
-    void CompressedColumnJacobianTransposeBuilder<I>::buildSystem(size_t nThreads, bool useMEstimator)
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::buildSystem(size_t nThreads, bool useMEstimator)
+    {
+      _isJacobianBuiltFromJacobianTranspose = false;
+      std::vector<size_t> numSkipped(std::max<size_t>(1, nThreads), 0);
+      setupThreadedJob([this, useMEstimator, &numSkipped](int threadId, int startIdx, int endIdx) {
+        numSkipped[threadId] = evaluateJacobians(threadId, startIdx, endIdx, useMEstimator, nullptr);
+      }, nThreads);
+      _numSkippedJacobians = std::accumulate(numSkipped.begin(), numSkipped.end(), size_t(0));
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::buildSystem(size_t nThreads, bool useMEstimator, const std::vector<char>& refreshErrorTerm)
     {
+      typedef typename CompressedColumnMatrix<I, V>::Exception Exception;
+      SM_ASSERT_EQ(Exception, refreshErrorTerm.size(), _jacobianPointers.size(), "There must be one refresh flag per error term");
       _isJacobianBuiltFromJacobianTranspose = false;
-      setupThreadedJob(&CompressedColumnJacobianTransposeBuilder::evaluateJacobians, nThreads, useMEstimator);
+      std::vector<size_t> numSkipped(std::max<size_t>(1, nThreads), 0);
+      setupThreadedJob([this, useMEstimator, &refreshErrorTerm, &numSkipped](int threadId, int startIdx, int endIdx) {
+        numSkipped[threadId] = evaluateJacobians(threadId, startIdx, endIdx, useMEstimator, &refreshErrorTerm);
+      }, nThreads);
+      _numSkippedJacobians = std::accumulate(numSkipped.begin(), numSkipped.end(), size_t(0));
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::broydenUpdate(size_t nThreads, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr)
+    {
+      typedef typename CompressedColumnMatrix<I, V>::Exception Exception;
+      SM_ASSERT_EQ(Exception, (size_t)dx.size(), _J_transpose.rows(), "The state update has the wrong size");
+      _isJacobianBuiltFromJacobianTranspose = false;
+      _numSkippedJacobians = 0;
+      setupThreadedJob([this, &dx, &dr](int threadId, int startIdx, int endIdx) {
+        broydenUpdateJacobians(threadId, startIdx, endIdx, dx, dr);
+      }, nThreads);
     }
 
 
     /// \brief a function to be run by a single thread.
-    template<typename I>
-    void CompressedColumnJacobianTransposeBuilder<I>::evaluateJacobians(int /* threadId */, int startIdx, int endIdx, bool useMEstimator)
+    template<typename I, typename V>
+    size_t CompressedColumnJacobianTransposeBuilder<I, V>::evaluateJacobians(int /* threadId */, int startIdx, int endIdx, bool useMEstimator, const std::vector<char>* refreshErrorTerm)
     {
-      Eigen::VectorXd ee;
-      for (int i = startIdx; i < endIdx; ++i) {
-        JacobianContainerSparse<Eigen::Dynamic> jc(_jacobianPointers[i].errorTerm->dimension());
-        _jacobianPointers[i].errorTerm->getWeightedJacobians(jc, useMEstimator);
+      const bool skipSmallWeights = useMEstimator && _mEstimatorWeightThreshold > 0.0;
+      size_t numSkipped = 0;
+      // Error terms that are not evaluated interrupt the runs of batch members
+      auto evaluatedErrorTerm = [&](size_t i) -> ErrorTerm* {
+        ErrorTerm* errorTerm = _jacobianPointers[i].errorTerm;
+        // The weight is up to date as the error is evaluated before the Jacobians
+        if ((refreshErrorTerm != nullptr && !(*refreshErrorTerm)[i])
+            || (skipSmallWeights && errorTerm->getCurrentMEstimatorWeight() < _mEstimatorWeightThreshold))
+          return nullptr;
+        return errorTerm;
+      };
+      for (int i = startIdx; i < endIdx; ) {
+        ErrorTerm* errorTerm = evaluatedErrorTerm(i);
+        if (errorTerm == nullptr) {
+          if (refreshErrorTerm == nullptr || (*refreshErrorTerm)[i]) {
+            _J_transpose.zeroJacobians(_jacobianPointers[i].jcp, _jacobianPointers[i].errorTerm->dimension());
+            numSkipped++;
+          }
+          ++i;
+          continue;
+        }
+        ErrorTermBatch* batch = errorTerm->batch();
+        if (batch != nullptr && batch->hasBatchJacobians()) {
+          // Write the Jacobians of the whole run directly into J^T
+          const int end = static_cast<int>(findBatchRunEnd(i, endIdx, evaluatedErrorTerm));
+          BatchJacobianWriter writer(*this, i, errorTerm->batchIndex());
+          batch->evaluateJacobians(errorTerm->batchIndex(), errorTerm->batchIndex() + (end - i), useMEstimator, writer);
+          i = end;
+          continue;
+        }
+        JacobianContainerSparse<Eigen::Dynamic> jc(errorTerm->dimension());
+        errorTerm->getWeightedJacobians(jc, useMEstimator);
         _J_transpose.writeJacobians(jc, _jacobianPointers[i].jcp);
+        ++i;
+      }
+      return numSkipped;
+    }
+
+
+    /// \brief a function to be run by a single thread.
+    template<typename I, typename V>
+    void CompressedColumnJacobianTransposeBuilder<I, V>::broydenUpdateJacobians(int /* threadId */, int startIdx, int endIdx, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr)
+    {
+      for (int i = startIdx; i < endIdx; ++i) {
+        const Evaluator& ev = _jacobianPointers[i];
+        _J_transpose.broydenUpdateJacobians(ev.jcp, ev.errorTerm->dimension(), dx, dr, ev.eRow);
       }
     }
 
@@ -134,22 +228,22 @@ namespace aslam {
 
 
     /// \brief Get a view of the transpose of the Jacobian as a cholmod sparse matrix.
-    template<typename I>
-    cholmod_sparse CompressedColumnJacobianTransposeBuilder<I>::getJacobianTransposeView()
+    template<typename I, typename V>
+    cholmod_sparse CompressedColumnJacobianTransposeBuilder<I, V>::getJacobianTransposeView()
     {
       return cholmod_sparse();
     }
 
     /// \brief Get a const version of the compressed column matrix.
-    template<typename I>
-    CompressedColumnMatrix<I> & CompressedColumnJacobianTransposeBuilder<I>::J_transpose()
+    template<typename I, typename V>
+    CompressedColumnMatrix<I, V> & CompressedColumnJacobianTransposeBuilder<I, V>::J_transpose()
     {
       return _J_transpose;
     }
 
     /// \brief Get a const version of the compressed column matrix.
-    template<typename I>
-    const CompressedColumnMatrix<I> & CompressedColumnJacobianTransposeBuilder<I>::J_transpose() const
+    template<typename I, typename V>
+    const CompressedColumnMatrix<I, V> & CompressedColumnJacobianTransposeBuilder<I, V>::J_transpose() const
     {
       return _J_transpose;
     }
@@ -14,26 +14,26 @@ namespace aslam {
 
 
 
-    template<typename I>
-    CompressedColumnMatrix<I>::~CompressedColumnMatrix()
+    template<typename I, typename V>
+    CompressedColumnMatrix<I, V>::~CompressedColumnMatrix()
     {
     }
 
     /// \brief initialize and set the potential number of nonzeros.
-    template<typename I>
-    CompressedColumnMatrix<I>::CompressedColumnMatrix(size_t rows, size_t cols, size_t nnz, size_t num_cols)
+    template<typename I, typename V>
+    CompressedColumnMatrix<I, V>::CompressedColumnMatrix(size_t rows, size_t cols, size_t nnz, size_t num_cols)
     {
       init(rows, cols, nnz, num_cols);
     }
 
-    template<typename I>
-    CompressedColumnMatrix<I>::CompressedColumnMatrix()
+    template<typename I, typename V>
+    CompressedColumnMatrix<I, V>::CompressedColumnMatrix()
     {
       init(0, 0, 0, 0);
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::init(size_t rows, size_t cols, size_t nnz, size_t num_cols)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::init(size_t rows, size_t cols, size_t nnz, size_t num_cols)
     {
       _rows = rows;
       _cols = cols;
@@ -45,8 +45,8 @@ namespace aslam {
     }
 
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::getView(cholmod_sparse* cs)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::getView(cholmod_sparse* cs)
     {
       if (!cs)
         return;
@@ -95,9 +95,9 @@ namespace aslam {
       //                   CHOLMOD_LONG:    p, i, and nz are SuiteSparse_long
       cs->itype = CholmodIndexTraits<I>::IType;
       // int xtype ;     pattern, real, complex, or zomplex
-      cs->xtype = CholmodValueTraits<double>::XType;
+      cs->xtype = CholmodValueTraits<V>::XType;
       // int dtype ;     x and z are double or float
-      cs->dtype = CholmodValueTraits<double>::DType;
+      cs->dtype = CholmodValueTraits<V>::DType;
       // int sorted ;  TRUE if columns are sorted, FALSE otherwise
       cs->sorted = 1;
       // int packed ;  TRUE if packed (nz ignored), FALSE if unpacked
@@ -107,15 +107,15 @@ namespace aslam {
 
 
     // /// \brief Return this matrix as a sparse Eigen matrix
-    // template<typename I>
-    // typename CompressedColumnMatrix<I>::eigen_sparse_t CompressedColumnMatrix<I>::asEigenMatrix()
+    // template<typename I, typename V>
+    // typename CompressedColumnMatrix<I, V>::eigen_sparse_t CompressedColumnMatrix<I, V>::asEigenMatrix()
     // {
     //     // \todo
     //     return Eigen::MappedCompressedColumnMatrix<value_t>();
     // }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::toDenseInto(Eigen::MatrixXd& outM) const
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::toDenseInto(Eigen::MatrixXd& outM) const
     {
       outM.resize(_rows, _cols);
       outM.setZero();
@@ -128,8 +128,8 @@ namespace aslam {
 
 
     /// \brief Clear all values in this matrix
-    template<typename I>
-    void CompressedColumnMatrix<I>::clear()
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::clear()
     {
       _values.clear();
       _row_ind.clear();
@@ -138,24 +138,24 @@ namespace aslam {
 
 
     /// \brief return the number of rows in this matrix
-    template<typename I>
-    size_t CompressedColumnMatrix<I>::rows() const
+    template<typename I, typename V>
+    size_t CompressedColumnMatrix<I, V>::rows() const
     {
       return _rows;
     }
 
 
     /// \brief return the number of columns in this matrix
-    template<typename I>
-    size_t CompressedColumnMatrix<I>::cols() const
+    template<typename I, typename V>
+    size_t CompressedColumnMatrix<I, V>::cols() const
     {
       return _cols;
     }
 
 
     /// \brief get the element at row r and column c
-    template<typename I>
-    double CompressedColumnMatrix<I>::value(size_t r, size_t c) const
+    template<typename I, typename V>
+    double CompressedColumnMatrix<I, V>::value(size_t r, size_t c) const
     {
       SM_ASSERT_LT(Exception, r, _rows, "Index out of bounds");
       SM_ASSERT_LT(Exception, c, _cols, "Index out of bounds");
@@ -164,8 +164,8 @@ namespace aslam {
 
 
     /// \brief get the element at row r and column c
-    template<typename I>
-    double CompressedColumnMatrix<I>::operator()(size_t r, size_t c) const
+    template<typename I, typename V>
+    double CompressedColumnMatrix<I, V>::operator()(size_t r, size_t c) const
     {
       SM_ASSERT_LT_DBG(Exception, r, _rows, "Index out of bounds");
       SM_ASSERT_LT_DBG(Exception, c, _cols, "Index out of bounds");
@@ -186,35 +186,35 @@ namespace aslam {
     }
 
 
-    template<typename I>
-    size_t CompressedColumnMatrix<I>::nnz() const
+    template<typename I, typename V>
+    size_t CompressedColumnMatrix<I, V>::nnz() const
     {
       return _values.size();
     }
 
     /// \brief Get the underlying values
-    template<typename I>
-    const std::vector<double>& CompressedColumnMatrix<I>::values() const
+    template<typename I, typename V>
+    const std::vector<V>& CompressedColumnMatrix<I, V>::values() const
     {
       return _values;
     }
 
     /// \brief Get the underlying row indices
-    template<typename I>
-    const std::vector<I>& CompressedColumnMatrix<I>::row_ind() const
+    template<typename I, typename V>
+    const std::vector<I>& CompressedColumnMatrix<I, V>::row_ind() const
     {
       return _row_ind;
     }
 
     /// \brief Get the underlying column pointers
-    template<typename I>
-    const std::vector<I>& CompressedColumnMatrix<I>::col_ptr() const
+    template<typename I, typename V>
+    const std::vector<I>& CompressedColumnMatrix<I, V>::col_ptr() const
     {
       return _col_ptr;
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::appendJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::appendJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc)
     {
       std::vector<DesignVariable*> dvs;
       auto it = jc.begin();
@@ -225,22 +225,63 @@ namespace aslam {
       writeJacobians(jc, jcp);
     }
 
-    template<typename I>
-    JacobianColumnPointer CompressedColumnMatrix<I>::appendErrorJacobiansSymbolic(const ErrorTerm& e)
+    template<typename I, typename V>
+    JacobianColumnPointer CompressedColumnMatrix<I, V>::appendErrorJacobiansSymbolic(const ErrorTerm& e)
     {
       return appendJacobiansSymbolic(e.dimension(), e.designVariables());
     }
 
     /// \brief Adds the Jacobians to the right of this matrix
-    template<typename I>
-    JacobianColumnPointer CompressedColumnMatrix<I>::appendJacobiansSymbolic(int Jrows, const std::vector<DesignVariable*>& dvs)
+    template<typename I, typename V>
+    JacobianColumnPointer CompressedColumnMatrix<I, V>::appendJacobiansSymbolic(int Jrows, const std::vector<DesignVariable*>& dvs)
     {
       SM_ASSERT_FALSE(Exception, _hasDiagonalAppended, "Adding more values after appending a diagonal is unsupported");
-      // Build a list, sorted by block index, of the block indices and block sizes.
       std::vector<DesignVariable*> activeDvs;
-      activeDvs.reserve(dvs.size());
       // The number of new elements we are adding per column.
-      int elementsPerColumn = 0;
+      const size_t elementsPerColumn = collectActiveDesignVariables(dvs, activeDvs);
+      size_t startValueIndex = _row_ind.size();
+      _row_ind.resize(_row_ind.size() + elementsPerColumn * Jrows);
+      _values.resize(_values.size() + elementsPerColumn * Jrows);
+      size_t startColumn = _cols;
+      _col_ptr.resize(_col_ptr.size() + Jrows);
+      writeJacobiansSymbolic(activeDvs, elementsPerColumn, Jrows, startColumn, startValueIndex);
+      // Good. We have updated the three elements of this matrix and it should be fine.
+      _cols = _cols + Jrows;
+      checkMatrixDbg();
+      return JacobianColumnPointer(startValueIndex, elementsPerColumn, activeDvs.size());
+    }
+
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::resizeSymbolic(size_t rows, size_t cols, size_t nnz, size_t reserveNnz)
+    {
+      _rows = rows;
+      _cols = cols;
+      _values.reserve(std::max(nnz, reserveNnz));
+      _row_ind.reserve(std::max(nnz, reserveNnz));
+      _values.assign(nnz, V(0));
+      _row_ind.resize(nnz);
+      _col_ptr.assign(_cols + 1, (index_t)0);
+      _hasDiagonalAppended = false;
+    }
+
+    template<typename I, typename V>
+    JacobianColumnPointer CompressedColumnMatrix<I, V>::setJacobiansSymbolic(size_t startColumn, size_t startValueIndex, int Jrows, const std::vector<DesignVariable*>& dvs)
+    {
+      std::vector<DesignVariable*> activeDvs;
+      const size_t elementsPerColumn = collectActiveDesignVariables(dvs, activeDvs);
+      SM_ASSERT_LE(Exception, startColumn + Jrows, _cols, "The columns are outside of the matrix bounds");
+      SM_ASSERT_LE(Exception, startValueIndex + elementsPerColumn * Jrows, _row_ind.size(), "The nonzeros are outside of the matrix bounds");
+      writeJacobiansSymbolic(activeDvs, elementsPerColumn, Jrows, startColumn, startValueIndex);
+      return JacobianColumnPointer(startValueIndex, elementsPerColumn, activeDvs.size());
+    }
+
+    template<typename I, typename V>
+    size_t CompressedColumnMatrix<I, V>::collectActiveDesignVariables(const std::vector<DesignVariable*>& dvs, std::vector<DesignVariable*>& activeDvs) const
+    {
+      // Build a list, sorted by block index, of the block indices and block sizes.
+      activeDvs.clear();
+      activeDvs.reserve(dvs.size());
+      size_t elementsPerColumn = 0;
       for (size_t i = 0; i < dvs.size(); ++i) {
         DesignVariable* dv = dvs[i];
         if (dv->isActive()) {
@@ -254,21 +295,23 @@ namespace aslam {
       }
       // Sort the indices by block index.
       std::sort(activeDvs.begin(), activeDvs.end(), DesignVariable::BlockIndexOrdering());
-      size_t startValueIndex = _row_ind.size();
-      _row_ind.resize(_row_ind.size() + elementsPerColumn * Jrows);
-      _values.resize(_values.size() + elementsPerColumn * Jrows);
-      size_t startColIdx = _col_ptr.size();
-      _col_ptr.resize(_col_ptr.size() + Jrows);
+      return elementsPerColumn;
+    }
+
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::writeJacobiansSymbolic(const std::vector<DesignVariable*>& activeDvs, size_t elementsPerColumn, int Jrows, size_t startColumn, size_t startValueIndex)
+    {
+      const JacobianColumnPointer cp(startValueIndex, elementsPerColumn, activeDvs.size());
+      // Only the column pointers behind the first column are written such that neighboring blocks can be written concurrently
       for (int r = 0; r < Jrows; r++) {
-        //SM_ASSERT_GE_LT_DBG(Exception, (int)startColIdx + r, 0, (int)_col_ptr.size(), "Index out of bounds");
-        _col_ptr[startColIdx + r] = _col_ptr[startColIdx + r - 1] + elementsPerColumn;
+        _col_ptr[startColumn + r + 1] = cp.valueIndex(r + 1, 0);
       }
-      int rowOffset = 0;
+      size_t rowOffset = 0;
       for (std::vector<DesignVariable*>::const_iterator it = activeDvs.begin(); it != activeDvs.end(); ++it) {
         // This is the first column of block index j
         const DesignVariable& dv = *(*it);
         for (int c = 0; c < Jrows; ++c) {
-          int valueIndex = startValueIndex + c * elementsPerColumn + rowOffset;
+          size_t valueIndex = cp.valueIndex(c, rowOffset);
           for (int r = 0; r < dv.minimalDimensions(); ++r) {
             SM_ASSERT_LT_DBG(Exception, (int)(dv.columnBase() + r), (int)_rows, "This element is outside of the matrix bounds");
             //SM_ASSERT_GE_LT_DBG(Exception, valueIndex, 0, (int)_row_ind.size(), "index out of bounds");
@@ -279,26 +322,22 @@ namespace aslam {
         }
         rowOffset += dv.minimalDimensions();
       }
-      // Good. We have updated the three elements of this matrix and it should be fine.
-      _cols = _cols + Jrows;
-      checkMatrixDbg();
-      return JacobianColumnPointer(startValueIndex, elementsPerColumn, activeDvs.size());
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::writeJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc, const JacobianColumnPointer& cp)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::writeJacobians(const JacobianContainerSparse<Eigen::Dynamic>& jc, const JacobianColumnPointer& cp)
     {
       auto it = jc.begin();
       SM_ASSERT_EQ(Exception, jc.numDesignVariables(), cp.numActiveDesignVariables, "The number of design variables in the Jacobian container should match the number of active design variables found at initialization!");
-      int rowOffset = 0;
+      size_t rowOffset = 0;
       for (; it != jc.end(); ++it) {
         for (int c = 0; c < it->second.rows(); ++c) {
-          int ind = cp.startValueIndex + c * cp.elementsPerColumn + rowOffset;
+          size_t ind = cp.valueIndex(c, rowOffset);
           //SM_ASSERT_GE_LT_DBG(Exception, ind, 0, (int)_values.size(), "Index out of bounds");
           //SM_ASSERT_LE_DBG(Exception, ind + it->second.cols(), (int)_values.size(), "Index out of bounds");
-          double* vp = &_values[ind];
+          V* vp = &_values[ind];
           for (int r = 0; r < it->second.cols(); ++r) {
-            *(vp++) = it->second(c, r);
+            *(vp++) = static_cast<V>(it->second(c, r));
           }
         }
         rowOffset += it->second.cols();
@@ -306,14 +345,71 @@ namespace aslam {
     }
 
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::pushConstantDiagonalBlock(double constant)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::writeJacobians(const std::vector<DesignVariable*>& dvs, const Eigen::Ref<const Eigen::MatrixXd>& J, const JacobianColumnPointer& cp)
+    {
+      size_t colOffset = 0;
+      for (size_t k = 0; k < dvs.size(); colOffset += dvs[k]->minimalDimensions(), ++k) {
+        const DesignVariable* dv = dvs[k];
+        if (!dv->isActive())
+          continue;
+        // The rows of the active design variables are sorted by block index
+        size_t rowOffset = 0;
+        for (const DesignVariable* other : dvs) {
+          if (other->isActive() && other->blockIndex() < dv->blockIndex())
+            rowOffset += other->minimalDimensions();
+        }
+        for (int c = 0; c < J.rows(); ++c) {
+          V* vp = &_values[cp.valueIndex(c, rowOffset)];
+          for (int r = 0; r < dv->minimalDimensions(); ++r) {
+            *(vp++) = static_cast<V>(J(c, colOffset + r));
+          }
+        }
+      }
+      SM_ASSERT_EQ_DBG(Exception, colOffset, (size_t)J.cols(), "The Jacobian does not match the design variables");
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::zeroJacobians(const JacobianColumnPointer& cp, int Jrows)
+    {
+      // The columns of one error term are contiguous in the value array
+      std::fill_n(_values.begin() + cp.startValueIndex, cp.valueIndex(Jrows, 0) - cp.startValueIndex, V(0));
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::broydenUpdateJacobians(const JacobianColumnPointer& cp, int Jrows, const Eigen::VectorXd& dx, const Eigen::VectorXd& dr, size_t startRow)
+    {
+      SM_ASSERT_LE_DBG(Exception, startRow + Jrows, (size_t)dr.size(), "Index out of bounds");
+      for (int c = 0; c < Jrows; ++c) {
+        const size_t start = cp.valueIndex(c, 0);
+        const size_t end = start + cp.elementsPerColumn;
+        double Jdx = 0.0;
+        double dxdx = 0.0;
+        for (size_t idx = start; idx < end; ++idx) {
+          const double x = dx[_row_ind[idx]];
+          Jdx += _values[idx] * x;
+          dxdx += x * x;
+        }
+        if (dxdx <= 0.0)
+          continue;
+        const double scale = (dr[startRow + c] - Jdx) / dxdx;
+        for (size_t idx = start; idx < end; ++idx) {
+          _values[idx] = static_cast<V>(_values[idx] + scale * dx[_row_ind[idx]]);
+        }
+      }
+    }
+
+
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::pushConstantDiagonalBlock(double constant)
     {
       pushDiagonalBlock(Eigen::VectorXd::Constant(_rows, constant));
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::pushDiagonalBlock(const Eigen::VectorXd& diagonal)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::pushDiagonalBlock(const Eigen::VectorXd& diagonal)
     {
       checkMatrixDbg();
       SM_ASSERT_EQ(Exception, (size_t)diagonal.size(), _rows, "The diagonal vector must match the number of rows");
@@ -336,13 +432,13 @@ namespace aslam {
       }
       checkMatrixDbg();
       // Copy over the values.
-      memcpy(&_values[vsize], &diagonal[0], sizeof(double)*_rows);
+      Eigen::Map<Eigen::Matrix<V, Eigen::Dynamic, 1> >(&_values[vsize], _rows) = diagonal.template cast<V>();
       _hasDiagonalAppended = true;
       checkMatrixDbg();
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::popDiagonalBlock()
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::popDiagonalBlock()
     {
       SM_ASSERT_TRUE(Exception, _hasDiagonalAppended, "No diagonal is appended.");
       _values.resize(_values.size() - _rows);
@@ -355,27 +451,27 @@ namespace aslam {
 
 
     /// \brief update the diagonal block
-    template<typename I>
-    void CompressedColumnMatrix<I>::updateDiagonalBlock(const Eigen::VectorXd& diagonal)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::updateDiagonalBlock(const Eigen::VectorXd& diagonal)
     {
       SM_ASSERT_TRUE(Exception, _hasDiagonalAppended, "No diagonal is appended.");
-      Eigen::Map<Eigen::VectorXd> diag(&_values[_values.size() - _rows], _rows);
-      diag = diagonal;
+      Eigen::Map<Eigen::Matrix<V, Eigen::Dynamic, 1> > diag(&_values[_values.size() - _rows], _rows);
+      diag = diagonal.template cast<V>();
     }
 
     /// \brief update the diagonal block with a constant value
-    template<typename I>
-    void CompressedColumnMatrix<I>::updateConstantDiagonalBlock(double diagonal)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::updateConstantDiagonalBlock(double diagonal)
     {
       SM_ASSERT_TRUE(Exception, _hasDiagonalAppended, "No diagonal is appended.");
-      Eigen::Map<Eigen::VectorXd> diag(&_values[_values.size() - _rows], _rows);
-      diag = Eigen::VectorXd::Constant(_rows, diagonal);
+      Eigen::Map<Eigen::Matrix<V, Eigen::Dynamic, 1> > diag(&_values[_values.size() - _rows], _rows);
+      diag.setConstant(static_cast<V>(diagonal));
     }
 
 
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::rightMultiply(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::rightMultiply(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const
     {
       size_t cols = _hasDiagonalAppended ? _cols - _rows : _cols;
       SM_ASSERT_EQ(Exception, (size_t)x.size(), cols, "The input array is the wrong size");
@@ -391,8 +487,8 @@ namespace aslam {
 
 
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::leftMultiply(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::leftMultiply(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const
     {
       size_t cols = _hasDiagonalAppended ? _cols - _rows : _cols;
       SM_ASSERT_EQ(Exception, (size_t)x.size(), _rows, "The input array is the wrong size");
@@ -407,14 +503,14 @@ namespace aslam {
 
 
 
-    template<typename I>
-    void CompressedColumnMatrix<I>:: fromDense(const Eigen::MatrixXd& M)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>:: fromDense(const Eigen::MatrixXd& M)
     {
       fromDenseTolerance(M, 0.0);
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>:: fromDenseTolerance(const Eigen::MatrixXd& M, double tolerance)
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>:: fromDenseTolerance(const Eigen::MatrixXd& M, double tolerance)
     {
       _rows = M.rows();
       _cols = M.cols();
@@ -426,7 +522,7 @@ namespace aslam {
       for (size_t c = 0; c < _cols; ++c) {
         for (size_t r = 0; r < _rows; ++r) {
           if (fabs(M(r, c)) > tolerance) {
-            _values.push_back(M(r, c));
+            _values.push_back(static_cast<V>(M(r, c)));
             _row_ind.push_back(r);
           }
         }
@@ -435,8 +531,8 @@ namespace aslam {
       checkMatrixDbg();
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::write(std::ostream& stream) const {
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::write(std::ostream& stream) const {
       stream << "M = " << rows() << ", N = " << cols() << std::endl;
       stream << "values(" << values().size() << "):\n";
       sm::toStream(stream, values().begin(), values().end(), ",", "[", "]");
@@ -448,8 +544,8 @@ namespace aslam {
       Matrix::write(stream);
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::writeMATLAB(std::ostream& stream) const {
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::writeMATLAB(std::ostream& stream) const {
       for (size_t j = 0; j < _cols; ++j)
         for (I p = _col_ptr[j]; p < _col_ptr[j + 1]; ++p)
           if (std::fabs(_values[p]) > std::numeric_limits<double>::epsilon())
@@ -457,8 +553,8 @@ namespace aslam {
               _row_ind[p] + 1 << " " << j + 1 << " " << _values[p] << std::endl;
     }
 
-    template<typename I>
-    void CompressedColumnMatrix<I>::
+    template<typename I, typename V>
+    void CompressedColumnMatrix<I, V>::
         fromCholmodSparse(const cholmod_sparse* cs) {
       if (cs == NULL)
         return;
@@ -33,6 +33,9 @@ inline void OptimizerStatus::serialize(Archive & ar, const unsigned int /*versio
   ar & BOOST_SERIALIZATION_NVP(numIterations);
   ar & BOOST_SERIALIZATION_NVP(numJacobianEvaluations);
   ar & BOOST_SERIALIZATION_NVP(numErrorEvaluations);
+  ar & BOOST_SERIALIZATION_NVP(numLineSearches);
+  ar & BOOST_SERIALIZATION_NVP(numLineSearchErrorEvaluations);
+  ar & BOOST_SERIALIZATION_NVP(numLineSearchGradientEvaluations);
   ar & BOOST_SERIALIZATION_NVP(gradientNorm);
   ar & BOOST_SERIALIZATION_NVP(maxDeltaX);
   ar & BOOST_SERIALIZATION_NVP(error);
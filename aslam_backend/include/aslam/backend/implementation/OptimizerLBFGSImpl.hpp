@@ -0,0 +1,20 @@
+#ifndef INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERLBFGSIMPL_HPP_
+#define INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERLBFGSIMPL_HPP_
+
+#include <boost/serialization/nvp.hpp>
+
+namespace aslam {
+namespace backend {
+
+template<class Archive>
+inline void OptimizerOptionsLBFGS::serialize(Archive & ar, const unsigned int /*version*/) {
+  ar & BOOST_SERIALIZATION_BASE_OBJECT_NVP(OptimizerOptionsBase);
+  ar & BOOST_SERIALIZATION_NVP(linesearch);
+  ar & BOOST_SERIALIZATION_NVP(useDenseJacobianContainer);
+  ar & BOOST_SERIALIZATION_NVP(historySize);
+}
+
+} /* namespace aslam */
+} /* namespace backend */
+
+#endif /* INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERLBFGSIMPL_HPP_ */
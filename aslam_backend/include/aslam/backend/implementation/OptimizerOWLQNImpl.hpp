@@ -0,0 +1,23 @@
+#ifndef INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZEROWLQNIMPL_HPP_
+#define INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZEROWLQNIMPL_HPP_
+
+#include <boost/serialization/nvp.hpp>
+
+namespace aslam {
+namespace backend {
+
+template<class Archive>
+inline void OptimizerOptionsOWLQN::serialize(Archive & ar, const unsigned int /*version*/) {
+  ar & BOOST_SERIALIZATION_BASE_OBJECT_NVP(OptimizerOptionsBase);
+  ar & BOOST_SERIALIZATION_NVP(useDenseJacobianContainer);
+  ar & BOOST_SERIALIZATION_NVP(historySize);
+  ar & BOOST_SERIALIZATION_NVP(armijoFactor);
+  ar & BOOST_SERIALIZATION_NVP(backtrackingFactor);
+  ar & BOOST_SERIALIZATION_NVP(maxBacktrackingSteps);
+  // the regularizer is not serialized, as error terms are not serializable
+}
+
+} /* namespace aslam */
+} /* namespace backend */
+
+#endif /* INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZEROWLQNIMPL_HPP_ */
@@ -0,0 +1,28 @@
+#ifndef INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERSTOCHASTICIMPL_HPP_
+#define INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERSTOCHASTICIMPL_HPP_
+
+#include <boost/serialization/nvp.hpp>
+
+namespace aslam {
+namespace backend {
+
+template<class Archive>
+inline void OptimizerOptionsStochastic::serialize(Archive & ar, const unsigned int /*version*/) {
+  ar & BOOST_SERIALIZATION_BASE_OBJECT_NVP(OptimizerOptionsBase);
+  ar & BOOST_SERIALIZATION_NVP(method);
+  ar & BOOST_SERIALIZATION_NVP(batchSize);
+  ar & BOOST_SERIALIZATION_NVP(learningRate);
+  ar & BOOST_SERIALIZATION_NVP(learningRateDecay);
+  ar & BOOST_SERIALIZATION_NVP(momentum);
+  ar & BOOST_SERIALIZATION_NVP(beta1);
+  ar & BOOST_SERIALIZATION_NVP(beta2);
+  ar & BOOST_SERIALIZATION_NVP(epsilon);
+  ar & BOOST_SERIALIZATION_NVP(seed);
+  ar & BOOST_SERIALIZATION_NVP(useDenseJacobianContainer);
+  // the polishing optimizer is not serialized, as optimizers are not serializable
+}
+
+} /* namespace aslam */
+} /* namespace backend */
+
+#endif /* INCLUDE_ASLAM_BACKEND_IMPLEMENTATION_OPTIMIZERSTOCHASTICIMPL_HPP_ */
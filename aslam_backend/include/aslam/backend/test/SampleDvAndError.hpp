@@ -123,6 +123,62 @@ public:
 
 };
 
+/// \brief The Rosenbrock function as least squares problem: e = [10 (y - x^2), 1 - x]
+class RosenbrockErr : public aslam::backend::ErrorTermFs<2> {
+public:
+  Point2d* _p2d;
+
+  RosenbrockErr(Point2d* p2d) : _p2d(p2d) {
+    _p2d->setActive(true);
+    setDesignVariables(_p2d);
+  }
+  ~RosenbrockErr() override {}
+
+  /// \brief evaluate the error term
+  double evaluateErrorImplementation() override {
+    const Eigen::Vector2d& v = _p2d->_v;
+    setError(Eigen::Vector2d(10.0 * (v[1] - v[0] * v[0]), 1.0 - v[0]));
+    return evaluateChiSquaredError();
+  }
+
+  /// \brief evaluate the jacobian
+  void evaluateJacobiansImplementation(aslam::backend::JacobianContainer& outJ) override {
+    Eigen::Matrix2d J;
+    J << -20.0 * _p2d->_v[0], 10.0,
+         -1.0, 0.0;
+    outJ.add(_p2d, J);
+  }
+
+};
+
+/// \brief Pulls two points together: e = w (p1 - p2)
+class DifferenceErr : public aslam::backend::ErrorTermFs<2> {
+public:
+  Point2d* _p2d1;
+  Point2d* _p2d2;
+  double _w;
+
+  DifferenceErr(Point2d* p2d1, Point2d* p2d2, double w) : _p2d1(p2d1), _p2d2(p2d2), _w(w) {
+    _p2d1->setActive(true);
+    _p2d2->setActive(true);
+    setDesignVariables((aslam::backend::DesignVariable*)_p2d1, (aslam::backend::DesignVariable*)_p2d2);
+  }
+  ~DifferenceErr() override {}
+
+  /// \brief evaluate the error term
+  double evaluateErrorImplementation() override {
+    setError(_w * (_p2d1->_v - _p2d2->_v));
+    return evaluateChiSquaredError();
+  }
+
+  /// \brief evaluate the jacobian
+  void evaluateJacobiansImplementation(aslam::backend::JacobianContainer& outJ) override {
+    outJ.add(_p2d1, _w * Eigen::Matrix2d::Identity());
+    outJ.add(_p2d2, -_w * Eigen::Matrix2d::Identity());
+  }
+
+};
+
 
 class LinearErr2 : public aslam::backend::ErrorTermFs<2> {
 public:
@@ -298,6 +354,7 @@ inline boost::shared_ptr<aslam::backend::OptimizationProblem> buildProblem(int s
   std::vector<aslam::backend::ErrorTerm*> errs;
   buildSystem(D, E, dvs, errs);
   boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+  problem->reserve(dvs.size(), errs.size());
   for (size_t i = 0; i < dvs.size(); ++i) {
     problem->addDesignVariable(dvs[i], true);
   }
@@ -307,5 +364,36 @@ inline boost::shared_ptr<aslam::backend::OptimizationProblem> buildProblem(int s
   return problem;
 }
 
+/// \brief D independent Rosenbrock valleys, starting from the classical (-1.2, 1). The optimum is (1, 1) for all of them.
+inline boost::shared_ptr<aslam::backend::OptimizationProblem> buildRosenbrockProblem(int D)
+{
+  using namespace aslam::backend;
+  boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+  for (int i = 0; i < D; ++i) {
+    Point2d* point = new Point2d(Eigen::Vector2d(-1.2, 1.0));
+    problem->addDesignVariable(point, true);
+    problem->addErrorTerm(new RosenbrockErr(point), true);
+  }
+  return problem;
+}
+
+/// \brief Rosenbrock valleys starting at staggered points, consecutive valleys weakly pulled together by a DifferenceErr.
+///        The valleys converge at different rates while the chain makes their design variables neighbours.
+inline boost::shared_ptr<aslam::backend::OptimizationProblem> buildCoupledRosenbrockProblem(int D, double w)
+{
+  using namespace aslam::backend;
+  boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+  std::vector<Point2d*> points;
+  for (int i = 0; i < D; ++i) {
+    points.push_back(new Point2d(Eigen::Vector2d(-1.2 + 0.1 * i, 1.0)));
+    problem->addDesignVariable(points.back(), true);
+    problem->addErrorTerm(new RosenbrockErr(points.back()), true);
+  }
+  for (int i = 0; i + 1 < D; ++i) {
+    problem->addErrorTerm(new DifferenceErr(points[i], points[i + 1], w), true);
+  }
+  return problem;
+}
+
 
 #endif /* _SAMPLEDVANDERROR_H_ */
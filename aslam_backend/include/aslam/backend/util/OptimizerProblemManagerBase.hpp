@@ -37,7 +37,7 @@ class OptimizerProblemManagerBase : public OptimizerBase
  protected:
   const ProblemManager& problemManager() const { return _problemManager; }
   ProblemManager& problemManager() { return _problemManager; }
-  void initializeImplementation() override { _problemManager.initialize(); }
+  void initializeImplementation() override { _problemManager.initialize(getOptions().numThreadsJacobian); }
 
  private:
   ProblemManager _problemManager; /// \brief Problem manager
@@ -48,8 +48,12 @@ class ProblemManager {
   /// \brief Set up to work on the optimization problem.
   void setProblem(boost::shared_ptr<OptimizationProblemBase> problem);
 
-  /// \brief initialize the class
-  virtual void initialize();
+  /// \brief initialize the class, the row bases of the error terms are computed by nThreads threads
+  virtual void initialize(size_t nThreads = 1);
+
+  /// \brief Re-collect the active design variables and assign their block indices and column bases after design
+  ///        variables were activated or deactivated. Unlike initialize(), the error terms are kept as they are.
+  void updateDesignVariables();
 
   /// \brief Is everything initialized?
   bool isInitialized() const { return _isInitialized; }
@@ -83,9 +87,13 @@ class ProblemManager {
   ///        hooked up to design variables and running finite differences on error terms where this is possible.
   void checkProblemSetup() const;
 
-  /// \brief Evaluate the value of the objective function
+  /// \brief Evaluate the value of the objective function. nThreads = 0 is treated as 1.
   double evaluateError(const size_t nThreads = 1) const;
 
+  /// \brief Evaluate the summed error of the error terms with the given indices.
+  ///        Indices range over 0 .. numErrorTerms() - 1, the non-squared error terms come first. nThreads = 0 is treated as 1.
+  double evaluateError(const std::vector<std::size_t>& errorTermIndices, const size_t nThreads = 1) const;
+
   /// \brief Signal that the problem changed.
   void signalProblemChanged() { setInitialized(false); }
 
@@ -106,6 +114,18 @@ class ProblemManager {
   /// \brief compute the current gradient of the objective function
   void computeGradient(RowVectorType& outGrad, size_t nThreads, bool useMEstimator, bool applyDvScaling, bool useDenseJacobianContainer);
 
+  /// \brief compute the gradient of the error terms with the given indices (see evaluateError()).
+  ///        The size of \p threadGradients determines the number of threads. Its entries are used as per thread
+  ///        accumulators and are only resized if their dimension does not match, so repeated calls don't allocate.
+  ///        Only the columns of the active design variables of the batch are cleared and read, the others are left stale.
+  ///        Squared error terms always use sparse Jacobian containers, as a dense container costs O(numOptParameters) per term.
+  void computeGradient(RowVectorType& outGrad, const std::vector<std::size_t>& errorTermIndices, std::vector<RowVectorType>& threadGradients,
+                       bool useMEstimator, bool applyDvScaling, bool useDenseJacobianContainer);
+
+  /// \brief Collects the design variables of the error terms with the given indices (see evaluateError()).
+  ///        \p outDvs is cleared first and may contain duplicates.
+  void getDesignVariables(const std::vector<std::size_t>& errorTermIndices, std::vector<DesignVariable*>& outDvs) const;
+
   /// \brief Apply the scaling of the design variables to \p outGrad
   void applyDesignVariableScaling(RowVectorType& outGrad) const;
 
@@ -117,17 +137,32 @@ class ProblemManager {
   const std::vector<ErrorTerm*>& getErrorTerms() const {
     return _errorTermsS;
   }
+
+  /// \brief The non-squared error terms. Their indices in evaluateError() and computeGradient() are their positions in this vector.
+  const std::vector<ScalarNonSquaredErrorTerm*>& getNonSquaredErrorTerms() const {
+    return _errorTermsNS;
+  }
  protected:
   /// \brief Set the initialized status
   void setInitialized(bool isInitialized) { _isInitialized = isInitialized; }
 
  private:
+  /// \brief Collect the active design variables and assign their block indices and column bases
+  void initializeDesignVariables();
+
   /// \brief Evaluate the gradient of the objective function
   void evaluateGradients(size_t threadId, size_t startIdx, size_t endIdx, RowVectorType& grad, bool useMEstimator, bool useDenseJacobianContainer);
 
+  /// \brief Evaluate the gradient of a subset of the error terms
+  void evaluateGradientsForIndices(size_t threadId, size_t startIdx, size_t endIdx, RowVectorType& grad,
+                                   const std::vector<std::size_t>& errorTermIndices, bool useMEstimator, bool useDenseJacobianContainer);
+
   /// \brief Evaluate the objective function
   void sumErrorTerms(size_t /* threadId */, size_t startIdx, size_t endIdx, double& err) const;
 
+  /// \brief Evaluate the objective function for a subset of the error terms
+  void sumErrorTermsForIndices(size_t /* threadId */, size_t startIdx, size_t endIdx, double& err, const std::vector<std::size_t>& errorTermIndices) const;
+
  private:
 
   /// \brief The current optimization problem.
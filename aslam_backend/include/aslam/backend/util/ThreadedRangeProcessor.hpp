@@ -44,6 +44,48 @@ void runThreadedFunction(boost::function<void(size_t, size_t, size_t, Output&)>
   runThreadedJob(boost::bind(function, _1, _2, _3, boost::bind(static_cast<Output & (std::vector<Output>::*)(size_t) >(&std::vector<Output>::at), &out, _1)), rangeLength, out.size());
 }
 
+/**
+ * Computes the exclusive prefix sum of value(i) over the range (0 .. rangeLength - 1) with nThreads threads.
+ * Every thread scans its subrange, the subrange sums are accumulated in order and added in a second parallel pass.
+ * It throws the exception thrown in the first job throwing an exception unless non is thrown.
+ *
+ * @param value returns the summand of index i. It is called once per index and concurrently for different indices.
+ * @param rangeLength specifies the length of the range (0 .. rangeLength - 1).
+ * @param nThreads number of threads to create
+ * @param out resized to rangeLength, out[i] will hold value(0) + ... + value(i - 1).
+ * @return the sum of all values
+ *
+ * The summand type T has to be value initializable to zero and support +=.
+ */
+
+template <typename T, typename Value>
+T runThreadedExclusiveScan(const Value& value, size_t rangeLength, size_t nThreads, std::vector<T>& out){
+  out.resize(rangeLength);
+  std::vector<T> subrangeSums(nThreads, T());
+  runThreadedJob([&value, &out, &subrangeSums](size_t threadId, size_t startIdx, size_t endIdx) {
+    T sum = T();
+    for (size_t i = startIdx; i < endIdx; ++i) {
+      out[i] = sum;
+      sum += value(i);
+    }
+    subrangeSums[threadId] = sum;
+  }, rangeLength, nThreads);
+  // The subranges are ordered by thread index
+  T total = T();
+  for (T& s : subrangeSums) {
+    const T sum = s;
+    s = total;
+    total += sum;
+  }
+  if (nThreads > 1) {
+    runThreadedJob([&out, &subrangeSums](size_t threadId, size_t startIdx, size_t endIdx) {
+      for (size_t i = startIdx; i < endIdx; ++i)
+        out[i] += subrangeSums[threadId];
+    }, rangeLength, nThreads);
+  }
+  return total;
+}
+
 }
 }
 }
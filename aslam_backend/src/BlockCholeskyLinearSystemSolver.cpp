@@ -4,10 +4,53 @@
 #include <sparse_block_matrix/linear_solver_cholmod.h>
 #include <sparse_block_matrix/linear_solver_spqr.h>
 #include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/ErrorTermBatch.hpp>
 #include <sm/PropertyTree.hpp>
 
 namespace aslam {
   namespace backend {
+
+  namespace {
+
+    /// \brief Adds the Jacobians of a run of batch members starting with error term \p firstErrorTerm to the Hessian
+    ///        as JacobianContainerSparse::evaluateHessian() does.
+    class HessianWriter : public ErrorTermBatch::JacobianSink {
+    public:
+      HessianWriter(const std::vector<ErrorTerm*>& errorTerms, size_t firstErrorTerm, size_t firstMember,
+                    BlockCholeskyLinearSystemSolver::SparseBlockMatrix& H, Eigen::VectorXd& rhs)
+          : _errorTerms(errorTerms), _firstErrorTerm(firstErrorTerm), _firstMember(firstMember), _H(H), _rhs(rhs) { }
+
+      void write(std::size_t member, const Eigen::Ref<const Eigen::MatrixXd>& J, const Eigen::Ref<const Eigen::VectorXd>& weightedError) override {
+        const std::vector<DesignVariable*>& dvs = _errorTerms[_firstErrorTerm + (member - _firstMember)]->designVariables();
+        int col1 = 0;
+        for (size_t k1 = 0; k1 < dvs.size(); col1 += dvs[k1]->minimalDimensions(), ++k1) {
+          const DesignVariable* dv1 = dvs[k1];
+          if (!dv1->isActive())
+            continue;
+          const int b1 = dv1->blockIndex();
+          const auto J1 = J.middleCols(col1, dv1->minimalDimensions());
+          _rhs.segment(_H.rowBaseOfBlock(b1), J1.cols()) -= dv1->scaling() * J1.transpose() * weightedError;
+          int col2 = 0;
+          for (size_t k2 = 0; k2 < dvs.size(); col2 += dvs[k2]->minimalDimensions(), ++k2) {
+            const DesignVariable* dv2 = dvs[k2];
+            // Only the upper triangle is stored
+            if (!dv2->isActive() || dv2->blockIndex() < b1)
+              continue;
+            const auto J2 = J.middleCols(col2, dv2->minimalDimensions());
+            *_H.block(b1, dv2->blockIndex(), true) += (dv1->scaling() * dv2->scaling()) * J1.transpose() * J2;
+          }
+        }
+      }
+
+    private:
+      const std::vector<ErrorTerm*>& _errorTerms;
+      size_t _firstErrorTerm;
+      size_t _firstMember;
+      BlockCholeskyLinearSystemSolver::SparseBlockMatrix& _H;
+      Eigen::VectorXd& _rhs;
+    };
+
+  } // namespace
   BlockCholeskyLinearSystemSolver::BlockCholeskyLinearSystemSolver(const std::string & solver, const BlockCholeskyLinearSolverOptions& options) :
       _options(options),
       _solverType(solver) {
@@ -65,11 +108,19 @@ namespace aslam {
       //       Save it for later.
       _H._M.clear(false);
       _rhs.setZero();
-      std::vector<ErrorTerm*>::iterator it, it_end;
-      it = _errorTerms.begin();
-      it_end = _errorTerms.end();
-      for (; it != it_end; ++it) {
-        (*it)->buildHessian(_H._M, _rhs, useMEstimator);
+      const auto errorTermAt = [this](size_t i) { return _errorTerms[i]; };
+      for (size_t i = 0; i < _errorTerms.size(); ) {
+        ErrorTerm* errorTerm = _errorTerms[i];
+        ErrorTermBatch* batch = errorTerm->batch();
+        if (batch != nullptr && batch->hasBatchJacobians()) {
+          const size_t end = findBatchRunEnd(i, _errorTerms.size(), errorTermAt);
+          HessianWriter writer(_errorTerms, i, errorTerm->batchIndex(), _H._M, _rhs);
+          batch->evaluateJacobians(errorTerm->batchIndex(), errorTerm->batchIndex() + (end - i), useMEstimator, writer);
+          i = end;
+          continue;
+        }
+        errorTerm->buildHessian(_H._M, _rhs, useMEstimator);
+        ++i;
       }
     }
 
@@ -94,7 +145,7 @@ namespace aslam {
         int rowBase = 0;
         for (int i = 0; i < _H._M.bRows(); ++i) {
           Eigen::MatrixXd& block = *_H._M.block(i, i, true);
-          block.diagonal() -= _diagonalConditioner.segment(rowBase, block.rows());
+          block.diagonal() -= _diagonalConditioner.segment(rowBase, block.rows()).cwiseAbs2();
           rowBase += block.rows();
         }
       }
@@ -107,6 +158,17 @@ namespace aslam {
       return solutionSuccess;
     }
 
+    bool BlockCholeskyLinearSystemSolver::solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)rhs.size(), _JCols, "The right-hand side has the wrong size");
+      // The Hessian is kept, so solving again with the swapped right-hand side solves the same system.
+      Eigen::VectorXd systemRhs = rhs;
+      _rhs.swap(systemRhs);
+      const bool success = solveSystem(outDx);
+      _rhs.swap(systemRhs);
+      return success;
+    }
+
 
   void BlockCholeskyLinearSystemSolver::initSolver() {
       if(_solverType == "cholesky") {
@@ -143,7 +205,7 @@ namespace aslam {
         int rowBase = 0;
         for (int i = 0; i < _H._M.bRows(); ++i) {
           Eigen::MatrixXd& block = *_H._M.block(i, i, true);
-          block.diagonal() -= _diagonalConditioner.segment(rowBase, block.rows());
+          block.diagonal() -= _diagonalConditioner.segment(rowBase, block.rows()).cwiseAbs2();
           rowBase += block.rows();
         }
       }
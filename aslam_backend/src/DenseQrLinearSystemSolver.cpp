@@ -1,7 +1,11 @@
 #include <aslam/backend/DenseQrLinearSystemSolver.hpp>
+
+#include <algorithm>
+
 #include <aslam/backend/ErrorTerm.hpp>
 #include <Eigen/Dense> // householderQr.solve
 #include <sm/PropertyTree.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
 
 namespace aslam {
   namespace backend {
@@ -24,8 +28,9 @@ namespace aslam {
       return &_J;
     }
 
-  void DenseQrLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& /* dvs */, const std::vector<ErrorTerm*>& /* errors */, bool /* useDiagonalConditioner */)
+  void DenseQrLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& /* dvs */, const std::vector<ErrorTerm*>& /* errors */, bool useDiagonalConditioner)
     {
+      _useDiagonalConditioner = useDiagonalConditioner;
       // \todo Verify that this is similar to the "reserve()" feature in a standard vector.
       _J._M.resize(_JRows, _JCols);
     }
@@ -57,6 +62,49 @@ namespace aslam {
       return true;
     }
 
+    bool DenseQrLinearSystemSolver::solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)e.size(), _JRows, "The error vector has the wrong size");
+      // The right-hand side of the least squares problem is the error vector, not J^T e.
+      Eigen::VectorXd systemError = e;
+      _e.swap(systemError);
+      const bool success = solveSystem(outDx);
+      _e.swap(systemError);
+      return success;
+    }
+
+    void DenseQrLinearSystemSolver::solveSystems(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx)
+    {
+      outDx.resize(conditioners.size());
+      const size_t numDiagonalRows = _useDiagonalConditioner ? _JCols : 0;
+      util::runThreadedJob([&](size_t /* threadId */, size_t startIdx, size_t endIdx) {
+        if (startIdx == endIdx)
+          return;
+        // The same augmentation as in solveSystem(), on a copy per thread
+        Eigen::MatrixXd J(_JRows + numDiagonalRows, _JCols);
+        J.topRows(_JRows) = _J._M;
+        Eigen::VectorXd e = Eigen::VectorXd::Zero(_JRows + numDiagonalRows);
+        e.head(_JRows) = _e;
+        for (size_t i = startIdx; i < endIdx; ++i) {
+          if (_useDiagonalConditioner)
+            J.bottomRows(_JCols) = Eigen::VectorXd::Constant(_JCols, conditioners[i]).asDiagonal();
+          outDx[i] = J.colPivHouseholderQr().solve(e);
+        }
+      }, conditioners.size(), std::max<size_t>(1, std::min(nThreads, conditioners.size())));
+    }
+
+    bool DenseQrLinearSystemSolver::multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const
+    {
+      outJx = _J._M * x;
+      return true;
+    }
+
+    bool DenseQrLinearSystemSolver::multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const
+    {
+      outJty = _J._M.transpose() * y;
+      return true;
+    }
+
 
   void DenseQrLinearSystemSolver::evaluateJacobians(size_t /* threadId */, size_t startIdx, size_t endIdx, bool useMEstimator)
     {
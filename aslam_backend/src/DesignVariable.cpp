@@ -1,14 +1,31 @@
 #include <aslam/backend/DesignVariable.hpp>
-#include <aslam/backend/CacheInterface.hpp>
 
 namespace aslam {
   namespace backend {
 
     DesignVariable::DesignVariable() :
-      _blockIndex(-1), _columnBase(-1), _isMarginalized(false), _isActive(false), _scaling(1.0)
+      _blockIndex(-1), _columnBase(-1), _isMarginalized(false), _isActive(false), _scaling(1.0), _updateCount(0)
     {
     }
 
+    DesignVariable::DesignVariable(const DesignVariable& other) :
+      _blockIndex(other._blockIndex), _columnBase(other._columnBase), _isMarginalized(other._isMarginalized),
+      _isActive(other._isActive), _scaling(other._scaling), _updateCount(0)
+    {
+    }
+
+    DesignVariable& DesignVariable::operator=(const DesignVariable& other)
+    {
+      _blockIndex = other._blockIndex;
+      _columnBase = other._columnBase;
+      _isMarginalized = other._isMarginalized;
+      _isActive = other._isActive;
+      _scaling = other._scaling;
+      // the value of the derived class is assigned as well
+      invalidateCache();
+      return *this;
+    }
+
 
     DesignVariable::~DesignVariable()
     {
@@ -18,18 +35,17 @@ namespace aslam {
     /// \brief update the design variable.
     void DesignVariable::update(const double* dp, int size)
     {
-      invalidateCache();
-
       // update the design variable:
       updateImplementation(dp, size);
+      invalidateCache();
     }
 
 
     /// \brief Revert the last state update
     void DesignVariable::revertUpdate()
     {
-      invalidateCache();
       revertUpdateImplementation();
+      invalidateCache();
     }
 
     /// \brief what is the number of dimensions of the perturbation variable.
@@ -43,8 +59,8 @@ namespace aslam {
     }
 
     void DesignVariable::setParameters(const Eigen::MatrixXd& value) {
-      invalidateCache();
       setParametersImplementation(value);
+      invalidateCache();
     }
 
     /// \brief Computes the minimal distance in tangent space between the current value of the DV and xHat
@@ -71,19 +87,6 @@ namespace aslam {
 
     }
 
-  void DesignVariable::registerCacheExpressionNode(const boost::shared_ptr<CacheInterface>& cn) {
-    _cacheNodes.push_back(cn);
-  }
-
-  void DesignVariable::invalidateCacheImplementation() {
-    // reset the cache
-    for (const auto cn : _cacheNodes) {
-      const auto pt = cn.lock();
-      if (pt != nullptr) // TODO: Can this happen at all? Do we have to clean up here?
-        pt->invalidate();
-    }
-  }
-
   } // namespace backend
 } // namespace aslam
 
@@ -0,0 +1,107 @@
+#include <aslam/backend/GeodesicAccelerationTrustRegionPolicy.hpp>
+#include <sm/PropertyTree.hpp>
+
+namespace aslam {
+    namespace backend {
+
+    GeodesicAccelerationTrustRegionPolicy::GeodesicAccelerationTrustRegionPolicy() :
+        GeodesicAccelerationTrustRegionPolicy(1e-3)
+    {
+
+    }
+
+    GeodesicAccelerationTrustRegionPolicy::GeodesicAccelerationTrustRegionPolicy(double lambdaInit, double finiteDifferenceStep, double maxAccelerationRatio) :
+        LevenbergMarquardtTrustRegionPolicy(lambdaInit),
+        _numAcceleratedSteps(0),
+        _numRejectedAccelerations(0),
+        _lastAccelerationRatio(0.0)
+    {
+      setFiniteDifferenceStep(finiteDifferenceStep);
+      setMaxAccelerationRatio(maxAccelerationRatio);
+    }
+
+    GeodesicAccelerationTrustRegionPolicy::GeodesicAccelerationTrustRegionPolicy(const sm::ConstPropertyTree & config) :
+        LevenbergMarquardtTrustRegionPolicy(config),
+        _numAcceleratedSteps(0),
+        _numRejectedAccelerations(0),
+        _lastAccelerationRatio(0.0)
+    {
+      setFiniteDifferenceStep(config.getDouble("finiteDifferenceStep", 0.1));
+      setMaxAccelerationRatio(config.getDouble("maxAccelerationRatio", 0.75));
+    }
+
+    GeodesicAccelerationTrustRegionPolicy::~GeodesicAccelerationTrustRegionPolicy() {}
+
+    void GeodesicAccelerationTrustRegionPolicy::setFiniteDifferenceStep(double h)
+    {
+      SM_ASSERT_GT(Exception, h, 0.0, "The finite difference step has to be positive");
+      _finiteDifferenceStep = h;
+    }
+
+    void GeodesicAccelerationTrustRegionPolicy::setMaxAccelerationRatio(double alpha)
+    {
+      SM_ASSERT_GT(Exception, alpha, 0.0, "The maximum acceleration ratio has to be positive");
+      _maxAccelerationRatio = alpha;
+    }
+
+    void GeodesicAccelerationTrustRegionPolicy::optimizationStartingImplementation(double J)
+    {
+      LevenbergMarquardtTrustRegionPolicy::optimizationStartingImplementation(J);
+      _numAcceleratedSteps = 0;
+      _numRejectedAccelerations = 0;
+      _lastAccelerationRatio = 0.0;
+    }
+
+    bool GeodesicAccelerationTrustRegionPolicy::solveSystemImplementation(double J, bool previousIterationFailed, int nThreads, Eigen::VectorXd& outDx)
+    {
+      if (!LevenbergMarquardtTrustRegionPolicy::solveSystemImplementation(J, previousIterationFailed, nThreads, outDx))
+        return false;
+
+      const double vNorm = outDx.norm();
+      if (vNorm == 0.0)
+        return true;
+
+      Eigen::VectorXd a;
+      if (!computeAcceleration(outDx, a))
+        return true;
+
+      _lastAccelerationRatio = 2.0 * a.norm() / vNorm;
+      if (_lastAccelerationRatio <= _maxAccelerationRatio) {
+        outDx += 0.5 * a;
+        ++_numAcceleratedSteps;
+      } else {
+        ++_numRejectedAccelerations;
+      }
+      return true;
+    }
+
+    bool GeodesicAccelerationTrustRegionPolicy::computeAcceleration(const Eigen::VectorXd& v, Eigen::VectorXd& outA)
+    {
+      if (!_applyStateUpdate || !_revertStateUpdate || !_evaluateError)
+        return false;
+
+      Eigen::VectorXd Jv;
+      if (!_solver->multiplyJacobian(v, Jv))
+        return false;
+
+      // Probe the residuals at x + h v. The solver stores the negative residuals.
+      const double h = _finiteDifferenceStep;
+      const Eigen::VectorXd hv = h * v;
+      _applyStateUpdate(hv);
+      _evaluateError();
+      const Eigen::VectorXd rvv = (2.0 / h) * ((linearizationError() - _solver->e()) / h - Jv);
+      _revertStateUpdate(hv);
+      _solver->setErrorVector(linearizationError());
+
+      return _solver->solveSystemWithError(-rvv, outA);
+    }
+
+    std::ostream & GeodesicAccelerationTrustRegionPolicy::printState(std::ostream & out) const
+    {
+      LevenbergMarquardtTrustRegionPolicy::printState(out);
+      out << " accel ratio:" << _lastAccelerationRatio << " accelerated:" << _numAcceleratedSteps << " rejected:" << _numRejectedAccelerations;
+      return out;
+    }
+
+    } // namespace backend
+} // namespace aslam
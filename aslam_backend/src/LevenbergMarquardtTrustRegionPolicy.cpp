@@ -1,6 +1,8 @@
 #include <aslam/backend/LevenbergMarquardtTrustRegionPolicy.hpp>
 #include <sm/PropertyTree.hpp>
 
+#include <algorithm>
+
 namespace aslam {
     namespace backend {
 
@@ -9,7 +11,8 @@ namespace aslam {
         _gammaInit(3),
         _betaInit(2),
         _pInit(3),
-        _muInit(2)
+        _muInit(2),
+        _numLambdaCandidates(1)
     {
 
     }
@@ -18,7 +21,8 @@ namespace aslam {
         _gammaInit(3),
         _betaInit(2),
         _pInit(3),
-        _muInit(2)
+        _muInit(2),
+        _numLambdaCandidates(1)
     {
 
     }
@@ -29,6 +33,9 @@ namespace aslam {
       _betaInit   = config.getDouble("betaInit", 2.0); 
       _pInit      = config.getInt("pInit", 3);
       _muInit     = config.getDouble("muInit", 2.0);
+      const int numLambdaCandidates = config.getInt("numLambdaCandidates", 1);
+      SM_ASSERT_GE(Exception, numLambdaCandidates, 1, "There has to be at least one lambda candidate");
+      setNumLambdaCandidates(numLambdaCandidates);
     }
     
         LevenbergMarquardtTrustRegionPolicy::~LevenbergMarquardtTrustRegionPolicy() {}
@@ -53,7 +60,7 @@ namespace aslam {
             
             if (isFirstIteration()) {
                 // This is the first step.
-                _solver->buildSystem(nThreads, true);
+                buildSystem(nThreads);
             } else {
                 ///get Rho and update Lambda:
                 double rho = getLmRho(outDx);
@@ -69,7 +76,7 @@ namespace aslam {
                 } else {
                     // The last iteration was successful
                     // Here we need to rebuild the system
-                    _solver->buildSystem(nThreads, true);
+                    buildSystem(nThreads);
                     if (_lambda > 1e-16) {
                         double u1 = 1 / _gamma;
                         double u2 = 1 - (_beta - 1) * pow((2 * rho - 1), _p);
@@ -84,10 +91,56 @@ namespace aslam {
                 }
             }
             
-            _solver->setConstantConditioner(_lambda);
+            return resolveSystem(_lambda, outDx);
+        }
+
+        void LevenbergMarquardtTrustRegionPolicy::buildSystem(int nThreads)
+        {
+            _solver->buildSystem(nThreads, true);
+            _linearizationError = _solver->e();
+        }
+
+        bool LevenbergMarquardtTrustRegionPolicy::resolveSystem(double lambda, Eigen::VectorXd& outDx)
+        {
+            _solver->setErrorVector(_linearizationError);
+            _solver->setConstantConditioner(lambda);
             return _solver->solveSystem(outDx);
         }
         
+        void LevenbergMarquardtTrustRegionPolicy::setNumLambdaCandidates(size_t numLambdaCandidates)
+        {
+            SM_ASSERT_GE(Exception, numLambdaCandidates, 1u, "There has to be at least one lambda candidate");
+            _numLambdaCandidates = numLambdaCandidates;
+        }
+
+        void LevenbergMarquardtTrustRegionPolicy::increaseDamping(size_t i, double& lambda, double& mu) const
+        {
+            for (size_t k = 0; k < i; ++k) {
+                mu *= 2;
+                lambda *= mu;
+            }
+        }
+
+        void LevenbergMarquardtTrustRegionPolicy::solveCandidates(int nThreads, std::vector<Eigen::VectorXd>& outDx)
+        {
+            SM_ASSERT_TRUE(Exception, _solver.get() != NULL, "The solver is null");
+            std::vector<double> lambdas;
+            for (size_t i = 1; i < _numLambdaCandidates; ++i) {
+                double lambda = _lambda, mu = _mu;
+                increaseDamping(i, lambda, mu);
+                lambdas.push_back(lambda);
+            }
+            // The system is not rebuilt, only the conditioner changes
+            _solver->setErrorVector(_linearizationError);
+            _solver->solveSystems(lambdas, std::max(nThreads, 1), outDx);
+        }
+
+        void LevenbergMarquardtTrustRegionPolicy::selectCandidate(size_t i)
+        {
+            SM_ASSERT_LT(Exception, i, _numLambdaCandidates, "Candidate index out of bounds");
+            increaseDamping(i, _lambda, _mu);
+        }
+
         /// \brief print the current state to a stream (no newlines).
         std::ostream & LevenbergMarquardtTrustRegionPolicy::printState(std::ostream & out) const
         {
@@ -400,6 +400,7 @@ LineSearchOptions::LineSearchOptions(const sm::PropertyTree& config)
   nMaxIterWolfe1 = config.getInt("nMaxIterWolfe1", nMaxIterWolfe1);
   nMaxIterWolfe2 = config.getInt("nMaxIterWolfe2", nMaxIterWolfe2);
   nMaxIterZoom = config.getInt("nMaxIterZoom", nMaxIterZoom);
+  lazyGradientEvaluation = config.getBool("lazyGradientEvaluation", lazyGradientEvaluation);
   check();
 }
 
@@ -427,7 +428,8 @@ ostream& operator<<(ostream& out, const aslam::backend::LineSearchOptions& optio
   out << "\tinitialStepLength: " << options.initialStepLength << endl;
   out << "\tnMaxIterWolfe1: " << options.nMaxIterWolfe1 << endl;
   out << "\tnMaxIterWolfe2: " << options.nMaxIterWolfe2 << endl;
-  out << "\tnMaxIterZoom: " << options.nMaxIterZoom;
+  out << "\tnMaxIterZoom: " << options.nMaxIterZoom << endl;
+  out << "\tlazyGradientEvaluation: " << options.lazyGradientEvaluation;
   return out;
 }
 
@@ -463,6 +465,8 @@ void LineSearch::initialize(boost::optional<const RowVectorType&> searchDirectio
   _stepLength = 0.0;
   _errorOutdated = _derrorOutdated = true;
   _errorOld = std::numeric_limits<double>::signaling_NaN();
+  _trialCache.clear();
+  _atOrigin = _exactState = true;
 
   if (error)
     _error = error.get();
@@ -489,6 +493,7 @@ void LineSearch::setSearchDirection(const RowVectorType& searchDirection) {
   _searchDirection = searchDirection;
   _derror = computeErrorDerivative();
   _derrorOutdated = false;
+  resetTrialCache();
   SM_VERBOSE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: set search direction to " << _searchDirection.format(IOFormat(15, DontAlignCols, ", ", ", ", "", "", "[", "]")));
   SM_VERBOSE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: computed error derivative " << _derror);
   SM_ASSERT_LE(Exception, _derror, 0.0, "Wrong search direction supplied! In case approximate Hessian information is used, "
@@ -509,6 +514,8 @@ void LineSearch::applyStateUpdate(const double s) {
         utils::getFlattenedDesignVariableParameters(_costFunction->getDesignVariables()).transpose() :  Eigen::RowVectorXd();
     utils::applyStateUpdate(_costFunction->getDesignVariables(), ds*_searchDirection);
     _errorOutdated = _derrorOutdated = true;
+    _exactState = _atOrigin;
+    _atOrigin = false;
     SM_VERBOSE_STREAM_NAMED("optimization.linesearch", "LineSearch: update step length " << s - ds << " -> " << _stepLength << " (ds: " << ds<< ")");
     SM_VERBOSE_STREAM_NAMED("optimization.linesearch", "LineSearch: update state" << std::endl <<
                             "Old  : " << p.format(fmt) << std::endl <<
@@ -523,8 +530,17 @@ void LineSearch::applyStateUpdate(const double s) {
 void LineSearch::updateError() {
   if (_errorOutdated) {
     const double errorOld = _error;
-    _error = _costFunction->evaluateError();
-    if (_evalErrorCallback) _evalErrorCallback();
+    const TrialPoint* trial = findTrialPoint();
+    if (trial != nullptr) {
+      _error = trial->error;
+      SM_ALL_STREAM_NAMED("optimization.linesearch", "LineSearch: reusing cached error at step length " << _stepLength);
+    } else {
+      _error = _costFunction->evaluateError();
+      _numErrorEvaluations++;
+      if (_evalErrorCallback) _evalErrorCallback();
+      if (_exactState)
+        _trialCache.push_back(TrialPoint{_stepLength, _error, false, std::numeric_limits<double>::signaling_NaN(), RowVectorType()});
+    }
     SM_VERBOSE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: update error " << errorOld << " -> " << _error << " (" << _error - errorOld << ")");
   }
   _errorOutdated = false;
@@ -532,19 +548,55 @@ void LineSearch::updateError() {
 
 void LineSearch::updateGradient() {
   _costFunction->computeGradient(_gradient);
+  _numGradientEvaluations++;
   if (_evalGradCallback) _evalGradCallback();
 }
 
 void LineSearch::updateErrorDerivative() {
   if (_derrorOutdated) {
     const double dErrorOld = _derror;
-    this->updateGradient();
-    _derror = computeErrorDerivative();
+    TrialPoint* trial = findTrialPoint();
+    if (trial != nullptr && trial->hasGradient) {
+      _gradient = trial->gradient;
+      _derror = trial->derror;
+      SM_ALL_STREAM_NAMED("optimization.linesearch", "LineSearch: reusing cached gradient at step length " << _stepLength);
+    } else {
+      this->updateGradient();
+      _derror = computeErrorDerivative();
+      if (trial != nullptr) {
+        trial->hasGradient = true;
+        trial->derror = _derror;
+        trial->gradient = _gradient;
+      }
+    }
     SM_VERBOSE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: update error derivative "<< dErrorOld << " -> " << _derror << " (" << _derror - dErrorOld << ")");
   }
   _derrorOutdated = false;
 }
 
+void LineSearch::resetCounters() {
+  _numErrorEvaluations = _numGradientEvaluations = 0;
+}
+
+LineSearch::TrialPoint* LineSearch::findTrialPoint() {
+  // Only states reached with a single update from the start of the search are cached. Revisiting a step length
+  // through several updates does not reproduce the parameters bitwise, in particular for non-Euclidean design variables.
+  if (!_exactState)
+    return nullptr;
+  for (auto& trial : _trialCache) {
+    if (trial.stepLength == _stepLength)
+      return &trial;
+  }
+  return nullptr;
+}
+
+void LineSearch::resetTrialCache() {
+  _trialCache.clear();
+  _atOrigin = _exactState = true;
+  if (!_errorOutdated && !_derrorOutdated)
+    _trialCache.push_back(TrialPoint{_stepLength, _error, true, _derror, _gradient});
+}
+
 bool LineSearch::zoom(double minStepSize, double maxStepSize, double error_lo, double error_hi, double derror_lo, double error0, double derror0) {
 
   size_t i = 0;
@@ -652,6 +704,11 @@ double LineSearch::computeErrorDerivative() const {
 
 
 bool LineSearch::lineSearchWolfe1() {
+  resetCounters();
+  return wolfe1();
+}
+
+bool LineSearch::wolfe1() {
 
   // Check that the error and gradient information is up to date and not NaN
   SM_ASSERT_FALSE(Exception, isnan(getError()), "");
@@ -681,6 +738,15 @@ bool LineSearch::lineSearchWolfe1() {
   Dcsrch dcsrch(stepLength, getError(), getErrorDerivative(), _options.minStepLength,
                 _options.maxStepLength, _options.c1WolfeCondition, _options.xtol, _options.c2WolfeCondition);
 
+  // Largest step length satisfying the sufficient decrease condition with negative error derivative so far.
+  // If a longer trial step violates the sufficient decrease condition, the interval between both contains a
+  // step length satisfying the strong Wolfe conditions and zoom finds it without the gradient at the trial step.
+  const double error0 = getError();
+  const double derror0 = getErrorDerivative();
+  double stepLengthLo = 0.0;
+  double errorLo = error0;
+  double derrorLo = derror0;
+
   size_t cnt = 0;
   while(!terminate && cnt < _options.nMaxIterWolfe1) {
 
@@ -689,12 +755,28 @@ bool LineSearch::lineSearchWolfe1() {
     const double stp = dcsrch.updateStepLength(getError(), getErrorDerivative());
 
     switch(dcsrch.status()) {
-      case Dcsrch::RUNNING:
+      case Dcsrch::RUNNING: {
         stepLength = stp;
         this->applyStateUpdate(stp);
         this->updateError();
+        if (_options.lazyGradientEvaluation && stp > stepLengthLo &&
+            (getError() > error0 + _options.c1WolfeCondition*stp*derror0 || getError() >= errorLo)) {
+          SM_ALL_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: wolfe1 -- sufficient decrease condition not satisfied at step length " <<
+                              stp << ", calling zoom with interval [" << stepLengthLo << ", " << stp << "]");
+          const bool zoomSuccess = this->zoom(stepLengthLo, stp, errorLo, getError(), derrorLo, error0, derror0);
+          if (zoomSuccess)
+            SM_FINE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: wolfe1 -- converged in zoom, final step length " << getCurrentStepLength() <<
+                                 ", final error " << getError() << ", final error derivative " << getErrorDerivative());
+          return zoomSuccess;
+        }
         this->updateErrorDerivative();
+        if (getErrorDerivative() < 0.0 && getError() < errorLo) {
+          stepLengthLo = stp;
+          errorLo = getError();
+          derrorLo = getErrorDerivative();
+        }
         break;
+      }
       case Dcsrch::CONVERGED:
         SM_FINE_STREAM_NAMED("optimization.linesearch", setprecision(20) << "LineSearch: wolfe1 -- converged, final step length " << stp <<
                               ", final error " << getError() << ", final error derivative " << getErrorDerivative());
@@ -723,6 +805,11 @@ bool LineSearch::lineSearchWolfe1() {
 }
 
 bool LineSearch::lineSearchWolfe2() {
+  resetCounters();
+  return wolfe2();
+}
+
+bool LineSearch::wolfe2() {
 
   // Check that the error and gradient information is up to date and not NaN
   SM_ASSERT_FALSE(Exception, isnan(getError()), "");
@@ -825,13 +912,16 @@ bool LineSearch::lineSearchWolfe2() {
 
 bool LineSearch::lineSearchWolfe12() {
 
+  resetCounters();
+
   const double errorOld0 = _errorOld; // _errorOld gets modified by lineSearchWolfe1
-  const double error0 = _error;
-  const double derror0 = _derror;
+  const double error0 = getError();
+  const double derror0 = getErrorDerivative();
+  const RowVectorType gradient0 = _gradient;
 
   utils::DesignVariableState dvstate(_costFunction->getDesignVariables());
 
-  if (!lineSearchWolfe1()) {
+  if (!wolfe1()) {
     SM_FINE_STREAM_NAMED("optimization.linesearch", "LineSearch: method wolfe1 failed, trying method wolfe2");
 
     // restore error values to the ones before calling lineSearchWolfe1().
@@ -839,10 +929,13 @@ bool LineSearch::lineSearchWolfe12() {
     _errorOld = errorOld0;
     _error = error0;
     _derror = derror0;
+    _gradient = gradient0;
+    _errorOutdated = _derrorOutdated = false;
     _stepLength = 0.0;
     dvstate.restore();
+    _atOrigin = _exactState = true;
 
-    return lineSearchWolfe2();
+    return wolfe2();
   }
 
   return true;
@@ -1,15 +1,28 @@
 #include <aslam/backend/LinearSystemSolver.hpp>
 
+#include <algorithm>
 #include <future>
+#include <numeric>
 
 #include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/ErrorTermBatch.hpp>
+#include <aslam/backend/DesignVariable.hpp>
 #include <aslam/backend/OptimizerCallbackManager.hpp>
+#include <aslam/backend/util/CommonDefinitions.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
 
 namespace aslam {
   namespace backend {
 
     LinearSystemSolver::LinearSystemSolver() :
-      _acceptConstantErrorTerms(false)
+      _acceptConstantErrorTerms(false),
+      _jacobianUpdate(JACOBIAN_FULL),
+      _jacobianRefreshTolerance(0.0),
+      _hasJacobian(false),
+      _fullJacobianRequested(false),
+      _jacobianAge(0),
+      _mEstimatorWeightThreshold(0.0),
+      _numSkippedJacobians(0)
     {
     }
     LinearSystemSolver::~LinearSystemSolver() {}
@@ -18,6 +31,8 @@ namespace aslam {
     {
       SM_ASSERT_LT_DBG(Exception, threadId, _threadLocalErrors.size(), "Index out of bounds in thread " << threadId);
       SM_ASSERT_LE_DBG(Exception, endIdx, _errorTerms.size(), "Index out of bounds in thread " << threadId);
+      forEachBatchRun(startIdx, endIdx, [this](size_t i) { return _errorTerms[i]; },
+                      [](ErrorTermBatch& batch, size_t begin, size_t end) { batch.prefetchErrors(begin, end); });
       Eigen::VectorXd e;
       for (size_t i = startIdx; i < endIdx; ++i) {
         SM_ASSERT_TRUE_DBG(Exception, _errorTerms[i] != NULL, "Null error term " << i);
@@ -82,6 +97,35 @@ namespace aslam {
     }
 
 
+    void LinearSystemSolver::setErrorVector(const Eigen::VectorXd& e)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)e.size(), _JRows, "The error vector has the wrong size");
+      _e = e;
+    }
+
+    void LinearSystemSolver::solveSystems(const std::vector<double>& conditioners, size_t /* nThreads */, std::vector<Eigen::VectorXd>& outDx)
+    {
+      const Eigen::VectorXd diagonalConditioner = _diagonalConditioner;
+      outDx.resize(conditioners.size());
+      for (size_t i = 0; i < conditioners.size(); ++i) {
+        setConstantConditioner(conditioners[i]);
+        if (!solveSystem(outDx[i]))
+          outDx[i].resize(0);
+      }
+      setConditioner(diagonalConditioner);
+    }
+
+    bool LinearSystemSolver::solveSystemWithRhs(const Eigen::VectorXd& /* rhs */, Eigen::VectorXd& /* outDx */)
+    {
+      return false;
+    }
+
+    bool LinearSystemSolver::solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx)
+    {
+      Eigen::VectorXd rhs;
+      return multiplyJacobianTranspose(e, rhs) && solveSystemWithRhs(rhs, outDx);
+    }
+
     void LinearSystemSolver::setConditioner(const Eigen::VectorXd& diag)
     {
       SM_ASSERT_EQ(Exception, (size_t)diag.size(), _JCols, "The diagonal conditioner must have the same number of rows as the Hessian matrix");
@@ -94,16 +138,22 @@ namespace aslam {
     }
 
 
-    void LinearSystemSolver::initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner)
+    void LinearSystemSolver::initMatrixStructure(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner, size_t nThreads)
     {
+      Timer timer("LinearSystemSolver: Initialize matrix structure---Dimensions");
       setOrdering(dvs, errors);
       _errorTerms = errors;
+      _numThreadsInitMatrixStructure = std::max<size_t>(1, nThreads);
       // Figure out the size of the Jacobian matrix.
-      _JRows = 0;
-      std::vector<ErrorTerm*>::const_iterator eit = errors.begin();
-      for (; eit != errors.end(); ++eit) {
-        _JRows += (*eit)->dimension();
-      }
+      std::vector<size_t> threadRows(_numThreadsInitMatrixStructure, 0);
+      util::runThreadedJob([&errors, &threadRows](size_t threadId, size_t startIdx, size_t endIdx) {
+        size_t rows = 0;
+        for (size_t i = startIdx; i < endIdx; ++i) {
+          rows += errors[i]->dimension();
+        }
+        threadRows[threadId] = rows;
+      }, errors.size(), _numThreadsInitMatrixStructure);
+      _JRows = std::accumulate(threadRows.begin(), threadRows.end(), size_t(0));
       _JCols = 0;
       std::vector<DesignVariable*>::const_iterator dit = dvs.begin();
       for (; dit != dvs.end(); ++dit) {
@@ -114,6 +164,17 @@ namespace aslam {
       _e.conservativeResize(_JRows);
       _rhs.resize(_JCols);
       _diagonalConditioner = Eigen::VectorXd::Zero(_JCols);
+      // Reset the lazy Jacobian state as the structure changed.
+      _hasJacobian = false;
+      _jacobianAge = 0;
+      _dxSinceJacobian = Eigen::VectorXd::Zero(_JCols);
+      _designVariables = dvs;
+      _designVariableMotion.assign(dvs.size(), 0.0);
+      _errorTermMotionAtJacobian.assign(errors.size(), 0.0);
+      _refreshErrorTerm.assign(errors.size(), 1);
+      _zeroJacobian.assign(errors.size(), 0);
+      timer.stop();
+      Timer timerImplementation("LinearSystemSolver: Initialize matrix structure---Implementation");
       initMatrixStructureImplementation(dvs, errors, useDiagonalConditioner);
     }
 
@@ -139,5 +200,78 @@ namespace aslam {
     void LinearSystemSolver::handleNewAcceptConstantErrorTerms() {
     }
 
+    void LinearSystemSolver::setJacobianUpdate(JacobianUpdate update, double refreshTolerance)
+    {
+      SM_ASSERT_GE(Exception, refreshTolerance, 0.0, "The refresh tolerance must not be negative");
+      _jacobianUpdate = update;
+      _jacobianRefreshTolerance = refreshTolerance;
+    }
+
+    void LinearSystemSolver::setMEstimatorWeightThreshold(double threshold)
+    {
+      SM_ASSERT_GE(Exception, threshold, 0.0, "The MEstimator weight threshold must not be negative");
+      _mEstimatorWeightThreshold = threshold;
+    }
+
+    void LinearSystemSolver::notifyStateUpdate(const Eigen::VectorXd& dx)
+    {
+      if (_jacobianUpdate == JACOBIAN_FULL || !supportsLazyJacobian())
+        return;
+      SM_ASSERT_EQ(Exception, (size_t)dx.size(), _JCols, "The state update has the wrong size");
+      // The motion is taken from the net state change when the next Jacobian is built, so a reverted step cancels out
+      _dxSinceJacobian += dx;
+    }
+
+    double LinearSystemSolver::errorTermMotion(size_t i) const
+    {
+      double motion = 0.0;
+      for (const DesignVariable* dv : _errorTerms[i]->designVariables()) {
+        if (dv->isActive())
+          motion += _designVariableMotion[dv->blockIndex()];
+      }
+      return motion;
+    }
+
+    bool LinearSystemSolver::isJacobianSkipped(size_t i, bool useMEstimator) const
+    {
+      // The same test as in CompressedColumnJacobianTransposeBuilder::evaluateJacobians()
+      return useMEstimator && _mEstimatorWeightThreshold > 0.0 && _errorTerms[i]->getCurrentMEstimatorWeight() < _mEstimatorWeightThreshold;
+    }
+
+    LinearSystemSolver::JacobianUpdate LinearSystemSolver::beginJacobianUpdate(bool useMEstimator)
+    {
+      if (!_hasJacobian || _fullJacobianRequested || !supportsLazyJacobian())
+        return JACOBIAN_FULL;
+      // Add the max-norm displacement of each design variable from the last linearization point
+      for (DesignVariable* dv : _designVariables) {
+        if (dv->minimalDimensions() > 0)
+          _designVariableMotion[dv->blockIndex()] += _dxSinceJacobian.segment(dv->columnBase(), dv->minimalDimensions()).cwiseAbs().maxCoeff();
+      }
+      if (_jacobianUpdate == JACOBIAN_PARTIAL) {
+        // A zero filled Jacobian is stale as soon as the weight of its error term recovers, whatever the motion
+        for (size_t i = 0; i < _errorTerms.size(); ++i)
+          _refreshErrorTerm[i] = errorTermMotion(i) - _errorTermMotionAtJacobian[i] > _jacobianRefreshTolerance
+              || (_zeroJacobian[i] && !isJacobianSkipped(i, useMEstimator));
+      }
+      return _jacobianUpdate;
+    }
+
+    void LinearSystemSolver::endJacobianUpdate(JacobianUpdate update, bool useMEstimator)
+    {
+      _hasJacobian = true;
+      _fullJacobianRequested = false;
+      _jacobianAge = update == JACOBIAN_FULL ? 0 : _jacobianAge + 1;
+      _eAtJacobian = _e;
+      _dxSinceJacobian.setZero();
+      if (_jacobianUpdate == JACOBIAN_FULL)
+        return;
+      for (size_t i = 0; i < _errorTerms.size(); ++i) {
+        if (update != JACOBIAN_BROYDEN && (update == JACOBIAN_FULL || _refreshErrorTerm[i])) {
+          _errorTermMotionAtJacobian[i] = errorTermMotion(i);
+          _zeroJacobian[i] = isJacobianSkipped(i, useMEstimator);
+        }
+      }
+    }
+
   } // namespace backend
 }  // namespace aslam
@@ -96,7 +96,7 @@ void marginalize(
 			}
 
 		  aslam::backend::DenseQrLinearSystemSolver qrSolver;
-      qrSolver.initMatrixStructure(inDesignVariables, inErrorTerms, false);
+      qrSolver.initMatrixStructure(inDesignVariables, inErrorTerms, false, numThreads);
 
 		  SM_INFO_STREAM("Marginalization optimization problem initialized with " << inDesignVariables.size() << " design variables and " << inErrorTerms.size() << " error terrms");
 		  SM_INFO_STREAM("The Jacobian matrix is " << dim << " x " << columnBase);
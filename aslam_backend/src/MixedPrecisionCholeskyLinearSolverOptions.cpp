@@ -0,0 +1,41 @@
+#include "aslam/backend/MixedPrecisionCholeskyLinearSolverOptions.h"
+
+namespace aslam {
+  namespace backend {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    MixedPrecisionCholeskyLinearSolverOptions::
+        MixedPrecisionCholeskyLinearSolverOptions() :
+        maxRefinementSteps(3),
+        refinementTolerance(1e-10),
+        verbose(false) {
+    }
+
+    MixedPrecisionCholeskyLinearSolverOptions::
+        MixedPrecisionCholeskyLinearSolverOptions(
+        const MixedPrecisionCholeskyLinearSolverOptions& other) :
+        maxRefinementSteps(other.maxRefinementSteps),
+        refinementTolerance(other.refinementTolerance),
+        verbose(other.verbose) {
+    }
+
+    MixedPrecisionCholeskyLinearSolverOptions&
+    MixedPrecisionCholeskyLinearSolverOptions::operator =
+        (const MixedPrecisionCholeskyLinearSolverOptions& other) {
+      if (this != &other) {
+        maxRefinementSteps = other.maxRefinementSteps;
+        refinementTolerance = other.refinementTolerance;
+        verbose = other.verbose;
+      }
+      return *this;
+    }
+
+    MixedPrecisionCholeskyLinearSolverOptions::
+        ~MixedPrecisionCholeskyLinearSolverOptions() {
+    }
+
+  }
+}
@@ -0,0 +1,261 @@
+#include <aslam/backend/MixedPrecisionCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
+#include <sm/PropertyTree.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace aslam {
+  namespace backend {
+    MixedPrecisionCholeskyLinearSystemSolver::MixedPrecisionCholeskyLinearSystemSolver(const MixedPrecisionCholeskyLinearSolverOptions& options) :
+        _isPatternAnalyzed(false), _isFactorized(false), _numRefinementSteps(0), _relativeResidual(0.0), _options(options) {}
+
+    MixedPrecisionCholeskyLinearSystemSolver::MixedPrecisionCholeskyLinearSystemSolver(const sm::PropertyTree& config) :
+        _isPatternAnalyzed(false), _isFactorized(false), _numRefinementSteps(0), _relativeResidual(0.0) {
+      _options.maxRefinementSteps = config.getInt("maxRefinementSteps", _options.maxRefinementSteps);
+      _options.refinementTolerance = config.getDouble("refinementTolerance", _options.refinementTolerance);
+      _options.verbose = config.getBool("verbose", _options.verbose);
+    }
+
+    MixedPrecisionCholeskyLinearSystemSolver::~MixedPrecisionCholeskyLinearSystemSolver() {}
+
+    void MixedPrecisionCholeskyLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner)
+    {
+      _errorTerms = errors;
+      _isPatternAnalyzed = false;
+      _isFactorized = false;
+      _useDiagonalConditioner = useDiagonalConditioner;
+      _jacobianBuilder.initMatrixStructure(dvs, errors, _numThreadsInitMatrixStructure);
+      initHessianStructure();
+      // We can't do the factorization as the function requires numerical values.
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::initHessianStructure()
+    {
+      const CompressedColumnMatrix<int, float>& J_transpose = _jacobianBuilder.J_transpose();
+      const std::vector<int>& aColPtr = J_transpose.col_ptr();
+      const std::vector<int>& aRowInd = J_transpose.row_ind();
+      const int n = (int)J_transpose.rows();
+      const int m = (int)J_transpose.cols();
+
+      // Row wise access to J^T: for every design variable column of J the Jacobian rows touching it,
+      // sorted by Jacobian row, and the position of the entry in J^T.
+      _jtRowPtr.assign(n + 1, 0);
+      for (int k = 0; k < m; ++k) {
+        for (int idx = aColPtr[k]; idx < aColPtr[k + 1]; ++idx) {
+          ++_jtRowPtr[aRowInd[idx] + 1];
+        }
+      }
+      for (int r = 0; r < n; ++r) {
+        _jtRowPtr[r + 1] += _jtRowPtr[r];
+      }
+      _jtRowCol.resize(_jtRowPtr[n]);
+      _jtRowEntry.resize(_jtRowPtr[n]);
+      std::vector<int> fill(_jtRowPtr.begin(), _jtRowPtr.end() - 1);
+      for (int k = 0; k < m; ++k) {
+        for (int idx = aColPtr[k]; idx < aColPtr[k + 1]; ++idx) {
+          _jtRowEntry[fill[aRowInd[idx]]] = idx;
+          _jtRowCol[fill[aRowInd[idx]]++] = k;
+        }
+      }
+
+      // The upper triangle of J^T J. Column j holds every row i <= j sharing a Jacobian row with j.
+      // The diagonal is always stored so that the conditioner can be added to it.
+      std::vector<int> marker(n, -1);
+      std::vector<int> hColPtr(n + 1, 0);
+      std::vector<int> hRowInd;
+      for (int j = 0; j < n; ++j) {
+        marker[j] = j;
+        hRowInd.push_back(j);
+        for (int p = _jtRowPtr[j]; p < _jtRowPtr[j + 1]; ++p) {
+          const int k = _jtRowCol[p];
+          for (int idx = aColPtr[k]; idx < aColPtr[k + 1]; ++idx) {
+            const int i = aRowInd[idx];
+            if (i < j && marker[i] != j) {
+              marker[i] = j;
+              hRowInd.push_back(i);
+            }
+          }
+        }
+        SM_ASSERT_LE(Exception, hRowInd.size(), (size_t)std::numeric_limits<int>::max(),
+                     "J^T J has too many nonzeros for int indices. Use the sparse_cholesky solver.");
+        hColPtr[j + 1] = hRowInd.size();
+        std::sort(hRowInd.begin() + hColPtr[j], hRowInd.end());
+      }
+      const std::vector<float> hValues(hRowInd.size(), 0.0f);
+      _hessian = Eigen::Map<const HessianMatrix>(n, n, hRowInd.size(), hColPtr.data(), hRowInd.data(), hValues.data());
+      _jtjDiagonal.setZero(n);
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::assembleHessianColumns(size_t startCol, size_t endCol)
+    {
+      const CompressedColumnMatrix<int, float>& J_transpose = _jacobianBuilder.J_transpose();
+      const int* aColPtr = J_transpose.col_ptr().data();
+      const int* aRowInd = J_transpose.row_ind().data();
+      const float* aValues = J_transpose.values().data();
+      const int* hColPtr = _hessian.outerIndexPtr();
+      const int* hRowInd = _hessian.innerIndexPtr();
+      float* hValues = _hessian.valuePtr();
+      std::fill(hValues + hColPtr[startCol], hValues + hColPtr[endCol], 0.0f);
+      // Column j of J^T J is the sum over the columns k of J^T touching row j of their entries above j times
+      // their entry in row j. Only the J^T entries of the rows [startCol, endCol) are visited.
+      for (size_t j = startCol; j < endCol; ++j) {
+        const int* slotBegin = hRowInd + hColPtr[j];
+        const int* slotEnd = hRowInd + hColPtr[j + 1] - 1;
+        double diagonal = 0.0;
+        for (int e = _jtRowPtr[j]; e < _jtRowPtr[j + 1]; ++e) {
+          const int q = _jtRowEntry[e];
+          const double vj = aValues[q];
+          // The rows of both columns are sorted, the diagonal is the last entry of the column.
+          const int* slot = slotBegin;
+          for (int p = aColPtr[_jtRowCol[e]]; p != q; ++p) {
+            slot = std::lower_bound(slot, slotEnd, aRowInd[p]);
+            hValues[slot - hRowInd] += (float)(aValues[p] * vj);
+          }
+          diagonal += vj * vj;
+        }
+        _jtjDiagonal[j] = diagonal;
+      }
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::buildSystem(size_t nThreads, bool useMEstimator)
+    {
+      buildJacobian(_jacobianBuilder, nThreads, useMEstimator);
+      const CompressedColumnMatrix<int, float>& J_transpose = _jacobianBuilder.J_transpose();
+      J_transpose.rightMultiply(_e, _rhs);
+
+      const size_t n = _hessian.cols();
+      nThreads = std::max((size_t)1, std::min(nThreads, n));
+      if (nThreads <= 1) {
+        assembleHessianColumns(0, n);
+      } else {
+        // Split the columns by their number of stored entries to balance the work.
+        std::vector<size_t> indices(nThreads + 1, n);
+        indices[0] = 0;
+        const int* hColPtr = _hessian.outerIndexPtr();
+        const size_t nnzPerThread = _hessian.nonZeros() / nThreads;
+        size_t t = 1;
+        for (size_t j = 0; j < n && t < nThreads; ++j) {
+          if ((size_t)hColPtr[j + 1] >= t * nnzPerThread) {
+            indices[t++] = j + 1;
+          }
+        }
+        util::runThreadedJob([this, &indices](size_t /* threadId */, size_t startIdx, size_t endIdx) {
+          for (size_t i = startIdx; i < endIdx; ++i) {
+            assembleHessianColumns(indices[i], indices[i + 1]);
+          }
+        }, nThreads, nThreads);
+      }
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::multiplyNormalEquations(const Eigen::VectorXd& x, Eigen::VectorXd& outY) const
+    {
+      const CompressedColumnMatrix<int, float>& J_transpose = _jacobianBuilder.J_transpose();
+      Eigen::VectorXd Jx;
+      J_transpose.leftMultiply(x, Jx);
+      J_transpose.rightMultiply(Jx, outY);
+      if (_useDiagonalConditioner) {
+        outY += _diagonalConditioner.cwiseAbs2().cwiseProduct(x);
+      }
+    }
+
+    bool MixedPrecisionCholeskyLinearSystemSolver::solveSystem(Eigen::VectorXd& outDx)
+    {
+      const int n = _hessian.cols();
+      const int* hColPtr = _hessian.outerIndexPtr();
+      float* hValues = _hessian.valuePtr();
+      for (int j = 0; j < n; ++j) {
+        hValues[hColPtr[j + 1] - 1] = _jtjDiagonal[j] +
+            (_useDiagonalConditioner ? _diagonalConditioner[j] * _diagonalConditioner[j] : 0.0);
+      }
+      if (!_isPatternAnalyzed) {
+        // The symbolic analysis only depends on the sparsity pattern.
+        _factor.analyzePattern(_hessian);
+        _isPatternAnalyzed = true;
+      }
+      _factor.factorize(_hessian);
+      _isFactorized = _factor.info() == Eigen::Success;
+      if (!_isFactorized) {
+        std::cout << "Factorization failed\n";
+        return false;
+      }
+      solveFactorizedSystem(_rhs, outDx);
+      return true;
+    }
+
+    bool MixedPrecisionCholeskyLinearSystemSolver::solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)rhs.size(), _JCols, "The right-hand side has the wrong size");
+      if (!_isFactorized) {
+        return false;
+      }
+      solveFactorizedSystem(rhs, outDx);
+      return true;
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::solveFactorizedSystem(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx)
+    {
+      _numRefinementSteps = 0;
+      outDx = _factor.solve(rhs.cast<float>()).cast<double>();
+
+      // Iterative refinement: the residual is evaluated in double precision through J instead of the squared system.
+      const double rhsNorm = rhs.norm();
+      Eigen::VectorXd Ax;
+      while (true) {
+        multiplyNormalEquations(outDx, Ax);
+        _refinementResidual = rhs - Ax;
+        _relativeResidual = rhsNorm > 0.0 ? _refinementResidual.norm() / rhsNorm : _refinementResidual.norm();
+        if (_options.verbose) {
+          std::cout << "Refinement step " << _numRefinementSteps << ": relative residual " << _relativeResidual << std::endl;
+        }
+        if (_relativeResidual <= _options.refinementTolerance || _numRefinementSteps >= _options.maxRefinementSteps) {
+          break;
+        }
+        outDx += _factor.solve(_refinementResidual.cast<float>()).cast<double>();
+        ++_numRefinementSteps;
+      }
+    }
+
+    bool MixedPrecisionCholeskyLinearSystemSolver::multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const
+    {
+      _jacobianBuilder.J_transpose().leftMultiply(x, outJx);
+      return true;
+    }
+
+    bool MixedPrecisionCholeskyLinearSystemSolver::multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const
+    {
+      _jacobianBuilder.J_transpose().rightMultiply(y, outJty);
+      return true;
+    }
+
+    const CompressedColumnMatrix<int, float>& MixedPrecisionCholeskyLinearSystemSolver::getJacobianTranspose() const {
+      return _jacobianBuilder.J_transpose();
+    }
+
+    const MixedPrecisionCholeskyLinearSolverOptions&
+    MixedPrecisionCholeskyLinearSystemSolver::getOptions() const {
+      return _options;
+    }
+
+    MixedPrecisionCholeskyLinearSolverOptions&
+    MixedPrecisionCholeskyLinearSystemSolver::getOptions() {
+      return _options;
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::setOptions(
+        const MixedPrecisionCholeskyLinearSolverOptions& options) {
+      _options = options;
+    }
+
+    double MixedPrecisionCholeskyLinearSystemSolver::rhsJtJrhs() {
+      const CompressedColumnMatrix<int, float>& J_transpose = _jacobianBuilder.J_transpose();
+      Eigen::VectorXd Jrhs;
+      J_transpose.leftMultiply(_rhs, Jrhs);
+      return Jrhs.squaredNorm();
+    }
+
+    void MixedPrecisionCholeskyLinearSystemSolver::handleNewAcceptConstantErrorTerms() {
+      _jacobianBuilder.J_transpose().setAcceptConstantErrorTerms(isAcceptConstantErrorTerms());
+    }
+  } // namespace backend
+}  // namespace aslam
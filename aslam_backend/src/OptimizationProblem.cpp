@@ -3,6 +3,9 @@
 #include <aslam/backend/ErrorTerm.hpp>
 #include <sm/boost/null_deleter.hpp>
 #include "../include/aslam/backend/ScalarNonSquaredErrorTerm.hpp"
+#include <aslam/Exceptions.hpp>
+#include <algorithm>
+#include <utility>
 
 namespace aslam {
   namespace backend {
@@ -16,30 +19,126 @@ namespace aslam {
     }
 
 
+    template <typename ErrorTermType>
+    void OptimizationProblem::ErrorTermIndex<ErrorTermType>::add(const boost::shared_ptr<ErrorTermType> & et)
+    {
+      SM_ASSERT_FALSE(aslam::InvalidArgumentException, contains(et.get()), "That error term has already been added");
+      _errorTerms.push_back(et);
+      size_t numAdded = 0;
+      try {
+        Entry & entry = _entries.emplace(et.get(), Entry()).first->second;
+        entry.slot = _errorTerms.size() - 1;
+        entry.positions.resize(et->numDesignVariables());
+        for (; numAdded < et->numDesignVariables(); ++numAdded) {
+          std::vector<ErrorTermType*> & terms = _errorTermsOfDesignVariable[et->designVariable(numAdded)];
+          entry.positions[numAdded] = terms.size();
+          terms.push_back(et.get());
+        }
+      } catch (...) {
+        // Roll back such that a failed allocation leaves the index unchanged
+        for (size_t i = std::min(numAdded + 1, et->numDesignVariables()); i-- > 0; ) {
+          auto lit = _errorTermsOfDesignVariable.find(et->designVariable(i));
+          if (lit == _errorTermsOfDesignVariable.end())
+            continue;
+          if (i < numAdded)
+            lit->second.pop_back();
+          if (lit->second.empty())
+            _errorTermsOfDesignVariable.erase(lit);
+        }
+        _entries.erase(et.get());
+        _errorTerms.pop_back();
+        throw;
+      }
+    }
+
+    template <typename ErrorTermType>
+    void OptimizationProblem::ErrorTermIndex<ErrorTermType>::remove(const ErrorTermType* et)
+    {
+      auto eit = _entries.find(et);
+      if (eit == _entries.end())
+        return;
+      Entry & entry = eit->second;
+      // Swap and pop the error term from the lists of its design variables
+      for (size_t i = 0; i < et->numDesignVariables(); ++i) {
+        const DesignVariable* dv = et->designVariable(i);
+        auto lit = _errorTermsOfDesignVariable.find(dv);
+        std::vector<ErrorTermType*> & terms = lit->second;
+        const size_t last = terms.size() - 1;
+        if (entry.positions[i] != last) {
+          ErrorTermType* moved = terms[last];
+          terms[entry.positions[i]] = moved;
+          Entry & movedEntry = _entries.find(moved)->second;
+          for (size_t j = 0; j < moved->numDesignVariables(); ++j) {
+            if (moved->designVariable(j) == dv && movedEntry.positions[j] == last) {
+              movedEntry.positions[j] = entry.positions[i];
+              break;
+            }
+          }
+        }
+        terms.pop_back();
+        if (terms.empty())
+          _errorTermsOfDesignVariable.erase(lit);
+      }
+      // Swap and pop the error term from the slots, the error term may be deleted afterwards
+      const size_t slot = entry.slot;
+      _entries.erase(eit);
+      if (slot != _errorTerms.size() - 1) {
+        std::swap(_errorTerms[slot], _errorTerms.back());
+        _entries.find(_errorTerms[slot].get())->second.slot = slot;
+      }
+      _errorTerms.pop_back();
+    }
+
+    template <typename ErrorTermType>
+    void OptimizationProblem::ErrorTermIndex<ErrorTermType>::clear()
+    {
+      _entries.clear();
+      _errorTermsOfDesignVariable.clear();
+      _errorTerms.clear();
+    }
+
+    template <typename ErrorTermType>
+    void OptimizationProblem::ErrorTermIndex<ErrorTermType>::reserve(size_t numErrorTerms, size_t numDesignVariables)
+    {
+      _errorTerms.reserve(numErrorTerms);
+      _entries.reserve(numErrorTerms);
+      _errorTermsOfDesignVariable.reserve(numDesignVariables);
+    }
+
+    template <typename ErrorTermType>
+    const std::vector<ErrorTermType*> & OptimizationProblem::ErrorTermIndex<ErrorTermType>::errorTerms(const DesignVariable* dv) const
+    {
+      static const std::vector<ErrorTermType*> empty;
+      auto it = _errorTermsOfDesignVariable.find(dv);
+      return it == _errorTermsOfDesignVariable.end() ? empty : it->second;
+    }
+
+
     /// \brief Add a design variable to the problem. If the second
     /// argument is true, the design variable will be deleted
     /// when the problem is cleared or goes out of scope.
     void OptimizationProblem::addDesignVariable(DesignVariable* dv, bool problemOwnsVariable)
     {
-      // \todo This is also bad and slow.
-      for (unsigned i = 0; i < _designVariables.size(); ++i) {
-        SM_ASSERT_NE(std::runtime_error, dv, _designVariables[i].get(), "That design variable has already been added");
-      }
+      // Check before taking ownership, a rejected design variable must not be deleted
+      SM_ASSERT_FALSE(std::runtime_error, isDesignVariableInProblem(dv), "That design variable has already been added");
       if (problemOwnsVariable)
-        _designVariables.push_back(boost::shared_ptr<DesignVariable>(dv));
+        addDesignVariable(boost::shared_ptr<DesignVariable>(dv));
       else
-        _designVariables.push_back(boost::shared_ptr<DesignVariable>(dv, sm::null_deleter()));
+        addDesignVariable(boost::shared_ptr<DesignVariable>(dv, sm::null_deleter()));
     }
 
 
     /// \brief Add a design variable to the problem.
     void OptimizationProblem::addDesignVariable(boost::shared_ptr<DesignVariable> dv)
     {
-      // \todo This is also bad and slow.
-      for (unsigned i = 0; i < _designVariables.size(); ++i) {
-        SM_ASSERT_NE(std::runtime_error, dv.get(), _designVariables[i].get(), "That design variable has already been added");
-      }
+      SM_ASSERT_FALSE(std::runtime_error, isDesignVariableInProblem(dv.get()), "That design variable has already been added");
       _designVariables.push_back(dv);
+      try {
+        _designVariableSlots.emplace(dv.get(), _designVariables.size() - 1);
+      } catch (...) {
+        _designVariables.pop_back();
+        throw;
+      }
     }
 
 
@@ -48,6 +147,8 @@ namespace aslam {
     /// problem is cleared or goes out of scope.
     void OptimizationProblem::addErrorTerm(ErrorTerm* ev, bool problemOwnsVariable)
     {
+      // Check before taking ownership, a rejected error term must not be deleted
+      SM_ASSERT_FALSE(aslam::InvalidArgumentException, _errorTerms.contains(ev), "That error term has already been added");
       if (problemOwnsVariable)
         addErrorTerm(boost::shared_ptr<ErrorTerm>(ev));
       else
@@ -60,6 +161,7 @@ namespace aslam {
     /// problem is cleared or goes out of scope.
     void OptimizationProblem::addErrorTerm(ScalarNonSquaredErrorTerm* ev, bool problemOwnsVariable)
     {
+      SM_ASSERT_FALSE(aslam::InvalidArgumentException, _sNSErrorTerms.contains(ev), "That error term has already been added");
       if (problemOwnsVariable)
         addErrorTerm(boost::shared_ptr<ScalarNonSquaredErrorTerm>(ev));
       else
@@ -70,35 +172,25 @@ namespace aslam {
     /// \brief Add an error term to the problem
     void OptimizationProblem::addErrorTerm(const boost::shared_ptr<ErrorTerm> & et)
     {
-      _errorTerms.push_back(et);
-      // add this error term to the multi-map
       for (size_t i = 0; i < et->numDesignVariables(); ++i) {
-        DesignVariable* dv = et->designVariable(i);
-        SM_ASSERT_TRUE_DBG(aslam::InvalidArgumentException, isDesignVariableInProblem(dv), "It is illegal to add an error term that contains a missing design variable. Add the design variables to the problem before adding the error terms.");
-        _errorTermMap.insert(std::make_pair(dv, et.get()));
+        SM_ASSERT_TRUE_DBG(aslam::InvalidArgumentException, isDesignVariableInProblem(et->designVariable(i)), "It is illegal to add an error term that contains a missing design variable. Add the design variables to the problem before adding the error terms.");
       }
+      _errorTerms.add(et);
     }
 
     /// \brief Add a scalar non-squared error term to the problem
     void OptimizationProblem::addErrorTerm(const boost::shared_ptr<ScalarNonSquaredErrorTerm> & et)
     {
-      _sNSErrorTerms.push_back(et);
-      // add this error term to the multi-map
       for (size_t i = 0; i < et->numDesignVariables(); ++i) {
-        DesignVariable* dv = et->designVariable(i);
-        SM_ASSERT_TRUE_DBG(aslam::InvalidArgumentException, isDesignVariableInProblem(dv), "It is illegal to add an error term that contains a missing design variable. Add the design variables to the problem before adding the error terms.");
-        _errorTermMapSns.insert(std::make_pair(dv, et.get()));
+        SM_ASSERT_TRUE_DBG(aslam::InvalidArgumentException, isDesignVariableInProblem(et->designVariable(i)), "It is illegal to add an error term that contains a missing design variable. Add the design variables to the problem before adding the error terms.");
       }
+      _sNSErrorTerms.add(et);
     }
 
 
     bool OptimizationProblem::isDesignVariableInProblem(const DesignVariable* dv)
     {
-      for (size_t i = 0; i < _designVariables.size(); ++i) {
-        if (_designVariables[i].get() == dv)
-          return true;
-      }
-      return false;
+      return _designVariableSlots.count(dv) > 0;
     }
 
     /// \brief clear the design variables and error terms.
@@ -107,8 +199,15 @@ namespace aslam {
       _errorTerms.clear();
       _sNSErrorTerms.clear();
       _designVariables.clear();
-      _errorTermMap.clear();
-      _errorTermMapSns.clear();
+      _designVariableSlots.clear();
+    }
+
+    void OptimizationProblem::reserve(size_t numDesignVariables, size_t numErrorTerms, size_t numNonSquaredErrorTerms)
+    {
+      _designVariables.reserve(numDesignVariables);
+      _designVariableSlots.reserve(numDesignVariables);
+      _errorTerms.reserve(numErrorTerms, numDesignVariables);
+      _sNSErrorTerms.reserve(numNonSquaredErrorTerms, numNonSquaredErrorTerms > 0 ? numDesignVariables : 0);
     }
 
 
@@ -139,94 +238,64 @@ namespace aslam {
 
     ErrorTerm* OptimizationProblem::errorTermImplementation(size_t i)
     {
-      return _errorTerms[i].get();
+      return _errorTerms.at(i);
     }
 
     ScalarNonSquaredErrorTerm* OptimizationProblem::nonSquaredErrorTermImplementation(size_t i)
     {
-      return _sNSErrorTerms[i].get();
+      return _sNSErrorTerms.at(i);
     }
 
     const ErrorTerm* OptimizationProblem::errorTermImplementation(size_t i) const
     {
-      return _errorTerms[i].get();
+      return _errorTerms.at(i);
     }
     const ScalarNonSquaredErrorTerm* OptimizationProblem::nonSquaredErrorTermImplementation(size_t i) const
     {
-      return _sNSErrorTerms[i].get();
+      return _sNSErrorTerms.at(i);
     }
 
     void OptimizationProblem::getErrorsImplementation(const DesignVariable* dv, std::set<ErrorTerm*>& outErrorSet)
     {
-      error_map_t::iterator it, it_end;
-      // I'm not sure why this const cast is necessary but I get a failure on OSX if it isn't here.
-      // Also, somehow this is painfully slow.
-      boost::tie(it, it_end) = _errorTermMap.equal_range(const_cast<DesignVariable*>(dv));
-      for (; it != it_end; ++it) {
-        outErrorSet.insert(it->second);
-      }
+      const std::vector<ErrorTerm*> & terms = _errorTerms.errorTerms(dv);
+      outErrorSet.insert(terms.begin(), terms.end());
     }
 
     void OptimizationProblem::getNonSquaredErrorsImplementation(const DesignVariable* dv, std::set<ScalarNonSquaredErrorTerm*>& outErrorSet)
     {
-      error_map_sns_t::iterator it, it_end;
-      // I'm not sure why this const cast is necessary but I get a failure on OSX if it isn't here.
-      // Also, somehow this is painfully slow.
-      boost::tie(it, it_end) = _errorTermMapSns.equal_range(const_cast<DesignVariable*>(dv));
-      for (; it != it_end; ++it) {
-        outErrorSet.insert(it->second);
-      }
+      const std::vector<ScalarNonSquaredErrorTerm*> & terms = _sNSErrorTerms.errorTerms(dv);
+      outErrorSet.insert(terms.begin(), terms.end());
     }
 
     /// \brief Remove the error term
     void OptimizationProblem::removeErrorTerm(const ErrorTerm* et)
     {
-      // For each design variable associated with this error term
-      for (size_t i = 0; i < et->numDesignVariables(); ++i) {
-        const DesignVariable* dv = et->designVariable(i);
-        error_map_t::iterator it, it_end;
-        boost::tie(it, it_end) = _errorTermMap.equal_range(const_cast<DesignVariable*>(dv));
-        for (; it != it_end; it++) {
-          if (it->second == et) {
-            // remove the reference from the multi-map.
-            _errorTermMap.erase(it);
-            break;
-          }
-        }
-      }
-      // now remove the design variable.
-      // This sucks. \todo Make this more efficient.
-      std::vector< boost::shared_ptr<ErrorTerm> >::iterator eit = _errorTerms.begin();
-      for (; eit != _errorTerms.end(); ++eit) {
-        if (eit->get() == et) {
-          // remove this error term from the set of error terms.
-          _errorTerms.erase(eit);
-          break;
-        }
-      }
+      _errorTerms.remove(et);
     }
 
     /// \brief Remove the design variable
     void OptimizationProblem::removeDesignVariable(const DesignVariable* dv)
     {
-      // Remove any error terms from the project
-      error_map_t::iterator it, it2, it_end;
-      boost::tie(it, it_end) = _errorTermMap.equal_range(const_cast<DesignVariable*>(dv));
-      std::vector<ErrorTerm*> terms;
-      for (; it != it_end; ++it) {
-        terms.push_back(it->second);
+      // Remove any error terms from the problem, copying the lists as removing modifies them
+      const std::vector<ErrorTerm*> terms = _errorTerms.errorTerms(dv);
+      for (ErrorTerm* et : terms) {
+        _errorTerms.remove(et);
       }
-      for (size_t i = 0; i < terms.size(); ++i) {
-        removeErrorTerm(terms[i]);
+      const std::vector<ScalarNonSquaredErrorTerm*> sNSTerms = _sNSErrorTerms.errorTerms(dv);
+      for (ScalarNonSquaredErrorTerm* et : sNSTerms) {
+        _sNSErrorTerms.remove(et);
       }
       // Now remove the design variable itself.
-      std::vector< boost::shared_ptr<DesignVariable> >::iterator dit = _designVariables.begin();
-      for (; dit != _designVariables.end(); ++dit) {
-        if (dit->get() == dv) {
-          _designVariables.erase(dit);
-          return;
-        }
+      auto it = _designVariableSlots.find(dv);
+      if (it == _designVariableSlots.end())
+        return;
+      const size_t slot = it->second;
+      _designVariableSlots.erase(it);
+      if (slot != _designVariables.size() - 1) {
+        std::swap(_designVariables[slot], _designVariables.back());
+        _designVariableSlots[_designVariables[slot].get()] = slot;
       }
+      _designVariables.pop_back();
     }
 
     size_t OptimizationProblem::countActiveDesignVariables() {
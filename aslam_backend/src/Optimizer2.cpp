@@ -37,6 +37,12 @@ namespace aslam {
 
         void Optimizer2::Status::resetImplementation() {
           srv = SolutionReturnValue();
+          numLazyJacobianUpdates = 0;
+          numFrozenDesignVariables = 0;
+          numReactivatedDesignVariables = 0;
+          numActiveSetUpdates = 0;
+          numSkippedJacobians = 0;
+          numCandidateSteps = 0;
         }
 
         Optimizer2::Optimizer2(const Options& options) :
@@ -54,6 +60,26 @@ namespace aslam {
           options.doSchurComplement = config.getBool("doSchurComplement", options.doSchurComplement);
           options.verbose = config.getBool("verbose", options.verbose);
           options.linearSolverMaximumFails = config.getInt("linearSolverMaximumFails", options.linearSolverMaximumFails);
+          const std::string jacobianUpdate = config.getString("jacobianUpdate", "full");
+          if (jacobianUpdate == "full") {
+            options.jacobianUpdate = LinearSystemSolver::JACOBIAN_FULL;
+          } else if (jacobianUpdate == "broyden") {
+            options.jacobianUpdate = LinearSystemSolver::JACOBIAN_BROYDEN;
+          } else if (jacobianUpdate == "partial") {
+            options.jacobianUpdate = LinearSystemSolver::JACOBIAN_PARTIAL;
+          } else {
+            SM_THROW(Exception, "Unknown jacobianUpdate " << jacobianUpdate << ". Use full, broyden or partial.");
+          }
+          options.maxJacobianAge = config.getInt("maxJacobianAge", options.maxJacobianAge);
+          options.jacobianStallRatio = config.getDouble("jacobianStallRatio", options.jacobianStallRatio);
+          options.jacobianRefreshTolerance = config.getDouble("jacobianRefreshTolerance", options.jacobianRefreshTolerance);
+          options.useActiveSet = config.getBool("useActiveSet", options.useActiveSet);
+          options.activeSetFreezeThreshold = config.getDouble("activeSetFreezeThreshold", options.activeSetFreezeThreshold);
+          options.activeSetFreezeIterations = config.getInt("activeSetFreezeIterations", options.activeSetFreezeIterations);
+          options.activeSetReactivationThreshold = config.getDouble("activeSetReactivationThreshold", options.activeSetReactivationThreshold);
+          options.activeSetUpdateInterval = config.getInt("activeSetUpdateInterval", options.activeSetUpdateInterval);
+          options.activeSetMinFreezeFraction = config.getDouble("activeSetMinFreezeFraction", options.activeSetMinFreezeFraction);
+          options.mEstimatorWeightThreshold = config.getDouble("mEstimatorWeightThreshold", options.mEstimatorWeightThreshold);
           options.numThreadsJacobian = getDeprecatedPropertyIfItExists(config, "nThreads", "numThreadsJacobian", (int)options.numThreadsJacobian, static_cast<int(sm::ConstPropertyTree::*)(const std::string&, int) const>(&sm::ConstPropertyTree::getInt));
           options.numThreadsError = config.getInt("numThreadsError", options.numThreadsError);
           options.linearSystemSolver = linearSystemSolver;
@@ -78,12 +104,6 @@ namespace aslam {
           }
 
 
-          // \todo remove this check when the sparse qr solver supports an augmented diagonal
-          if(_solver->name() == "sparse_qr" && _trustRegionPolicy->name() == "levenberg_marquardt") {
-            _options.verbose && std::cout << "The sparse_qr solver is not compatible with levenberg_marquardt. Changing to the dog_leg trust region policy\n";
-            _trustRegionPolicy.reset( new DogLegTrustRegionPolicy() );
-          }
-
           _options.verbose && std::cout << "Using the " << _trustRegionPolicy->name() << " trust region policy\n";
 
         }
@@ -109,7 +129,7 @@ namespace aslam {
 
             Timer initMx("Optimizer2: Initialize---Matrices");
             // Set up the block matrix structure.
-            _solver->initMatrixStructure(getDesignVariables(), problemManager().getErrorTerms(), _trustRegionPolicy->requiresAugmentedDiagonal());
+            _solver->initMatrixStructure(getDesignVariables(), problemManager().getErrorTerms(), _trustRegionPolicy->requiresAugmentedDiagonal(), _options.numThreadsJacobian);
             initMx.stop();
             _options.verbose && std::cout << "Optimization problem initialized with " << problemManager().numDesignVariables() << " design variables and " << problemManager().getErrorTerms().size() << " error terms\n";
             _options.verbose && std::cout << "The Jacobian matrix is " << problemManager().getTotalDimSquaredErrorTerms() << " x " << problemManager().numOptParameters() << std::endl;
@@ -178,8 +198,28 @@ namespace aslam {
             bool linearSolverFailure = false;
 
             SM_ASSERT_TRUE(Exception, _solver.get() != NULL, "The solver is null");
+            // Lazy Jacobian updates: start from a full Jacobian as the state may have changed since the last run
+            const bool lazyJacobian = _options.jacobianUpdate != LinearSystemSolver::JACOBIAN_FULL && _solver->supportsLazyJacobian();
+            if (_options.jacobianUpdate != LinearSystemSolver::JACOBIAN_FULL && !lazyJacobian)
+              _options.verbose && std::cout << "[WARNING] The " << _solver->name() << " linear system solver does not support lazy Jacobian updates\n";
+            _solver->setJacobianUpdate(lazyJacobian ? _options.jacobianUpdate : LinearSystemSolver::JACOBIAN_FULL, _options.jacobianRefreshTolerance);
+            _solver->requestFullJacobian();
+            _solver->setMEstimatorWeightThreshold(_options.mEstimatorWeightThreshold);
+            bool lazyJacobianStalled = false;
+            double previousDeltaJ = std::numeric_limits<double>::infinity();
             _trustRegionPolicy->setSolver(_solver);
+            _trustRegionPolicy->setStateUpdateFunctions(
+                // Probe steps are taken back right away and are no motion of the linearization point
+                [this](const Eigen::VectorXd& dx) { applyStateUpdate(dx, false); },
+                [this](const Eigen::VectorXd& dx) { revertLastStateUpdate(dx, false); },
+                [this]() {
+                  // A probe of the policy, not an iterate: the status error and the callbacks are left alone
+                  _solver->evaluateError(_options.numThreadsError, true);
+                  _status.numErrorEvaluations++;
+                });
             _trustRegionPolicy->optimizationStarting(_status.error);
+            if (_options.useActiveSet)
+              initializeActiveSet();
 
             issueCallback<callback::event::OPTIMIZATION_INITIALIZED>();
 
@@ -190,9 +230,17 @@ namespace aslam {
                      fabs(deltaJ) > _options.convergenceDeltaError) ||
                     linearSolverFailure)) {
 
+                if (lazyJacobian && (previousIterationFailed || lazyJacobianStalled || _solver->jacobianAge() >= size_t(std::max(0, _options.maxJacobianAge))))
+                  _solver->requestFullJacobian();
+                const size_t jacobianAge = _solver->jacobianAge();
+                const size_t numSkippedJacobians = _solver->numSkippedJacobians();
+
                 timeSolve.start();
                 bool solutionSuccess = _trustRegionPolicy->solveSystem(_status.error, previousIterationFailed, _options.numThreadsError, _dx);
                 _status.numJacobianEvaluations++;
+                if (_solver->jacobianAge() > jacobianAge)
+                  _status.numLazyJacobianUpdates++;
+                _status.numSkippedJacobians += _solver->numSkippedJacobians() - numSkippedJacobians;
                 SM_ASSERT_EQ(Exception, problemManager().numOptParameters(), size_t(_dx.size()), "_trustRegionPolicy->solveSystem yielded dx with wrong size!");
                 timeSolve.stop();
                 issueCallback<callback::event::LINEAR_SYSTEM_SOLVED>();
@@ -216,10 +264,18 @@ namespace aslam {
                     // This was a regression.
                     if( _trustRegionPolicy->revertOnFailure() )
                     {
-                        if(deltaJ < 0.0)
+                        const bool evaluateCandidates = deltaJ < 0.0 && _trustRegionPolicy->numCandidates() > 1;
+                        if (evaluateCandidates && evaluateCandidateSteps())
+                        {
+                            // evaluateCandidateSteps() updated deltaX and deltaJ
+                            _p_J = _status.error;
+                            previousIterationFailed = false;
+                        }
+                        else if(deltaJ < 0.0)
                         {
                             _options.verbose && std::cout << "Last step was a regression. Reverting\n";
-                            revertLastStateUpdate();
+                            if (!evaluateCandidates)
+                              revertLastStateUpdate();
                             srv.failedIterations++;
                             previousIterationFailed = true;
                         }
@@ -233,6 +289,13 @@ namespace aslam {
                     {
                         _p_J = _status.error;
                     }
+                    if (lazyJacobian && !previousIterationFailed) {
+                      // Force a full Jacobian if a step from a lazily updated Jacobian made little progress
+                      lazyJacobianStalled = _solver->jacobianAge() > 0 && deltaJ < _options.jacobianStallRatio * previousDeltaJ;
+                      previousDeltaJ = deltaJ;
+                    }
+                    if (_options.useActiveSet && !previousIterationFailed)
+                      updateActiveSet();
                     srv.iterations++;
                     _status.numIterations = srv.iterations;
 
@@ -241,6 +304,8 @@ namespace aslam {
                     _options.verbose && std::cout << std::endl;
                 }
             } // if the linear solver failed / else
+            if (_options.useActiveSet)
+              releaseActiveSet();
             srv.JFinal = _status.error = _p_J;
             srv.dXFinal = deltaX;
             srv.dJFinal = deltaJ;
@@ -274,19 +339,26 @@ namespace aslam {
 
 
             double Optimizer2::applyStateUpdate()
+            {
+                return applyStateUpdate(_dx);
+            }
+
+            double Optimizer2::applyStateUpdate(const Eigen::VectorXd& dx, bool notifySolver)
             {
                 // Apply the update to the dense state.
                 int startIdx = 0;
                 for (DesignVariable* d : getDesignVariables()) {
                     const int dbd = d->minimalDimensions();
-                    Eigen::VectorXd dxS = _dx.segment(startIdx, dbd);
+                    Eigen::VectorXd dxS = dx.segment(startIdx, dbd);
                     dxS *= d->scaling();
                     d->update(&dxS[0], dbd);
                     startIdx += dbd;
                 }
+                if (notifySolver)
+                    _solver->notifyStateUpdate(dx);
                 // Track the maximum delta
                 // \todo: should this be some other metric?
-                double deltaX = _dx.array().abs().maxCoeff();
+                double deltaX = dx.array().abs().maxCoeff();
                 return deltaX;
             }
 
@@ -295,10 +367,186 @@ namespace aslam {
 
 
             void Optimizer2::revertLastStateUpdate()
+            {
+                revertLastStateUpdate(_dx);
+            }
+
+            void Optimizer2::revertLastStateUpdate(const Eigen::VectorXd& dx, bool notifySolver)
             {
                 for (DesignVariable * d : getDesignVariables()) {
                     d->revertUpdate();
                 }
+                if (notifySolver)
+                    _solver->notifyStateUpdate(-dx);
+            }
+
+            bool Optimizer2::evaluateCandidateSteps()
+            {
+                const size_t numCandidates = _trustRegionPolicy->numCandidates();
+                revertLastStateUpdate();
+                // All candidates share the linearization. Their steps are solved at once, concurrently if the solver
+                // supports it. The evaluations are sequential as every one updates the design variables in place.
+                std::vector<Eigen::VectorXd> candidateDx;
+                _trustRegionPolicy->solveCandidates(_options.numThreadsError, candidateDx);
+                SM_ASSERT_LE(Exception, candidateDx.size(), numCandidates - 1, "The trust region policy returned too many candidate steps");
+                size_t best = 0, lastTried = 0;
+                double bestError = _p_J, bestDeltaX = 0.0;
+                Eigen::VectorXd bestDx;
+                bool applied = false;
+                for (size_t i = 1; i <= candidateDx.size(); ++i) {
+                    if (applied) {
+                        revertLastStateUpdate();
+                        applied = false;
+                    }
+                    if (candidateDx[i - 1].size() == 0)
+                        break;
+                    _dx = candidateDx[i - 1];
+                    lastTried = i;
+                    const double deltaX = applyStateUpdate();
+                    applied = true;
+                    evaluateError(true);
+                    _status.numCandidateSteps++;
+                    if (_status.error < bestError) {
+                        best = i;
+                        bestError = _status.error;
+                        bestDeltaX = deltaX;
+                        bestDx = _dx;
+                    }
+                }
+                if (best == 0) {
+                    // Continue increasing the damping from the last rejected candidate
+                    if (applied)
+                        revertLastStateUpdate();
+                    _trustRegionPolicy->selectCandidate(lastTried);
+                    return false;
+                }
+                if (best != lastTried || !applied) {
+                    if (applied)
+                        revertLastStateUpdate();
+                    _dx = bestDx;
+                    applyStateUpdate();
+                    evaluateError(true);
+                }
+                _options.verbose && std::cout << "Accepted candidate step " << best << " after a regression\n";
+                _trustRegionPolicy->selectCandidate(best);
+                _status.maxDeltaX = bestDeltaX;
+                _status.deltaError = _p_J - _status.error;
+                return true;
+            }
+
+            void Optimizer2::initializeActiveSet()
+            {
+                _activeSetDesignVariables = getDesignVariables();
+                const size_t numDvs = _activeSetDesignVariables.size();
+                _activeSetQuietIterations.assign(numDvs, 0);
+                _isFrozen.assign(numDvs, 0);
+                _isPendingReactivation.assign(numDvs, 0);
+                _activeSetIterationsSinceUpdate = 0;
+                // The design variables are sorted by block index, so blockIndex() maps them to the active set index
+                _activeSetNeighbours.assign(numDvs, std::vector<size_t>());
+                for (const ErrorTerm* e : problemManager().getErrorTerms()) {
+                    for (const DesignVariable* di : e->designVariables()) {
+                        if (!di->isActive())
+                            continue;
+                        for (const DesignVariable* dj : e->designVariables()) {
+                            if (dj != di && dj->isActive())
+                                _activeSetNeighbours[di->blockIndex()].push_back(dj->blockIndex());
+                        }
+                    }
+                }
+                for (auto& neighbours : _activeSetNeighbours) {
+                    std::sort(neighbours.begin(), neighbours.end());
+                    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+                }
+                // Error terms of frozen design variables only contribute a constant residual
+                _solverAcceptedConstantErrorTerms = _solver->isAcceptConstantErrorTerms();
+                _solver->setAcceptConstantErrorTerms(true);
+            }
+
+            void Optimizer2::updateActiveSet()
+            {
+                _activeSetIterationsSinceUpdate++;
+                const size_t numDvs = _activeSetDesignVariables.size();
+                std::vector<char> movedNeighbour(numDvs, 0);
+                std::vector<size_t> freeze;
+                size_t numActive = 0;
+                for (size_t i = 0; i < numDvs; ++i) {
+                    if (_isFrozen[i])
+                        continue;
+                    numActive++;
+                    const DesignVariable* d = _activeSetDesignVariables[i];
+                    const int dim = d->minimalDimensions();
+                    const double step = dim > 0 ? _dx.segment(d->columnBase(), dim).cwiseAbs().maxCoeff() : 0.0;
+                    if (step > _options.activeSetReactivationThreshold) {
+                        for (size_t j : _activeSetNeighbours[i])
+                            movedNeighbour[j] = 1;
+                    }
+                    _activeSetQuietIterations[i] = step < _options.activeSetFreezeThreshold ? _activeSetQuietIterations[i] + 1 : 0;
+                }
+                for (size_t i = 0; i < numDvs; ++i) {
+                    if (_isFrozen[i] && movedNeighbour[i])
+                        _isPendingReactivation[i] = 1;
+                }
+                // Every structure update rebuilds the linear system, so changes are batched instead of following every step
+                if (_activeSetIterationsSinceUpdate < _options.activeSetUpdateInterval)
+                    return;
+                bool changed = false;
+                for (size_t i = 0; i < numDvs; ++i) {
+                    if (_isPendingReactivation[i]) {
+                        _isPendingReactivation[i] = 0;
+                        _isFrozen[i] = 0;
+                        _activeSetQuietIterations[i] = 0;
+                        _activeSetDesignVariables[i]->setActive(true);
+                        _status.numReactivatedDesignVariables++;
+                        numActive++;
+                        changed = true;
+                    } else if (!_isFrozen[i] && !movedNeighbour[i] && _activeSetQuietIterations[i] >= _options.activeSetFreezeIterations) {
+                        freeze.push_back(i);
+                    }
+                }
+                // Keep at least one design variable active, the optimization has converged anyway then.
+                // Freezing only a few design variables does not pay for a structure update on its own.
+                if (!freeze.empty() && freeze.size() < numActive &&
+                    (changed || freeze.size() >= _options.activeSetMinFreezeFraction * numActive)) {
+                    for (size_t i : freeze) {
+                        _isFrozen[i] = 1;
+                        _activeSetDesignVariables[i]->setActive(false);
+                    }
+                    _status.numFrozenDesignVariables += freeze.size();
+                    changed = true;
+                }
+                if (changed) {
+                    updateActiveSetStructure();
+                    _activeSetIterationsSinceUpdate = 0;
+                }
+            }
+
+            void Optimizer2::releaseActiveSet()
+            {
+                bool changed = false;
+                for (size_t i = 0; i < _isFrozen.size(); ++i) {
+                    _isPendingReactivation[i] = 0;
+                    if (_isFrozen[i]) {
+                        _isFrozen[i] = 0;
+                        _activeSetDesignVariables[i]->setActive(true);
+                        changed = true;
+                    }
+                }
+                if (changed)
+                    updateActiveSetStructure();
+                _solver->setAcceptConstantErrorTerms(_solverAcceptedConstantErrorTerms);
+            }
+
+            void Optimizer2::updateActiveSetStructure()
+            {
+                Timer timer("Optimizer2: Update active set");
+                // Only the design variable indexing and the matrix structure change, the error terms are kept
+                problemManager().updateDesignVariables();
+                _solver->initMatrixStructure(getDesignVariables(), problemManager().getErrorTerms(), _trustRegionPolicy->requiresAugmentedDiagonal(), _options.numThreadsJacobian);
+                _trustRegionPolicy->structureChanged();
+                _status.numActiveSetUpdates++;
+                // initMatrixStructure() discards the error vector
+                evaluateError(true);
             }
 
             double Optimizer2::evaluateError(bool useMEstimator)
@@ -371,7 +619,7 @@ namespace aslam {
               boost::shared_ptr<BlockCholeskyLinearSystemSolver> solver_sp;
               solver_sp.reset(new BlockCholeskyLinearSystemSolver());
               // True here for creating the diagonal conditioning.
-              solver_sp->initMatrixStructure(getDesignVariables(), problemManager().getErrorTerms(), true);
+              solver_sp->initMatrixStructure(getDesignVariables(), problemManager().getErrorTerms(), true, _options.numThreadsJacobian);
 
               _options.verbose && std::cout << "Setting the diagonal conditioner to: " << lambda << ".\n";
               evaluateError(false);
@@ -128,6 +128,9 @@ void OptimizerBFGS::optimizeImplementation()
 
       // perform line search
       bool lsSuccess = _linesearch.lineSearchWolfe12();
+      _status.numLineSearches++;
+      _status.numLineSearchErrorEvaluations += _linesearch.getNumErrorEvaluations();
+      _status.numLineSearchGradientEvaluations += _linesearch.getNumGradientEvaluations();
       _callbackManager.issueCallback( callback::event::DESIGN_VARIABLES_UPDATED{} );
 
       const double alpha_k = _linesearch.getCurrentStepLength();
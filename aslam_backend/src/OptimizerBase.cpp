@@ -108,6 +108,11 @@ std::ostream& operator<<(std::ostream& out, const OptimizerStatus& ret)
   out << "\tmax dx: " << ret.maxDeltaX << std::endl;
   out << "\tevals objective: " << ret.numErrorEvaluations << std::endl;
   out << "\tevals derivative: " << ret.numJacobianEvaluations;
+  if (ret.numLineSearches > 0) {
+    out << std::endl << "\tline searches: " << ret.numLineSearches << std::endl;
+    out << "\tevals objective per line search: " << double(ret.numLineSearchErrorEvaluations)/ret.numLineSearches << std::endl;
+    out << "\tevals derivative per line search: " << double(ret.numLineSearchGradientEvaluations)/ret.numLineSearches;
+  }
   return out;
 }
 
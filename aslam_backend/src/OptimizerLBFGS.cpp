@@ -0,0 +1,236 @@
+#include <iomanip>
+#include <limits>
+#include <aslam/backend/OptimizerLBFGS.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <sm/PropertyTree.hpp>
+#include <sm/logging.hpp>
+
+namespace aslam {
+namespace backend {
+
+OptimizerOptionsLBFGS::OptimizerOptionsLBFGS()
+    : OptimizerOptionsBase(), linesearch()
+{
+  // base options checked by OptimizerOptionsBase
+  linesearch.check();
+}
+
+OptimizerOptionsLBFGS::OptimizerOptionsLBFGS(const sm::PropertyTree& config)
+    : OptimizerOptionsBase(config), linesearch(sm::PropertyTree(config, "linesearch"))
+{
+  useDenseJacobianContainer = config.getBool("useDenseJacobianContainer", useDenseJacobianContainer);
+  historySize = config.getInt("historySize", historySize);
+  // base options checked by OptimizerOptionsBase
+  linesearch.check();
+  SM_ASSERT_GT( Exception, historySize, 0, "");
+}
+
+void OptimizerOptionsLBFGS::check() const
+{
+  OptimizerOptionsBase::check();
+  linesearch.check();
+  SM_ASSERT_GT( Exception, historySize, 0, "");
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsLBFGS& options)
+{
+  out << static_cast<OptimizerOptionsBase>(options) << std::endl;
+  out << options.linesearch << std::endl;
+  out << "OptimizerOptionsLBFGS:" << std::endl;
+  out << "\tuseDenseJacobianContainer: " << (options.useDenseJacobianContainer ? "TRUE" : "FALSE") << std::endl;
+  out << "\thistorySize: " << options.historySize;
+  return out;
+}
+
+
+OptimizerLBFGS::OptimizerLBFGS(const OptimizerOptionsLBFGS& options)
+    : _options(options),
+      _linesearch(getCostFunction<false,true,false,true,true>(problemManager(), false, _options.useDenseJacobianContainer, false, _options.numThreadsJacobian, _options.numThreadsError), _options.linesearch)
+{
+  _options.check();
+  _linesearch.setEvaluateErrorCallback( [&]() { _status.numErrorEvaluations++; } );
+  _linesearch.setEvaluateGradientCallback( [&]() { _status.numJacobianEvaluations++; });
+}
+
+OptimizerLBFGS::OptimizerLBFGS()
+    : OptimizerLBFGS::OptimizerLBFGS(OptimizerOptionsLBFGS())
+{
+}
+
+
+OptimizerLBFGS::OptimizerLBFGS(const sm::PropertyTree& config)
+    : OptimizerLBFGS::OptimizerLBFGS(OptimizerOptionsLBFGS(config))
+{
+}
+
+OptimizerLBFGS::~OptimizerLBFGS()
+{
+}
+
+void OptimizerLBFGS::resetImplementation() {
+  _S.resize(problemManager().numOptParameters(), _options.historySize);
+  _Y.resize(problemManager().numOptParameters(), _options.historySize);
+  _rho.resize(_options.historySize);
+  clearHistory();
+  _linesearch.initialize();
+}
+
+void OptimizerLBFGS::clearHistory() {
+  _firstPair = 0;
+  _numPairs = 0;
+}
+
+void OptimizerLBFGS::addCorrectionPair(const RowVectorType& sk, const RowVectorType& yk) {
+  const double ys = yk.dot(sk);
+  // Skip pairs violating the curvature condition, they would make the approximation indefinite.
+  if (!(ys > std::numeric_limits<double>::epsilon() * yk.squaredNorm())) {
+    SM_FINE_STREAM_NAMED("optimization", "OptimizerLBFGS: Skipping correction pair with y^T s = " << ys);
+    return;
+  }
+  const std::size_t m = _S.cols();
+  std::size_t col;
+  if (_numPairs < m) {
+    col = (_firstPair + _numPairs) % m;
+    ++_numPairs;
+  } else {
+    col = _firstPair;
+    _firstPair = (_firstPair + 1) % m;
+  }
+  _S.col(col) = sk.transpose();
+  _Y.col(col) = yk.transpose();
+  _rho[col] = 1.0/ys;
+}
+
+void OptimizerLBFGS::computeSearchDirection(const RowVectorType& gradient, RowVectorType& outDirection) {
+  const std::size_t m = _S.cols();
+  Eigen::VectorXd q = gradient.transpose();
+  Eigen::VectorXd alpha(_numPairs);
+  // first loop, newest to oldest pair
+  for (std::size_t k = _numPairs; k-- > 0; ) {
+    const std::size_t i = (_firstPair + k) % m;
+    alpha[k] = _rho[i] * _S.col(i).dot(q);
+    q -= alpha[k] * _Y.col(i);
+  }
+  // initial inverse Hessian approximation gamma * I
+  if (_numPairs > 0) {
+    const std::size_t newest = (_firstPair + _numPairs - 1) % m;
+    q *= 1.0/(_rho[newest] * _Y.col(newest).squaredNorm());
+  }
+  // second loop, oldest to newest pair
+  for (std::size_t k = 0; k < _numPairs; ++k) {
+    const std::size_t i = (_firstPair + k) % m;
+    const double beta = _rho[i] * _Y.col(i).dot(q);
+    q += (alpha[k] - beta) * _S.col(i);
+  }
+  outDirection = -q.transpose();
+}
+
+void OptimizerLBFGS::optimizeImplementation()
+{
+  Timer timeSearchDirection("OptimizerLBFGS: Compute---Search direction", true);
+
+  using namespace Eigen;
+
+  RowVectorType gfk, gfkp1;
+  gfk = _linesearch.getGradient();
+  _status.gradientNorm = gfk.norm();
+  _status.error = _linesearch.getError();
+  SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << "OptimizerLBFGS: Start optimization at state " <<
+                       problemManager().getFlattenedDesignVariableParameters().transpose().format(IOFormat(15, DontAlignCols, ", ", ", ", "", "", "[", "]")) <<
+                        " with gradient " << gfk.transpose().format(IOFormat(15, DontAlignCols, ", ", ", ", "", "", "[", "]")) << " (norm: " <<
+                        _status.gradientNorm << ") and error " << _status.error);
+  this->updateStatus(true);
+
+  if (!_status.success()) {
+
+    std::size_t cnt = 0;
+    for (cnt = 0; _options.maxIterations == -1 || cnt < static_cast<size_t>(_options.maxIterations); ++cnt, ++_status.numIterations) {
+
+      _callbackManager.issueCallback( callback::event::ITERATION_START{} );
+
+      // compute search direction
+      // Note: the curvature condition is enforced when storing correction pairs, so this should always be a
+      // descent direction. If numerical issues still produce an ascent direction, the history is dropped and
+      // we restart with steepest descent. If that fails as well the exception is re-thrown.
+      timeSearchDirection.start();
+      RowVectorType pk;
+      computeSearchDirection(gfk, pk);
+      timeSearchDirection.stop();
+      for(std::size_t j=0; j<2; ++j) {
+        try {
+          _linesearch.setSearchDirection(pk);
+          break;
+        } catch (const std::exception& e) {
+          if (j == 0) {
+            SM_WARN("OptimizerLBFGS: Search direction is not a descent direction, dropping the correction history. "
+                "Check your problem setup anyways and potentially re-scale your parameters.");
+            clearHistory();
+            pk = -gfk;
+          } else {
+            throw;
+          }
+        }
+      }
+
+      // store last design variables
+      const Eigen::VectorXd dv = problemManager().getFlattenedDesignVariableParameters();
+
+      // perform line search
+      bool lsSuccess = _linesearch.lineSearchWolfe12();
+      _status.numLineSearches++;
+      _status.numLineSearchErrorEvaluations += _linesearch.getNumErrorEvaluations();
+      _status.numLineSearchGradientEvaluations += _linesearch.getNumGradientEvaluations();
+      _callbackManager.issueCallback( callback::event::DESIGN_VARIABLES_UPDATED{} );
+
+      const double alpha_k = _linesearch.getCurrentStepLength();
+      gfkp1 = _linesearch.getGradient();
+      _status.gradientNorm = gfkp1.norm();
+      _status.deltaError = _linesearch.getError() - _status.error;
+      _status.error = _linesearch.getError();
+      _status.maxDeltaX = (problemManager().getFlattenedDesignVariableParameters() - dv).cwiseAbs().maxCoeff();
+
+      this->updateStatus(lsSuccess);
+      if (_status.success() || _status.failure())
+        break;
+
+      SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << _status << std::endl <<
+                           "\tsteplength: " << alpha_k);
+
+      // Update the correction history
+      addCorrectionPair(alpha_k * pk, gfkp1 - gfk);
+      gfk = gfkp1;
+
+      _callbackManager.issueCallback( callback::event::ITERATION_END{} );
+    }
+  }
+
+  if (!_status.failure())
+    SM_DEBUG_STREAM_NAMED("optimization", _status);
+  else
+    SM_ERROR_STREAM(_status);
+
+}
+
+void OptimizerLBFGS::updateStatus(const bool lineSearchSuccess)
+{
+
+  // Test failure criteria
+  if (!lineSearchSuccess) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    return;
+  }
+
+  if (!std::isfinite(_status.error)) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    SM_WARN("OptimizerLBFGS: We correctly found +-inf as optimal value, or something went wrong?");
+    return;
+  }
+
+  // Test success criteria
+  _status.convergence = ConvergenceStatus::IN_PROGRESS; // if none of the success criteria succeed, we are not converged yet
+  this->updateConvergenceStatus();
+
+}
+
+} // namespace backend
+} // namespace aslam
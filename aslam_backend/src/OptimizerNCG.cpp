@@ -0,0 +1,243 @@
+#include <iomanip>
+#include <limits>
+#include <aslam/backend/OptimizerNCG.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <sm/PropertyTree.hpp>
+#include <sm/logging.hpp>
+
+namespace aslam {
+namespace backend {
+
+OptimizerOptionsNCG::OptimizerOptionsNCG()
+    : OptimizerOptionsBase(), linesearch()
+{
+  // Conjugate gradient methods need a more accurate line search than quasi-Newton methods
+  linesearch.c2WolfeCondition = 0.1;
+  // base options checked by OptimizerOptionsBase
+  linesearch.check();
+}
+
+OptimizerOptionsNCG::OptimizerOptionsNCG(const sm::PropertyTree& config)
+    : OptimizerOptionsBase(config), linesearch(sm::PropertyTree(config, "linesearch"))
+{
+  useDenseJacobianContainer = config.getBool("useDenseJacobianContainer", useDenseJacobianContainer);
+  const std::string methodName = config.getString("method", "POLAK_RIBIERE_PLUS");
+  if (methodName == "HAGER_ZHANG") {
+    method = HAGER_ZHANG;
+  } else {
+    SM_ASSERT_EQ( Exception, methodName, std::string("POLAK_RIBIERE_PLUS"), "Unknown method. Options are POLAK_RIBIERE_PLUS and HAGER_ZHANG.");
+    method = POLAK_RIBIERE_PLUS;
+  }
+  restartInterval = config.getInt("restartInterval", restartInterval);
+  restartOrthogonalityThreshold = config.getDouble("restartOrthogonalityThreshold", restartOrthogonalityThreshold);
+  hagerZhangEta = config.getDouble("hagerZhangEta", hagerZhangEta);
+  check();
+}
+
+void OptimizerOptionsNCG::check() const
+{
+  OptimizerOptionsBase::check();
+  linesearch.check();
+  SM_ASSERT_GE( Exception, restartInterval, -1, "");
+  SM_ASSERT_GE( Exception, restartOrthogonalityThreshold, 0.0, "");
+  SM_ASSERT_GT( Exception, hagerZhangEta, 0.0, "");
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsNCG::Method& method)
+{
+  switch(method)
+  {
+    case OptimizerOptionsNCG::Method::POLAK_RIBIERE_PLUS:
+      out << "POLAK_RIBIERE_PLUS";
+      break;
+    case OptimizerOptionsNCG::Method::HAGER_ZHANG:
+      out << "HAGER_ZHANG";
+      break;
+  }
+  return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsNCG& options)
+{
+  out << static_cast<OptimizerOptionsBase>(options) << std::endl;
+  out << options.linesearch << std::endl;
+  out << "OptimizerOptionsNCG:" << std::endl;
+  out << "\tuseDenseJacobianContainer: " << (options.useDenseJacobianContainer ? "TRUE" : "FALSE") << std::endl;
+  out << "\tmethod: " << options.method << std::endl;
+  out << "\trestartInterval: " << options.restartInterval << std::endl;
+  out << "\trestartOrthogonalityThreshold: " << options.restartOrthogonalityThreshold << std::endl;
+  out << "\thagerZhangEta: " << options.hagerZhangEta;
+  return out;
+}
+
+
+OptimizerNCG::OptimizerNCG(const OptimizerOptionsNCG& options)
+    : _options(options),
+      _linesearch(getCostFunction<false,true,false,true,true>(problemManager(), false, _options.useDenseJacobianContainer, false, _options.numThreadsJacobian, _options.numThreadsError), _options.linesearch)
+{
+  _options.check();
+  _linesearch.setEvaluateErrorCallback( [&]() { _status.numErrorEvaluations++; } );
+  _linesearch.setEvaluateGradientCallback( [&]() { _status.numJacobianEvaluations++; });
+}
+
+OptimizerNCG::OptimizerNCG()
+    : OptimizerNCG::OptimizerNCG(OptimizerOptionsNCG())
+{
+}
+
+
+OptimizerNCG::OptimizerNCG(const sm::PropertyTree& config)
+    : OptimizerNCG::OptimizerNCG(OptimizerOptionsNCG(config))
+{
+}
+
+OptimizerNCG::~OptimizerNCG()
+{
+}
+
+void OptimizerNCG::resetImplementation() {
+  _linesearch.initialize();
+}
+
+double OptimizerNCG::computeBeta(const RowVectorType& gfkp1, const RowVectorType& gfk, const RowVectorType& pk) const
+{
+  const RowVectorType yk = gfkp1 - gfk;
+  switch (_options.method) {
+    case OptimizerOptionsNCG::HAGER_ZHANG:
+    {
+      const double dy = pk.dot(yk);
+      if (dy == 0.0)
+        return 0.0;
+      const double beta = (yk - 2.0*yk.squaredNorm()/dy*pk).dot(gfkp1)/dy;
+      // truncation guaranteeing descent, eq. (1.6) in Hager and Zhang, 2006
+      const double etak = -1.0/(pk.norm()*std::min(_options.hagerZhangEta, gfk.norm()));
+      return std::max(beta, etak);
+    }
+    case OptimizerOptionsNCG::POLAK_RIBIERE_PLUS:
+    default:
+      return std::max(0.0, gfkp1.dot(yk)/gfk.squaredNorm());
+  }
+}
+
+void OptimizerNCG::optimizeImplementation()
+{
+  using namespace Eigen;
+
+  const std::size_t restartInterval = _options.restartInterval == 0 ? problemManager().numOptParameters() :
+      (_options.restartInterval < 0 ? std::numeric_limits<std::size_t>::max() : static_cast<std::size_t>(_options.restartInterval));
+
+  RowVectorType gfk, gfkp1;
+  gfk = _linesearch.getGradient();
+  _status.gradientNorm = gfk.norm();
+  _status.error = _linesearch.getError();
+  SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << "OptimizerNCG: Start optimization at state " <<
+                       problemManager().getFlattenedDesignVariableParameters().transpose().format(IOFormat(15, DontAlignCols, ", ", ", ", "", "", "[", "]")) <<
+                        " with gradient " << gfk.transpose().format(IOFormat(15, DontAlignCols, ", ", ", ", "", "", "[", "]")) << " (norm: " <<
+                        _status.gradientNorm << ") and error " << _status.error);
+  this->updateStatus(true);
+
+  if (!_status.success()) {
+
+    RowVectorType pk = -gfk;
+    std::size_t itSinceRestart = 0;
+    double previousSlope = std::numeric_limits<double>::quiet_NaN();
+    double previousStepLength = std::numeric_limits<double>::quiet_NaN();
+
+    std::size_t cnt = 0;
+    for (cnt = 0; _options.maxIterations == -1 || cnt < static_cast<size_t>(_options.maxIterations); ++cnt, ++_status.numIterations) {
+
+      _callbackManager.issueCallback( callback::event::ITERATION_START{} );
+
+      // The line search rejects ascent directions. Restart with steepest descent in that case.
+      try {
+        _linesearch.setSearchDirection(pk);
+      } catch (const std::exception&) {
+        SM_FINE_STREAM_NAMED("optimization", "OptimizerNCG: Conjugate direction is not a descent direction, restarting.");
+        pk = -gfk;
+        itSinceRestart = 0;
+        _status.numRestarts++;
+        _linesearch.setSearchDirection(pk);
+      }
+
+      // Initial step length guess from the previous iteration, assuming the first order change is the same (Nocedal and Wright, eq. 3.60).
+      const double slope = gfk.dot(pk);
+      if (std::isfinite(previousStepLength) && slope != 0.0) {
+        _linesearch.options().initialStepLength = std::min(std::max(previousStepLength*previousSlope/slope, _options.linesearch.minStepLength), _options.linesearch.maxStepLength);
+      }
+
+      // store last design variables
+      const Eigen::VectorXd dv = problemManager().getFlattenedDesignVariableParameters();
+
+      // perform line search
+      bool lsSuccess = _linesearch.lineSearchWolfe12();
+      _status.numLineSearches++;
+      _status.numLineSearchErrorEvaluations += _linesearch.getNumErrorEvaluations();
+      _status.numLineSearchGradientEvaluations += _linesearch.getNumGradientEvaluations();
+      _linesearch.options().initialStepLength = _options.linesearch.initialStepLength;
+      _callbackManager.issueCallback( callback::event::DESIGN_VARIABLES_UPDATED{} );
+
+      const double alpha_k = _linesearch.getCurrentStepLength();
+      gfkp1 = _linesearch.getGradient();
+      _status.gradientNorm = gfkp1.norm();
+      _status.deltaError = _linesearch.getError() - _status.error;
+      _status.error = _linesearch.getError();
+      _status.maxDeltaX = (problemManager().getFlattenedDesignVariableParameters() - dv).cwiseAbs().maxCoeff();
+
+      this->updateStatus(lsSuccess);
+      if (_status.success() || _status.failure())
+        break;
+
+      SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << _status << std::endl <<
+                           "\tsteplength: " << alpha_k);
+
+      previousSlope = slope;
+      previousStepLength = alpha_k;
+
+      // Compute the next search direction
+      ++itSinceRestart;
+      const bool restart = itSinceRestart >= restartInterval ||
+          (_options.restartOrthogonalityThreshold > 0.0 &&
+           std::fabs(gfkp1.dot(gfk)) >= _options.restartOrthogonalityThreshold*gfkp1.squaredNorm());
+      if (restart) {
+        pk = -gfkp1;
+        itSinceRestart = 0;
+        _status.numRestarts++;
+      } else {
+        pk = -gfkp1 + computeBeta(gfkp1, gfk, pk)*pk;
+      }
+      gfk = gfkp1;
+
+      _callbackManager.issueCallback( callback::event::ITERATION_END{} );
+    }
+  }
+
+  if (!_status.failure())
+    SM_DEBUG_STREAM_NAMED("optimization", _status);
+  else
+    SM_ERROR_STREAM(_status);
+
+}
+
+void OptimizerNCG::updateStatus(const bool lineSearchSuccess)
+{
+
+  // Test failure criteria
+  if (!lineSearchSuccess) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    return;
+  }
+
+  if (!std::isfinite(_status.error)) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    SM_WARN("OptimizerNCG: We correctly found +-inf as optimal value, or something went wrong?");
+    return;
+  }
+
+  // Test success criteria
+  _status.convergence = ConvergenceStatus::IN_PROGRESS; // if none of the success criteria succeed, we are not converged yet
+  this->updateConvergenceStatus();
+
+}
+
+} // namespace backend
+} // namespace aslam
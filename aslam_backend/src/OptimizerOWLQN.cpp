@@ -0,0 +1,399 @@
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <aslam/backend/OptimizerOWLQN.hpp>
+#include <aslam/backend/L1NormInterface.hpp>
+#include <aslam/backend/ScalarNonSquaredErrorTerm.hpp>
+#include <aslam/backend/DesignVariable.hpp>
+#include <sm/PropertyTree.hpp>
+#include <sm/logging.hpp>
+
+namespace aslam {
+namespace backend {
+
+OptimizerOptionsOWLQN::OptimizerOptionsOWLQN()
+    : OptimizerOptionsBase()
+{
+  check();
+}
+
+OptimizerOptionsOWLQN::OptimizerOptionsOWLQN(const sm::PropertyTree& config)
+    : OptimizerOptionsBase(config)
+{
+  useDenseJacobianContainer = config.getBool("useDenseJacobianContainer", useDenseJacobianContainer);
+  historySize = config.getInt("historySize", historySize);
+  armijoFactor = config.getDouble("armijoFactor", armijoFactor);
+  backtrackingFactor = config.getDouble("backtrackingFactor", backtrackingFactor);
+  maxBacktrackingSteps = config.getInt("maxBacktrackingSteps", maxBacktrackingSteps);
+  check();
+}
+
+void OptimizerOptionsOWLQN::check() const
+{
+  OptimizerOptionsBase::check();
+  SM_ASSERT_GT( Exception, historySize, 0, "");
+  SM_ASSERT_GT( Exception, armijoFactor, 0.0, "");
+  SM_ASSERT_LT( Exception, armijoFactor, 1.0, "");
+  SM_ASSERT_GT( Exception, backtrackingFactor, 0.0, "");
+  SM_ASSERT_LT( Exception, backtrackingFactor, 1.0, "");
+  SM_ASSERT_GT( Exception, maxBacktrackingSteps, 0, "");
+  SM_ASSERT_TRUE( Exception, !regularizer || dynamic_cast<const L1NormInterface*>(regularizer.get()) != nullptr,
+                  "The regularizer has to implement the L1NormInterface");
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsOWLQN& options)
+{
+  out << static_cast<OptimizerOptionsBase>(options) << std::endl;
+  out << "OptimizerOptionsOWLQN:" << std::endl;
+  out << "\tuseDenseJacobianContainer: " << (options.useDenseJacobianContainer ? "TRUE" : "FALSE") << std::endl;
+  out << "\thistorySize: " << options.historySize << std::endl;
+  out << "\tarmijoFactor: " << options.armijoFactor << std::endl;
+  out << "\tbacktrackingFactor: " << options.backtrackingFactor << std::endl;
+  out << "\tmaxBacktrackingSteps: " << options.maxBacktrackingSteps << std::endl;
+  out << "\thasRegularizer: " << ((options.regularizer != nullptr) ? "TRUE" : "FALSE");
+  return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerStatusOWLQN& status)
+{
+  out << static_cast<const OptimizerStatus&>(status) << std::endl;
+  out << "\tL1 parameters: " << status.numL1Parameters << std::endl;
+  out << "\tzero L1 parameters: " << status.numZeroParameters << std::endl;
+  out << "\tbacktracking steps: " << status.numBacktrackingSteps;
+  return out;
+}
+
+
+OptimizerOWLQN::OptimizerOWLQN(const OptimizerOptionsOWLQN& options)
+    : _options(options)
+{
+  _options.check();
+}
+
+OptimizerOWLQN::OptimizerOWLQN()
+    : OptimizerOWLQN::OptimizerOWLQN(OptimizerOptionsOWLQN())
+{
+}
+
+
+OptimizerOWLQN::OptimizerOWLQN(const sm::PropertyTree& config)
+    : OptimizerOWLQN::OptimizerOWLQN(OptimizerOptionsOWLQN(config))
+{
+}
+
+OptimizerOWLQN::~OptimizerOWLQN()
+{
+}
+
+void OptimizerOWLQN::resetImplementation()
+{
+  const std::size_t numParameters = problemManager().numOptParameters();
+  _S.resize(numParameters, _options.historySize);
+  _Y.resize(numParameters, _options.historySize);
+  _rho.resize(_options.historySize);
+  clearHistory();
+  _threadGradients.assign(std::max<std::size_t>(_options.numThreadsJacobian, 1), RowVectorType::Zero(1, numParameters));
+  initializeL1Terms();
+}
+
+void OptimizerOWLQN::initializeL1Terms()
+{
+  const std::size_t numParameters = problemManager().numOptParameters();
+  _l1Weights = Eigen::VectorXd::Zero(numParameters);
+  _x = Eigen::VectorXd::Zero(numParameters);
+
+  _smoothErrorTerms.clear();
+  _smoothErrorTerms.reserve(problemManager().numErrorTerms());
+  const auto& nonSquaredErrorTerms = problemManager().getNonSquaredErrorTerms();
+  for (std::size_t i = 0; i < problemManager().numErrorTerms(); ++i) {
+    const L1NormInterface* l1 = i < nonSquaredErrorTerms.size() ? dynamic_cast<const L1NormInterface*>(nonSquaredErrorTerms[i]) : nullptr;
+    if (l1)
+      addL1Term(*nonSquaredErrorTerms[i], l1->getL1NormWeight());
+    else
+      _smoothErrorTerms.push_back(i);
+  }
+  if (_options.regularizer)
+    addL1Term(*_options.regularizer, dynamic_cast<const L1NormInterface&>(*_options.regularizer).getL1NormWeight());
+
+  _l1Columns.clear();
+  _l1DesignVariables.clear();
+  for (DesignVariable* dv : problemManager().designVariables()) {
+    if (_l1Weights[dv->columnBase()] > 0.0) {
+      _l1Columns.push_back(dv->columnBase());
+      _l1DesignVariables.push_back(dv);
+    }
+  }
+  _status.numL1Parameters = _l1Columns.size();
+  readL1Parameters();
+  SM_FINE_STREAM_NAMED("optimization", "OptimizerOWLQN: " << _l1Columns.size() << " of " << numParameters <<
+                       " parameters have an L1 weight, the smooth part has " << _smoothErrorTerms.size() << " error terms");
+}
+
+void OptimizerOWLQN::addL1Term(const ScalarNonSquaredErrorTerm& e, const double weight)
+{
+  SM_ASSERT_GE(Exception, weight, 0.0, "L1 weights have to be non-negative");
+  for (const DesignVariable* dv : e.designVariables()) {
+    // Skip design variables which are not optimized
+    if (!dv->isActive() || dv->blockIndex() < 0 || static_cast<std::size_t>(dv->blockIndex()) >= problemManager().numDesignVariables() ||
+        problemManager().designVariables()[dv->blockIndex()] != dv)
+      continue;
+    SM_ASSERT_EQ(Exception, dv->minimalDimensions(), 1, "L1 terms only support scalar design variables");
+    _l1Weights[dv->columnBase()] += weight;
+  }
+}
+
+void OptimizerOWLQN::readL1Parameters()
+{
+  Eigen::MatrixXd p;
+  for (std::size_t i = 0; i < _l1Columns.size(); ++i) {
+    _l1DesignVariables[i]->getParameters(p);
+    _x[_l1Columns[i]] = p(0, 0);
+  }
+}
+
+double OptimizerOWLQN::evaluateSmoothError()
+{
+  _status.numErrorEvaluations++;
+  return problemManager().evaluateError(_smoothErrorTerms, _options.numThreadsError);
+}
+
+void OptimizerOWLQN::computeSmoothGradient(RowVectorType& outGrad)
+{
+  problemManager().computeGradient(outGrad, _smoothErrorTerms, _threadGradients, false /*useMEstimator*/, false /*applyDvScaling*/,
+                                   _options.useDenseJacobianContainer);
+  _status.numJacobianEvaluations++;
+}
+
+double OptimizerOWLQN::evaluateL1Error() const
+{
+  double error = 0.0;
+  for (const std::size_t c : _l1Columns)
+    error += _l1Weights[c] * std::fabs(_x[c]);
+  return error;
+}
+
+void OptimizerOWLQN::computePseudoGradient(const RowVectorType& gradient, RowVectorType& outPseudoGradient) const
+{
+  outPseudoGradient = gradient;
+  for (const std::size_t c : _l1Columns) {
+    const double w = _l1Weights[c];
+    if (_x[c] < 0.0) {
+      outPseudoGradient[c] -= w;
+    } else if (_x[c] > 0.0) {
+      outPseudoGradient[c] += w;
+    } else if (gradient[c] + w < 0.0) {
+      // moving into the positive orthant decreases the objective
+      outPseudoGradient[c] += w;
+    } else if (gradient[c] - w > 0.0) {
+      // moving into the negative orthant decreases the objective
+      outPseudoGradient[c] -= w;
+    } else {
+      // zero is optimal for this parameter
+      outPseudoGradient[c] = 0.0;
+    }
+  }
+}
+
+void OptimizerOWLQN::clearHistory()
+{
+  _firstPair = 0;
+  _numPairs = 0;
+}
+
+void OptimizerOWLQN::addCorrectionPair(const RowVectorType& sk, const RowVectorType& yk)
+{
+  const double ys = yk.dot(sk);
+  // Skip pairs violating the curvature condition, they would make the approximation indefinite.
+  if (!(ys > std::numeric_limits<double>::epsilon() * yk.squaredNorm())) {
+    SM_FINE_STREAM_NAMED("optimization", "OptimizerOWLQN: Skipping correction pair with y^T s = " << ys);
+    return;
+  }
+  const std::size_t m = _S.cols();
+  std::size_t col;
+  if (_numPairs < m) {
+    col = (_firstPair + _numPairs) % m;
+    ++_numPairs;
+  } else {
+    col = _firstPair;
+    _firstPair = (_firstPair + 1) % m;
+  }
+  _S.col(col) = sk.transpose();
+  _Y.col(col) = yk.transpose();
+  _rho[col] = 1.0/ys;
+}
+
+void OptimizerOWLQN::computeSearchDirection(const RowVectorType& pseudoGradient, RowVectorType& outDirection)
+{
+  const std::size_t m = _S.cols();
+  Eigen::VectorXd q = pseudoGradient.transpose();
+  Eigen::VectorXd alpha(_numPairs);
+  // first loop, newest to oldest pair
+  for (std::size_t k = _numPairs; k-- > 0; ) {
+    const std::size_t i = (_firstPair + k) % m;
+    alpha[k] = _rho[i] * _S.col(i).dot(q);
+    q -= alpha[k] * _Y.col(i);
+  }
+  // initial inverse Hessian approximation gamma * I
+  if (_numPairs > 0) {
+    const std::size_t newest = (_firstPair + _numPairs - 1) % m;
+    q *= 1.0/(_rho[newest] * _Y.col(newest).squaredNorm());
+  }
+  // second loop, oldest to newest pair
+  for (std::size_t k = 0; k < _numPairs; ++k) {
+    const std::size_t i = (_firstPair + k) % m;
+    const double beta = _rho[i] * _Y.col(i).dot(q);
+    q += (alpha[k] - beta) * _S.col(i);
+  }
+  outDirection = -q.transpose();
+
+  // Constrain the direction to the orthant of the steepest descent direction of the L1 parameters
+  for (const std::size_t c : _l1Columns) {
+    if (outDirection[c] * pseudoGradient[c] >= 0.0)
+      outDirection[c] = 0.0;
+  }
+}
+
+void OptimizerOWLQN::applyStep(const RowVectorType& step)
+{
+  // Unlike ProblemManager::applyStateUpdate(), the step is applied without scaling to set parameters to exactly zero
+  for (DesignVariable* d : problemManager().designVariables()) {
+    const int dim = d->minimalDimensions();
+    Eigen::VectorXd dx = step.segment(d->columnBase(), dim).transpose();
+    d->update(&dx[0], dim);
+  }
+}
+
+bool OptimizerOWLQN::lineSearch(const RowVectorType& direction, const RowVectorType& pseudoGradient, const Eigen::VectorXd& orthant,
+                                const double initialStepLength, double& inOutError, RowVectorType& outStep)
+{
+  const Eigen::VectorXd x0 = _x;
+  double stepLength = initialStepLength;
+  _status.numLineSearches++;
+  for (int k = 0; k <= _options.maxBacktrackingSteps; ++k) {
+    outStep = stepLength * direction;
+    // Project onto the orthant, parameters leaving it are set to zero
+    for (const std::size_t c : _l1Columns) {
+      const double x = x0[c] + outStep[c];
+      if (x * orthant[c] <= 0.0) {
+        outStep[c] = -x0[c];
+        _x[c] = 0.0;
+      } else {
+        _x[c] = x;
+      }
+    }
+    applyStep(outStep);
+    const double error = evaluateSmoothError() + evaluateL1Error();
+    _status.numLineSearchErrorEvaluations++;
+    if (std::isfinite(error) && error <= inOutError + _options.armijoFactor * pseudoGradient.dot(outStep)) {
+      inOutError = error;
+      return true;
+    }
+    problemManager().revertLastStateUpdate();
+    _x = x0;
+    _status.numBacktrackingSteps++;
+    stepLength *= _options.backtrackingFactor;
+  }
+  return false;
+}
+
+void OptimizerOWLQN::optimizeImplementation()
+{
+  Timer timeSearchDirection("OptimizerOWLQN: Compute---Search direction", true);
+  Timer timeLineSearch("OptimizerOWLQN: Compute---Line search", true);
+
+  using namespace Eigen;
+
+  RowVectorType gfk, gfkp1, pgk, pk, sk;
+  readL1Parameters();
+  _status.error = evaluateSmoothError() + evaluateL1Error();
+  computeSmoothGradient(gfk);
+  computePseudoGradient(gfk, pgk);
+  _status.gradientNorm = pgk.norm();
+  SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << "OptimizerOWLQN: Start optimization with pseudo-gradient norm " <<
+                       _status.gradientNorm << " and error " << _status.error);
+  this->updateStatus(true);
+
+  if (!_status.success()) {
+
+    for (std::size_t cnt = 0; _options.maxIterations == -1 || cnt < static_cast<size_t>(_options.maxIterations); ++cnt, ++_status.numIterations) {
+
+      _callbackManager.issueCallback( callback::event::ITERATION_START{} );
+
+      // compute search direction, restart with steepest descent if it is not a descent direction
+      timeSearchDirection.start();
+      computeSearchDirection(pgk, pk);
+      if (!(pk.dot(pgk) < 0.0)) {
+        SM_WARN("OptimizerOWLQN: Search direction is not a descent direction, dropping the correction history.");
+        clearHistory();
+        computeSearchDirection(pgk, pk);
+      }
+      // The orthant of the step: the sign of the parameter or, for parameters at zero, of the steepest descent direction
+      Eigen::VectorXd orthant = Eigen::VectorXd::Zero(_x.size());
+      for (const std::size_t c : _l1Columns)
+        orthant[c] = _x[c] != 0.0 ? (_x[c] > 0.0 ? 1.0 : -1.0) : (pgk[c] < 0.0 ? 1.0 : (pgk[c] > 0.0 ? -1.0 : 0.0));
+      timeSearchDirection.stop();
+
+      // perform line search, the first step without curvature information is normalized
+      timeLineSearch.start();
+      double error = _status.error;
+      const double initialStepLength = _numPairs == 0 ? 1.0/std::max(pk.norm(), 1.0) : 1.0;
+      const bool lsSuccess = lineSearch(pk, pgk, orthant, initialStepLength, error, sk);
+      timeLineSearch.stop();
+      _callbackManager.issueCallback( callback::event::DESIGN_VARIABLES_UPDATED{} );
+
+      if (lsSuccess) {
+        computeSmoothGradient(gfkp1);
+        computePseudoGradient(gfkp1, pgk);
+        _status.gradientNorm = pgk.norm();
+        _status.deltaError = error - _status.error;
+        _status.error = error;
+        _status.maxDeltaX = sk.cwiseAbs().maxCoeff();
+      }
+      _status.numZeroParameters = 0;
+      for (const std::size_t c : _l1Columns)
+        _status.numZeroParameters += _x[c] == 0.0;
+
+      this->updateStatus(lsSuccess);
+      if (_status.success() || _status.failure())
+        break;
+
+      SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << _status);
+
+      // Update the correction history with the gradient of the smooth part
+      addCorrectionPair(sk, gfkp1 - gfk);
+      gfk = gfkp1;
+
+      _callbackManager.issueCallback( callback::event::ITERATION_END{} );
+    }
+  }
+
+  if (!_status.failure())
+    SM_DEBUG_STREAM_NAMED("optimization", _status);
+  else
+    SM_ERROR_STREAM(_status);
+
+}
+
+void OptimizerOWLQN::updateStatus(const bool lineSearchSuccess)
+{
+
+  // Test failure criteria
+  if (!lineSearchSuccess) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    return;
+  }
+
+  if (!std::isfinite(_status.error)) {
+    _status.convergence = ConvergenceStatus::FAILURE;
+    SM_WARN("OptimizerOWLQN: We correctly found +-inf as optimal value, or something went wrong?");
+    return;
+  }
+
+  // Test success criteria
+  _status.convergence = ConvergenceStatus::IN_PROGRESS; // if none of the success criteria succeed, we are not converged yet
+  this->updateConvergenceStatus();
+
+}
+
+} // namespace backend
+} // namespace aslam
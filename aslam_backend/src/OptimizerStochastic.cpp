@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <aslam/backend/OptimizerStochastic.hpp>
+#include <aslam/backend/OptimizerCallback.hpp>
+#include <aslam/backend/DesignVariable.hpp>
+#include <sm/PropertyTree.hpp>
+#include <sm/logging.hpp>
+
+namespace aslam {
+namespace backend {
+
+OptimizerOptionsStochastic::OptimizerOptionsStochastic()
+    : OptimizerOptionsBase()
+{
+  check();
+}
+
+OptimizerOptionsStochastic::OptimizerOptionsStochastic(const sm::PropertyTree& config)
+    : OptimizerOptionsBase(config)
+{
+  const std::string methodName = config.getString("method", "ADAM");
+  if (methodName == "SGD_MOMENTUM") {
+    method = SGD_MOMENTUM;
+  } else if (methodName == "SVRG") {
+    method = SVRG;
+  } else {
+    SM_ASSERT_EQ( Exception, methodName, std::string("ADAM"), "Unknown method. Options are SGD_MOMENTUM, ADAM and SVRG.");
+    method = ADAM;
+  }
+  batchSize = config.getInt("batchSize", batchSize);
+  learningRate = config.getDouble("learningRate", learningRate);
+  learningRateDecay = config.getDouble("learningRateDecay", learningRateDecay);
+  momentum = config.getDouble("momentum", momentum);
+  beta1 = config.getDouble("beta1", beta1);
+  beta2 = config.getDouble("beta2", beta2);
+  epsilon = config.getDouble("epsilon", epsilon);
+  seed = config.getInt("seed", seed);
+  useDenseJacobianContainer = config.getBool("useDenseJacobianContainer", useDenseJacobianContainer);
+  check();
+}
+
+void OptimizerOptionsStochastic::check() const
+{
+  OptimizerOptionsBase::check();
+  SM_ASSERT_GT( Exception, batchSize, 0, "");
+  SM_ASSERT_GT( Exception, learningRate, 0.0, "");
+  SM_ASSERT_GE( Exception, learningRateDecay, 0.0, "");
+  SM_ASSERT_GE( Exception, momentum, 0.0, "");
+  SM_ASSERT_LT( Exception, momentum, 1.0, "");
+  SM_ASSERT_GE( Exception, beta1, 0.0, "");
+  SM_ASSERT_LT( Exception, beta1, 1.0, "");
+  SM_ASSERT_GE( Exception, beta2, 0.0, "");
+  SM_ASSERT_LT( Exception, beta2, 1.0, "");
+  SM_ASSERT_GT( Exception, epsilon, 0.0, "");
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsStochastic::Method& method)
+{
+  switch(method)
+  {
+    case OptimizerOptionsStochastic::Method::SGD_MOMENTUM:
+      out << "SGD_MOMENTUM";
+      break;
+    case OptimizerOptionsStochastic::Method::ADAM:
+      out << "ADAM";
+      break;
+    case OptimizerOptionsStochastic::Method::SVRG:
+      out << "SVRG";
+      break;
+  }
+  return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerOptionsStochastic& options)
+{
+  out << static_cast<OptimizerOptionsBase>(options) << std::endl;
+  out << "OptimizerOptionsStochastic:" << std::endl;
+  out << "\tmethod: " << options.method << std::endl;
+  out << "\tbatchSize: " << options.batchSize << std::endl;
+  out << "\tlearningRate: " << options.learningRate << std::endl;
+  out << "\tlearningRateDecay: " << options.learningRateDecay << std::endl;
+  out << "\tmomentum: " << options.momentum << std::endl;
+  out << "\tbeta1: " << options.beta1 << std::endl;
+  out << "\tbeta2: " << options.beta2 << std::endl;
+  out << "\tepsilon: " << options.epsilon << std::endl;
+  out << "\tseed: " << options.seed << std::endl;
+  out << "\tuseDenseJacobianContainer: " << (options.useDenseJacobianContainer ? "TRUE" : "FALSE") << std::endl;
+  out << "\tpolishingOptimizer: " << (options.polishingOptimizer ? "SET" : "NONE");
+  return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const aslam::backend::OptimizerStatusStochastic& status)
+{
+  out << static_cast<const OptimizerStatus&>(status) << std::endl;
+  out << "\tmini-batches: " << status.numBatches << std::endl;
+  out << "\terror term gradients: " << status.numErrorTermGradients << std::endl;
+  out << "\terror terms per second: " << status.termsPerSecond << std::endl;
+  out << "\tpolishing iterations: " << status.numPolishingIterations;
+  return out;
+}
+
+
+OptimizerStochastic::OptimizerStochastic(const OptimizerOptionsStochastic& options)
+    : _options(options)
+{
+  _options.check();
+}
+
+OptimizerStochastic::OptimizerStochastic()
+    : OptimizerStochastic::OptimizerStochastic(OptimizerOptionsStochastic())
+{
+}
+
+
+OptimizerStochastic::OptimizerStochastic(const sm::PropertyTree& config)
+    : OptimizerStochastic::OptimizerStochastic(OptimizerOptionsStochastic(config))
+{
+}
+
+OptimizerStochastic::~OptimizerStochastic()
+{
+}
+
+void OptimizerStochastic::resetImplementation()
+{
+  const std::size_t numParameters = problemManager().numOptParameters();
+  const std::size_t numErrorTerms = problemManager().numErrorTerms();
+  const std::size_t numDesignVariables = problemManager().numDesignVariables();
+
+  _rng.seed(_options.seed);
+  _permutation.resize(numErrorTerms);
+  std::iota(_permutation.begin(), _permutation.end(), 0);
+  _batch.clear();
+  _batch.reserve(std::min(_options.batchSize, numErrorTerms));
+  _threadGradients.assign(std::max<std::size_t>(_options.numThreadsJacobian, 1), RowVectorType::Zero(1, numParameters));
+  _fullGradient = RowVectorType::Zero(1, numParameters);
+  _batchGradient = RowVectorType::Zero(1, numParameters);
+  _snapshotBatchGradient = RowVectorType::Zero(1, numParameters);
+  _m = RowVectorType::Zero(1, numParameters);
+  _v = RowVectorType::Zero(1, numParameters);
+  _dx = ColumnVectorType::Zero(numParameters);
+  _numAdamSteps = 0;
+  _batchSeconds = 0.0;
+  _batchTermGradients = 0;
+  _snapshotParameters.resize(numDesignVariables);
+  _currentParameters.resize(numDesignVariables);
+  _batchDesignVariables.clear();
+  _isBatchDesignVariable.assign(numDesignVariables, 0);
+}
+
+void OptimizerStochastic::evaluateFull()
+{
+  _status.error = problemManager().evaluateError(_options.numThreadsError);
+  _status.numErrorEvaluations++;
+  problemManager().computeGradient(_fullGradient, _options.numThreadsJacobian, false /*useMEstimator*/, false /*applyDvScaling*/, _options.useDenseJacobianContainer);
+  _status.numJacobianEvaluations++;
+  _status.numErrorTermGradients += problemManager().numErrorTerms();
+  _status.gradientNorm = _fullGradient.norm();
+}
+
+void OptimizerStochastic::computeBatchGradient(RowVectorType& outGrad)
+{
+  problemManager().computeGradient(outGrad, _batch, _threadGradients, false /*useMEstimator*/, false /*applyDvScaling*/, _options.useDenseJacobianContainer);
+  // scale to an unbiased estimate of the full gradient
+  outGrad *= static_cast<double>(problemManager().numErrorTerms())/static_cast<double>(_batch.size());
+  _status.numErrorTermGradients += _batch.size();
+}
+
+void OptimizerStochastic::computeSnapshotBatchGradient(RowVectorType& outGrad)
+{
+  // Only the active design variables touched by the batch are moved to the snapshot state
+  problemManager().getDesignVariables(_batch, _batchDesignVariables);
+  auto end = std::remove_if(_batchDesignVariables.begin(), _batchDesignVariables.end(), [this](DesignVariable* dv) {
+    if (!dv->isActive() || _isBatchDesignVariable[dv->blockIndex()])
+      return true;
+    _isBatchDesignVariable[dv->blockIndex()] = 1;
+    return false;
+  });
+  _batchDesignVariables.erase(end, _batchDesignVariables.end());
+
+  for (auto dv : _batchDesignVariables) {
+    _isBatchDesignVariable[dv->blockIndex()] = 0;
+    dv->getParameters(_currentParameters[dv->blockIndex()]);
+    dv->setParameters(_snapshotParameters[dv->blockIndex()]);
+  }
+  try {
+    computeBatchGradient(outGrad);
+  } catch (...) {
+    for (auto dv : _batchDesignVariables)
+      dv->setParameters(_currentParameters[dv->blockIndex()]);
+    throw;
+  }
+  for (auto dv : _batchDesignVariables)
+    dv->setParameters(_currentParameters[dv->blockIndex()]);
+}
+
+void OptimizerStochastic::computeStep(const RowVectorType& gradient, const double learningRate)
+{
+  switch (_options.method) {
+    case OptimizerOptionsStochastic::SGD_MOMENTUM:
+    {
+      _m = _options.momentum*_m + gradient;
+      _dx = -learningRate*_m.transpose();
+      break;
+    }
+    case OptimizerOptionsStochastic::ADAM:
+    {
+      ++_numAdamSteps;
+      _m = _options.beta1*_m + (1.0 - _options.beta1)*gradient;
+      _v = _options.beta2*_v + (1.0 - _options.beta2)*gradient.cwiseAbs2();
+      // bias correction folded into the step size
+      const double t = static_cast<double>(_numAdamSteps);
+      const double alpha = learningRate*std::sqrt(1.0 - std::pow(_options.beta2, t))/(1.0 - std::pow(_options.beta1, t));
+      _dx = -alpha*(_m.array()/(_v.array().sqrt() + _options.epsilon)).matrix().transpose();
+      break;
+    }
+    case OptimizerOptionsStochastic::SVRG:
+    {
+      _dx = -learningRate*gradient.transpose();
+      break;
+    }
+  }
+}
+
+void OptimizerStochastic::optimizeImplementation()
+{
+  const std::size_t numErrorTerms = problemManager().numErrorTerms();
+
+  evaluateFull();
+  SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << "OptimizerStochastic: Start optimization with gradient norm " <<
+                       _status.gradientNorm << " and error " << _status.error);
+  _status.convergence = ConvergenceStatus::IN_PROGRESS;
+  this->updateConvergenceStatus();
+
+  std::size_t cnt = 0;
+  for (cnt = 0; !_status.success() && (_options.maxIterations == -1 || cnt < static_cast<size_t>(_options.maxIterations)); ++cnt, ++_status.numIterations) {
+
+    _callbackManager.issueCallback( callback::event::ITERATION_START{} );
+
+    const double learningRate = _options.learningRate/(1.0 + _options.learningRateDecay*_status.numIterations);
+
+    // The state at the beginning of the epoch is the SVRG snapshot, _fullGradient its gradient
+    if (_options.method == OptimizerOptionsStochastic::SVRG) {
+      for (std::size_t i = 0; i < problemManager().numDesignVariables(); ++i)
+        problemManager().designVariable(i)->getParameters(_snapshotParameters[i]);
+    }
+    const Eigen::VectorXd dv = problemManager().getFlattenedDesignVariableParameters();
+
+    std::shuffle(_permutation.begin(), _permutation.end(), _rng);
+
+    const std::size_t numTermGradientsBefore = _status.numErrorTermGradients;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t begin = 0; begin < numErrorTerms; begin += _options.batchSize) {
+      _batch.assign(_permutation.begin() + begin, _permutation.begin() + std::min(begin + _options.batchSize, numErrorTerms));
+
+      computeBatchGradient(_batchGradient);
+      if (_options.method == OptimizerOptionsStochastic::SVRG) {
+        computeSnapshotBatchGradient(_snapshotBatchGradient);
+        _batchGradient += _fullGradient - _snapshotBatchGradient;
+      }
+      computeStep(_batchGradient, learningRate);
+
+      _callbackManager.issueCallback( callback::event::DESIGN_VARIABLE_UPDATE_COMPUTED{} );
+      problemManager().applyStateUpdate(_dx);
+      _callbackManager.issueCallback( callback::event::DESIGN_VARIABLES_UPDATED{} );
+      _status.numBatches++;
+    }
+    _batchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _batchTermGradients += _status.numErrorTermGradients - numTermGradientsBefore;
+    _status.termsPerSecond = _batchSeconds > 0.0 ? _batchTermGradients/_batchSeconds : 0.0;
+
+    const double previousError = _status.error;
+    evaluateFull();
+    _status.deltaError = _status.error - previousError;
+    _status.maxDeltaX = (problemManager().getFlattenedDesignVariableParameters() - dv).cwiseAbs().maxCoeff();
+
+    if (!std::isfinite(_status.error) || !_fullGradient.allFinite()) {
+      _status.convergence = ConvergenceStatus::FAILURE;
+      SM_WARN("OptimizerStochastic: Diverged, try reducing the learning rate.");
+    } else {
+      _status.convergence = ConvergenceStatus::IN_PROGRESS;
+      this->updateConvergenceStatus();
+    }
+
+    SM_FINE_STREAM_NAMED("optimization", std::setprecision(20) << _status << std::endl <<
+                         "\tlearning rate: " << learningRate);
+
+    _callbackManager.issueCallback( callback::event::ITERATION_END{} );
+
+    if (_status.failure())
+      break;
+  }
+
+  polish();
+
+  if (!_status.failure())
+    SM_DEBUG_STREAM_NAMED("optimization", _status);
+  else
+    SM_ERROR_STREAM(_status);
+
+}
+
+void OptimizerStochastic::polish()
+{
+  if (!_options.polishingOptimizer || _status.failure())
+    return;
+
+  OptimizerBase& polishingOptimizer = *_options.polishingOptimizer;
+  polishingOptimizer.setProblem(problemManager().getProblem());
+  polishingOptimizer.optimize();
+  const OptimizerStatus& polishingStatus = polishingOptimizer.getStatus();
+  _status.numPolishingIterations = polishingStatus.numIterations;
+
+  // The polishing optimizer re-initializes the problem, make sure our indexing is consistent again
+  problemManager().initialize();
+  const double previousError = _status.error;
+  evaluateFull();
+  _status.deltaError = _status.error - previousError;
+  _status.convergence = polishingStatus.convergence;
+
+  SM_FINE_STREAM_NAMED("optimization", "OptimizerStochastic: Polishing finished after " << _status.numPolishingIterations <<
+                       " iterations with error " << _status.error);
+}
+
+} // namespace backend
+} // namespace aslam
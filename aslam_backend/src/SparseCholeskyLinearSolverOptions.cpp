@@ -25,16 +25,20 @@ namespace aslam {
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
-      SparseCholeskyLinearSolverOptions::SparseCholeskyLinearSolverOptions() {}
-      
+    SparseCholeskyLinearSolverOptions::SparseCholeskyLinearSolverOptions() :
+        indexType(INDEX_AUTOMATIC) {
+    }
+
     SparseCholeskyLinearSolverOptions::SparseCholeskyLinearSolverOptions(
-        const SparseCholeskyLinearSolverOptions& /* other */) {
+        const SparseCholeskyLinearSolverOptions& other) :
+        indexType(other.indexType) {
     }
 
     SparseCholeskyLinearSolverOptions&
     SparseCholeskyLinearSolverOptions::operator =
         (const SparseCholeskyLinearSolverOptions& other) {
       if (this != &other) {
+        indexType = other.indexType;
       }
       return *this;
     }
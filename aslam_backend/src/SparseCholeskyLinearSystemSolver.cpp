@@ -1,38 +1,100 @@
 #include <aslam/backend/SparseCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
 #include <sm/PropertyTree.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace aslam {
   namespace backend {
-    SparseCholeskyLinearSystemSolver::SparseCholeskyLinearSystemSolver(const SparseCholeskyLinearSolverOptions& options) : _factor(NULL), _options(options) {}
-  SparseCholeskyLinearSystemSolver::SparseCholeskyLinearSystemSolver(const sm::PropertyTree& /* config */) :
-        _factor(NULL) {
-      // NO OPTIONS CURRENTLY IMPLEMENTED
+    SparseCholeskyLinearSystemSolver::SparseCholeskyLinearSystemSolver(const SparseCholeskyLinearSolverOptions& options) : _useLongIndices(false), _factor(NULL), _options(options) {}
+  SparseCholeskyLinearSystemSolver::SparseCholeskyLinearSystemSolver(const sm::PropertyTree& config) :
+        _useLongIndices(false), _factor(NULL) {
+      const std::string indexType = config.getString("indexType", "automatic");
+      if (indexType == "int") {
+        _options.indexType = SparseCholeskyLinearSolverOptions::INDEX_INT;
+      } else if (indexType == "long") {
+        _options.indexType = SparseCholeskyLinearSolverOptions::INDEX_LONG;
+      } else {
+        SM_ASSERT_EQ(Exception, indexType, std::string("automatic"), "Unknown index type. Options are automatic, int and long.");
+      }
       // USING C++11 would allow to do constructor delegation and more elegant code
     }
     SparseCholeskyLinearSystemSolver::~SparseCholeskyLinearSystemSolver() {
+      freeFactor();
+    }
+
+    void SparseCholeskyLinearSystemSolver::freeFactor() {
       if (_factor) {
-        _cholmod.free(_factor);
+        // The factor has to be freed by the cholmod instance that allocated it.
+        if (_useLongIndices) {
+          _cholmodLong.free(_factor);
+        } else {
+          _cholmod.free(_factor);
+        }
+        _factor = NULL;
       }
     }
 
+    template<>
+    CompressedColumnJacobianTransposeBuilder<int>& SparseCholeskyLinearSystemSolver::jacobianBuilder<int>() {
+      return _jacobianBuilder;
+    }
+
+    template<>
+    CompressedColumnJacobianTransposeBuilder<SuiteSparse_long>& SparseCholeskyLinearSystemSolver::jacobianBuilder<SuiteSparse_long>() {
+      return _jacobianBuilderLong;
+    }
+
+    template<>
+    Cholmod<int>& SparseCholeskyLinearSystemSolver::cholmod<int>() {
+      return _cholmod;
+    }
+
+    template<>
+    Cholmod<SuiteSparse_long>& SparseCholeskyLinearSystemSolver::cholmod<SuiteSparse_long>() {
+      return _cholmodLong;
+    }
+
     void SparseCholeskyLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner)
     {
       _errorTerms = errors;
-      if (_factor) {
-        _cholmod.free(_factor);
-        _factor = NULL;
-      }
+      freeFactor();
       // std::cout << "init structure\n";
       _useDiagonalConditioner = useDiagonalConditioner;
-      _jacobianBuilder.initMatrixStructure(dvs, errors);
-      CompressedColumnMatrix<int>& J_transpose = _jacobianBuilder.J_transpose();
+      // The layout does not depend on the index type and is counted in parallel once
+      const JacobianTransposeStructure structure = CompressedColumnJacobianTransposeBuilder<int>::computeStructure(dvs, errors, _numThreadsInitMatrixStructure);
+      switch (_options.indexType) {
+        case SparseCholeskyLinearSolverOptions::INDEX_INT:
+          _useLongIndices = false;
+          break;
+        case SparseCholeskyLinearSolverOptions::INDEX_LONG:
+          _useLongIndices = true;
+          break;
+        default:
+          _useLongIndices = structure.numNonZeros() > (size_t)std::numeric_limits<int>::max();
+          break;
+      }
+      if (_useLongIndices) {
+        _jacobianBuilderLong.initMatrixStructure(structure, errors, _numThreadsInitMatrixStructure);
+        initCholmodViews<SuiteSparse_long>();
+      } else {
+        _jacobianBuilder.initMatrixStructure(structure, errors, _numThreadsInitMatrixStructure);
+        initCholmodViews<int>();
+      }
+    }
+
+    template<typename I>
+    void SparseCholeskyLinearSystemSolver::initCholmodViews()
+    {
+      CompressedColumnMatrix<I>& J_transpose = jacobianBuilder<I>().J_transpose();
       if (_useDiagonalConditioner) {
         J_transpose.pushConstantDiagonalBlock(1.0);
       }
       // View this matrix as a sparse matrix.
       // These views should remain valid for the lifetime of the object.
       J_transpose.getView(&_cholmodLhs);
-      _cholmod.view(_rhs, &_cholmodRhs);
+      cholmod<I>().view(_rhs, &_cholmodRhs);
       if (_useDiagonalConditioner) {
         J_transpose.popDiagonalBlock();
       }
@@ -41,32 +103,53 @@ namespace aslam {
 
 
     void SparseCholeskyLinearSystemSolver::buildSystem(size_t nThreads, bool useMEstimator)
+    {
+      if (_useLongIndices) {
+        buildSystemImplementation<SuiteSparse_long>(nThreads, useMEstimator);
+      } else {
+        buildSystemImplementation<int>(nThreads, useMEstimator);
+      }
+    }
+
+    template<typename I>
+    void SparseCholeskyLinearSystemSolver::buildSystemImplementation(size_t nThreads, bool useMEstimator)
     {
       //std::cout << "build system\n";
-      _jacobianBuilder.buildSystem(nThreads, useMEstimator);
-      CompressedColumnMatrix<int>& J_transpose = _jacobianBuilder.J_transpose();
+      buildJacobian(jacobianBuilder<I>(), nThreads, useMEstimator);
+      CompressedColumnMatrix<I>& J_transpose = jacobianBuilder<I>().J_transpose();
       J_transpose.rightMultiply(_e, _rhs);
       // std::cout << "build system complete\n";
     }
 
     bool SparseCholeskyLinearSystemSolver::solveSystem(Eigen::VectorXd& outDx)
     {
-      CompressedColumnMatrix<int>& J_transpose = _jacobianBuilder.J_transpose();
+      if (_useLongIndices) {
+        return solveSystemImplementation<SuiteSparse_long>(outDx);
+      } else {
+        return solveSystemImplementation<int>(outDx);
+      }
+    }
+
+    template<typename I>
+    bool SparseCholeskyLinearSystemSolver::solveSystemImplementation(Eigen::VectorXd& outDx)
+    {
+      CompressedColumnMatrix<I>& J_transpose = jacobianBuilder<I>().J_transpose();
+      Cholmod<I>& cholmodI = cholmod<I>();
       if (_useDiagonalConditioner) {
         J_transpose.pushDiagonalBlock(_diagonalConditioner);
       }
       J_transpose.getView(&_cholmodLhs);
-      _cholmod.view(_rhs, &_cholmodRhs);
+      cholmodI.view(_rhs, &_cholmodRhs);
       // std::cout << "solve system\n";
       if (!_factor) {
         // std::cout << "\tAnalyze system\n";
         // Now do the symbolic analysis with cholmod.
-        _factor = _cholmod.analyze(&_cholmodLhs);
+        _factor = cholmodI.analyze(&_cholmodLhs);
         //  std::cout << "\tanalyze system complete\n";
       }
       // Now we can solve the system.
       outDx.resize(J_transpose.rows());
-      cholmod_dense* sol = _cholmod.solve(&_cholmodLhs, _factor, &_cholmodRhs);
+      cholmod_dense* sol = cholmodI.solve(&_cholmodLhs, _factor, &_cholmodRhs);
       if (_useDiagonalConditioner) {
         J_transpose.popDiagonalBlock();
       }
@@ -84,14 +167,121 @@ namespace aslam {
         std::cout << e.what() << std::endl;
         // avoid leaking memory but still do error checking.
         // look at me! I done good.
-        _cholmod.free(sol);
+        cholmodI.free(sol);
         throw;
       }
-      _cholmod.free(sol);
+      cholmodI.free(sol);
       //std::cout << "solve system complete\n";
       return true;
     }
 
+    bool SparseCholeskyLinearSystemSolver::solveSystemWithRhs(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx)
+    {
+      if (!_factor) {
+        return LinearSystemSolver::solveSystemWithRhs(rhs, outDx);
+      }
+      if (_useLongIndices) {
+        return solveSystemWithRhsImplementation<SuiteSparse_long>(rhs, outDx);
+      } else {
+        return solveSystemWithRhsImplementation<int>(rhs, outDx);
+      }
+    }
+
+    template<typename I>
+    bool SparseCholeskyLinearSystemSolver::solveSystemWithRhsImplementation(const Eigen::VectorXd& rhs, Eigen::VectorXd& outDx)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)rhs.size(), _JCols, "The right-hand side has the wrong size");
+      Cholmod<I>& cholmodI = cholmod<I>();
+      cholmod_dense cholmodRhs;
+      cholmodI.view(rhs, &cholmodRhs);
+      // The factor still holds the numeric factorization of the last solve, no refactorization necessary
+      cholmod_dense* sol = cholmodI.solve(_factor, &cholmodRhs);
+      if (!sol) {
+        std::cout << "Solution failed\n";
+        return false;
+      }
+      outDx.resize(rhs.size());
+      memcpy((void*)&outDx[0], sol->x, sizeof(double)*sol->nrow);
+      cholmodI.free(sol);
+      return true;
+    }
+
+    void SparseCholeskyLinearSystemSolver::solveSystems(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx)
+    {
+      if (_useLongIndices) {
+        solveSystemsImplementation<SuiteSparse_long>(conditioners, nThreads, outDx);
+      } else {
+        solveSystemsImplementation<int>(conditioners, nThreads, outDx);
+      }
+    }
+
+    template<typename I>
+    void SparseCholeskyLinearSystemSolver::solveSystemsImplementation(const std::vector<double>& conditioners, size_t nThreads, std::vector<Eigen::VectorXd>& outDx)
+    {
+      const CompressedColumnMatrix<I>& J_transpose = jacobianBuilder<I>().J_transpose();
+      if (!_factor) {
+        // The threads copy the symbolic analysis instead of repeating it.
+        if (_useDiagonalConditioner) {
+          jacobianBuilder<I>().J_transpose().pushConstantDiagonalBlock(1.0);
+        }
+        jacobianBuilder<I>().J_transpose().getView(&_cholmodLhs);
+        _factor = cholmod<I>().analyze(&_cholmodLhs);
+        if (_useDiagonalConditioner) {
+          jacobianBuilder<I>().J_transpose().popDiagonalBlock();
+        }
+      }
+      outDx.resize(conditioners.size());
+      util::runThreadedJob([&](size_t /* threadId */, size_t startIdx, size_t endIdx) {
+        if (startIdx == endIdx)
+          return;
+        // Each thread needs its own cholmod workspace, matrix and factor.
+        Cholmod<I> cholmodI;
+        CompressedColumnMatrix<I> lhs(J_transpose);
+        if (_useDiagonalConditioner) {
+          lhs.pushConstantDiagonalBlock(1.0);
+        }
+        cholmod_sparse cholmodLhs;
+        lhs.getView(&cholmodLhs);
+        cholmod_dense cholmodRhs;
+        cholmodI.view(_rhs, &cholmodRhs);
+        cholmod_factor* factor = cholmodI.copy(_factor);
+        for (size_t i = startIdx; i < endIdx; ++i) {
+          if (_useDiagonalConditioner) {
+            lhs.updateConstantDiagonalBlock(conditioners[i]);
+          }
+          cholmod_dense* sol = cholmodI.solve(&cholmodLhs, factor, &cholmodRhs);
+          if (!sol) {
+            outDx[i].resize(0);
+            continue;
+          }
+          outDx[i].resize(sol->nrow);
+          memcpy((void*)&outDx[i][0], sol->x, sizeof(double)*sol->nrow);
+          cholmodI.free(sol);
+        }
+        cholmodI.free(factor);
+      }, conditioners.size(), std::max<size_t>(1, std::min(nThreads, conditioners.size())));
+    }
+
+    bool SparseCholeskyLinearSystemSolver::multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const
+    {
+      if (_useLongIndices) {
+        _jacobianBuilderLong.J_transpose().leftMultiply(x, outJx);
+      } else {
+        _jacobianBuilder.J_transpose().leftMultiply(x, outJx);
+      }
+      return true;
+    }
+
+    bool SparseCholeskyLinearSystemSolver::multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const
+    {
+      if (_useLongIndices) {
+        _jacobianBuilderLong.J_transpose().rightMultiply(y, outJty);
+      } else {
+        _jacobianBuilder.J_transpose().rightMultiply(y, outJty);
+      }
+      return true;
+    }
+
     const SparseCholeskyLinearSolverOptions&
     SparseCholeskyLinearSystemSolver::getOptions() const {
       return _options;
@@ -108,7 +298,16 @@ namespace aslam {
     }
       
     double SparseCholeskyLinearSystemSolver::rhsJtJrhs() {
-        CompressedColumnMatrix<int>& J_transpose = _jacobianBuilder.J_transpose();
+      if (_useLongIndices) {
+        return rhsJtJrhsImplementation<SuiteSparse_long>();
+      } else {
+        return rhsJtJrhsImplementation<int>();
+      }
+    }
+
+    template<typename I>
+    double SparseCholeskyLinearSystemSolver::rhsJtJrhsImplementation() {
+        CompressedColumnMatrix<I>& J_transpose = jacobianBuilder<I>().J_transpose();
         Eigen::VectorXd Jrhs;
         J_transpose.leftMultiply(_rhs, Jrhs);
         return Jrhs.squaredNorm();
@@ -116,7 +315,7 @@ namespace aslam {
       
     void SparseCholeskyLinearSystemSolver::handleNewAcceptConstantErrorTerms() {
       _jacobianBuilder.J_transpose().setAcceptConstantErrorTerms(isAcceptConstantErrorTerms());
+      _jacobianBuilderLong.J_transpose().setAcceptConstantErrorTerms(isAcceptConstantErrorTerms());
     }
   } // namespace backend
 }  // namespace aslam
-
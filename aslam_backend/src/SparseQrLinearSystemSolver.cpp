@@ -27,26 +27,30 @@ namespace aslam {
     }
 
 
-  void SparseQrLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool /* useDiagonalConditioner */)
+  void SparseQrLinearSystemSolver::initMatrixStructureImplementation(const std::vector<DesignVariable*>& dvs, const std::vector<ErrorTerm*>& errors, bool useDiagonalConditioner)
     {
       _errorTerms = errors;
       if (_factor) {
         _cholmod.free(_factor);
         _factor = NULL;
       }
-      // should not be available or am i wrong?
-      _useDiagonalConditioner = false; // useDiagonalConditioner;
-      _jacobianBuilder.initMatrixStructure(dvs, errors);
+      _useDiagonalConditioner = useDiagonalConditioner;
+      _jacobianBuilder.initMatrixStructure(dvs, errors, _numThreadsInitMatrixStructure);
       // spqr is only available with LONG indices
       CompressedColumnMatrix<SuiteSparse_long>& J_transpose = _jacobianBuilder.J_transpose();
       if (_useDiagonalConditioner) {
+        // The augmented system [J; D] dx = [e; 0] needs a zero padded right-hand side.
+        _eAugmented = Eigen::VectorXd::Zero(_JRows + _JCols);
         J_transpose.pushConstantDiagonalBlock(1.0);
       }
       // View this matrix as a sparse matrix.
       // These views should remain valid for the lifetime of the object.
       J_transpose.getView(&_cholmodLhs);
-      _cholmod.view(_e, &_cholmodRhs);
+      _cholmod.view(_useDiagonalConditioner ? _eAugmented : _e, &_cholmodRhs);
+      // The sparsity pattern of [J; D] does not depend on the values of D.
+      // Therefore, the symbolic analysis is done once here and reused for every new conditioner.
       if (_useDiagonalConditioner) {
+        _factor = _cholmod.analyzeQR(&_cholmodLhs);
         J_transpose.popDiagonalBlock();
       }
     }
@@ -54,7 +58,7 @@ namespace aslam {
     void SparseQrLinearSystemSolver::buildSystem(size_t nThreads, bool useMEstimator)
     {
       //std::cout << "build system\n";
-      _jacobianBuilder.buildSystem(nThreads, useMEstimator);
+      buildJacobian(_jacobianBuilder, nThreads, useMEstimator);
       CompressedColumnMatrix<SuiteSparse_long>& J_transpose = _jacobianBuilder.J_transpose();
       J_transpose.rightMultiply(_e, _rhs);
       //std::cout << "build system complete\n";
@@ -66,9 +70,13 @@ namespace aslam {
       CompressedColumnMatrix<SuiteSparse_long>& J_transpose = _jacobianBuilder.J_transpose();
       if (_useDiagonalConditioner) {
         J_transpose.pushDiagonalBlock(_diagonalConditioner);
+        // The tail of the augmented right-hand side stays zero.
+        _eAugmented.head(_JRows) = _e;
+        _cholmod.view(_eAugmented, &_cholmodRhs);
+      } else {
+        _cholmod.view(_e, &_cholmodRhs);
       }
       J_transpose.getView(&_cholmodLhs);
-      _cholmod.view(_e, &_cholmodRhs);
       //std::cout << "solve system\n";
       if (!_factor) {
         //std::cout << "\tAnalyze system\n";
@@ -107,6 +115,29 @@ namespace aslam {
       return true;
     }
 
+    bool SparseQrLinearSystemSolver::solveSystemWithError(const Eigen::VectorXd& e, Eigen::VectorXd& outDx)
+    {
+      SM_ASSERT_EQ(Exception, (size_t)e.size(), _JRows, "The error vector has the wrong size");
+      // The right-hand side of the least squares problem is the error vector, not J^T e.
+      Eigen::VectorXd systemError = e;
+      _e.swap(systemError);
+      const bool success = solveSystem(outDx);
+      _e.swap(systemError);
+      return success;
+    }
+
+    bool SparseQrLinearSystemSolver::multiplyJacobian(const Eigen::VectorXd& x, Eigen::VectorXd& outJx) const
+    {
+      _jacobianBuilder.J_transpose().leftMultiply(x, outJx);
+      return true;
+    }
+
+    bool SparseQrLinearSystemSolver::multiplyJacobianTranspose(const Eigen::VectorXd& y, Eigen::VectorXd& outJty) const
+    {
+      _jacobianBuilder.J_transpose().rightMultiply(y, outJty);
+      return true;
+    }
+
     const SparseQRLinearSolverOptions&
     SparseQrLinearSystemSolver::getOptions() const {
       return _options;
@@ -176,11 +207,17 @@ namespace aslam {
     void SparseQrLinearSystemSolver::analyzeSystem() {
       CompressedColumnMatrix<SuiteSparse_long>& J_transpose =
         _jacobianBuilder.J_transpose();
+      // The factor has been analyzed for the augmented pattern if a conditioner is used.
+      if (_useDiagonalConditioner)
+        J_transpose.pushDiagonalBlock(_diagonalConditioner);
       J_transpose.getView(&_cholmodLhs);
       if (_factor == NULL)
         _factor = _cholmod.analyzeQR(&_cholmodLhs);
-      SM_ASSERT_TRUE(Exception, _cholmod.factorize(&_cholmodLhs, _factor,
-        _options.qrTol, true), "QR decomposition failed");
+      const bool success = _cholmod.factorize(&_cholmodLhs, _factor,
+        _options.qrTol, true);
+      if (_useDiagonalConditioner)
+        J_transpose.popDiagonalBlock();
+      SM_ASSERT_TRUE(Exception, success, "QR decomposition failed");
     }
 
     double SparseQrLinearSystemSolver::rhsJtJrhs() {
@@ -33,6 +33,12 @@ namespace aslam {
             _isFirstIteration=true;
             optimizationStartingImplementation(J);
         }
+
+        void TrustRegionPolicy::structureChanged()
+        {
+            // The last step and the solver's right hand side do not refer to the new columns
+            _isFirstIteration=true;
+        }
             
         // Returns true if the solution was successful
     bool TrustRegionPolicy::solveSystem(double J, bool previousIterationFailed, int nThreads, Eigen::VectorXd& outDx)
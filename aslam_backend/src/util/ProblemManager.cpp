@@ -1,4 +1,7 @@
 #include <aslam/backend/util/ProblemManager.hpp>
+
+#include <algorithm>
+
 #include <aslam/backend/OptimizationProblemBase.hpp>
 #include <aslam/backend/ErrorTerm.hpp>
 #include <aslam/backend/ScalarNonSquaredErrorTerm.hpp>
@@ -36,7 +39,7 @@ void ProblemManager::setProblem(boost::shared_ptr<OptimizationProblemBase> probl
 }
 
 /// \brief initialize the class
-void ProblemManager::initialize()
+void ProblemManager::initialize(size_t nThreads)
 {
 
   SM_ASSERT_FALSE(Exception, _problem == nullptr, "No optimization problem has been set");
@@ -48,23 +51,7 @@ void ProblemManager::initialize()
   _errorTermsS.clear();
   _errorTermsS.reserve(_problem->numErrorTerms());
   Timer initDv("ProblemManager: Initialize design Variables");
-  // Run through all design variables adding active ones to an active list.
-  for (size_t i = 0; i < _problem->numDesignVariables(); ++i) {
-    DesignVariable* dv = _problem->designVariable(i);
-    if (dv->isActive())
-      _designVariables.push_back(dv);
-  }
-  SM_ASSERT_FALSE(Exception, _problem->numDesignVariables() > 0 && _designVariables.empty(),
-                  "It is illegal to run the optimizer with all marginalized design variables. Did you forget to set the design variables as active?");
-  SM_ASSERT_FALSE(Exception, _designVariables.empty(), "It is illegal to run the optimizer with all marginalized design variables.");
-  // Assign block indices to the design variables.
-  // "blocks" will hold the structure of the left-hand-side of Gauss-Newton
-  _numOptParameters = 0;
-  for (size_t i = 0; i < _designVariables.size(); ++i) {
-    _designVariables[i]->setBlockIndex(i);
-    _designVariables[i]->setColumnBase(_numOptParameters);
-    _numOptParameters += _designVariables[i]->minimalDimensions();
-  }
+  initializeDesignVariables();
   initDv.stop();
 
   Timer initEt("ProblemManager: Initialize error terms");
@@ -75,15 +62,23 @@ void ProblemManager::initialize()
     _errorTermsNS.push_back(e);
     _numErrorTerms++;
   }
-  _dimErrorTermsS = 0;
   for (unsigned i = 0; i < _problem->numErrorTerms(); ++i) {
-    ErrorTerm* e = _problem->errorTerm(i);
-    _errorTermsS.push_back(e);
-    e->setRowBase(_dimErrorTermsS);
-    _dimErrorTermsS += e->dimension();
+    _errorTermsS.push_back(_problem->errorTerm(i));
     _numErrorTerms++;
   }
   initEt.stop();
+
+  Timer initRows("ProblemManager: Initialize row bases");
+  // The row base of each error term is the sum of the dimensions of the error terms before it
+  nThreads = std::max<size_t>(1, nThreads);
+  std::vector<std::size_t> rowBases;
+  _dimErrorTermsS = util::runThreadedExclusiveScan([this](size_t i) -> std::size_t { return _errorTermsS[i]->dimension(); },
+                                                   _errorTermsS.size(), nThreads, rowBases);
+  util::runThreadedJob([this, &rowBases](size_t /*threadId*/, size_t startIdx, size_t endIdx) {
+    for (size_t i = startIdx; i < endIdx; ++i)
+      _errorTermsS[i]->setRowBase(rowBases[i]);
+  }, _errorTermsS.size(), nThreads);
+  initRows.stop();
   SM_ASSERT_FALSE(Exception, _errorTermsNS.empty() && _errorTermsS.empty(), "It is illegal to run the optimizer with no error terms.");
 
   _isInitialized = true;
@@ -95,6 +90,35 @@ void ProblemManager::initialize()
 
 }
 
+void ProblemManager::updateDesignVariables()
+{
+  SM_ASSERT_TRUE(Exception, _isInitialized, "The problem manager has to be initialized before updating the design variables");
+  Timer t("ProblemManager: Update design variables");
+  initializeDesignVariables();
+}
+
+void ProblemManager::initializeDesignVariables()
+{
+  _designVariables.clear();
+  // Run through all design variables adding active ones to an active list.
+  for (size_t i = 0; i < _problem->numDesignVariables(); ++i) {
+    DesignVariable* dv = _problem->designVariable(i);
+    if (dv->isActive())
+      _designVariables.push_back(dv);
+  }
+  SM_ASSERT_FALSE(Exception, _problem->numDesignVariables() > 0 && _designVariables.empty(),
+                  "It is illegal to run the optimizer with all marginalized design variables. Did you forget to set the design variables as active?");
+  SM_ASSERT_FALSE(Exception, _designVariables.empty(), "It is illegal to run the optimizer with all marginalized design variables.");
+  // Assign block indices to the design variables.
+  // "blocks" will hold the structure of the left-hand-side of Gauss-Newton
+  _numOptParameters = 0;
+  for (size_t i = 0; i < _designVariables.size(); ++i) {
+    _designVariables[i]->setBlockIndex(i);
+    _designVariables[i]->setColumnBase(_numOptParameters);
+    _numOptParameters += _designVariables[i]->minimalDimensions();
+  }
+}
+
 DesignVariable* ProblemManager::designVariable(size_t i)
 {
   SM_ASSERT_LT_DBG(Exception, i, _designVariables.size(), "index out of bounds");
@@ -132,6 +156,57 @@ void ProblemManager::computeGradient(RowVectorType& outGrad, size_t nThreads, bo
     applyDesignVariableScaling(outGrad);
 }
 
+void ProblemManager::computeGradient(RowVectorType& outGrad, const std::vector<std::size_t>& errorTermIndices, std::vector<RowVectorType>& threadGradients,
+                                     bool useMEstimator, bool applyDvScaling, bool useDenseJacobianContainer)
+{
+  SM_ASSERT_GT(Exception, threadGradients.size(), 0, "");
+  Timer t("ProblemManager: Compute batch gradient", false);
+  // The error terms only write to the columns of their active design variables. Only these columns of the per
+  // thread accumulators are cleared and summed up, so a small batch does not cost O(numOptParameters) per thread.
+  std::vector<DesignVariable*> dvs;
+  getDesignVariables(errorTermIndices, dvs);
+  dvs.erase(std::remove_if(dvs.begin(), dvs.end(), [](const DesignVariable* dv) { return !dv->isActive(); }), dvs.end());
+  std::sort(dvs.begin(), dvs.end());
+  dvs.erase(std::unique(dvs.begin(), dvs.end()), dvs.end());
+  for (auto& g : threadGradients) {
+    if (g.cols() != static_cast<Eigen::Index>(_numOptParameters)) {
+      g.setZero(_numOptParameters);
+    } else {
+      for (const auto dv : dvs)
+        g.segment(dv->columnBase(), dv->minimalDimensions()).setZero();
+    }
+  }
+  boost::function<void(size_t, size_t, size_t, RowVectorType&)> job(boost::bind(&ProblemManager::evaluateGradientsForIndices, this, _1, _2, _3, _4,
+                                                                                boost::cref(errorTermIndices), useMEstimator, useDenseJacobianContainer));
+  util::runThreadedFunction(job, errorTermIndices.size(), threadGradients);
+  // Add up the gradients
+  outGrad.setZero(_numOptParameters);
+  for (const auto dv : dvs) {
+    auto block = outGrad.segment(dv->columnBase(), dv->minimalDimensions());
+    for (const auto& g : threadGradients)
+      block += g.segment(dv->columnBase(), dv->minimalDimensions());
+    if (applyDvScaling)
+      block *= dv->scaling();
+  }
+}
+
+void ProblemManager::getDesignVariables(const std::vector<std::size_t>& errorTermIndices, std::vector<DesignVariable*>& outDvs) const
+{
+  outDvs.clear();
+  for (const auto i : errorTermIndices) {
+    SM_ASSERT_LT_DBG(Exception, i, _numErrorTerms, "index out of bounds");
+    if (i < _errorTermsNS.size()) {
+      ScalarNonSquaredErrorTerm* e = _errorTermsNS[i];
+      for (size_t j = 0; j < e->numDesignVariables(); ++j)
+        outDvs.push_back(e->designVariable(j));
+    } else {
+      ErrorTerm* e = _errorTermsS[i - _errorTermsNS.size()];
+      for (size_t j = 0; j < e->numDesignVariables(); ++j)
+        outDvs.push_back(e->designVariable(j));
+    }
+  }
+}
+
 void ProblemManager::applyDesignVariableScaling(RowVectorType& outGrad) const {
   for (const auto dv : _designVariables)
     outGrad.block(0, dv->columnBase(), outGrad.rows(), dv->minimalDimensions()) *= dv->scaling();
@@ -171,7 +246,7 @@ void ProblemManager::addGradientForErrorTerm(JacobianContainerDense<RowVectorTyp
 
 double ProblemManager::evaluateError(const size_t nThreads /*= 1*/) const {
 
-  std::vector<double> errors(nThreads, 0.0);
+  std::vector<double> errors(std::max<size_t>(1, nThreads), 0.0);
   boost::function<void(size_t, size_t, size_t, double&)> job(boost::bind(&ProblemManager::sumErrorTerms, this, _1, _2, _3, _4));
   util::runThreadedFunction(job, _numErrorTerms, errors);
 
@@ -183,6 +258,20 @@ double ProblemManager::evaluateError(const size_t nThreads /*= 1*/) const {
 
 }
 
+double ProblemManager::evaluateError(const std::vector<std::size_t>& errorTermIndices, const size_t nThreads /*= 1*/) const {
+
+  std::vector<double> errors(std::max<size_t>(1, nThreads), 0.0);
+  boost::function<void(size_t, size_t, size_t, double&)> job(boost::bind(&ProblemManager::sumErrorTermsForIndices, this, _1, _2, _3, _4, boost::cref(errorTermIndices)));
+  util::runThreadedFunction(job, errorTermIndices.size(), errors);
+
+  double error = 0.0;
+  for (auto e : errors)
+    error += e;
+
+  return error;
+
+}
+
 
 void ProblemManager::applyStateUpdate(const ColumnVectorType& dx)
 {
@@ -258,6 +347,18 @@ void ProblemManager::sumErrorTerms(size_t /* threadId */, size_t startIdx, size_
   }
 }
 
+void ProblemManager::sumErrorTermsForIndices(size_t /* threadId */, size_t startIdx, size_t endIdx, double& err, const std::vector<std::size_t>& errorTermIndices) const {
+  SM_ASSERT_LE_DBG(Exception, endIdx, errorTermIndices.size(), "");
+  for (size_t k = startIdx; k < endIdx; ++k) {
+    const size_t i = errorTermIndices[k];
+    SM_ASSERT_LT_DBG(Exception, i, _numErrorTerms, "index out of bounds");
+    if (i < _errorTermsNS.size())
+      err += _errorTermsNS[i]->evaluateError();
+    else
+      err += _errorTermsS[i - _errorTermsNS.size()]->evaluateError();
+  }
+}
+
 /**
  * Evaluate the gradient of the objective function
  * @param
@@ -297,5 +398,37 @@ void ProblemManager::evaluateGradients(size_t /* threadId */, size_t startIdx, s
 
 }
 
+/**
+ * Evaluate the gradient of a subset of the error terms
+ * @param startIdx First position in \p errorTermIndices (including)
+ * @param endIdx Last position in \p errorTermIndices (excluding)
+ * @param J The gradient for the specified error terms
+ * @param errorTermIndices The error term indices
+ */
+void ProblemManager::evaluateGradientsForIndices(size_t /* threadId */, size_t startIdx, size_t endIdx, RowVectorType& J,
+                                                 const std::vector<std::size_t>& errorTermIndices, bool useMEstimator, bool useDenseJacobianContainer)
+{
+  SM_ASSERT_LE_DBG(Exception, endIdx, errorTermIndices.size(), "");
+
+  JacobianContainerDense<RowVectorType&, 1> jcDense(J);
+  JacobianContainerSparse<1> jcSparse(1);
+  for (size_t k = startIdx; k < endIdx; ++k)
+  {
+    const size_t i = errorTermIndices[k];
+    SM_ASSERT_LT_DBG(Exception, i, _numErrorTerms, "index out of bounds");
+    if (i < _errorTermsNS.size()) {
+      if (useDenseJacobianContainer) {
+        addGradientForErrorTerm(jcDense, _errorTermsNS[i], useMEstimator);
+      } else {
+        jcSparse.clear();
+        addGradientForErrorTerm(jcSparse, J, _errorTermsNS[i], useMEstimator);
+      }
+    } else {
+      addGradientForErrorTerm(J, _errorTermsS[i - _errorTermsNS.size()], useMEstimator, false);
+    }
+  }
+
+}
+
 } // namespace backend
 } // namespace aslam
@@ -2,6 +2,7 @@
 
 #include <aslam/backend/CompressedColumnMatrix.hpp>
 #include <numeric>
+#include <limits>
 #include "DummyDesignVariable.hpp"
 #include <aslam/backend/CompressedColumnJacobianTransposeBuilder.hpp>
 #include <aslam/backend/test/SampleDvAndError.hpp>
@@ -147,6 +148,74 @@ TEST(CompressColumnMatrixTestSuite, testJcBuilder)
 }
 
 
+TEST(CompressColumnMatrixTestSuite, testJcBuilderParallelStructure)
+{
+  using namespace aslam::backend;
+  const int D = 5;
+  const int E = 23;
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    int blockBase = 0;
+    for (int i = 0; i < D; ++i) {
+      dvs.push_back(new Point2d(Eigen::Vector2d::Random()));
+      dvs.back()->setActive(true);
+      dvs.back()->setBlockIndex(i);
+      dvs.back()->setColumnBase(blockBase);
+      blockBase += dvs.back()->minimalDimensions();
+    }
+    // A serially appended reference structure
+    CompressedColumnMatrix<int> reference(blockBase, 0, 0, 0);
+    for (int i = 0; i < E; ++i) {
+      if (i % 2 == 0)
+        errs.push_back(new LinearErr2((Point2d*)dvs[(i + 1) % D], (Point2d*)dvs[i % D]));
+      else
+        errs.push_back(new LinearErr3((Point2d*)dvs[i % D], (Point2d*)dvs[(i + 3) % D], (Point2d*)dvs[(i + 1) % D]));
+      reference.appendErrorJacobiansSymbolic(*errs.back());
+    }
+
+    std::vector<int> dimensions;
+    for (ErrorTerm* e : errs)
+      dimensions.push_back(e->dimension());
+    for (size_t nThreads = 1; nThreads <= 2 * errs.size(); nThreads += 3) {
+      std::vector<int> offsets;
+      const int total = util::runThreadedExclusiveScan([&dimensions](size_t i) { return dimensions[i]; }, dimensions.size(), nThreads, offsets);
+      ASSERT_EQ(std::accumulate(dimensions.begin(), dimensions.end(), 0), total);
+      ASSERT_EQ(dimensions.size(), offsets.size());
+      for (size_t i = 0; i < offsets.size(); ++i)
+        ASSERT_EQ(std::accumulate(dimensions.begin(), dimensions.begin() + i, 0), offsets[i]) << "Number of threads: " << nThreads;
+
+      CompressedColumnJacobianTransposeBuilder<int> ccjtb;
+      ccjtb.initMatrixStructure(dvs, errs, nThreads);
+      const CompressedColumnMatrix<int>& J_transpose = ccjtb.J_transpose();
+      ASSERT_EQ(reference.rows(), J_transpose.rows());
+      ASSERT_EQ(reference.cols(), J_transpose.cols());
+      ASSERT_TRUE(reference.col_ptr() == J_transpose.col_ptr()) << "Number of threads: " << nThreads;
+      ASSERT_TRUE(reference.row_ind() == J_transpose.row_ind()) << "Number of threads: " << nThreads;
+      // The structure is ready for evaluating the Jacobians
+      for (ErrorTerm* e : errs)
+        e->evaluateError();
+      ccjtb.buildSystem(nThreads, false);
+      Eigen::MatrixXd J = ccjtb.J_transpose().toDense().transpose();
+      for (size_t i = 0; i < errs.size(); ++i) {
+        JacobianContainerSparse<> jc(errs[i]->dimension());
+        errs[i]->getWeightedJacobians(jc, false);
+        std::vector<int> blocks;
+        for (DesignVariable* dv : dvs)
+          blocks.push_back(dv->columnBase() + dv->minimalDimensions());
+        ASSERT_DOUBLE_MX_EQ(J.block(offsets[i], 0, errs[i]->dimension(), J.cols()), jc.asDenseMatrix(blocks), 1e-6, "Number of threads: " << nThreads << ", block row: " << i);
+      }
+    }
+  } catch (std::exception const& e) {
+    ADD_FAILURE() << e.what();
+  }
+  for (unsigned i = 0; i < dvs.size(); ++i)
+    delete dvs[i];
+  for (unsigned i = 0; i < errs.size(); ++i)
+    delete errs[i];
+}
+
+
 TEST(CompressColumnMatrixTestSuite, testAppendDiagonal)
 {
   const int rows = 5;
@@ -164,3 +233,16 @@ TEST(CompressColumnMatrixTestSuite, testAppendDiagonal)
   Eigen::MatrixXd diagDense = diag.asDiagonal();
   ASSERT_DOUBLE_MX_EQ(matDense, diagDense, 1e-6, "");
 }
+
+TEST(CompressColumnMatrixTestSuite, testJacobianColumnPointerLargeOffsets)
+{
+  using namespace aslam::backend;
+  // Offsets beyond the range of int have to be computed without overflow
+  const size_t start = (size_t(3) << 30);
+  const size_t elementsPerColumn = 100000;
+  JacobianColumnPointer cp(start, elementsPerColumn, 2);
+  EXPECT_EQ(start, cp.valueIndex(0, 0));
+  EXPECT_EQ(start + 7, cp.valueIndex(0, 7));
+  EXPECT_EQ(start + 30000 * elementsPerColumn + 7, cp.valueIndex(30000, 7));
+  EXPECT_GT(cp.valueIndex(30000, 7), size_t(std::numeric_limits<int>::max()) * 2);
+}
@@ -2,12 +2,15 @@
 
 #include <numeric>
 
+#include <Eigen/Dense>
+
 #include <aslam/backend/test/SampleDvAndError.hpp>
 
 #include <aslam/backend/DenseQrLinearSystemSolver.hpp>
 #include <aslam/backend/SparseCholeskyLinearSystemSolver.hpp>
 #include <aslam/backend/SparseQrLinearSystemSolver.hpp>
 #include <aslam/backend/BlockCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/MixedPrecisionCholeskyLinearSystemSolver.hpp>
 #include <boost/lexical_cast.hpp>
 #include <aslam/backend/Optimizer2.hpp>
 #include <aslam/backend/OptimizationProblem.hpp>
@@ -16,7 +19,7 @@ using namespace aslam::backend;
 
 
 template<typename S1_TYPE, typename S2_TYPE>
-void compareSolvers(int D, int E, bool useM, bool useDiag, int nThreads)
+void compareSolvers(int D, int E, bool useM, bool useDiag, int nThreads, double tolerance = 1e-6)
 {
   std::string S1Name = typeid(S1_TYPE).name();
   std::string S2Name = typeid(S2_TYPE).name();
@@ -51,10 +54,10 @@ void compareSolvers(int D, int E, bool useM, bool useDiag, int nThreads)
     S2.buildSystem(nThreads, useM);
     rhsS1 = S1.rhs();
     rhsS2 = S2.rhs();
-    ASSERT_DOUBLE_MX_EQ(rhsS1, rhsS2, 1e-6, "Checking right-hand sides");
+    ASSERT_DOUBLE_MX_EQ(rhsS1, rhsS2, tolerance, "Checking right-hand sides");
     S1.solveSystem(dxS1);
     S2.solveSystem(dxS2);
-    ASSERT_DOUBLE_MX_EQ(dxS2, dxS1, 1e-6, "Checking the solutions");
+    ASSERT_DOUBLE_MX_EQ(dxS2, dxS1, tolerance, "Checking the solutions");
     deleteSystem(dvs, errs);
   } catch (const std::exception& e) {
     deleteSystem(dvs, errs);
@@ -114,6 +117,54 @@ TEST(LinearSolverTestSuite, testSparseCholesky)
   }
 }
 
+/// A sparse Cholesky solver that always uses SuiteSparse_long indices.
+class SparseCholeskyLongIndexLinearSystemSolver : public SparseCholeskyLinearSystemSolver {
+ public:
+  SparseCholeskyLongIndexLinearSystemSolver() {
+    getOptions().indexType = SparseCholeskyLinearSolverOptions::INDEX_LONG;
+  }
+};
+
+TEST(LinearSolverTestSuite, testSparseCholeskyLongIndices)
+{
+  using namespace aslam::backend;
+  const int D = 4;
+  const int E = 20;
+  const bool useM = false;
+  bool useDiag = true;
+  for (int nThreads = 0; nThreads < 4; ++nThreads) {
+    {
+      useDiag = false;
+      SCOPED_TRACE(("No Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
+      compareSolvers<SparseCholeskyLinearSystemSolver, SparseCholeskyLongIndexLinearSystemSolver>(D, E, useM, useDiag, nThreads);
+    }
+    {
+      useDiag = true;
+      SCOPED_TRACE(("With Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
+      compareSolvers<SparseCholeskyLinearSystemSolver, SparseCholeskyLongIndexLinearSystemSolver>(D, E, useM, useDiag, nThreads);
+    }
+  }
+
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  buildSystem(D, E, dvs, errs);
+  SparseCholeskyLinearSystemSolver automatic;
+  automatic.initMatrixStructure(dvs, errs, false);
+  EXPECT_FALSE(automatic.isUsingLongIndices());
+  SparseCholeskyLongIndexLinearSystemSolver forced;
+  forced.initMatrixStructure(dvs, errs, false);
+  EXPECT_TRUE(forced.isUsingLongIndices());
+
+  // The index type is chosen from the parallel count of the nonzeros
+  const JacobianTransposeStructure structure = CompressedColumnJacobianTransposeBuilder<int>::computeStructure(dvs, errs, 3);
+  CompressedColumnJacobianTransposeBuilder<int> builder;
+  builder.initMatrixStructure(dvs, errs, 1);
+  EXPECT_EQ(builder.J_transpose().nnz(), structure.total.nnz);
+  EXPECT_EQ(builder.J_transpose().cols(), structure.total.cols);
+  EXPECT_EQ(builder.J_transpose().rows(), structure.rows);
+  deleteSystem(dvs, errs);
+}
+
 TEST(LinearSolverTestSuite, testSparseQR)
 {
   using namespace aslam::backend;
@@ -129,12 +180,116 @@ TEST(LinearSolverTestSuite, testSparseQR)
       SCOPED_TRACE(("No Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
       compareSolvers<SparseCholeskyLinearSystemSolver, SparseQrLinearSystemSolver>(D, E, useM, useDiag, nThreads);
     }
-    /*
-            {
-                useDiag = true;
-                SCOPED_TRACE(("With Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
-                compareSolvers<SparseCholeskyLinearSystemSolver, SparseQrLinearSystemSolver>(D,E,useM, useDiag, nThreads);
-            }*/
+    {
+      useDiag = true;
+      SCOPED_TRACE(("With Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
+      compareSolvers<SparseCholeskyLinearSystemSolver, SparseQrLinearSystemSolver>(D, E, useM, useDiag, nThreads);
+    }
+  }
+}
+
+TEST(LinearSolverTestSuite, testMixedPrecisionCholesky)
+{
+  using namespace aslam::backend;
+  const int D = 4;
+  const int E = 20;
+  const bool useM = false;
+  bool useDiag = false;
+  // J^T is stored in single precision, the solution agrees up to its rounding (percent tolerance).
+  const double tolerance = 1e-2;
+  for (int nThreads = 0; nThreads < 4; ++nThreads) {
+    {
+      useDiag = false;
+      SCOPED_TRACE(("No Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
+      compareSolvers<SparseCholeskyLinearSystemSolver, MixedPrecisionCholeskyLinearSystemSolver>(D, E, useM, useDiag, nThreads, tolerance);
+    }
+    {
+      useDiag = true;
+      SCOPED_TRACE(("With Diagonal and " + boost::lexical_cast<std::string>(nThreads) + " threads").c_str());
+      compareSolvers<SparseCholeskyLinearSystemSolver, MixedPrecisionCholeskyLinearSystemSolver>(D, E, useM, useDiag, nThreads, tolerance);
+    }
+  }
+}
+
+TEST(LinearSolverTestSuite, testMixedPrecisionCholeskyRefinement)
+{
+  using namespace aslam::backend;
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    buildSystem(4, 20, dvs, errs);
+    MixedPrecisionCholeskyLinearSolverOptions options;
+    options.maxRefinementSteps = 5;
+    options.refinementTolerance = 1e-12;
+    MixedPrecisionCholeskyLinearSystemSolver solver(options);
+    solver.initMatrixStructure(dvs, errs, true);
+    Eigen::VectorXd diag(solver.JCols());
+    diag.setConstant(1e-3);
+    solver.setConditioner(diag);
+    solver.evaluateError(1, false);
+    solver.buildSystem(1, false);
+    Eigen::VectorXd dx;
+    ASSERT_TRUE(solver.solveSystem(dx));
+    // The single precision factorization alone can not reach the tolerance.
+    EXPECT_GT(solver.getNumRefinementSteps(), 0);
+    EXPECT_LE(solver.getNumRefinementSteps(), options.maxRefinementSteps);
+    EXPECT_LT(solver.getRelativeResidual(), 1e-12);
+    // The refinement recovers the double precision solution for the single precision Jacobian.
+    Eigen::MatrixXd Jt;
+    solver.getJacobianTranspose().toDenseInto(Jt);
+    Eigen::MatrixXd H = Jt * Jt.transpose();
+    H.diagonal() += diag.cwiseAbs2();
+    const Eigen::VectorXd dxReference = H.ldlt().solve(solver.rhs());
+    ASSERT_DOUBLE_MX_EQ(dxReference, dx, 1e-8, "Checking the solutions");
+    deleteSystem(dvs, errs);
+  } catch (const std::exception& e) {
+    deleteSystem(dvs, errs);
+    FAIL() << e.what();
+  }
+}
+
+template<typename SOLVER_TYPE>
+void checkConcurrentSolveSystems(size_t nThreads)
+{
+  SCOPED_TRACE(typeid(SOLVER_TYPE).name());
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    buildSystem(4, 20, dvs, errs);
+    SOLVER_TYPE solver;
+    solver.initMatrixStructure(dvs, errs, true);
+    solver.setConstantConditioner(1e-2);
+    solver.evaluateError(1, false);
+    solver.buildSystem(1, false);
+    Eigen::VectorXd dx;
+    ASSERT_TRUE(solver.solveSystem(dx));
+    const std::vector<double> conditioners = { 1e-3, 1e-1, 1.0, 10.0, 1e3 };
+    std::vector<Eigen::VectorXd> concurrentDx, sequentialDx;
+    solver.solveSystems(conditioners, nThreads, concurrentDx);
+    solver.LinearSystemSolver::solveSystems(conditioners, 1, sequentialDx);
+    ASSERT_EQ(conditioners.size(), concurrentDx.size());
+    ASSERT_EQ(conditioners.size(), sequentialDx.size());
+    for (size_t i = 0; i < conditioners.size(); ++i) {
+      SCOPED_TRACE(conditioners[i]);
+      ASSERT_DOUBLE_MX_EQ(sequentialDx[i], concurrentDx[i], 1e-9, "Checking the solutions");
+    }
+    // The conditioner of the solver is unchanged
+    Eigen::VectorXd dxAfter;
+    ASSERT_TRUE(solver.solveSystem(dxAfter));
+    ASSERT_DOUBLE_MX_EQ(dx, dxAfter, 1e-12, "Checking the solution of the solver's conditioner");
+    deleteSystem(dvs, errs);
+  } catch (const std::exception& e) {
+    deleteSystem(dvs, errs);
+    FAIL() << e.what();
+  }
+}
+
+TEST(LinearSolverTestSuite, testConcurrentSolveSystems)
+{
+  for (size_t nThreads : { 1u, 2u, 8u }) {
+    SCOPED_TRACE(nThreads);
+    checkConcurrentSolveSystems<DenseQrLinearSystemSolver>(nThreads);
+    checkConcurrentSolveSystems<SparseCholeskyLinearSystemSolver>(nThreads);
   }
 }
 
@@ -164,3 +319,134 @@ TEST(LinearSolverTestSuite, testSparseQRAcceptConstantErrorTerms)
   EXPECT_ANY_THROW(solver.initMatrixStructure(dvs, errs, false));
   deleteSystem(dvs, errs);
 }
+
+TEST(LinearSolverTestSuite, testSkipJacobiansOfSmallMEstimatorWeights)
+{
+  using namespace aslam::backend;
+  const int D = 4;
+  const int E = 20;
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    buildSystem(D, E, dvs, errs);
+    // Every third error term is suppressed as an outlier
+    for (size_t i = 0; i < errs.size(); i += 3)
+      errs[i]->setMEstimatorPolicy(boost::shared_ptr<MEstimator>(new FixedWeightMEstimator(1e-8)));
+
+    for (int nThreads = 1; nThreads < 4; ++nThreads) {
+      SCOPED_TRACE(boost::lexical_cast<std::string>(nThreads) + " threads");
+      SparseQrLinearSystemSolver reference, skipping;
+      reference.initMatrixStructure(dvs, errs, false);
+      skipping.initMatrixStructure(dvs, errs, false);
+      skipping.setMEstimatorWeightThreshold(1e-4);
+      reference.evaluateError(nThreads, true);
+      skipping.evaluateError(nThreads, true);
+      reference.buildSystem(nThreads, true);
+      skipping.buildSystem(nThreads, true);
+      EXPECT_EQ(0u, reference.numSkippedJacobians());
+      EXPECT_EQ((errs.size() + 2) / 3, skipping.numSkippedJacobians());
+
+      // The columns of J^T of the suppressed error terms are zero, all others are unchanged
+      Eigen::MatrixXd Jt = skipping.getJacobianTranspose().toDense();
+      Eigen::MatrixXd JtRef = reference.getJacobianTranspose().toDense();
+      for (size_t i = 0; i < errs.size(); ++i) {
+        const int r = errs[i]->rowBase(), d = errs[i]->dimension();
+        if (i % 3 == 0)
+          EXPECT_EQ(0.0, Jt.middleCols(r, d).norm());
+        else
+          sm::eigen::assertNear(JtRef.middleCols(r, d), Jt.middleCols(r, d), 1e-12, SM_SOURCE_FILE_POS);
+      }
+
+      // Without the MEstimator nothing is skipped
+      const size_t numSkippedBefore = skipping.numSkippedJacobians();
+      skipping.evaluateError(nThreads, false);
+      skipping.buildSystem(nThreads, false);
+      EXPECT_EQ(0u, skipping.numSkippedJacobians() - numSkippedBefore);
+    }
+    deleteSystem(dvs, errs);
+  } catch (const std::exception& e) {
+    deleteSystem(dvs, errs);
+    FAIL() << e.what();
+  }
+}
+
+namespace {
+/// \brief Exposes the refresh flags of the last Jacobian update
+class RefreshFlagsSparseQrLinearSystemSolver : public aslam::backend::SparseQrLinearSystemSolver {
+ public:
+  const std::vector<char>& refreshErrorTerm() const { return _refreshErrorTerm; }
+};
+}
+
+TEST(LinearSolverTestSuite, testPartialJacobianIgnoresRevertedSteps)
+{
+  using namespace aslam::backend;
+  const int D = 4;
+  const int E = 20;
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    buildSystem(D, E, dvs, errs);
+    RefreshFlagsSparseQrLinearSystemSolver solver;
+    solver.initMatrixStructure(dvs, errs, false);
+    solver.setJacobianUpdate(LinearSystemSolver::JACOBIAN_PARTIAL, 0.1);
+    solver.evaluateError(1, false);
+    solver.buildSystem(1, false);
+
+    // A rejected step returns to the linearization point, no Jacobian is stale
+    const Eigen::VectorXd dx = Eigen::VectorXd::Constant(solver.JCols(), 1.0);
+    solver.notifyStateUpdate(dx);
+    solver.notifyStateUpdate(-dx);
+    solver.evaluateError(1, false);
+    solver.buildSystem(1, false);
+    EXPECT_EQ(std::vector<char>(errs.size(), 0), solver.refreshErrorTerm());
+
+    // An accepted step moves every error term beyond the tolerance
+    solver.notifyStateUpdate(dx);
+    solver.evaluateError(1, false);
+    solver.buildSystem(1, false);
+    EXPECT_EQ(std::vector<char>(errs.size(), 1), solver.refreshErrorTerm());
+    deleteSystem(dvs, errs);
+  } catch (const std::exception& e) {
+    deleteSystem(dvs, errs);
+    FAIL() << e.what();
+  }
+}
+
+TEST(LinearSolverTestSuite, testPartialJacobianRefreshesRecoveredMEstimatorWeights)
+{
+  using namespace aslam::backend;
+  const int D = 4;
+  const int E = 20;
+  std::vector<DesignVariable*> dvs;
+  std::vector<ErrorTerm*> errs;
+  try {
+    buildSystem(D, E, dvs, errs);
+    for (size_t i = 0; i < errs.size(); i += 3)
+      errs[i]->setMEstimatorPolicy(boost::shared_ptr<MEstimator>(new FixedWeightMEstimator(1e-8)));
+
+    SparseQrLinearSystemSolver reference, partial;
+    reference.initMatrixStructure(dvs, errs, false);
+    partial.initMatrixStructure(dvs, errs, false);
+    partial.setMEstimatorWeightThreshold(1e-4);
+    // Without state updates no error term moves beyond the tolerance
+    partial.setJacobianUpdate(LinearSystemSolver::JACOBIAN_PARTIAL, 1e3);
+    partial.evaluateError(1, true);
+    partial.buildSystem(1, true);
+    EXPECT_EQ((errs.size() + 2) / 3, partial.numSkippedJacobians());
+
+    // The weights recover, the zero filled Jacobians must be evaluated although the state did not change
+    for (size_t i = 0; i < errs.size(); i += 3)
+      errs[i]->setMEstimatorPolicy(boost::shared_ptr<MEstimator>(new FixedWeightMEstimator(1.0)));
+    reference.evaluateError(1, true);
+    partial.evaluateError(1, true);
+    reference.buildSystem(1, true);
+    partial.buildSystem(1, true);
+    EXPECT_EQ((errs.size() + 2) / 3, partial.numSkippedJacobians());
+    sm::eigen::assertNear(reference.getJacobianTranspose().toDense(), partial.getJacobianTranspose().toDense(), 1e-12, SM_SOURCE_FILE_POS);
+    deleteSystem(dvs, errs);
+  } catch (const std::exception& e) {
+    deleteSystem(dvs, errs);
+    FAIL() << e.what();
+  }
+}
@@ -119,7 +119,8 @@ TEST(MatrixStackTestSuites, testMatrixStack)
       sm::eigen::assertEqual(M1, stack.top(), SM_SOURCE_FILE_POS, "Testing push() of multiple matrices");
 
       const auto M3 = Eigen::Matrix<double, numRows, numRows>::Random().eval();
-      Eigen::MatrixXd expected = M1;
+      // push() multiplies fixed size matrices with fixed size products, compare with the same product
+      Eigen::Matrix<double, numRows, numRows> expected = M1;
       for (size_t i=0; i<10; ++i) {
         EXPECT_NO_THROW(stack.push(M3));
         expected = expected*M3;
@@ -133,3 +134,50 @@ TEST(MatrixStackTestSuites, testMatrixStack)
   }
 
 } /* TEST(MatrixStackTestSuites, testMatrixStack) */
+
+TEST(MatrixStackTestSuites, testFixedSizeProducts)
+{
+  try
+  {
+    using namespace aslam::backend;
+
+    // Rows dispatched to fixed size products and the dynamic fallback
+    for (int numRows : { 1, 2, 3, 4, 5, 6, 7 }) {
+      SCOPED_TRACE(std::to_string(numRows));
+      MatrixStack stack(numRows, 10, 36);
+      Eigen::MatrixXd expected = Eigen::MatrixXd::Random(numRows, 3);
+      stack.push(expected);
+
+      const Eigen::Matrix3d M33 = Eigen::Matrix3d::Random();
+      const Eigen::Matrix<double, 3, 6> M36 = Eigen::Matrix<double, 3, 6>::Random();
+      const Eigen::Matrix<double, 6, 6> M66 = Eigen::Matrix<double, 6, 6>::Random();
+      const Eigen::Matrix<double, 6, 4> M64 = Eigen::Matrix<double, 6, 4>::Random();
+      const Eigen::MatrixXd M43 = Eigen::MatrixXd::Random(4, 3);
+
+      // The dynamic reference products may round differently in the last digit
+      const double tolerance = 1e-12;
+      stack.push(M33);
+      expected = expected*M33;
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "3x3");
+      stack.push(M36);
+      expected = expected*M36;
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "3x6");
+      stack.push(M66);
+      expected = expected*M66;
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "6x6");
+      stack.push(M64);
+      expected = expected*M64;
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "6x4");
+      stack.push(M43);
+      expected = expected*M43;
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "dynamic 4x3");
+      stack.push(-M33.transpose());
+      expected = expected*(-M33.transpose());
+      sm::eigen::assertNear(expected, stack.top(), tolerance, SM_SOURCE_FILE_POS, "3x3 expression");
+    }
+  }
+  catch(std::exception const & e)
+  {
+    FAIL() << e.what();
+  }
+}
@@ -0,0 +1,300 @@
+/*
+ * Profiling.cpp
+ *
+ *  Benchmarks for the optimization problem construction, the linear system solvers, the trust region policies and the
+ *  first order optimizers of aslam_backend.
+ */
+
+// standard includes
+#include <chrono>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <string>
+
+// boost includes
+#include <boost/program_options.hpp>
+#include <boost/make_shared.hpp>
+
+// Schweizer Messer includes
+#include <sm/logging.hpp>
+#include <sm/timing/Timer.hpp>
+
+// aslam backend includes
+#include <aslam/backend/test/SampleDvAndError.hpp>
+#include <aslam/backend/SparseCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/MixedPrecisionCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/OptimizerLBFGS.hpp>
+#include <aslam/backend/OptimizerStochastic.hpp>
+#include <aslam/backend/Optimizer2.hpp>
+#include <aslam/backend/GeodesicAccelerationTrustRegionPolicy.hpp>
+
+
+using namespace std;
+using namespace aslam::backend;
+
+/// \brief Builds and solves the system nIterations times and returns the last solution.
+template <typename Solver>
+Eigen::VectorXd profileSolver(Solver& solver, const std::string& name, const vector<DesignVariable*>& dvs, const vector<ErrorTerm*>& errs,
+                              size_t nIterations, size_t nThreads, double lambda)
+{
+  {
+    sm::timing::Timer timer(name + ": initMatrixStructure", false);
+    solver.initMatrixStructure(dvs, errs, lambda > 0.0);
+  }
+  if (lambda > 0.0)
+    solver.setConstantConditioner(lambda);
+  solver.evaluateError(nThreads, false);
+  Eigen::VectorXd dx;
+  for (size_t i=0; i<nIterations; ++i) {
+    {
+      sm::timing::Timer timer(name + ": buildSystem", false);
+      solver.buildSystem(nThreads, false);
+    }
+    {
+      sm::timing::Timer timer(name + ": solveSystem", false);
+      solver.solveSystem(dx);
+    }
+  }
+  return dx;
+}
+
+/// \brief Builds an optimization problem from the design variables and error terms, queries and shrinks it.
+void profileProblem(const vector<DesignVariable*>& dvs, const vector<ErrorTerm*>& errs)
+{
+  OptimizationProblem problem;
+  {
+    sm::timing::Timer timer("OptimizationProblem: add", false);
+    problem.reserve(dvs.size(), errs.size());
+    for (DesignVariable* dv : dvs)
+      problem.addDesignVariable(dv, false);
+    for (ErrorTerm* et : errs)
+      problem.addErrorTerm(et, false);
+  }
+  size_t numPairs = 0;
+  {
+    sm::timing::Timer timer("OptimizationProblem: getErrors", false);
+    std::set<ErrorTerm*> errorSet;
+    for (DesignVariable* dv : dvs) {
+      errorSet.clear();
+      problem.getErrors(dv, errorSet);
+      numPairs += errorSet.size();
+    }
+  }
+  {
+    sm::timing::Timer timer("OptimizationProblem: removeErrorTerm", false);
+    for (size_t i = 0; i < errs.size(); i += 2)
+      problem.removeErrorTerm(errs[i]);
+  }
+  {
+    sm::timing::Timer timer("OptimizationProblem: removeDesignVariable", false);
+    for (size_t i = 0; i < dvs.size(); i += 10)
+      problem.removeDesignVariable(dvs[i]);
+  }
+  SM_INFO_STREAM("OptimizationProblem: " << errs.size() << " error terms with " << numPairs << " design variable references, " <<
+                 problem.numErrorTerms() << " error terms and " << problem.numDesignVariables() << " design variables left");
+}
+
+/// \brief Runs the optimizer on a perturbed sample problem and reports the error after every iteration.
+///        Returns the run time in seconds.
+double profileOptimizer(OptimizerBase& optimizer, const std::string& name, int nDesignVariables, int nErrorTerms)
+{
+  boost::shared_ptr<OptimizationProblem> problem = buildProblem(0, nDesignVariables, nErrorTerms);
+  for (size_t i = 0; i < problem->numDesignVariables(); ++i) {
+    Eigen::Vector2d dx = Eigen::Vector2d::Random();
+    problem->designVariable(i)->update(dx.data(), 2);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto seconds = [&start]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+  optimizer.callback().add<callback::event::ITERATION_END>([&]() {
+    SM_INFO_STREAM(name << ": iteration " << optimizer.getStatus().numIterations << ", " << seconds() << " s, error " << optimizer.getStatus().error);
+  });
+
+  optimizer.setProblem(problem);
+  {
+    sm::timing::Timer timer(name + ": optimize", false);
+    optimizer.optimize();
+  }
+  const double time = seconds();
+  const OptimizerStatus& status = optimizer.getStatus();
+  SM_INFO_STREAM(name << ": final error " << status.error << ", gradient norm " << status.gradientNorm << " after " <<
+                 status.numIterations << " iterations and " << time << " s (" << status.convergence << ")");
+  return time;
+}
+
+/// \brief Runs Optimizer2 with the given policy on independent Rosenbrock valleys and returns the number of iterations.
+int profileTrustRegionPolicy(boost::shared_ptr<TrustRegionPolicy> policy, int nValleys, size_t nThreads)
+{
+  boost::shared_ptr<OptimizationProblem> problem = buildRosenbrockProblem(nValleys);
+  Optimizer2Options options;
+  options.maxIterations = 500;
+  options.convergenceDeltaError = 1e-12;
+  options.convergenceDeltaX = 1e-10;
+  options.numThreadsError = nThreads;
+  options.numThreadsJacobian = nThreads;
+  options.trustRegionPolicy = policy;
+  options.linearSystemSolver.reset(new SparseCholeskyLinearSystemSolver());
+  Optimizer2 optimizer(options);
+  optimizer.setProblem(problem);
+  {
+    sm::timing::Timer timer(policy->name() + ": optimize", false);
+    optimizer.optimize();
+  }
+  const Optimizer2::Status& status = optimizer.getStatus();
+  SM_INFO_STREAM(policy->name() << ": final error " << status.error << " after " << status.srv.iterations << " iterations, " <<
+                 status.srv.failedIterations << " of them failed (" << status.convergence << ")");
+  return status.srv.iterations;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    string verbosity = "Info";
+    size_t nIterations = 10;
+    size_t nThreads = 4;
+    int nDesignVariables = 20000;
+    int nErrorTerms = 200000;
+    int nProblemErrorTerms = 1000000;
+    double lambda = 1e-3;
+    int maxRefinementSteps = MixedPrecisionCholeskyLinearSolverOptions().maxRefinementSteps;
+    bool noDouble = false, noMixed = false;
+    bool noProblem = false, noSolvers = false, noOptimizers = false, noPolicies = false;
+    int nValleys = 1000;
+    int nEpochs = 10;
+    size_t batchSize = 256;
+    double sgdLearningRate = 1e-4, adamLearningRate = 1e-2, svrgLearningRate = 1e-3;
+
+    namespace po = boost::program_options;
+    po::options_description desc("aslam_backend profiling options");
+    desc.add_options()
+      ("help", "Produce help message")
+      ("verbosity,v", po::value(&verbosity)->default_value(verbosity), "Verbosity string")
+      ("num-iterations", po::value(&nIterations)->default_value(nIterations), "Number of build and solve iterations")
+      ("num-threads", po::value(&nThreads)->default_value(nThreads), "Number of threads used to build the system")
+      ("num-design-variables", po::value(&nDesignVariables)->default_value(nDesignVariables), "Number of design variables")
+      ("num-error-terms", po::value(&nErrorTerms)->default_value(nErrorTerms), "Number of error terms")
+      ("lambda", po::value(&lambda)->default_value(lambda), "Constant diagonal conditioner, 0 disables it")
+      ("max-refinement-steps", po::value(&maxRefinementSteps)->default_value(maxRefinementSteps), "Maximum number of refinement steps of the mixed precision solver")
+      ("no-double", po::bool_switch(&noDouble), "Don't profile the double precision sparse Cholesky solver")
+      ("no-mixed", po::bool_switch(&noMixed), "Don't profile the mixed precision Cholesky solver")
+      ("num-problem-error-terms", po::value(&nProblemErrorTerms)->default_value(nProblemErrorTerms), "Number of error terms of the optimization problem construction")
+      ("no-problem", po::bool_switch(&noProblem), "Don't profile the optimization problem construction")
+      ("no-solvers", po::bool_switch(&noSolvers), "Don't profile the linear system solvers")
+      ("no-optimizers", po::bool_switch(&noOptimizers), "Don't profile the stochastic and full gradient optimizers")
+      ("no-policies", po::bool_switch(&noPolicies), "Don't compare Levenberg-Marquardt with and without geodesic acceleration")
+      ("num-valleys", po::value(&nValleys)->default_value(nValleys), "Number of Rosenbrock valleys of the trust region policy comparison")
+      ("num-epochs", po::value(&nEpochs)->default_value(nEpochs), "Number of iterations of the full gradient and epochs of the stochastic optimizers")
+      ("batch-size", po::value(&batchSize)->default_value(batchSize), "Mini-batch size of the stochastic optimizers")
+      ("sgd-learning-rate", po::value(&sgdLearningRate)->default_value(sgdLearningRate), "Learning rate of SGD with momentum")
+      ("adam-learning-rate", po::value(&adamLearningRate)->default_value(adamLearningRate), "Learning rate of Adam")
+      ("svrg-learning-rate", po::value(&svrgLearningRate)->default_value(svrgLearningRate), "Learning rate of SVRG")
+    ;
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+    sm::logging::setLevel(sm::logging::levels::fromString(verbosity));
+
+    // ******************************** //
+    //    Optimization problem          //
+    // ******************************** //
+
+    if (!noProblem) {
+      vector<DesignVariable*> dvs;
+      vector<ErrorTerm*> errs;
+      buildSystem(nDesignVariables, nProblemErrorTerms, dvs, errs);
+      profileProblem(dvs, errs);
+      deleteSystem(dvs, errs);
+    }
+
+    // ******************************** //
+    //    Linear system solvers         //
+    // ******************************** //
+
+    if (!noSolvers) {
+      vector<DesignVariable*> dvs;
+      vector<ErrorTerm*> errs;
+      buildSystem(nDesignVariables, nErrorTerms, dvs, errs);
+
+      Eigen::VectorXd dxDouble, dxMixed;
+      if (!noDouble) {
+        SparseCholeskyLinearSystemSolver solver;
+        dxDouble = profileSolver(solver, "SparseCholesky", dvs, errs, nIterations, nThreads, lambda);
+      }
+      if (!noMixed) {
+        MixedPrecisionCholeskyLinearSolverOptions options;
+        options.maxRefinementSteps = maxRefinementSteps;
+        MixedPrecisionCholeskyLinearSystemSolver solver(options);
+        dxMixed = profileSolver(solver, "MixedPrecisionCholesky", dvs, errs, nIterations, nThreads, lambda);
+        SM_INFO_STREAM("MixedPrecisionCholesky: " << solver.getNumRefinementSteps() << " refinement steps, relative residual " << solver.getRelativeResidual());
+      }
+      if (!noDouble && !noMixed) {
+        SM_INFO_STREAM("Relative difference of the solutions: " << (dxMixed - dxDouble).norm() / dxDouble.norm());
+      }
+
+      deleteSystem(dvs, errs);
+    }
+
+    // ******************************** //
+    //    Trust region policies         //
+    // ******************************** //
+
+    if (!noPolicies) {
+      const int lmIterations = profileTrustRegionPolicy(boost::make_shared<LevenbergMarquardtTrustRegionPolicy>(), nValleys, nThreads);
+      auto geodesic = boost::make_shared<GeodesicAccelerationTrustRegionPolicy>();
+      const int geodesicIterations = profileTrustRegionPolicy(geodesic, nValleys, nThreads);
+      SM_INFO_STREAM(geodesic->name() << ": " << geodesic->getNumAcceleratedSteps() << " accelerated steps, " <<
+                     geodesic->getNumRejectedAccelerations() << " rejected accelerations, " << lmIterations - geodesicIterations <<
+                     " iterations less than " << LevenbergMarquardtTrustRegionPolicy().name());
+    }
+
+    // ******************************** //
+    //    First order optimizers        //
+    // ******************************** //
+
+    if (!noOptimizers) {
+      OptimizerOptionsLBFGS lbfgsOptions;
+      lbfgsOptions.maxIterations = nEpochs;
+      lbfgsOptions.numThreadsJacobian = nThreads;
+      lbfgsOptions.useDenseJacobianContainer = false; // dense containers cost O(numOptParameters) per squared error term
+      OptimizerLBFGS lbfgs(lbfgsOptions);
+      const double lbfgsTime = profileOptimizer(lbfgs, "LBFGS", nDesignVariables, nErrorTerms);
+      SM_INFO_STREAM("LBFGS: " << lbfgs.getStatus().numJacobianEvaluations*nErrorTerms/lbfgsTime << " error term gradients per second");
+
+      const std::vector<std::pair<OptimizerOptionsStochastic::Method, double> > methods = {
+          {OptimizerOptionsStochastic::SGD_MOMENTUM, sgdLearningRate},
+          {OptimizerOptionsStochastic::ADAM, adamLearningRate},
+          {OptimizerOptionsStochastic::SVRG, svrgLearningRate} };
+      for (const auto& method : methods) {
+        OptimizerOptionsStochastic options;
+        options.method = method.first;
+        options.learningRate = method.second;
+        options.batchSize = batchSize;
+        options.maxIterations = nEpochs;
+        options.numThreadsJacobian = nThreads;
+        options.useDenseJacobianContainer = false;
+        OptimizerStochastic optimizer(options);
+        std::ostringstream name;
+        name << method.first;
+        profileOptimizer(optimizer, name.str(), nDesignVariables, nErrorTerms);
+        const OptimizerStatusStochastic& status = optimizer.getStatus();
+        SM_INFO_STREAM(name.str() << ": " << status.termsPerSecond << " error term gradients per second in " << status.numBatches <<
+                       " mini-batches, " << static_cast<double>(status.numErrorTermGradients)/nErrorTerms << " full gradient equivalents");
+      }
+    }
+
+    sm::timing::Timing::print(cout, sm::timing::SortType::SORT_BY_TOTAL);
+
+  }
+  catch (exception& e)
+  {
+    SM_FATAL_STREAM(e.what());
+    return EXIT_FAILURE;
+  }
+
+}
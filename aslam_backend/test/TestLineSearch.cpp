@@ -154,3 +154,56 @@ TEST(LineSearchTestSuite, testLineSearch)
     FAIL() << e.what();
   }
 }
+
+TEST(LineSearchTestSuite, testLazyGradientEvaluation)
+{
+  try {
+    using namespace aslam::backend;
+
+    Scalar dv( (Scalar::Vector1d() << 3.0).finished() );
+    dv.setActive(true);
+    ErrorTermLS errorTerm(&dv);
+
+    boost::shared_ptr<OptimizationProblem> problem_ptr(new OptimizationProblem);
+    problem_ptr->addDesignVariable(&dv, false);
+    problem_ptr->addErrorTerm(&errorTerm, false);
+
+    ProblemManager pm;
+    pm.setProblem(problem_ptr);
+    pm.initialize();
+    auto costFunction = getCostFunction(pm, true, true, false, 1, 1);
+
+    for (const bool lazy : {true, false}) {
+      dv._v[0] = 3.0;
+      LineSearchOptions options;
+      options.lazyGradientEvaluation = lazy;
+      LineSearch ls(costFunction, options);
+      ls.initialize();
+      const double error0 = ls.getError();
+      ls.setSearchDirection(-ls.getGradient());
+      const double derror0 = ls.getErrorDerivative();
+
+      // The unit step overshoots to -3.0 and violates the sufficient decrease condition
+      EXPECT_TRUE(ls.lineSearchWolfe12());
+      {
+        SCOPED_TRACE("");
+        checkWolfeConditions(error0, ls.getError(), derror0, ls.getErrorDerivative(), ls.options().c1WolfeCondition,
+                             ls.options().c2WolfeCondition, ls.getCurrentStepLength());
+      }
+      RowVectorType grad1;
+      costFunction->computeGradient(grad1);
+      sm::eigen::assertEqual(grad1, ls.getGradient(), SM_SOURCE_FILE_POS);
+
+      if (lazy) {
+        // Only the error at the unit step, the error and gradient at the interpolated minimum
+        EXPECT_EQ(2u, ls.getNumErrorEvaluations());
+        EXPECT_EQ(1u, ls.getNumGradientEvaluations());
+      } else {
+        EXPECT_EQ(ls.getNumErrorEvaluations(), ls.getNumGradientEvaluations());
+        EXPECT_GT(ls.getNumGradientEvaluations(), 1u);
+      }
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <sm/eigen/gtest.hpp>
 #include <aslam/backend/OptimizationProblem.hpp>
 #include <aslam/backend/DesignVariable.hpp>
@@ -193,3 +194,118 @@ TEST(OptimizationProblemTestSuite,  testAddRemoveErrorTerm1)
   ASSERT_EQ(1, (int)et2.count(&et21));
   ASSERT_EQ(1, (int)et2.count(&et22));
 }
+
+TEST(OptimizationProblemTestSuite, testAddRemoveDuplicates)
+{
+  OptimizationProblem op;
+  Dv dv1, dv2;
+  Et1 et1(&dv1);
+  op.reserve(2, 1);
+  op.addDesignVariable(&dv1, false);
+  EXPECT_ANY_THROW(op.addDesignVariable(&dv1, false));
+  op.addDesignVariable(&dv2, false);
+  op.addErrorTerm(&et1, false);
+  EXPECT_ANY_THROW(op.addErrorTerm(&et1, false));
+  ASSERT_EQ(2, (int)op.numDesignVariables());
+  ASSERT_EQ(1, (int)op.numErrorTerms());
+
+  // Removing the first design variable moves the last one into its slot
+  op.removeDesignVariable(&dv1);
+  ASSERT_EQ(1, (int)op.numDesignVariables());
+  ASSERT_TRUE(op.designVariable(0) == &dv2);
+  ASSERT_EQ(0, (int)op.numErrorTerms());
+  ASSERT_FALSE(op.isDesignVariableInProblem(&dv1));
+  ASSERT_TRUE(op.isDesignVariableInProblem(&dv2));
+  // Removing missing design variables and error terms does nothing
+  op.removeDesignVariable(&dv1);
+  op.removeErrorTerm(&et1);
+  ASSERT_EQ(1, (int)op.numDesignVariables());
+}
+
+namespace {
+int numDeleted = 0;
+
+class OwnedDv : public Dv {
+public:
+  ~OwnedDv() { ++numDeleted; }
+};
+
+class OwnedEt : public Et1 {
+public:
+  OwnedEt(DesignVariable* dv) : Et1(dv) {}
+  ~OwnedEt() { ++numDeleted; }
+};
+} // namespace
+
+TEST(OptimizationProblemTestSuite, testAddOwnedDuplicates)
+{
+  numDeleted = 0;
+  {
+    OptimizationProblem op;
+    OwnedDv* dv = new OwnedDv();
+    OwnedEt* et = new OwnedEt(dv);
+    op.addDesignVariable(dv, true);
+    op.addErrorTerm(et, true);
+    // Rejected duplicates are not deleted while the problem still owns them
+    EXPECT_ANY_THROW(op.addDesignVariable(dv, true));
+    EXPECT_ANY_THROW(op.addErrorTerm(et, true));
+    EXPECT_EQ(0, numDeleted);
+    ASSERT_EQ(1, (int)op.numDesignVariables());
+    ASSERT_EQ(1, (int)op.numErrorTerms());
+    ASSERT_TRUE(op.designVariable(0) == dv);
+    ASSERT_TRUE(op.errorTerm(0) == et);
+    op.clear();
+    EXPECT_EQ(2, numDeleted);
+  }
+  EXPECT_EQ(2, numDeleted);
+}
+
+TEST(OptimizationProblemTestSuite, testAddRemoveManyErrorTerms)
+{
+  const int numDvs = 10, numTerms = 200;
+  std::vector<Dv> dvs(numDvs);
+  std::vector<boost::shared_ptr<ErrorTerm> > terms;
+  OptimizationProblem op;
+  for (Dv& dv : dvs)
+    op.addDesignVariable(&dv, false);
+  for (int i = 0; i < numTerms; ++i) {
+    // The same design variable twice in some of the error terms
+    terms.emplace_back(i % 2 ? (ErrorTerm*)new Et1(&dvs[i % numDvs]) : (ErrorTerm*)new Et2(&dvs[i % numDvs], &dvs[(i * 7) % numDvs]));
+    op.addErrorTerm(terms.back());
+  }
+
+  auto expectConsistent = [&]() {
+    ASSERT_EQ(terms.size(), op.numErrorTerms());
+    std::set<ErrorTerm*> all;
+    for (size_t i = 0; i < op.numErrorTerms(); ++i)
+      all.insert(op.errorTerm(i));
+    for (auto& et : terms)
+      ASSERT_EQ(1u, all.count(et.get()));
+    for (Dv& dv : dvs) {
+      std::set<ErrorTerm*> expected, actual;
+      for (auto& et : terms)
+        for (size_t j = 0; j < et->numDesignVariables(); ++j)
+          if (et->designVariable(j) == &dv)
+            expected.insert(et.get());
+      op.getErrors(&dv, actual);
+      ASSERT_EQ(expected, actual);
+    }
+  };
+
+  expectConsistent();
+  for (int i = 0; i < numTerms / 2; ++i) {
+    const size_t k = (i * 37) % terms.size();
+    op.removeErrorTerm(terms[k].get());
+    terms.erase(terms.begin() + k);
+  }
+  expectConsistent();
+  op.removeDesignVariable(&dvs[3]);
+  terms.erase(std::remove_if(terms.begin(), terms.end(), [&](const boost::shared_ptr<ErrorTerm>& et) {
+    for (size_t j = 0; j < et->numDesignVariables(); ++j)
+      if (et->designVariable(j) == &dvs[3])
+        return true;
+    return false;
+  }), terms.end());
+  ASSERT_EQ(numDvs - 1, (int)op.numDesignVariables());
+  expectConsistent();
+}
@@ -1,6 +1,7 @@
 #include <boost/shared_ptr.hpp>
 #include <sm/eigen/gtest.hpp>
 #include <sm/random.hpp>
+#include <sm/BoostPropertyTree.hpp>
 
 #include <aslam/backend/Optimizer2.hpp>
 #include <aslam/backend/OptimizationProblem.hpp>
@@ -9,6 +10,7 @@
 #include <aslam/backend/BlockCholeskyLinearSystemSolver.hpp>
 #include <aslam/backend/DenseQrLinearSystemSolver.hpp>
 #include <aslam/backend/LineSearchTrustRegionPolicy.hpp>
+#include <aslam/backend/GeodesicAccelerationTrustRegionPolicy.hpp>
 #include <aslam/backend/SparseQrLinearSystemSolver.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <aslam/backend/test/ErrorTermTester.hpp>
@@ -34,6 +36,7 @@ TEST(Optimizer2TestSuite, compareAllCombinationsOfSolversAndTrustRegionPolicies)
     policies.emplace_back(new DogLegTrustRegionPolicy());
     policies.emplace_back(new GaussNewtonTrustRegionPolicy());
     policies.emplace_back(new LineSearchTrustRegionPolicy());
+    policies.emplace_back(new LevenbergMarquardtTrustRegionPolicy());
 
     boost::shared_ptr<OptimizationProblem> pb = buildProblem(seed, D, E);
     std::vector< boost::shared_ptr<OptimizationProblem> > problems;
@@ -74,3 +77,332 @@ TEST(Optimizer2TestSuite, compareAllCombinationsOfSolversAndTrustRegionPolicies)
     FAIL() << e.what();
   }
 }
+
+TEST(Optimizer2TestSuite, lazyJacobianUpdatesReachTheFullJacobianSolution)
+{
+  using namespace aslam::backend;
+  const int D = 10;
+  const int E = 60;
+  const int seed = 1;
+  try {
+    auto buildPerturbedProblem = [&]() {
+      boost::shared_ptr<OptimizationProblem> problem = buildProblem(seed, D, E);
+      for (size_t i = 0; i < problem->numDesignVariables(); ++i) {
+        Eigen::Vector2d dx = Eigen::Vector2d::Constant(0.5 + 0.1 * i);
+        problem->designVariable(i)->update(dx.data(), 2);
+      }
+      return problem;
+    };
+    auto totalError = [](OptimizationProblem& problem) {
+      double error = 0.0;
+      for (size_t i = 0; i < problem.numErrorTerms(); ++i)
+        error += problem.errorTerm(i)->evaluateError();
+      return error;
+    };
+
+    Optimizer2Options options;
+    options.maxIterations = 50;
+    options.convergenceDeltaError = 1e-12;
+    options.convergenceDeltaX = 1e-10;
+    options.verbose = false;
+
+    boost::shared_ptr<OptimizationProblem> reference = buildPerturbedProblem();
+    options.linearSystemSolver.reset(new SparseCholeskyLinearSystemSolver());
+    Optimizer2 referenceOptimizer(options);
+    referenceOptimizer.setProblem(reference);
+    referenceOptimizer.optimize();
+    EXPECT_EQ(0u, referenceOptimizer.getStatus().numLazyJacobianUpdates);
+    const double referenceError = totalError(*reference);
+
+    for (auto update : { LinearSystemSolver::JACOBIAN_BROYDEN, LinearSystemSolver::JACOBIAN_PARTIAL }) {
+      std::vector<boost::shared_ptr<LinearSystemSolver>> solvers;
+      solvers.emplace_back(new SparseCholeskyLinearSystemSolver());
+      solvers.emplace_back(new SparseQrLinearSystemSolver());
+      for (auto& solver : solvers) {
+        SCOPED_TRACE(solver->name() + (update == LinearSystemSolver::JACOBIAN_BROYDEN ? " broyden" : " partial"));
+        boost::shared_ptr<OptimizationProblem> problem = buildPerturbedProblem();
+        options.linearSystemSolver = solver;
+        options.jacobianUpdate = update;
+        options.jacobianRefreshTolerance = 0.1;
+        Optimizer2 optimizer(options);
+        optimizer.setProblem(problem);
+        optimizer.optimize();
+        EXPECT_GT(optimizer.getStatus().numLazyJacobianUpdates, 0u);
+        EXPECT_LT(optimizer.getStatus().numLazyJacobianUpdates, optimizer.getStatus().numJacobianEvaluations);
+        EXPECT_NEAR(referenceError, totalError(*problem), 1e-6 * (1.0 + referenceError));
+      }
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(Optimizer2TestSuite, activeSetFreezesConvergedDesignVariables)
+{
+  using namespace aslam::backend;
+  const int D = 10;
+  const int E = 60;
+  const int seed = 1;
+  try {
+    // Only the first half of the design variables starts away from the optimum
+    boost::shared_ptr<OptimizationProblem> problem = buildProblem(seed, D, E);
+    for (size_t i = 0; i < problem->numDesignVariables() / 2; ++i) {
+      Eigen::Vector2d dx = Eigen::Vector2d::Constant(2.0);
+      problem->designVariable(i)->update(dx.data(), 2);
+    }
+    double initialError = 0.0;
+    for (size_t i = 0; i < problem->numErrorTerms(); ++i)
+      initialError += problem->errorTerm(i)->evaluateError();
+
+    Optimizer2Options options;
+    options.maxIterations = 50;
+    options.verbose = false;
+    options.useActiveSet = true;
+    options.activeSetFreezeThreshold = 0.3;
+    options.activeSetFreezeIterations = 1;
+    options.activeSetReactivationThreshold = 10.0;
+    options.activeSetUpdateInterval = 1;
+    options.linearSystemSolver.reset(new SparseCholeskyLinearSystemSolver());
+    Optimizer2 optimizer(options);
+    optimizer.setProblem(problem);
+    optimizer.optimize();
+
+    const Optimizer2::Status& status = optimizer.getStatus();
+    EXPECT_FALSE(status.failure());
+    EXPECT_GT(status.numFrozenDesignVariables, 0u);
+    EXPECT_GT(status.numActiveSetUpdates, 0u);
+    EXPECT_FALSE(options.linearSystemSolver->isAcceptConstantErrorTerms());
+
+    // All design variables are active again afterwards
+    EXPECT_EQ(size_t(D), optimizer.numDesignVariables());
+    for (size_t i = 0; i < problem->numDesignVariables(); ++i)
+      EXPECT_TRUE(problem->designVariable(i)->isActive());
+
+    double finalError = 0.0;
+    for (size_t i = 0; i < problem->numErrorTerms(); ++i)
+      finalError += problem->errorTerm(i)->evaluateError();
+    EXPECT_NEAR(status.error, finalError, 1e-9 * (1.0 + finalError));
+    EXPECT_LT(finalError, 0.1 * initialError);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(Optimizer2TestSuite, activeSetKeepsIteratingToTheFullSolution)
+{
+  using namespace aslam::backend;
+  const int D = 10;
+  const int E = 60;
+  const int seed = 1;
+  try {
+    auto buildPerturbedProblem = [&]() {
+      boost::shared_ptr<OptimizationProblem> problem = buildProblem(seed, D, E);
+      for (size_t i = 0; i < problem->numDesignVariables() / 2; ++i) {
+        Eigen::Vector2d dx = Eigen::Vector2d::Constant(2.0);
+        problem->designVariable(i)->update(dx.data(), 2);
+      }
+      return problem;
+    };
+    auto totalError = [](OptimizationProblem& problem) {
+      double error = 0.0;
+      for (size_t i = 0; i < problem.numErrorTerms(); ++i)
+        error += problem.errorTerm(i)->evaluateError();
+      return error;
+    };
+
+    Optimizer2Options options;
+    options.maxIterations = 50;
+    options.convergenceDeltaError = 1e-12;
+    options.convergenceDeltaX = 1e-10;
+    options.verbose = false;
+    options.linearSystemSolver.reset(new SparseCholeskyLinearSystemSolver());
+
+    boost::shared_ptr<OptimizationProblem> reference = buildPerturbedProblem();
+    Optimizer2 referenceOptimizer(options);
+    referenceOptimizer.setProblem(reference);
+    referenceOptimizer.optimize();
+    const double referenceError = totalError(*reference);
+
+    boost::shared_ptr<OptimizationProblem> problem = buildPerturbedProblem();
+    options.useActiveSet = true;
+    options.activeSetFreezeThreshold = 1e-3;
+    options.activeSetFreezeIterations = 1;
+    options.activeSetReactivationThreshold = 10.0;
+    options.activeSetUpdateInterval = 1;
+    Optimizer2 optimizer(options);
+    optimizer.setProblem(problem);
+    // The steps solved after the first freeze have to use the new structure
+    size_t numSolvesAfterFreeze = 0;
+    optimizer.callback().add<callback::event::LINEAR_SYSTEM_SOLVED>([&]() {
+      if (optimizer.getStatus().numActiveSetUpdates > 0)
+        numSolvesAfterFreeze++;
+    });
+    optimizer.optimize();
+
+    const Optimizer2::Status& status = optimizer.getStatus();
+    EXPECT_FALSE(status.failure());
+    EXPECT_GT(status.numFrozenDesignVariables, 0u);
+    EXPECT_GT(numSolvesAfterFreeze, 1u);
+    EXPECT_NEAR(referenceError, totalError(*problem), 1e-4 * (1.0 + referenceError));
+    for (size_t i = 0; i < problem->numDesignVariables(); ++i) {
+      Eigen::MatrixXd value, referenceValue;
+      problem->designVariable(i)->getParameters(value);
+      reference->designVariable(i)->getParameters(referenceValue);
+      sm::eigen::assertNear(referenceValue, value, 1e-2, SM_SOURCE_FILE_POS, "The frozen design variables did not converge");
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(Optimizer2TestSuite, activeSetBatchesStructureUpdatesOfOscillatingDesignVariables)
+{
+  using namespace aslam::backend;
+  const int D = 10;
+  try {
+    // Design variables freeze on steps below 0.3, but are activated again as soon as a neighbour moves by more than 0.03
+    Optimizer2Options options;
+    options.maxIterations = 100;
+    options.convergenceDeltaError = 1e-12;
+    options.convergenceDeltaX = 1e-10;
+    options.verbose = false;
+    options.useActiveSet = true;
+    options.activeSetFreezeThreshold = 0.3;
+    options.activeSetFreezeIterations = 1;
+    options.activeSetReactivationThreshold = 0.03;
+    options.linearSystemSolver.reset(new DenseQrLinearSystemSolver());
+
+    // Updating the structure on every change follows the oscillation
+    Optimizer2Options unbatchedOptions = options;
+    unbatchedOptions.activeSetUpdateInterval = 1;
+    unbatchedOptions.activeSetMinFreezeFraction = 0.0;
+    Optimizer2 unbatchedOptimizer(unbatchedOptions);
+    unbatchedOptimizer.setProblem(buildCoupledRosenbrockProblem(D, 0.1));
+    unbatchedOptimizer.optimize();
+    const Optimizer2::Status& unbatchedStatus = unbatchedOptimizer.getStatus();
+    EXPECT_FALSE(unbatchedStatus.failure());
+    EXPECT_GT(unbatchedStatus.numReactivatedDesignVariables, 0u);
+    EXPECT_GT(unbatchedStatus.numActiveSetUpdates, unbatchedStatus.srv.iterations / size_t(options.activeSetUpdateInterval) + 1);
+
+    Optimizer2 optimizer(options);
+    optimizer.setProblem(buildCoupledRosenbrockProblem(D, 0.1));
+    optimizer.optimize();
+    const Optimizer2::Status& status = optimizer.getStatus();
+    EXPECT_FALSE(status.failure());
+    EXPECT_GT(status.numFrozenDesignVariables, 0u);
+    // At most one update per interval plus the final release of the frozen design variables
+    EXPECT_LE(status.numActiveSetUpdates, status.srv.iterations / size_t(options.activeSetUpdateInterval) + 1);
+    EXPECT_LT(status.numActiveSetUpdates, unbatchedStatus.numActiveSetUpdates);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(Optimizer2TestSuite, levenbergMarquardtLambdaCandidatesReduceFailedIterations)
+{
+  using namespace aslam::backend;
+  try {
+    std::vector<size_t> numCandidateSteps;
+    std::vector<int> failedIterations;
+    for (size_t numLambdaCandidates : { 1u, 4u }) {
+      SCOPED_TRACE(numLambdaCandidates);
+      Point2d point(Eigen::Vector2d(-1.2, 1.0));
+      point.setActive(true);
+      RosenbrockErr error(&point);
+      boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+      problem->addDesignVariable(&point, false);
+      problem->addErrorTerm(&error, false);
+
+      boost::shared_ptr<LevenbergMarquardtTrustRegionPolicy> policy(new LevenbergMarquardtTrustRegionPolicy());
+      policy->setNumLambdaCandidates(numLambdaCandidates);
+      Optimizer2Options options;
+      options.maxIterations = 200;
+      options.convergenceDeltaError = 1e-14;
+      options.convergenceDeltaX = 1e-10;
+      options.verbose = false;
+      // The candidate steps are solved concurrently
+      options.numThreadsError = 2;
+      options.trustRegionPolicy = policy;
+      Optimizer2 optimizer(options);
+      optimizer.setProblem(problem);
+      optimizer.optimize();
+
+      const Optimizer2::Status& status = optimizer.getStatus();
+      EXPECT_FALSE(status.failure());
+      numCandidateSteps.push_back(status.numCandidateSteps);
+      failedIterations.push_back(status.srv.failedIterations);
+      sm::eigen::assertNear(Eigen::Vector2d(1.0, 1.0), point._v, 1e-4, SM_SOURCE_FILE_POS);
+    }
+    EXPECT_EQ(0u, numCandidateSteps[0]);
+    EXPECT_GT(failedIterations[0], 0);
+    EXPECT_GT(numCandidateSteps[1], 0u);
+    EXPECT_LE(failedIterations[1], failedIterations[0]);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(Optimizer2TestSuite, levenbergMarquardtLambdaCandidatesFromConfig)
+{
+  using namespace aslam::backend;
+  sm::BoostPropertyTree pt;
+  pt.setInt("numLambdaCandidates", 3);
+  EXPECT_EQ(3u, LevenbergMarquardtTrustRegionPolicy(pt).getNumLambdaCandidates());
+  pt.setInt("numLambdaCandidates", 0);
+  EXPECT_ANY_THROW(LevenbergMarquardtTrustRegionPolicy policy(pt));
+  pt.setInt("numLambdaCandidates", -1);
+  EXPECT_ANY_THROW(LevenbergMarquardtTrustRegionPolicy policy(pt));
+}
+
+TEST(Optimizer2TestSuite, geodesicAccelerationReducesIterations)
+{
+  using namespace aslam::backend;
+  try {
+    std::vector<boost::shared_ptr<LinearSystemSolver>> solvers;
+    solvers.emplace_back(new SparseCholeskyLinearSystemSolver()); // back-substitution with the kept factorization
+    solvers.emplace_back(new SparseQrLinearSystemSolver()); // re-solving the least squares problem of the probe
+    solvers.emplace_back(new DenseQrLinearSystemSolver());
+    for (auto& solver : solvers) {
+      SCOPED_TRACE(solver->name());
+      std::vector<int> iterations;
+      for (bool accelerate : { false, true }) {
+        SCOPED_TRACE(accelerate);
+        Point2d point(Eigen::Vector2d(-1.2, 1.0));
+        RosenbrockErr error(&point);
+        boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+        problem->addDesignVariable(&point, false);
+        problem->addErrorTerm(&error, false);
+
+        boost::shared_ptr<GeodesicAccelerationTrustRegionPolicy> geodesicPolicy(new GeodesicAccelerationTrustRegionPolicy());
+        Optimizer2Options options;
+        options.maxIterations = 200;
+        options.convergenceDeltaError = 1e-14;
+        options.convergenceDeltaX = 1e-10;
+        options.verbose = false;
+        options.linearSystemSolver = solver;
+        if (accelerate)
+          options.trustRegionPolicy = geodesicPolicy;
+        else
+          options.trustRegionPolicy.reset(new LevenbergMarquardtTrustRegionPolicy());
+        Optimizer2 optimizer(options);
+        optimizer.setProblem(problem);
+        optimizer.optimize();
+
+        const Optimizer2::Status& status = optimizer.getStatus();
+        EXPECT_FALSE(status.failure());
+        iterations.push_back(status.srv.iterations);
+        sm::eigen::assertNear(Eigen::Vector2d(1.0, 1.0), point._v, 1e-4, SM_SOURCE_FILE_POS);
+        // One evaluation at the start and one per step, plus one probe per acceleration
+        size_t numProbes = 0;
+        if (accelerate) {
+          EXPECT_GT(geodesicPolicy->getNumAcceleratedSteps(), 0u);
+          numProbes = geodesicPolicy->getNumAcceleratedSteps() + geodesicPolicy->getNumRejectedAccelerations();
+        }
+        EXPECT_EQ(1 + status.srv.iterations + numProbes, status.numErrorEvaluations);
+      }
+      EXPECT_LE(iterations[1], iterations[0]);
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
@@ -0,0 +1,98 @@
+#include <sm/eigen/gtest.hpp>
+#include <aslam/backend/OptimizerLBFGS.hpp>
+#include <aslam/backend/OptimizationProblem.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <sm/random.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+#include <aslam/backend/test/SampleDvAndError.hpp>
+
+TEST(OptimizerLBFGSTestSuite, testLBFGS)
+{
+  try {
+    using namespace aslam::backend;
+    boost::shared_ptr<OptimizationProblem> problem_ptr(new OptimizationProblem);
+    OptimizationProblem& problem = *problem_ptr;
+
+    const int P = 2;
+    const int E = 3;
+    // Add some design variables.
+    std::vector< boost::shared_ptr<Point2d> > p2d;
+    p2d.reserve(P);
+    for (int p = 0; p < P; ++p) {
+      boost::shared_ptr<Point2d> point(new Point2d(Eigen::Vector2d::Random())); // random initialization of design variable
+      p2d.push_back(point);
+      problem.addDesignVariable(point);
+      point->setBlockIndex(p);
+      point->setActive(true);
+    }
+
+    // Add some error terms.
+    std::vector< boost::shared_ptr<TestNonSquaredError> > e1;
+    e1.reserve(P*E);
+    for (int p = 0; p < P; ++p) {
+      for (int e = 0; e < E; ++e) {
+        TestNonSquaredError::grad_t g(p+1, e+1);
+        boost::shared_ptr<TestNonSquaredError> err(new TestNonSquaredError(p2d[p].get(), g));
+        err->_p = 1.0;
+        e1.push_back(err);
+        problem.addErrorTerm(err);
+        SCOPED_TRACE("");
+        testErrorTerm(err);
+      }
+    }
+    // Now let's optimize.
+    OptimizerLBFGS::Options options;
+    options.maxIterations = 500;
+    options.numThreadsJacobian = 8;
+    options.convergenceGradientNorm = 0.0;
+    options.convergenceDeltaX = 0.0;
+    EXPECT_ANY_THROW(options.check());
+    options.convergenceGradientNorm = 1e-15;
+    EXPECT_NO_THROW(options.check());
+    options.historySize = 0;
+    EXPECT_ANY_THROW(options.check());
+    options.historySize = 5;
+    EXPECT_NO_THROW(options.check());
+    OptimizerLBFGS optimizer(options);
+    optimizer.setProblem(problem_ptr);
+
+    // Test that linesearch options are correctly forwarded
+    options.linesearch.initialStepLength = 1.1;
+    optimizer.setOptions(options);
+    EXPECT_DOUBLE_EQ(options.linesearch.initialStepLength, optimizer.getLineSearch().options().initialStepLength);
+
+    EXPECT_NO_THROW(optimizer.checkProblemSetup());
+
+    optimizer.initialize();
+    SCOPED_TRACE("");
+    optimizer.optimize();
+    const auto& ret = optimizer.getStatus();
+
+    EXPECT_GT(ret.convergence, ConvergenceStatus::FAILURE);
+    EXPECT_LE(ret.gradientNorm, options.convergenceGradientNorm);
+    EXPECT_GT(ret.numErrorEvaluations, 0);
+    EXPECT_GT(ret.numJacobianEvaluations, 0);
+    EXPECT_GE(ret.error, 0.0);
+    EXPECT_LT(ret.deltaError, 1e-12);
+    EXPECT_LT(ret.maxDeltaX, 1e-3);
+    EXPECT_LT(ret.error, std::numeric_limits<double>::max());
+    EXPECT_GT(ret.numIterations, 0);
+    EXPECT_LE(optimizer.getHistorySize(), static_cast<std::size_t>(options.historySize));
+
+    // A history depth of 1 has to converge to the same minimum
+    const double minimalError = ret.error;
+    for (auto& p : p2d)
+      p->_v.setRandom();
+    options.historySize = 1;
+    optimizer.setOptions(options);
+    optimizer.initialize();
+    optimizer.optimize();
+    EXPECT_GT(optimizer.getStatus().convergence, ConvergenceStatus::FAILURE);
+    EXPECT_NEAR(minimalError, optimizer.getStatus().error, 1e-9);
+    EXPECT_LE(optimizer.getHistorySize(), 1u);
+
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
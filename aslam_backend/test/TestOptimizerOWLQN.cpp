@@ -0,0 +1,159 @@
+#include <sm/eigen/gtest.hpp>
+#include <aslam/backend/OptimizerOWLQN.hpp>
+#include <aslam/backend/L1NormInterface.hpp>
+#include <aslam/backend/OptimizationProblem.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+#include <aslam/backend/test/SampleDvAndError.hpp>
+
+using namespace aslam::backend;
+
+namespace {
+
+/// \brief Encodes the error \f$ (\sum_i x_i - t)^2 \f$ on scalar design variables
+class SumSquaredError : public ScalarNonSquaredErrorTerm {
+ public:
+  SumSquaredError(const std::vector<Scalar*>& dvs, const double t) : _dvs(dvs), _t(t) {
+    setDesignVariables(std::vector<DesignVariable*>(dvs.begin(), dvs.end()));
+    setWeight(1.0);
+  }
+
+  double evaluateErrorImplementation() override {
+    const double d = residual();
+    return d*d;
+  }
+
+  void evaluateJacobiansImplementation(JacobianContainer& outJ) override {
+    Eigen::MatrixXd J(1, 1);
+    J(0, 0) = 2.0*residual();
+    for (auto dv : _dvs)
+      outJ.add(dv, J);
+  }
+
+ private:
+  double residual() const {
+    double sum = -_t;
+    for (auto dv : _dvs)
+      sum += dv->_v[0];
+    return sum;
+  }
+  std::vector<Scalar*> _dvs;
+  double _t;
+};
+
+/// \brief Encodes the error \f$ w \sum_i |x_i| \f$
+class L1Error : public ScalarNonSquaredErrorTerm, public L1NormInterface {
+ public:
+  L1Error(const std::vector<Scalar*>& dvs, const double w) : _dvs(dvs) {
+    setDesignVariables(std::vector<DesignVariable*>(dvs.begin(), dvs.end()));
+    setWeight(w);
+  }
+
+  double getL1NormWeight() const override { return getWeight(); }
+
+  double evaluateErrorImplementation() override {
+    double sum = 0.0;
+    for (auto dv : _dvs)
+      sum += std::fabs(dv->_v[0]);
+    return sum;
+  }
+
+  void evaluateJacobiansImplementation(JacobianContainer& outJ) override {
+    Eigen::MatrixXd J(1, 1);
+    for (auto dv : _dvs) {
+      J(0, 0) = (0.0 < dv->_v[0]) - (dv->_v[0] < 0.0);
+      outJ.add(dv, J);
+    }
+  }
+
+ private:
+  std::vector<Scalar*> _dvs;
+};
+
+/// \brief Builds \f$ \sum_i (x_i - t_i)^2 + (x_0 + x_3 - 1)^2 + |x|_1 \f$. The L1 term is part of the problem or
+///        returned in \p outRegularizer if it is not NULL.
+boost::shared_ptr<OptimizationProblem> buildLassoProblem(std::vector<boost::shared_ptr<Scalar> >& outDvs, boost::shared_ptr<L1Error>* outRegularizer = NULL)
+{
+  const std::vector<double> t = { 3.0, 0.2, -0.1, -2.0 };
+  const std::vector<double> x0 = { 0.5, -0.5, 0.5, 0.5 };
+  boost::shared_ptr<OptimizationProblem> problem(new OptimizationProblem);
+  outDvs.clear();
+  std::vector<Scalar*> dvs;
+  for (size_t i = 0; i < t.size(); ++i) {
+    outDvs.emplace_back(new Scalar(Scalar::Vector1d::Constant(x0[i])));
+    outDvs.back()->setActive(true);
+    problem->addDesignVariable(outDvs.back());
+    dvs.push_back(outDvs.back().get());
+    problem->addErrorTerm(boost::shared_ptr<ScalarNonSquaredErrorTerm>(new SumSquaredError({ dvs.back() }, t[i])));
+  }
+  problem->addErrorTerm(boost::shared_ptr<ScalarNonSquaredErrorTerm>(new SumSquaredError({ dvs[0], dvs[3] }, 1.0)));
+  boost::shared_ptr<L1Error> l1(new L1Error(dvs, 1.0));
+  if (outRegularizer)
+    *outRegularizer = l1;
+  else
+    problem->addErrorTerm(l1);
+  return problem;
+}
+
+} // namespace
+
+TEST(OptimizerOWLQNTestSuite, testOWLQN)
+{
+  try {
+    for (bool asRegularizer : { false, true }) {
+      SCOPED_TRACE(asRegularizer);
+      std::vector<boost::shared_ptr<Scalar> > dvs;
+      boost::shared_ptr<L1Error> regularizer;
+      boost::shared_ptr<OptimizationProblem> problem = buildLassoProblem(dvs, asRegularizer ? &regularizer : NULL);
+
+      OptimizerOWLQN::Options options;
+      options.maxIterations = 100;
+      options.convergenceGradientNorm = 1e-9;
+      options.numThreadsJacobian = 2;
+      options.regularizer = regularizer;
+      OptimizerOWLQN optimizer(options);
+      optimizer.setProblem(problem);
+      EXPECT_NO_THROW(optimizer.checkProblemSetup());
+      optimizer.optimize();
+
+      const auto& status = optimizer.getStatus();
+      EXPECT_EQ(ConvergenceStatus::GRADIENT_NORM, status.convergence);
+      EXPECT_EQ(4u, status.numL1Parameters);
+      EXPECT_EQ(2u, status.numZeroParameters);
+      EXPECT_LT(status.numJacobianEvaluations, 30u);
+      // The uncoupled parameters are soft-thresholded to exactly zero
+      EXPECT_EQ(0.0, dvs[1]->_v[0]);
+      EXPECT_EQ(0.0, dvs[2]->_v[0]);
+      // Optimality of the coupled parameters: 2 (x_i - t_i) + 2 (x_0 + x_3 - 1) + sign(x_i) = 0
+      const double x0 = dvs[0]->_v[0], x3 = dvs[3]->_v[0];
+      EXPECT_GT(x0, 0.0);
+      EXPECT_LT(x3, 0.0);
+      EXPECT_NEAR(0.0, 2.0*(x0 - 3.0) + 2.0*(x0 + x3 - 1.0) + 1.0, 1e-8);
+      EXPECT_NEAR(0.0, 2.0*(x3 + 2.0) + 2.0*(x0 + x3 - 1.0) - 1.0, 1e-8);
+
+      double error = 0.0;
+      for (size_t i = 0; i < problem->numNonSquaredErrorTerms(); ++i)
+        error += problem->nonSquaredErrorTerm(i)->evaluateError();
+      if (regularizer)
+        error += regularizer->evaluateError();
+      EXPECT_NEAR(error, status.error, 1e-12);
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(OptimizerOWLQNTestSuite, testOptions)
+{
+  OptimizerOWLQN::Options options;
+  EXPECT_NO_THROW(options.check());
+  options.historySize = 0;
+  EXPECT_ANY_THROW(options.check());
+  options.historySize = 10;
+  options.backtrackingFactor = 1.0;
+  EXPECT_ANY_THROW(options.check());
+  options.backtrackingFactor = 0.5;
+  // regularizers have to implement the L1NormInterface
+  Point2d point(Eigen::Vector2d::Zero());
+  options.regularizer.reset(new TestNonSquaredError(&point, TestNonSquaredError::grad_t::Ones()));
+  EXPECT_ANY_THROW(options.check());
+}
@@ -0,0 +1,171 @@
+#include <numeric>
+#include <sm/eigen/gtest.hpp>
+#include <aslam/backend/OptimizerStochastic.hpp>
+#include <aslam/backend/Optimizer2.hpp>
+#include <aslam/backend/OptimizationProblem.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/util/ProblemManager.hpp>
+#include <sm/random.hpp>
+#include <aslam/backend/test/SampleDvAndError.hpp>
+
+using namespace aslam::backend;
+
+namespace {
+
+const int D = 10;
+const int E = 120;
+const int seed = 1;
+
+/// \brief Builds the sample problem and moves the design variables away from the optimum
+boost::shared_ptr<OptimizationProblem> buildPerturbedProblem()
+{
+  boost::shared_ptr<OptimizationProblem> problem = buildProblem(seed, D, E);
+  for (size_t i = 0; i < problem->numDesignVariables(); ++i) {
+    Eigen::Vector2d dx = Eigen::Vector2d::Random();
+    problem->designVariable(i)->update(dx.data(), 2);
+  }
+  return problem;
+}
+
+double totalError(OptimizationProblem& problem)
+{
+  double error = 0.0;
+  for (size_t i = 0; i < problem.numErrorTerms(); ++i)
+    error += problem.errorTerm(i)->evaluateError();
+  return error;
+}
+
+void testMethod(const OptimizerOptionsStochastic::Method method, const double learningRate)
+{
+  try {
+    boost::shared_ptr<OptimizationProblem> problem = buildPerturbedProblem();
+    const double initialError = totalError(*problem);
+
+    OptimizerStochastic::Options options;
+    options.method = method;
+    options.learningRate = learningRate;
+    options.batchSize = 16;
+    options.maxIterations = 100;
+    options.numThreadsJacobian = 2;
+    options.convergenceGradientNorm = 1e-6;
+    OptimizerStochastic optimizer(options);
+    optimizer.setProblem(problem);
+    EXPECT_NO_THROW(optimizer.checkProblemSetup());
+    optimizer.initialize();
+    optimizer.optimize();
+
+    const auto& status = optimizer.getStatus();
+    EXPECT_FALSE(status.failure());
+    EXPECT_GT(status.numIterations, 0);
+    EXPECT_EQ(status.numIterations * ((E + options.batchSize - 1) / options.batchSize), status.numBatches);
+    EXPECT_GT(status.numErrorTermGradients, status.numIterations * E);
+    EXPECT_GT(status.termsPerSecond, 0.0);
+    EXPECT_EQ(0u, status.numPolishingIterations);
+    EXPECT_NEAR(totalError(*problem), status.error, 1e-9);
+    EXPECT_LT(status.error, 0.5*initialError);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+} // namespace
+
+TEST(OptimizerStochasticTestSuite, testBatchGradient)
+{
+  try {
+    boost::shared_ptr<OptimizationProblem> problem = buildPerturbedProblem();
+    ProblemManager pm(problem);
+
+    RowVectorType fullGradient, batchGradient, partGradient;
+    pm.computeGradient(fullGradient, 1, false, false, true);
+
+    std::vector<std::size_t> indices(pm.numErrorTerms());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::vector<RowVectorType> threadGradients(3);
+    pm.computeGradient(batchGradient, indices, threadGradients, false, false, true);
+    sm::eigen::assertNear(fullGradient, batchGradient, 1e-9, SM_SOURCE_FILE_POS);
+    EXPECT_NEAR(pm.evaluateError(), pm.evaluateError(indices, 3), 1e-9);
+
+    // The gradient is additive over disjoint batches
+    std::vector<std::size_t> even, odd;
+    for (auto i : indices)
+      (i % 2 == 0 ? even : odd).push_back(i);
+    pm.computeGradient(batchGradient, even, threadGradients, false, false, true);
+    pm.computeGradient(partGradient, odd, threadGradients, false, false, true);
+    sm::eigen::assertNear(fullGradient, batchGradient + partGradient, 1e-9, SM_SOURCE_FILE_POS);
+    EXPECT_NEAR(pm.evaluateError(), pm.evaluateError(even) + pm.evaluateError(odd), 1e-9);
+
+    // Reused accumulators hold stale columns of the previous batches, which must not leak into a smaller batch
+    std::vector<RowVectorType> freshThreadGradients(3);
+    const std::vector<std::size_t> single(1, 1);
+    pm.computeGradient(batchGradient, single, threadGradients, false, false, true);
+    pm.computeGradient(partGradient, single, freshThreadGradients, false, false, true);
+    sm::eigen::assertNear(partGradient, batchGradient, 1e-12, SM_SOURCE_FILE_POS);
+    EXPECT_NEAR(pm.evaluateError(indices), pm.evaluateError(indices, 0), 1e-12);
+
+    std::vector<DesignVariable*> dvs;
+    pm.getDesignVariables(std::vector<std::size_t>(1, 1), dvs);
+    EXPECT_EQ(problem->errorTerm(1)->numDesignVariables(), dvs.size());
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(OptimizerStochasticTestSuite, testSgdMomentum)
+{
+  testMethod(OptimizerOptionsStochastic::SGD_MOMENTUM, 1e-4);
+}
+
+TEST(OptimizerStochasticTestSuite, testAdam)
+{
+  testMethod(OptimizerOptionsStochastic::ADAM, 1e-2);
+}
+
+TEST(OptimizerStochasticTestSuite, testSvrg)
+{
+  testMethod(OptimizerOptionsStochastic::SVRG, 2e-3);
+}
+
+TEST(OptimizerStochasticTestSuite, testPolishing)
+{
+  try {
+    // Reference: Gauss-Newton from the same start
+    boost::shared_ptr<OptimizationProblem> reference = buildPerturbedProblem();
+    Optimizer2Options options2;
+    options2.verbose = false;
+    Optimizer2 optimizer2(options2);
+    optimizer2.setProblem(reference);
+    optimizer2.optimize();
+
+    boost::shared_ptr<OptimizationProblem> problem = buildPerturbedProblem();
+    OptimizerStochastic::Options options;
+    options.maxIterations = 3;
+    options.learningRate = 1e-2;
+    options.polishingOptimizer.reset(new Optimizer2(options2));
+    OptimizerStochastic optimizer(options);
+    optimizer.setProblem(problem);
+    optimizer.optimize();
+
+    const auto& status = optimizer.getStatus();
+    EXPECT_FALSE(status.failure());
+    EXPECT_GT(status.numPolishingIterations, 0);
+    const double referenceError = totalError(*reference);
+    EXPECT_NEAR(referenceError, status.error, 1e-4*referenceError);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(OptimizerStochasticTestSuite, testOptions)
+{
+  OptimizerStochastic::Options options;
+  EXPECT_NO_THROW(options.check());
+  options.batchSize = 0;
+  EXPECT_ANY_THROW(options.check());
+  options.batchSize = 1;
+  options.beta2 = 1.0;
+  EXPECT_ANY_THROW(options.check());
+  options.beta2 = 0.999;
+  options.learningRate = 0.0;
+  EXPECT_ANY_THROW(options.check());
+}
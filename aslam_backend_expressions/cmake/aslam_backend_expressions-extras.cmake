@@ -0,0 +1,21 @@
+include(CMakeParseArguments)
+
+# aslam_backend_generate_code(<output> GENERATOR <executable target> [ARGS <arguments>...])
+#
+# Runs the generator executable at build time to write the header <output>, e.g. error terms
+# generated with aslam::backend::ExpressionCodeGenerator. The generator is called as
+# "<generator> <output> <arguments>...". Add <output> to the sources of the targets using it.
+function(aslam_backend_generate_code OUTPUT)
+  cmake_parse_arguments(GEN "" "GENERATOR" "ARGS" ${ARGN})
+  if(NOT GEN_GENERATOR)
+    message(FATAL_ERROR "aslam_backend_generate_code: GENERATOR is required")
+  endif()
+  get_filename_component(OUTPUT_DIR ${OUTPUT} PATH)
+  add_custom_command(OUTPUT ${OUTPUT}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+    COMMAND ${GEN_GENERATOR} ${OUTPUT} ${GEN_ARGS}
+    DEPENDS ${GEN_GENERATOR}
+    COMMENT "Generating ${OUTPUT}"
+    VERBATIM)
+  set_source_files_properties(${OUTPUT} PROPERTIES GENERATED TRUE)
+endfunction()
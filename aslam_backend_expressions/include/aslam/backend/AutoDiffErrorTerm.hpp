@@ -0,0 +1,75 @@
+#ifndef ASLAM_BACKEND_AUTO_DIFF_ERROR_TERM_HPP
+#define ASLAM_BACKEND_AUTO_DIFF_ERROR_TERM_HPP
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/DualNumber.hpp>
+
+namespace aslam {
+namespace backend {
+
+/**
+ * \class AutoDiffErrorTerm
+ *
+ * \brief An error term of dimension D computed by a functor, differentiated with dual numbers.
+ *
+ * The functor evaluates the error from the parameters of the design variables for any scalar type T:
+ * \code
+ * struct Functor {
+ *   template <typename T>
+ *   void operator()(const T* const* parameters, T* error) const;
+ * };
+ * \endcode
+ * parameters[i] points to the parameters of design variable i, column major, error to D values. The error is
+ * evaluated with T = double and the Jacobians with T = DualNumber<double, N> together with the error in one
+ * pass, instead of 2 error evaluations per minimal dimension as by evaluateJacobiansFiniteDifference().
+ * N is the sum of the minimal dimensions of the design variables. Pass it as template argument to avoid
+ * heap allocations for the derivatives.
+ *
+ * The Jacobians are taken w.r.t. the parameters, which are therefore required to be updated additively, as
+ * e.g. EuclideanPoint, Scalar, GenericScalar or DesignVariableGenericVector are.
+ */
+template <int D, typename Functor, int N = Eigen::Dynamic>
+class AutoDiffErrorTerm : public ErrorTermFs<D> {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  typedef ErrorTermFs<D> parent_t;
+  typedef DualNumber<double, N> dual_t;
+
+  AutoDiffErrorTerm(const Functor & functor, const std::vector<DesignVariable*> & designVariables);
+  ~AutoDiffErrorTerm() override = default;
+
+  const Functor & functor() const { return _functor; }
+  Functor & functor() { return _functor; }
+
+  /// \brief The sum of the minimal dimensions of the design variables
+  int numDerivatives() const { return _offsets.back(); }
+
+ protected:
+  double evaluateErrorImplementation() override;
+  void evaluateJacobiansImplementation(JacobianContainer & outJacobians) override;
+
+ private:
+  /// \brief Gather the parameters of all design variables into _parameters
+  void getParameters();
+
+  Functor _functor;
+  /// \brief Offset of the parameters of each design variable, followed by their total number
+  std::vector<int> _offsets;
+  std::vector<const double*> _parameterPointers;
+  std::vector<const dual_t*> _dualParameterPointers;
+  Eigen::VectorXd _parameters;
+  std::vector<dual_t, Eigen::aligned_allocator<dual_t> > _dualParameters;
+  Eigen::MatrixXd _designVariableParameters;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+#include "implementation/AutoDiffErrorTerm.hpp"
+
+#endif /* ASLAM_BACKEND_AUTO_DIFF_ERROR_TERM_HPP */
@@ -22,6 +22,9 @@
 #include <aslam/backend/JacobianContainerSparse.hpp>
 #include <aslam/backend/JacobianContainerPrescale.hpp>
 #include <aslam/backend/CacheInterface.hpp>
+#include <aslam/backend/RotationExpressionNode.hpp>
+#include <aslam/backend/TransformationExpressionNode.hpp>
+#include <aslam/backend/HomogeneousExpressionNode.hpp>
 
 namespace aslam {
 namespace backend {
@@ -29,35 +32,81 @@ namespace backend {
 template<int IRows, int ICols, typename TScalar>
 class GenericMatrixExpressionNode;
 
+namespace internal {
+
+/// \brief Evaluates the value of an expression node to be cached
+template <typename ExpressionNode>
+struct CacheValueTraits {
+  typedef typename ExpressionNode::value_t value_t;
+  static value_t evaluate(ExpressionNode& node) { return node.evaluate(); }
+};
+
+template <>
+struct CacheValueTraits<RotationExpressionNode> {
+  typedef Eigen::Matrix3d value_t;
+  static value_t evaluate(RotationExpressionNode& node) { return node.toRotationMatrix(); }
+};
+
+template <>
+struct CacheValueTraits<TransformationExpressionNode> {
+  typedef Eigen::Matrix4d value_t;
+  static value_t evaluate(TransformationExpressionNode& node) { return node.toTransformationMatrix(); }
+};
+
+template <>
+struct CacheValueTraits<HomogeneousExpressionNode> {
+  typedef Eigen::Vector4d value_t;
+  static value_t evaluate(HomogeneousExpressionNode& node) { return node.toHomogeneous(); }
+};
+
+} // namespace internal
+
 /**
- * \class CacheExpressionNode
- * \brief Wraps an expression into a cache data structure to avoid duplicate
- * computation of error and Jacobian values
+ * \class CacheExpressionNodeBase
+ * \brief Cached value and Jacobians of a wrapped expression node, shared by the CacheExpressionNode
+ * specializations, which only forward the evaluation of the node type to cachedValue().
  *
  * \tparam ExpressionNode Type of the expression node
- * \tparam Dimensions Dimensionality of the design variables
+ * \tparam Dimension Dimensionality of the tangent space of the expression
  */
 template <typename ExpressionNode, int Dimension>
-class CacheExpressionNode : public CacheInterface, public ExpressionNode
+class CacheExpressionNodeBase : public CacheInterface, public ExpressionNode
 {
  public:
-  template <typename Expression>
-  friend Expression toCacheExpression(const Expression& expr);
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  typedef typename internal::CacheValueTraits<ExpressionNode>::value_t value_t;
 
- public:
-  virtual ~CacheExpressionNode() { }
+  virtual ~CacheExpressionNodeBase() { }
+
+  void updateCache() const override
+  {
+    updateJacobian();
+  }
 
  protected:
+  CacheExpressionNodeBase(const boost::shared_ptr<ExpressionNode>& e)
+      : CacheInterface(), ExpressionNode(), _node(e)
+  {
+    DesignVariable::set_t designVariables;
+    _node->getDesignVariables(designVariables);
+    setCacheDesignVariables(designVariables);
+  }
 
-  typename ExpressionNode::value_t evaluateImplementation() const override
+  const value_t& cachedValue() const
+  {
+    return cachedValue(currentVersion());
+  }
+
+  const value_t& cachedValue(const version_t version) const
   {
-    if (!_isCacheValidV)
+    if (!isValid(_versionV, version))
     {
+      // only the first thread evaluating a new version locks
       boost::mutex::scoped_lock lock(_mutexV);
-      if (!_isCacheValidV) // could be updated by another thread in the meantime
+      if (!isValid(_versionV, version)) // could be updated by another thread in the meantime
       {
-        _v = _node->evaluate();
-        _isCacheValidV = true;
+        _v = internal::CacheValueTraits<ExpressionNode>::evaluate(*_node);
+        _versionV.store(version, std::memory_order_release);
       }
     }
     return _v;
@@ -76,34 +125,107 @@ class CacheExpressionNode : public CacheInterface, public ExpressionNode
 
  private:
 
-  CacheExpressionNode(const boost::shared_ptr<ExpressionNode>& e)
-      : CacheInterface(), ExpressionNode(), _node(e)
-  {
-
-  }
-
   void updateJacobian() const
   {
-    if (!_isCacheValidJ)
+    const version_t version = currentVersion();
+    if (!isValid(_versionJ, version))
     {
+      // some nodes evaluate their Jacobians with values stored during the evaluation
+      cachedValue(version);
       boost::mutex::scoped_lock lock(_mutexJ);
-      if (!_isCacheValidJ) // could be updated by another thread in the meantime
+      if (!isValid(_versionJ, version)) // could be updated by another thread in the meantime
       {
         _jc.setZero();
         _node->evaluateJacobians(_jc);
-        _isCacheValidJ = true;
+        _versionJ.store(version, std::memory_order_release);
       }
     }
   }
 
  private:
-  mutable typename ExpressionNode::value_t _v; /// \brief Cache for error values
+  mutable value_t _v; /// \brief Cache for error values
   mutable JacobianContainerSparse<Dimension> _jc = JacobianContainerSparse<Dimension>(Dimension); /// \brief Cache for Jacobians
   boost::shared_ptr<ExpressionNode> _node; /// \brief Wrapped expression node, stored to delegate evaluation calls
   mutable boost::mutex _mutexV; /// \brief Mutex for error value write operations
   mutable boost::mutex _mutexJ; /// \brief Mutex for Jacobian write operations
 };
 
+/**
+ * \class CacheExpressionNode
+ * \brief Wraps an expression into a cache data structure to avoid duplicate
+ * computation of error and Jacobian values
+ *
+ * \tparam ExpressionNode Type of the expression node
+ * \tparam Dimensions Dimensionality of the design variables
+ */
+template <typename ExpressionNode, int Dimension>
+class CacheExpressionNode : public CacheExpressionNodeBase<ExpressionNode, Dimension>
+{
+ public:
+  template <typename Expression>
+  friend Expression toCacheExpression(const Expression& expr);
+
+ public:
+  virtual ~CacheExpressionNode() { }
+
+ protected:
+
+  typename ExpressionNode::value_t evaluateImplementation() const override
+  {
+    return this->cachedValue();
+  }
+
+ private:
+
+  CacheExpressionNode(const boost::shared_ptr<ExpressionNode>& e)
+      : CacheExpressionNodeBase<ExpressionNode, Dimension>(e)
+  {
+
+  }
+};
+
+template <>
+class CacheExpressionNode<RotationExpressionNode, 3> : public CacheExpressionNodeBase<RotationExpressionNode, 3>
+{
+ public:
+  template <typename Expression>
+  friend Expression toCacheExpression(const Expression& expr);
+
+ protected:
+  Eigen::Matrix3d toRotationMatrixImplementation() const override { return cachedValue(); }
+
+ private:
+  CacheExpressionNode(const boost::shared_ptr<RotationExpressionNode>& e) : CacheExpressionNodeBase<RotationExpressionNode, 3>(e) { }
+};
+
+template <>
+class CacheExpressionNode<TransformationExpressionNode, 6> : public CacheExpressionNodeBase<TransformationExpressionNode, 6>
+{
+ public:
+  template <typename Expression>
+  friend Expression toCacheExpression(const Expression& expr);
+
+ protected:
+  Eigen::Matrix4d toTransformationMatrixImplementation() override { return cachedValue(); }
+
+ private:
+  CacheExpressionNode(const boost::shared_ptr<TransformationExpressionNode>& e) : CacheExpressionNodeBase<TransformationExpressionNode, 6>(e) { }
+};
+
+template <>
+class CacheExpressionNode<HomogeneousExpressionNode, 4> : public CacheExpressionNodeBase<HomogeneousExpressionNode, 4>
+{
+ public:
+  template <typename Expression>
+  friend Expression toCacheExpression(const Expression& expr);
+
+ protected:
+  Eigen::Vector4d toHomogeneousImplementation() const override { return cachedValue(); }
+
+ private:
+  CacheExpressionNode(const boost::shared_ptr<HomogeneousExpressionNode>& e) : CacheExpressionNodeBase<HomogeneousExpressionNode, 4>(e) { }
+};
+
 
 
 template<int IRows, int ICols, int Dimension, typename TScalar>
@@ -117,17 +239,24 @@ class CacheExpressionNode< GenericMatrixExpressionNode<IRows, ICols, TScalar>, D
  public:
   virtual ~CacheExpressionNode() { }
 
+  void updateCache() const override
+  {
+    evaluateImplementation();
+    updateJacobian();
+  }
+
  protected:
 
   void evaluateImplementation() const override
   {
-    if (!_isCacheValidV)
+    const version_t version = currentVersion();
+    if (!isValid(_versionV, version))
     {
       boost::mutex::scoped_lock lock(_mutexV);
-      if (!_isCacheValidV) // could be updated by another thread in the meantime
+      if (!isValid(_versionV, version)) // could be updated by another thread in the meantime
       {
         this->_currentValue = _node->evaluate();
-        _isCacheValidV = true;
+        _versionV.store(version, std::memory_order_release);
       }
     }
   }
@@ -148,19 +277,22 @@ class CacheExpressionNode< GenericMatrixExpressionNode<IRows, ICols, TScalar>, D
   CacheExpressionNode(const boost::shared_ptr<ExpressionNode>& e)
       : CacheInterface(), ExpressionNode(), _node(e)
   {
-
+    DesignVariable::set_t designVariables;
+    _node->getDesignVariables(designVariables);
+    setCacheDesignVariables(designVariables);
   }
 
   void updateJacobian() const
   {
-    if (!_isCacheValidJ)
+    const version_t version = currentVersion();
+    if (!isValid(_versionJ, version))
     {
       boost::mutex::scoped_lock lock(_mutexJ);
-      if (!_isCacheValidJ) // could be updated by another thread in the meantime
+      if (!isValid(_versionJ, version)) // could be updated by another thread in the meantime
       {
         _jc.setZero();
         _node->evaluateJacobians(_jc, IdentityDifferential<typename ExpressionNode::tangent_vector_t, TScalar>());
-        _isCacheValidJ = true;
+        _versionJ.store(version, std::memory_order_release);
       }
     }
   }
@@ -174,9 +306,8 @@ class CacheExpressionNode< GenericMatrixExpressionNode<IRows, ICols, TScalar>, D
 
 
 /**
- * \brief Converts a regular expression to a cache expression and registers the expression
- * in the corresponding design variables in order to allow the design variables to
- * invalidate the cache
+ * \brief Converts a regular expression to a cache expression. The cache is invalidated by
+ * changes of the update counts of the design variables of the expression.
  *
  * @param expr original expression
  * \tparam Expression expression type
@@ -187,10 +318,6 @@ Expression toCacheExpression(const Expression& expr)
 {
   boost::shared_ptr< CacheExpressionNode<typename Expression::node_t, Expression::Dimension> > node
       (new CacheExpressionNode<typename Expression::node_t, Expression::Dimension>(expr.root()));
-  DesignVariable::set_t dvs;
-  node->getDesignVariables(dvs);
-  for (auto dv : dvs)
-    dv->registerCacheExpressionNode(node);
   return Expression(node);
 }
 
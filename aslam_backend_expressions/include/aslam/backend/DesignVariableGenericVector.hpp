@@ -29,7 +29,6 @@ class DesignVariableGenericVector : public DesignVariable, public GenericMatrixE
   using DesignVariable::setParameters;
   void setParameters(const Eigen::Matrix<Scalar_, D, 1>& value) {
     this->_currentValue = value;
-    this->_valueDirty = false;
     this->invalidateCache();
   }
  protected:
@@ -54,7 +53,6 @@ class DesignVariableGenericVector : public DesignVariable, public GenericMatrixE
 
   virtual void setParametersImplementation(const Eigen::MatrixXd& value) {
     this->_currentValue = value.template cast<Scalar_>();
-    this->_valueDirty = false;
   }
 
   virtual void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const {
@@ -66,6 +64,10 @@ class DesignVariableGenericVector : public DesignVariable, public GenericMatrixE
   }
   ;
   virtual void evaluateImplementation() const {
+  }
+  /// \brief All changes of the value invalidate the cache
+  virtual bool isCacheableImplementation() const {
+    return true;
   }
 
 	/// Computes the minimal distance in tangent space between the current value of the DV and xHat
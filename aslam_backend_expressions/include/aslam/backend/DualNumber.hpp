@@ -0,0 +1,304 @@
+#ifndef ASLAM_BACKEND_DUAL_NUMBER_HPP
+#define ASLAM_BACKEND_DUAL_NUMBER_HPP
+
+#include <cmath>
+#include <iosfwd>
+#include <limits>
+#include <Eigen/Core>
+
+namespace aslam {
+namespace backend {
+
+/**
+ * \class DualNumber
+ *
+ * \brief A value with its derivatives w.r.t. N variables for forward mode automatic differentiation.
+ *
+ * Functions written for a generic scalar type T compute their Jacobian in the same pass as their value when
+ * called with T = DualNumber: the variables are seeded with DualNumber::variable() and every operation applies
+ * the chain rule to the derivatives. Use unqualified calls for the elementary functions, e.g.
+ * \code
+ * using std::sin;
+ * return sin(x) * y;
+ * \endcode
+ * such that the overloads below are found for dual numbers.
+ *
+ * With N = Eigen::Dynamic the number of variables is chosen at runtime. Constants then carry no derivatives
+ * at all and are treated as having zero derivatives.
+ *
+ * Dual numbers may be the scalar type of GenericScalar and the generic expressions. Their values propagate
+ * through the expression nodes, but the nodes evaluate their Jacobians from the values only and discard the
+ * derivatives. The conversion to Scalar is explicit for the same reason, like Ceres' Jet.
+ */
+template <typename Scalar_, int N = Eigen::Dynamic>
+class DualNumber {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  typedef Scalar_ Scalar;
+  typedef Eigen::Matrix<Scalar, N, 1> Derivatives;
+  enum { NumDerivatives = N };
+
+  DualNumber() : DualNumber(Scalar(0)) {}
+
+  /// \brief A constant
+  DualNumber(Scalar value) : _value(value), _derivatives(Derivatives::Zero(N == Eigen::Dynamic ? 0 : N)) {}
+
+  template <typename DERIVED>
+  DualNumber(Scalar value, const Eigen::MatrixBase<DERIVED> & derivatives) : _value(value), _derivatives(derivatives) {}
+
+  /// \brief The variable \p i of \p numVariables with value \p value
+  static DualNumber variable(Scalar value, int i, int numVariables = N) {
+    return DualNumber(value, Derivatives::Unit(numVariables, i));
+  }
+
+  const Scalar & value() const { return _value; }
+  const Derivatives & derivatives() const { return _derivatives; }
+  Derivatives & derivatives() { return _derivatives; }
+
+  /// \brief Drops the derivatives
+  explicit operator Scalar() const { return _value; }
+
+  DualNumber operator + () const { return *this; }
+  DualNumber operator - () const { return DualNumber(-_value, -_derivatives); }
+
+  DualNumber & operator += (const DualNumber & other) { return *this = *this + other; }
+  DualNumber & operator -= (const DualNumber & other) { return *this = *this - other; }
+  DualNumber & operator *= (const DualNumber & other) { return *this = *this * other; }
+  DualNumber & operator /= (const DualNumber & other) { return *this = *this / other; }
+
+  /// \brief The dual number with value \p value and derivatives da * a + db * b
+  static DualNumber chain(Scalar value, Scalar da, const DualNumber & a, Scalar db, const DualNumber & b) {
+    if (N == Eigen::Dynamic) {
+      if (b._derivatives.size() == 0)
+        return DualNumber(value, da * a._derivatives);
+      if (a._derivatives.size() == 0)
+        return DualNumber(value, db * b._derivatives);
+    }
+    return DualNumber(value, da * a._derivatives + db * b._derivatives);
+  }
+
+  /// \brief The dual number with value \p value and derivatives da * a
+  static DualNumber chain(Scalar value, Scalar da, const DualNumber & a) {
+    return DualNumber(value, da * a._derivatives);
+  }
+
+  friend std::ostream & operator << (std::ostream & o, const DualNumber & v) {
+    return o << '[' << v._value << " ; " << v._derivatives.transpose() << ']';
+  }
+
+ private:
+  Scalar _value;
+  Derivatives _derivatives;
+};
+
+#define ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE template <typename Scalar_, int N>
+#define ASLAM_BACKEND_DUAL_NUMBER DualNumber<Scalar_, N>
+
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator + (const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(a.value() + b.value(), 1, a, 1, b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator + (const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) {
+  return ASLAM_BACKEND_DUAL_NUMBER(a.value() + b, a.derivatives());
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator + (typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return b + a;
+}
+
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator - (const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(a.value() - b.value(), 1, a, -1, b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator - (const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) {
+  return ASLAM_BACKEND_DUAL_NUMBER(a.value() - b, a.derivatives());
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator - (typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return ASLAM_BACKEND_DUAL_NUMBER(a - b.value(), -b.derivatives());
+}
+
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator * (const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(a.value() * b.value(), b.value(), a, a.value(), b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator * (const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(a.value() * b, b, a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator * (typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  return b * a;
+}
+
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator / (const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  const Scalar_ inv = Scalar_(1) / b.value(), value = a.value() * inv;
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, inv, a, -value * inv, b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator / (const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) {
+  const Scalar_ inv = Scalar_(1) / b;
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(a.value() * inv, inv, a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER operator / (typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  const Scalar_ inv = Scalar_(1) / b.value(), value = a * inv;
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, -value * inv, b);
+}
+
+// Comparisons only consider the values
+#define ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(OP) \
+  ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE \
+  inline bool operator OP (const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) { return a.value() OP b.value(); } \
+  ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE \
+  inline bool operator OP (const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) { return a.value() OP b; } \
+  ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE \
+  inline bool operator OP (typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) { return a OP b.value(); }
+
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(==)
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(!=)
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(<)
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(>)
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(<=)
+ASLAM_BACKEND_DUAL_NUMBER_COMPARISON(>=)
+#undef ASLAM_BACKEND_DUAL_NUMBER_COMPARISON
+
+// Elementary functions, found by argument dependent lookup
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER abs(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return a.value() < Scalar_(0) ? -a : a;
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER sqrt(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  const Scalar_ value = std::sqrt(a.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, Scalar_(0.5) / value, a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER exp(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  const Scalar_ value = std::exp(a.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, value, a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER log(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::log(a.value()), Scalar_(1) / a.value(), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER sin(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::sin(a.value()), std::cos(a.value()), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER cos(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::cos(a.value()), -std::sin(a.value()), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER tan(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  const Scalar_ value = std::tan(a.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, Scalar_(1) + value * value, a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER asin(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::asin(a.value()), Scalar_(1) / std::sqrt(Scalar_(1) - a.value() * a.value()), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER acos(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::acos(a.value()), Scalar_(-1) / std::sqrt(Scalar_(1) - a.value() * a.value()), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER atan(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::atan(a.value()), Scalar_(1) / (Scalar_(1) + a.value() * a.value()), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER atan2(const ASLAM_BACKEND_DUAL_NUMBER & y, const ASLAM_BACKEND_DUAL_NUMBER & x) {
+  const Scalar_ inv = Scalar_(1) / (x.value() * x.value() + y.value() * y.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(std::atan2(y.value(), x.value()), x.value() * inv, y, -y.value() * inv, x);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER pow(const ASLAM_BACKEND_DUAL_NUMBER & a, typename ASLAM_BACKEND_DUAL_NUMBER::Scalar b) {
+  const Scalar_ value = std::pow(a.value(), b);
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, b * std::pow(a.value(), b - Scalar_(1)), a);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER pow(typename ASLAM_BACKEND_DUAL_NUMBER::Scalar a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  const Scalar_ value = std::pow(a, b.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, value * std::log(a), b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline ASLAM_BACKEND_DUAL_NUMBER pow(const ASLAM_BACKEND_DUAL_NUMBER & a, const ASLAM_BACKEND_DUAL_NUMBER & b) {
+  const Scalar_ value = std::pow(a.value(), b.value());
+  return ASLAM_BACKEND_DUAL_NUMBER::chain(value, b.value() * std::pow(a.value(), b.value() - Scalar_(1)), a, value * std::log(a.value()), b);
+}
+ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+inline bool isfinite(const ASLAM_BACKEND_DUAL_NUMBER & a) {
+  return std::isfinite(a.value()) && a.derivatives().allFinite();
+}
+
+#undef ASLAM_BACKEND_DUAL_NUMBER
+#undef ASLAM_BACKEND_DUAL_NUMBER_TEMPLATE
+
+template <typename T>
+struct is_dual_number {
+  constexpr static bool value = false;
+};
+
+template <typename Scalar_, int N>
+struct is_dual_number<DualNumber<Scalar_, N>> {
+  constexpr static bool value = true;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+namespace Eigen {
+
+template <typename Scalar_, int N>
+struct NumTraits<aslam::backend::DualNumber<Scalar_, N> > : NumTraits<Scalar_> {
+  typedef aslam::backend::DualNumber<Scalar_, N> Real;
+  typedef Real NonInteger;
+  typedef Real Nested;
+  typedef Real Literal;
+
+  enum {
+    IsComplex = 0,
+    IsInteger = 0,
+    IsSigned = 1,
+    RequireInitialization = 1,
+    ReadCost = N == Dynamic ? HugeCost : N + 1,
+    AddCost = N == Dynamic ? HugeCost : N + 1,
+    MulCost = N == Dynamic ? HugeCost : 3 * N + 1
+  };
+
+  static inline Real epsilon() { return Real(NumTraits<Scalar_>::epsilon()); }
+  static inline Real dummy_precision() { return Real(NumTraits<Scalar_>::dummy_precision()); }
+  static inline Real highest() { return Real(NumTraits<Scalar_>::highest()); }
+  static inline Real lowest() { return Real(NumTraits<Scalar_>::lowest()); }
+  static inline int digits10() { return NumTraits<Scalar_>::digits10(); }
+};
+
+#if EIGEN_VERSION_AT_LEAST(3, 3, 0)
+template <typename Scalar_, int N, typename BinaryOp>
+struct ScalarBinaryOpTraits<aslam::backend::DualNumber<Scalar_, N>, Scalar_, BinaryOp> {
+  typedef aslam::backend::DualNumber<Scalar_, N> ReturnType;
+};
+
+template <typename Scalar_, int N, typename BinaryOp>
+struct ScalarBinaryOpTraits<Scalar_, aslam::backend::DualNumber<Scalar_, N>, BinaryOp> {
+  typedef aslam::backend::DualNumber<Scalar_, N> ReturnType;
+};
+#endif
+
+}  // namespace Eigen
+
+namespace std {
+
+template <typename Scalar_, int N>
+struct numeric_limits<aslam::backend::DualNumber<Scalar_, N> > : numeric_limits<Scalar_> {
+  static aslam::backend::DualNumber<Scalar_, N> epsilon() { return numeric_limits<Scalar_>::epsilon(); }
+};
+
+}
+
+#endif /* ASLAM_BACKEND_DUAL_NUMBER_HPP */
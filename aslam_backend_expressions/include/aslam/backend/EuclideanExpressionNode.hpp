@@ -41,6 +41,7 @@ namespace aslam {
       Eigen::Vector3d evaluateImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<RotationExpressionNode> _lhs;
       mutable Eigen::Matrix3d _C_lhs;
@@ -95,6 +96,7 @@ namespace aslam {
        Eigen::Vector3d evaluateImplementation() const override;
        void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
        void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+       int compileTape(ExpressionTapeBuilder& builder) const override;
 
        boost::shared_ptr<EuclideanExpressionNode> _lhs;
        boost::shared_ptr<EuclideanExpressionNode> _rhs;
@@ -119,6 +121,7 @@ namespace aslam {
         Eigen::Vector3d evaluateImplementation() const override;
         void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
         void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+        int compileTape(ExpressionTapeBuilder& builder) const override;
 
         boost::shared_ptr<EuclideanExpressionNode> _lhs;
         boost::shared_ptr<EuclideanExpressionNode> _rhs;
@@ -142,6 +145,7 @@ namespace aslam {
        Eigen::Vector3d evaluateImplementation() const override;
        void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
        void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+       int compileTape(ExpressionTapeBuilder& builder) const override;
 
        boost::shared_ptr<EuclideanExpressionNode> _lhs;
        boost::shared_ptr<EuclideanExpressionNode> _rhs;
@@ -166,6 +170,7 @@ namespace aslam {
        Eigen::Vector3d evaluateImplementation() const override;
        void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
        void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+       int compileTape(ExpressionTapeBuilder& builder) const override;
 
        boost::shared_ptr<EuclideanExpressionNode> _lhs;
        Eigen::Vector3d _rhs;
@@ -190,6 +195,7 @@ namespace aslam {
         Eigen::Vector3d evaluateImplementation() const override;
         void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
         void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+        int compileTape(ExpressionTapeBuilder& builder) const override;
 
         boost::shared_ptr<EuclideanExpressionNode> _operand;
       };
@@ -212,6 +218,7 @@ namespace aslam {
         Eigen::Vector3d evaluateImplementation() const override;
         void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
         void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+        int compileTape(ExpressionTapeBuilder& builder) const override;
 
         boost::shared_ptr<EuclideanExpressionNode> _p;
         boost::shared_ptr<ScalarExpressionNode> _s;
@@ -229,6 +236,7 @@ namespace aslam {
         Eigen::Vector3d evaluateImplementation() const override;
         void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
         void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+        int compileTape(ExpressionTapeBuilder& builder) const override;
 
         boost::shared_ptr<TransformationExpressionNode> _operand;
       };
@@ -264,6 +272,7 @@ namespace aslam {
         Eigen::Vector3d evaluateImplementation() const override;
         void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
         void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+        int compileTape(ExpressionTapeBuilder& builder) const override;
 
         boost::shared_ptr<HomogeneousExpressionNode> _root;
       };
@@ -29,7 +29,7 @@ namespace aslam {
       EuclideanExpression toExpression();
       HomogeneousExpression toHomogeneousExpression();
 
-      void set(const Eigen::Vector3d & p){ _p = p; _p_p = _p; }
+      void set(const Eigen::Vector3d & p){ _p = p; _p_p = _p; invalidateCache(); }
 
       const Eigen::Vector3d & getValue() const { return _p; }
       const Eigen::Vector3d & toEuclidean() const { return getValue() ; }
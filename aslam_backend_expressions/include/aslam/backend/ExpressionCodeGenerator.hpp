@@ -0,0 +1,63 @@
+#ifndef ASLAM_BACKEND_EXPRESSION_CODE_GENERATOR_HPP
+#define ASLAM_BACKEND_EXPRESSION_CODE_GENERATOR_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <aslam/backend/ExpressionTape.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    /**
+     * \class ExpressionCodeGenerator
+     *
+     * \brief Generates C++ error terms for expressions of a fixed topology.
+     *
+     * The prototype expression is compiled into an ExpressionTape and every instruction of the tape is
+     * emitted as a fixed size Eigen statement. The generated class derives from ErrorTermFs and computes the
+     * error and the Jacobians in straight-line code without virtual calls or shared pointers in the interior
+     * of the expression, which lets the compiler share work between the error and the Jacobians.
+     *
+     * The generated class is constructed from an expression with the same topology as the prototype. Its
+     * leaves, i.e. the design variables and all nodes without a tape operation, are still evaluated through
+     * the expression nodes, and its constants, e.g. the measurement of a reprojection error, are read from the
+     * expression. The constructor throws if the topology does not match.
+     *
+     * A small executable typically builds the prototypes, adds them with addErrorTerm() and writes the
+     * header with writeHeader(). The CMake function aslam_backend_generate_code() runs it at build time.
+     */
+    class ExpressionCodeGenerator
+    {
+     public:
+      SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
+
+      /// \brief Generated classes are put into \p nameSpace, e.g. "my_project::generated", or the global namespace if empty
+      ExpressionCodeGenerator(const std::string& nameSpace = std::string());
+
+      /// \brief Add the error term class \p className for expressions with the topology of \p expression
+      void addErrorTerm(const std::string& className, const ScalarExpression& expression);
+      void addErrorTerm(const std::string& className, const VectorExpression<3>& expression);
+      void addErrorTerm(const std::string& className, const HomogeneousExpression& expression);
+
+      /// \brief Write a self-contained header with all error terms added so far
+      void writeHeader(std::ostream& out, const std::string& includeGuard) const;
+
+      /// \brief Write the header to \p fileName, the include guard is derived from the file name
+      void writeHeader(const std::string& fileName) const;
+
+      /// \brief Write the error term class \p className for \p tape. \p expressionType is the constructor argument.
+      static void generateErrorTerm(const ExpressionTape& tape, const std::string& className, const std::string& expressionType, std::ostream& out);
+
+     private:
+      void addErrorTerm(const std::string& className, const ExpressionTape& tape, const std::string& expressionType);
+
+      std::string _nameSpace;
+      std::vector<std::string> _classes;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_EXPRESSION_CODE_GENERATOR_HPP */
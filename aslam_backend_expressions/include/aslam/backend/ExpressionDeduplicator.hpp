@@ -0,0 +1,71 @@
+#ifndef ASLAM_BACKEND_EXPRESSION_DEDUPLICATOR_HPP
+#define ASLAM_BACKEND_EXPRESSION_DEDUPLICATOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <aslam/backend/ExpressionTape.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    class ExpressionErrorTermInterface;
+    class OptimizationProblemBase;
+
+    /**
+     * \class ExpressionDeduplicator
+     *
+     * \brief Shares common sub-expressions across expression error terms.
+     *
+     * Error terms built independently often contain the same sub-expressions, e.g. the pose of a camera in
+     * the world frame composed from the same design variables for every landmark observation. The deduplicator
+     * compiles the expressions of all error terms into one ExpressionTape with hash consing, so that
+     * structurally identical operations on the same leaves end up in the same slot even if they were built from
+     * different nodes. Leaves, i.e. design variables and nodes without a tape operation, are compared by identity.
+     *
+     * Every shared operation that is not only needed as part of an equally shared parent is wrapped into a
+     * cache expression (see toCacheExpression()), which is invalidated by its design variables. The error terms
+     * are then compiled into their own tapes with all occurrences of the shared operation replaced by the cache
+     * node, so the shared value and its Jacobians are computed once per evaluation and not once per error term.
+     *
+     * The error terms keep their expressions, clearing their tapes goes back to the unshared trees.
+     */
+    class ExpressionDeduplicator
+    {
+     public:
+      SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
+
+      struct Statistics {
+        /// \brief Number of error terms whose expression could be compiled
+        std::size_t numErrorTerms = 0;
+        /// \brief Number of nodes summed over all error terms, shared nodes counted once per error term
+        std::size_t numNodes = 0;
+        /// \brief Number of structurally unique nodes
+        std::size_t numUniqueNodes = 0;
+        /// \brief Number of cache nodes inserted
+        std::size_t numCacheNodes = 0;
+
+        /// \brief Number of nodes per unique node, 1 if nothing is shared
+        double deduplicationRatio() const { return numUniqueNodes ? double(numNodes) / numUniqueNodes : 1.0; }
+      };
+
+      /// \brief Add an error term
+      void add(ExpressionErrorTermInterface& errorTerm);
+
+      /// \brief Add all expression error terms of \p problem, squared and non-squared. Returns the number of error terms added.
+      std::size_t add(OptimizationProblemBase& problem);
+
+      /// \brief Number of error terms added
+      std::size_t numErrorTerms() const { return _errorTerms.size(); }
+
+      /// \brief Insert the cache nodes and recompile the tapes of all error terms added
+      Statistics apply();
+
+     private:
+      std::vector<ExpressionErrorTermInterface*> _errorTerms;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_EXPRESSION_DEDUPLICATOR_HPP */
@@ -14,6 +14,7 @@
 #include <aslam/backend/EuclideanExpression.hpp>
 #include <aslam/backend/GenericMatrixExpression.hpp>
 #include <aslam/backend/GenericScalarExpression.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 
 namespace aslam {
 namespace backend {
@@ -87,10 +88,60 @@ struct ExpressionToEigenVectorTraits<ScalarExpression>{
     return (Eigen::Matrix<double, 1, 1>() << error).finished();
   }
 };
+
+/// \brief Compiles expressions into an ExpressionTape. Expressions that cannot be compiled yield a null pointer
+///        or the slot -1 when compiled into an existing builder.
+template <typename TExpression>
+struct ExpressionTapeTraits {
+  static ExpressionTape::Ptr compile(const TExpression & /* expression */, const ExpressionTape::NodeSubstitutions & /* substitutions */) {
+    return ExpressionTape::Ptr();
+  }
+  static int compile(ExpressionTapeBuilder & /* builder */, const TExpression & /* expression */) {
+    return -1;
+  }
+};
+
+template <>
+struct ExpressionTapeTraits<VectorExpression<3> > {
+  static ExpressionTape::Ptr compile(const VectorExpression<3> & expression, const ExpressionTape::NodeSubstitutions & substitutions) {
+    return ExpressionTape::compile(expression, substitutions);
+  }
+  static int compile(ExpressionTapeBuilder & builder, const VectorExpression<3> & expression) {
+    return builder.compile(expression.root());
+  }
+};
+
+template <>
+struct ExpressionTapeTraits<EuclideanExpression> : public ExpressionTapeTraits<VectorExpression<3> > {
+};
+
+template <>
+struct ExpressionTapeTraits<ScalarExpression> {
+  static ExpressionTape::Ptr compile(const ScalarExpression & expression, const ExpressionTape::NodeSubstitutions & substitutions) {
+    return ExpressionTape::compile(expression, substitutions);
+  }
+  static int compile(ExpressionTapeBuilder & builder, const ScalarExpression & expression) {
+    return builder.compile(expression.root());
+  }
+};
 }
 
+/// \brief Access to the expression of an error term for tools working on the expressions of many error terms, e.g. ExpressionDeduplicator
+class ExpressionErrorTermInterface {
+ public:
+  virtual ~ExpressionErrorTermInterface() {
+  }
+
+  /// \brief Compile the expression into \p builder and return the slot of its root or -1 if it cannot be compiled
+  virtual int compileExpression(ExpressionTapeBuilder & builder) const = 0;
+
+  /// \brief Evaluate the expression through a flattened ExpressionTape from now on, replacing the nodes in \p substitutions.
+  ///        Returns false if the expression cannot be compiled.
+  virtual bool compileExpressionTape(const ExpressionTape::NodeSubstitutions & substitutions = ExpressionTape::NodeSubstitutions()) = 0;
+};
+
 template<typename TExpression, int IDimension = internal::ExpressionDimensionTraits<TExpression>::Dimension>
-class ExpressionErrorTerm : public aslam::backend::ErrorTermFs<IDimension> {
+class ExpressionErrorTerm : public aslam::backend::ErrorTermFs<IDimension>, public ExpressionErrorTermInterface {
  public:
   typedef ExpressionErrorTerm self_t;
   typedef aslam::backend::ErrorTermFs<IDimension> parent_t;
@@ -110,6 +161,13 @@ class ExpressionErrorTerm : public aslam::backend::ErrorTermFs<IDimension> {
 
   /// \brief evaluate the error term
   virtual double evaluateErrorImplementation() {
+    if (_tape) {
+      _tape->evaluate();
+      const Eigen::Map<const PointT> error(_tape->rootValue());
+      this->setError(error);
+      auto tmp = (this->sqrtInvR() * error).eval();
+      return tmp.dot(tmp);
+    }
     auto error = internal::ExpressionToEigenVectorTraits<TExpression>::toEigenErrorVector(_expression.evaluate());
     this->setError(error);
     auto tmp = (this->sqrtInvR() * error).eval();
@@ -118,20 +176,49 @@ class ExpressionErrorTerm : public aslam::backend::ErrorTermFs<IDimension> {
 
   /// \brief evaluate the jacobian
   virtual void evaluateJacobiansImplementation(JacobianContainer & jacobians) {
-    _expression.evaluateJacobians(jacobians);
+    if (_tape)
+      _tape->evaluateJacobians(jacobians);
+    else
+      _expression.evaluateJacobians(jacobians);
   }
 
   inline TExpression getExpression() {
     return _expression;
   }
 
+  virtual int compileExpression(ExpressionTapeBuilder & builder) const override {
+    if (internal::ExpressionDimensionTraits<TExpression>::Dimension != IDimension)
+      return -1;
+    return internal::ExpressionTapeTraits<TExpression>::compile(builder, _expression);
+  }
+
+  /// \brief Evaluate the expression through a flattened ExpressionTape from now on.
+  ///        Returns false if the expression type cannot be compiled. The result does not change.
+  virtual bool compileExpressionTape(const ExpressionTape::NodeSubstitutions & substitutions = ExpressionTape::NodeSubstitutions()) override {
+    _tape = internal::ExpressionTapeTraits<TExpression>::compile(_expression, substitutions);
+    if (_tape && ExpressionTape::valueSize(_tape->rootType()) != IDimension)
+      _tape.reset();
+    return static_cast<bool>(_tape);
+  }
+
+  /// \brief Go back to evaluating the expression tree
+  void clearExpressionTape() {
+    _tape.reset();
+  }
+
+  /// \brief Whether the expression is evaluated through an ExpressionTape
+  bool usesExpressionTape() const {
+    return static_cast<bool>(_tape);
+  }
+
   using parent_t::setInvR;
   using parent_t::setSqrtInvR;
  private:
   const TExpression _expression;
+  ExpressionTape::Ptr _tape;
 };
 
-class ScalarNonSquaredExpressionErrorTerm : public aslam::backend::ScalarNonSquaredErrorTerm {
+class ScalarNonSquaredExpressionErrorTerm : public aslam::backend::ScalarNonSquaredErrorTerm, public ExpressionErrorTermInterface {
  public:
   typedef ScalarNonSquaredExpressionErrorTerm self_t;
   typedef aslam::backend::ScalarNonSquaredErrorTerm parent_t;
@@ -148,21 +235,49 @@ class ScalarNonSquaredExpressionErrorTerm : public aslam::backend::ScalarNonSqua
 
   /// \brief evaluate the error term
   virtual double evaluateErrorImplementation() override {
+    if (_tape) {
+      _tape->evaluate();
+      return *_tape->rootValue();
+    }
     auto error = internal::ExpressionToEigenVectorTraits<ScalarExpression>::toEigenErrorVector(_expression.evaluate());
     return error[0];
   }
 
   /// \brief evaluate the jacobian
   virtual void evaluateJacobiansImplementation(JacobianContainer & jacobians) override {
-    _expression.evaluateJacobians(jacobians);
+    if (_tape)
+      _tape->evaluateJacobians(jacobians);
+    else
+      _expression.evaluateJacobians(jacobians);
   }
 
   inline const ScalarExpression& getExpression() const {
     return _expression;
   }
 
+  virtual int compileExpression(ExpressionTapeBuilder & builder) const override {
+    return builder.compile(_expression.root());
+  }
+
+  /// \brief Evaluate the expression through a flattened ExpressionTape from now on
+  virtual bool compileExpressionTape(const ExpressionTape::NodeSubstitutions & substitutions = ExpressionTape::NodeSubstitutions()) override {
+    _tape = ExpressionTape::compile(_expression, substitutions);
+    return true;
+  }
+
+  /// \brief Go back to evaluating the expression tree
+  void clearExpressionTape() {
+    _tape.reset();
+  }
+
+  /// \brief Whether the expression is evaluated through an ExpressionTape
+  bool usesExpressionTape() const {
+    return static_cast<bool>(_tape);
+  }
+
  private:
   const ScalarExpression _expression;
+  ExpressionTape::Ptr _tape;
 };
 
 template<typename TExpression, int IDimension = internal::ExpressionDimensionTraits<TExpression>::Dimension>
@@ -0,0 +1,118 @@
+#ifndef ASLAM_BACKEND_EXPRESSION_NODE_PROFILER_HPP
+#define ASLAM_BACKEND_EXPRESSION_NODE_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace aslam {
+namespace backend {
+
+/**
+ * \class ExpressionNodeProfiler
+ *
+ * \brief Opt-in profiler collecting call counts, times and allocation counts per expression node type.
+ *
+ * The value and Jacobian entry points of the expression node base classes open a Scope for the concrete node
+ * type. While the profiler is enabled, the scopes record a call tree per thread, e.g. across a full
+ * Optimizer2::optimize():
+ * \code
+ * ExpressionNodeProfiler::enable();
+ * optimizer.optimize();
+ * ExpressionNodeProfiler::disable();
+ * ExpressionNodeProfiler::print(std::cout);
+ * ExpressionNodeProfiler::writeFoldedStacks(flamegraphFile);
+ * \endcode
+ * While disabled, a scope costs one relaxed atomic load. Define ASLAM_BACKEND_DISABLE_EXPRESSION_NODE_PROFILER
+ * to compile the scopes out entirely.
+ *
+ * Allocations are only counted in executables that call countAllocation() from their global operator new, as
+ * the aslam_backend_expressions-profiling executable does.
+ *
+ * The statistics must only be read or reset while no expressions are evaluated.
+ */
+class ExpressionNodeProfiler {
+ public:
+  enum Operation { Value, Jacobians, NumOperations };
+
+  /// \brief The statistics of one operation of one node type
+  struct Statistics {
+    std::string nodeType;
+    Operation operation;
+    std::size_t calls;
+    /// \brief Including the time spent in the operand nodes, nested calls of the same node type counted once
+    double inclusiveSeconds;
+    /// \brief Excluding the time spent in the operand nodes
+    double exclusiveSeconds;
+    std::size_t inclusiveAllocations;
+    std::size_t exclusiveAllocations;
+  };
+
+  /// \brief Records the call of \p operation of the node of type \p type until destructed
+  class Scope {
+   public:
+    Scope(const std::type_info & type, Operation operation) {
+      if (isEnabled())
+        enter(type, operation);
+    }
+    ~Scope() {
+      if (_node)
+        leave();
+    }
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+   private:
+    void enter(const std::type_info & type, Operation operation);
+    void leave();
+
+    void * _node = nullptr;
+    std::chrono::steady_clock::time_point _start;
+    std::size_t _startAllocations = 0;
+  };
+
+  static void enable(bool enabled = true) { _enabled.store(enabled, std::memory_order_relaxed); }
+  static void disable() { enable(false); }
+  static bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+
+  /// \brief Clear the statistics of all threads
+  static void reset();
+
+  /// \brief Count an allocation of the calling thread. Must not allocate itself.
+  static void countAllocation() noexcept;
+
+  /// \brief The statistics merged over all threads, sorted by decreasing exclusive time
+  static std::vector<Statistics> statistics();
+
+  /// \brief Print a table of the statistics
+  static void print(std::ostream & out);
+
+  /// \brief Write the call stacks in the folded format of flamegraph.pl, weighted by exclusive nanoseconds
+  static void writeFoldedStacks(std::ostream & out);
+
+  /// \brief Write the call graph between the node types in Graphviz dot format
+  static void writeGraphviz(std::ostream & out);
+
+  /// \brief The readable name of an operation
+  static const char * toString(Operation operation);
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+#ifndef ASLAM_BACKEND_DISABLE_EXPRESSION_NODE_PROFILER
+/// \brief Profile the enclosing member function of an expression node as \p OPERATION of its concrete type
+#define ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(OPERATION) \
+  ::aslam::backend::ExpressionNodeProfiler::Scope expressionNodeProfilerScope(typeid(*this), ::aslam::backend::ExpressionNodeProfiler::OPERATION)
+#else
+#define ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(OPERATION)
+#endif
+
+#endif /* ASLAM_BACKEND_EXPRESSION_NODE_PROFILER_HPP */
@@ -0,0 +1,267 @@
+#ifndef ASLAM_BACKEND_EXPRESSION_TAPE_HPP
+#define ASLAM_BACKEND_EXPRESSION_TAPE_HPP
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <unordered_map>
+
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+#include <sm/assert_macros.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    template <int D> class VectorExpressionNode;
+    typedef VectorExpressionNode<3> EuclideanExpressionNode;
+    class ScalarExpressionNode;
+    class HomogeneousExpressionNode;
+    class RotationExpressionNode;
+    class TransformationExpressionNode;
+
+    template <int D> class VectorExpression;
+    class ScalarExpression;
+    class HomogeneousExpression;
+    class RotationExpression;
+    class TransformationExpression;
+
+    class ExpressionTapeBuilder;
+
+    /**
+     * \class ExpressionTape
+     *
+     * \brief A flattened expression for fast repeated evaluation.
+     *
+     * The expression tree is compiled into a linear list of instructions working on slots in a contiguous
+     * value buffer. Every node is visited exactly once, shared sub-expressions are only compiled once.
+     * evaluate() runs a forward sweep computing all values, evaluateJacobians() a reverse sweep propagating
+     * the adjoint of the root (its Jacobian w.r.t. every slot) down to the leaves.
+     *
+     * Nodes that do not know how to compile themselves, including all design variables, become leaves of the
+     * tape. Leaves are evaluated through the tree interpreter and receive their adjoint as chain rule matrix.
+     * As for the tree interpreter, evaluateJacobians() uses the values of the last evaluate() call.
+     */
+    class ExpressionTape
+    {
+     public:
+      SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
+
+      typedef boost::shared_ptr<ExpressionTape> Ptr;
+
+      /// \brief Nodes, identified by their address, to be compiled as other nodes of the same type, e.g. as cache nodes
+      typedef std::unordered_map<const void*, boost::shared_ptr<void> > NodeSubstitutions;
+
+      /// \brief The type of a slot. The values are stored column major, the adjoints use the tangent space dimension.
+      enum ValueType {
+        SCALAR,         /// 1 value, 1 tangent dimension
+        EUCLIDEAN,      /// 3 values, 3 tangent dimensions
+        HOMOGENEOUS,    /// 4 values, 4 tangent dimensions
+        ROTATION,       /// 3x3 rotation matrix, 3 tangent dimensions
+        TRANSFORMATION  /// 4x4 transformation matrix, 6 tangent dimensions
+      };
+
+      /// \brief Instructions of the tape. Operations mirror the chain rule of the corresponding expression nodes.
+      enum OpCode {
+        LEAF,                       /// A node evaluated by the tree interpreter
+        SCALAR_MULTIPLY,            /// s0 * s1
+        SCALAR_DIVIDE,              /// s0 / s1
+        SCALAR_NEGATE,              /// -s0
+        SCALAR_ADD,                 /// s0 + parameter * s1
+        SCALAR_FROM_EUCLIDEAN,      /// p0[parameter]
+        EUCLIDEAN_ROTATE,           /// C0 * p1
+        EUCLIDEAN_CROSS,            /// p0 x p1
+        EUCLIDEAN_ADD,              /// p0 + p1
+        EUCLIDEAN_SUBTRACT,         /// p0 - p1
+        EUCLIDEAN_NEGATE,           /// -p0
+        EUCLIDEAN_SCALE,            /// p0 * s1
+        EUCLIDEAN_TRANSLATION,      /// translation of T0
+        EUCLIDEAN_FROM_HOMOGENEOUS, /// h0 dehomogenized
+        HOMOGENEOUS_TRANSFORM,      /// T0 * h1
+        HOMOGENEOUS_FROM_EUCLIDEAN, /// [p0; 1]
+        ROTATION_MULTIPLY,          /// C0 * C1
+        ROTATION_INVERSE,           /// C0^T
+        ROTATION_FROM_TRANSFORMATION, /// rotation of T0
+        TRANSFORMATION_MULTIPLY,    /// T0 * T1
+        TRANSFORMATION_INVERSE,     /// T0^-1
+        TRANSFORMATION_FROM_ROTATION_TRANSLATION /// [C0, p1; 0, 1]
+      };
+
+      /// \brief Compile an expression, replacing the nodes in \p substitutions
+      static Ptr compile(const ScalarExpression& expression, const NodeSubstitutions& substitutions = NodeSubstitutions());
+      static Ptr compile(const VectorExpression<3>& expression, const NodeSubstitutions& substitutions = NodeSubstitutions());
+      static Ptr compile(const HomogeneousExpression& expression, const NodeSubstitutions& substitutions = NodeSubstitutions());
+      static Ptr compile(const RotationExpression& expression, const NodeSubstitutions& substitutions = NodeSubstitutions());
+      static Ptr compile(const TransformationExpression& expression, const NodeSubstitutions& substitutions = NodeSubstitutions());
+
+      /// \brief Forward sweep: evaluate all slots
+      void evaluate();
+
+      /// \brief Reverse sweep: evaluate the Jacobians of the root w.r.t. all design variables
+      void evaluateJacobians(JacobianContainer& outJacobians);
+
+      /// \brief The value of the root, e.g. 9 values of a column major rotation matrix
+      const double* rootValue() const { return _values.data() + _slots[_rootSlot].value; }
+
+      /// \brief The type of the root
+      ValueType rootType() const { return _slots[_rootSlot].type; }
+
+      /// \brief The tangent space dimension of the root, i.e. the number of rows of the Jacobians
+      int rows() const { return _rows; }
+
+      /// \brief Number of instructions including the leaves
+      std::size_t numInstructions() const { return _instructions.size(); }
+
+      /// \brief Number of nodes evaluated by the tree interpreter
+      std::size_t numLeaves() const { return _leaves.size(); }
+
+      /// \brief Number of slots including constants
+      std::size_t numSlots() const { return _slots.size(); }
+
+      /// \brief Hash of the structure of the tape. Expressions of the same topology compile to tapes with the same hash.
+      std::size_t structureHash() const;
+
+      /// \brief Evaluate the leaves only. Used by code generated with ExpressionCodeGenerator.
+      void evaluateLeaves();
+
+      /// \brief The value of \p slot
+      const double* slotValue(int slot) const { return _values.data() + _slots[slot].value; }
+
+      /// \brief Apply the adjoint of leaf \p leaf, i.e. the Jacobian of the root w.r.t. the leaf, to the Jacobians of the leaf
+      void evaluateLeafJacobians(std::size_t leaf, const double* adjoint, JacobianContainer& outJacobians) const;
+
+      /// \brief Number of values stored for \p type
+      static int valueSize(ValueType type);
+
+      /// \brief Tangent space dimension of \p type
+      static int tangentSize(ValueType type);
+
+     private:
+      friend class ExpressionTapeBuilder;
+      friend class ExpressionCodeGenerator;
+      friend class ExpressionDeduplicator;
+
+      struct Instruction {
+        OpCode op;
+        int out;
+        int in0; /// first operand or index of the leaf
+        int in1;
+        double parameter;
+      };
+
+      struct Slot {
+        ValueType type;
+        int value;               /// offset into _values
+        int adjoint;             /// offset into _adjoints or -1 if the slot does not depend on design variables
+        bool hasDesignVariables;
+      };
+
+      struct Leaf {
+        ValueType type;
+        const void* node;
+        int slot;
+      };
+
+      ExpressionTape() = default;
+
+      template <typename NODE>
+      static Ptr compileRoot(const boost::shared_ptr<NODE>& root, ValueType type, const NodeSubstitutions& substitutions);
+
+      void evaluateLeaf(const Leaf& leaf, double* value);
+      void evaluateLeafJacobians(const Leaf& leaf, const double* adjoint, int cols, JacobianContainer& outJacobians) const;
+      void evaluateInstruction(const Instruction& instruction);
+      void propagateAdjoint(const Instruction& instruction);
+
+      std::vector<Instruction> _instructions;
+      std::vector<Slot> _slots;
+      std::vector<Leaf> _leaves;
+      std::vector<double> _values;
+      std::vector<double> _adjoints;
+      int _rootSlot = -1;
+      int _rows = 0;
+
+      /// \brief Keeps the expression and therefore all leaves alive
+      boost::shared_ptr<const void> _root;
+      /// \brief Keeps the substituted nodes alive
+      std::vector<boost::shared_ptr<void> > _substitutedNodes;
+    };
+
+    /**
+     * \class ExpressionTapeBuilder
+     *
+     * \brief Helper passed to the compileTape() methods of the expression nodes.
+     *
+     * Nodes compile their operands with compile(), which returns the slot of the operand and compiles every node
+     * only once, and append their own operation with addOperation().
+     *
+     * With hash consing enabled, structurally identical operations on the same slots and equal constants are
+     * compiled into one slot even if they stem from different nodes.
+     */
+    class ExpressionTapeBuilder
+    {
+     public:
+      typedef ExpressionTape::Exception Exception;
+
+      /// \brief Compile into \p tape, replacing the nodes in \p substitutions if not null
+      ExpressionTapeBuilder(ExpressionTape& tape, const ExpressionTape::NodeSubstitutions* substitutions = nullptr, bool hashConsing = false)
+          : _tape(tape), _substitutions(substitutions), _hashConsing(hashConsing) { }
+
+      /// \brief Compile \p node and return its slot
+      int compile(const boost::shared_ptr<ScalarExpressionNode>& node);
+      int compile(const boost::shared_ptr<EuclideanExpressionNode>& node);
+      int compile(const boost::shared_ptr<HomogeneousExpressionNode>& node);
+      int compile(const boost::shared_ptr<RotationExpressionNode>& node);
+      int compile(const boost::shared_ptr<TransformationExpressionNode>& node);
+      template <int D>
+      int compile(const boost::shared_ptr<VectorExpressionNode<D> >& /* node */) {
+        SM_THROW(Exception, "Only three dimensional vector expressions can be compiled");
+      }
+
+      /// \brief Add a leaf evaluated by the tree interpreter
+      int addLeaf(const ScalarExpressionNode* node);
+      int addLeaf(const EuclideanExpressionNode* node);
+      int addLeaf(const HomogeneousExpressionNode* node);
+      int addLeaf(const RotationExpressionNode* node);
+      int addLeaf(const TransformationExpressionNode* node);
+      template <int D>
+      int addLeaf(const VectorExpressionNode<D>* /* node */) {
+        SM_THROW(Exception, "Only three dimensional vector expressions can be compiled");
+      }
+
+      /// \brief Add a constant. Only nodes whose value can never change may be compiled to constants.
+      int addConstant(double value);
+      int addConstant(const Eigen::Vector3d& value);
+      int addConstant(const Eigen::Vector4d& value);
+      int addConstant(const Eigen::Matrix3d& value);
+      int addConstant(const Eigen::Matrix4d& value);
+
+      /// \brief Add an operation on the slots \p in0 and \p in1 and return its output slot
+      int addOperation(ExpressionTape::OpCode op, int in0, int in1 = -1, double parameter = 0.0);
+
+      /// \brief The first node compiled into \p slot or null, e.g. for constants
+      boost::shared_ptr<void> slotNode(int slot) const;
+
+     private:
+      friend class ExpressionDeduplicator;
+
+      template <typename NODE>
+      int compileNode(const boost::shared_ptr<NODE>& node);
+      int addSlot(ExpressionTape::ValueType type, bool hasDesignVariables);
+      int addLeaf(ExpressionTape::ValueType type, const void* node, bool hasDesignVariables);
+      int addConstant(ExpressionTape::ValueType type, const double* value);
+
+      ExpressionTape& _tape;
+      const ExpressionTape::NodeSubstitutions* _substitutions;
+      bool _hashConsing;
+      std::unordered_map<const void*, int> _nodeSlots;
+      std::vector<boost::shared_ptr<void> > _slotNodes;
+      std::map<std::tuple<int, int, int, double>, int> _operationSlots;
+      std::map<std::pair<int, std::vector<double> >, int> _constantSlots;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_EXPRESSION_TAPE_HPP */
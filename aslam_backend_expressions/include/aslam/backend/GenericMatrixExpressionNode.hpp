@@ -1,13 +1,38 @@
 #ifndef ASLAM_BACKEND_GENERIC_MATRIX_EXPRESSION_NODE_HPP
 #define ASLAM_BACKEND_GENERIC_MATRIX_EXPRESSION_NODE_HPP
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <aslam/backend/DesignVariable.hpp>
 #include <aslam/backend/JacobianContainer.hpp>
 #include <aslam/backend/Differential.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
 namespace backend {
 
 template<int IRows, int ICols, typename TScalar> class ConstantGenericMatrixExpressionNode;
 
+/**
+ * \class GenericMatrixExpressionNode
+ *
+ * \brief Node of a GenericMatrixExpression.
+ *
+ * The value of a cacheable node (see isCacheable()) is only recomputed by evaluate() if one of the design
+ * variables of the node changed since the last evaluation, which it detects by comparing the sum of their update
+ * counts with the sum the value was computed for. Sub-expressions not depending on the changed design variables
+ * keep their values, so after changing a few design variables only the paths from them to the root are recomputed.
+ * All other nodes are recomputed on every evaluate() as their value may depend on state that is not counted.
+ *
+ * Like the cache expressions, a cached node publishes the version its value was computed for with release
+ * semantics. Checking a valid value takes no lock, only the refresh is serialized. Nodes that are not cached are
+ * rewritten on every evaluate() and must not be evaluated concurrently.
+ */
 template<int IRows, int ICols, typename TScalar>
 class GenericMatrixExpressionNode {
  public:
@@ -22,16 +47,15 @@ class GenericMatrixExpressionNode {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
  protected:
   mutable matrix_t _currentValue;
-  mutable bool _valueDirty;
 
   inline GenericMatrixExpressionNode(const matrix_t & value)
       : _currentValue(value),
-        _valueDirty(false) {
+        _valueVersion(0) {
   }
  public:
   GenericMatrixExpressionNode(int rows = IRows, int cols = ICols, bool valueDirty = true)
       : _currentValue(rows, cols),
-        _valueDirty(valueDirty) {
+        _valueVersion(valueDirty ? invalidVersion() : 0) {
   }
   virtual ~GenericMatrixExpressionNode() {
   }
@@ -43,20 +67,33 @@ class GenericMatrixExpressionNode {
     return _currentValue;
   }
   inline const matrix_t & evaluate() const {
-    evaluateImplementation();
-    /* TODO activate value caching again.
-    if (!isConstant() && _valueDirty) {
-      evaluateImplementation();
-      _valueDirty = false;
-    };*/
+    if (!isConstant()) {
+      if (!isCacheable()) {
+        ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
+        evaluateImplementation();
+        return _currentValue;
+      }
+      const std::uint64_t version = designVariablesVersion();
+      if (!isValueValid(version)) {
+        // only the first thread evaluating a new version locks
+        boost::mutex::scoped_lock lock(_valueMutex);
+        if (!isValueValid(version)) { // could be updated by another thread in the meantime
+          ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
+          evaluateImplementation();
+          _valueVersion.store(version, std::memory_order_release);
+        }
+      }
+    }
     return _currentValue;
   }
 
   void evaluateJacobians(JacobianContainer & outJacobians) const {
+    ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
     evaluateJacobiansImplementation(outJacobians, IdentityDifferential<tangent_vector_t, TScalar>());
   }
 
   void evaluateJacobians(JacobianContainer & outJacobians, const differential_t & chainRuleDifferential) const {
+    ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
     evaluateJacobiansImplementation(outJacobians, chainRuleDifferential);
   }
 
@@ -71,8 +108,17 @@ class GenericMatrixExpressionNode {
     return isConstantImplementation();
   }
 
+  /// \brief Is the value of this node cached? Only if it changes with the update counts of the design variables
+  ///        of the node alone, see isCacheableImplementation().
+  bool isCacheable() const {
+    initCaching();
+    return _isCacheable;
+  }
+
+  /// \brief Force the recomputation of the value on the next evaluate() of this node. Parent nodes still
+  ///        consider their values valid as long as their design variables did not change.
   void inline invalidate() {
-    _valueDirty = true;
+    _valueVersion.store(invalidVersion(), std::memory_order_release);
   }
 
  protected:
@@ -82,6 +128,46 @@ class GenericMatrixExpressionNode {
   virtual bool isConstantImplementation() const {
     return false;
   }
+  /// \brief Does the value only depend on design variables counting all their changes, constants and cacheable
+  ///        nodes? Operation result nodes are cacheable if all their operands are, design variables if all their
+  ///        setters invalidate their caches. Other nodes are not, as they may depend on state that is not counted.
+  virtual bool isCacheableImplementation() const {
+    return isConstant();
+  }
+
+ private:
+  /// \brief Decide whether the value is cached and collect the design variables for it. The virtual functions
+  ///        can not be called in the constructor.
+  void initCaching() const {
+    std::call_once(_cachingInitialized, [this]() {
+      _isCacheable = isCacheableImplementation();
+      if (_isCacheable) {
+        DesignVariable::set_t designVariables;
+        getDesignVariables(designVariables);
+        _designVariables.assign(designVariables.begin(), designVariables.end());
+      }
+    });
+  }
+
+  /// \brief Sum of the update counts of the design variables of this node
+  std::uint64_t designVariablesVersion() const {
+    std::uint64_t version = 0;
+    for (const DesignVariable* dv : _designVariables)
+      version += dv->updateCount();
+    return version;
+  }
+
+  /// \brief Is the value valid for \p version?
+  bool isValueValid(std::uint64_t version) const {
+    return _valueVersion.load(std::memory_order_acquire) == version;
+  }
+  static constexpr std::uint64_t invalidVersion() { return std::numeric_limits<std::uint64_t>::max(); }
+
+  mutable std::vector<const DesignVariable*> _designVariables;
+  mutable bool _isCacheable = false;
+  mutable std::once_flag _cachingInitialized;
+  mutable std::atomic<std::uint64_t> _valueVersion; /// \brief Version of the current value
+  mutable boost::mutex _valueMutex; /// \brief Mutex for value refreshes
 
  public:
   typedef ConstantGenericMatrixExpressionNode<IRows, ICols, TScalar> constant_t;
@@ -110,6 +196,12 @@ class ConstantGenericMatrixExpressionNode : public GenericMatrixExpressionNode<I
   }
 };
 
+/// \brief Is \p node cacheable? Used by the operation result nodes, found by argument dependent lookup.
+template<int IRows, int ICols, typename TScalar>
+inline bool isCacheableNode(const GenericMatrixExpressionNode<IRows, ICols, TScalar> & node) {
+  return node.isCacheable();
+}
+
 }  // namespace backend
 }  // namespace aslam
 
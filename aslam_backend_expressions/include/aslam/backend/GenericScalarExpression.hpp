@@ -12,6 +12,8 @@ namespace aslam {
     template <typename Scalar_>
     class GenericScalarExpressionNode;
     
+    /// \brief The Jacobians are evaluated with the values converted to double, e.g. the derivatives of a DualNumber
+    ///        scalar are discarded.
     template <typename Scalar_>
     class GenericScalarExpression
     {
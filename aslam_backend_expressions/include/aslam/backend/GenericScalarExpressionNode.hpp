@@ -5,6 +5,7 @@
 #include <Eigen/Core>
 #include <aslam/backend/JacobianContainer.hpp>
 #include <aslam/backend/VectorExpressionNode.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
 namespace backend {
@@ -23,10 +24,10 @@ class GenericScalarExpressionNode {
   virtual ~GenericScalarExpressionNode(){}
 
   /// \brief Evaluate the scalar matrix.
-  inline Scalar toScalar() const { return evaluateImplementation(); }
+  inline Scalar toScalar() const { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value); return evaluateImplementation(); }
 
   /// \brief Evaluate the Jacobians
-  void evaluateJacobians(JacobianContainer & outJacobians) const { evaluateJacobiansImplementation(outJacobians); }
+  void evaluateJacobians(JacobianContainer & outJacobians) const { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians); evaluateJacobiansImplementation(outJacobians); }
 
   /// \brief Evaluate the Jacobians and apply the chain rule.
   template <typename DERIVED>
@@ -17,6 +17,8 @@ namespace aslam {
     public:
       SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
       typedef Eigen::Vector4d value_t;
+      typedef HomogeneousExpressionNode node_t;
+      enum { Dimension = 4 };
 
       HomogeneousExpression();
       HomogeneousExpression(HomogeneousExpressionNode * designVariable);
@@ -38,7 +40,7 @@ namespace aslam {
       }
 
       void getDesignVariables(DesignVariable::set_t & designVariables) const;
-      boost::shared_ptr<HomogeneousExpressionNode> root() { return _root; }
+      boost::shared_ptr<HomogeneousExpressionNode> root() const { return _root; }
 
     private:
       friend class TransformationExpression;
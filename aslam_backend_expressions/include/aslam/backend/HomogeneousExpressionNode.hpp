@@ -11,6 +11,7 @@
 namespace aslam {
   namespace backend {
     class TransformationExpressionNode;
+    class ExpressionTapeBuilder;
         
     /**
      * \class HomogeneousExpressionNode
@@ -37,6 +38,9 @@ namespace aslam {
       }
 
       virtual void getDesignVariables(DesignVariable::set_t & designVariables) const;
+
+      /// \brief Compile this node into an ExpressionTape and return the slot of its value. By default the node becomes a leaf of the tape.
+      virtual int compileTape(ExpressionTapeBuilder& builder) const;
     protected:        
       // These functions must be implemented by child classes.
       virtual Eigen::Vector4d toHomogeneousImplementation() const = 0;
@@ -65,6 +69,7 @@ namespace aslam {
       Eigen::Vector4d toHomogeneousImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<TransformationExpressionNode> _lhs;
       mutable Eigen::Matrix4d _T_lhs;
@@ -102,6 +107,7 @@ namespace aslam {
       Eigen::Vector4d toHomogeneousImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<EuclideanExpressionNode> _p;
     };
@@ -8,10 +8,12 @@
 #ifndef KINEMATICCHAIN_HPP_
 #define KINEMATICCHAIN_HPP_
 
+#include <vector>
 #include <sm/boost/null_deleter.hpp>
 #include "EuclideanExpression.hpp"
 #include "RotationExpression.hpp"
 #include "ScalarExpression.hpp"
+#include "CacheExpression.hpp"
 
 namespace aslam {
 namespace backend {
@@ -49,21 +51,21 @@ class CoordinateFrame {
 
   const RotationExpression & getR_G_L() const {
     if(pp && R_G_L.isEmpty()){
-      R_G_L = pp->getR_G_L() * R_P_L;
+      R_G_L = cached(pp->getR_G_L() * R_P_L);
     }
     return R_G_L;
   }
 
   const EuclideanExpression & getOmegaG() const {
     if(pp && omegaG.isEmpty()){
-      omegaG = pp->getOmegaG() + pp->getR_G_L() * omega;
+      omegaG = cached(pp->getOmegaG() + pp->getR_G_L() * omega);
     }
     return omegaG;
   }
 
   const EuclideanExpression & getAlphaG() const {
     if(pp && alphaG.isEmpty()){
-      alphaG = pp->getAlphaG() + pp->getOmegaG().cross(pp->getR_G_L() * omega) + pp->getR_G_L() * alpha;
+      alphaG = cached(pp->getAlphaG() + pp->getOmegaG().cross(pp->getR_G_L() * omega) + pp->getR_G_L() * alpha);
     }
     return alphaG;
   }
@@ -71,7 +73,7 @@ class CoordinateFrame {
 
   const EuclideanExpression & getPG() const {
     if(pp && pG.isEmpty()){
-      pG = pp->getPG() + pp->getR_G_L() * p;
+      pG = cached(pp->getPG() + pp->getR_G_L() * p);
     }
     return pG;
   }
@@ -98,14 +100,67 @@ class CoordinateFrame {
   const EuclideanExpression & getAlphaP() const {
     return alpha;
   }
+
+  /**
+   * \brief Build all global expressions of this frame as cache expressions.
+   *
+   * The global expressions of child frames built afterwards then compose the cached values and Jacobians
+   * instead of re-walking the expressions of all ancestors.
+   */
+  void cacheGlobals();
+  bool isCachingGlobals() const {
+    return _cacheGlobals;
+  }
+  /// \brief Bring the caches of the global expressions up to date, requires cacheGlobals()
+  void updateGlobalCaches() const;
+
  private:
   void initGlobalsWithoutParent();
+  template <typename Expression>
+  Expression cached(const Expression & e) const {
+    return (_cacheGlobals && !e.isEmpty() && !dynamic_cast<const CacheInterface*>(e.root().get())) ? toCacheExpression(e) : e;
+  }
 
   boost::shared_ptr<const CoordinateFrame> pp;
   mutable RotationExpression R_G_L;
   RotationExpression R_P_L; // converting coordinates from to this to global or parent frame
   EuclideanExpression p, v, a, omega, alpha;
   mutable EuclideanExpression pG, vG, aG, omegaG, alphaG;
+  bool _cacheGlobals = false;
+};
+
+/**
+ * \class KinematicTree
+ *
+ * \brief Evaluates the global poses, velocities and accelerations of a tree of coordinate frames once per update
+ * of the design variables.
+ *
+ * The frames cache their global expressions, which error terms use as leaves. evaluate() brings all caches up to
+ * date in topological order, in parallel across independent subtrees, e.g. from a
+ * callback::event::DESIGN_VARIABLES_UPDATED callback of the optimizer. Caches not updated that way are updated
+ * lazily by the first error term using them.
+ */
+class KinematicTree {
+ public:
+  /**
+   * \brief Add \p frame and cache its global expressions.
+   *
+   * The parent of \p frame must have been added before. Frames must be added before expressions of their children
+   * are built and must outlive the tree.
+   */
+  void addFrame(CoordinateFrame & frame);
+
+  std::size_t numFrames() const {
+    return _frames.size();
+  }
+
+  /// \brief Update the caches of all frames using \p nThreads threads
+  void evaluate(std::size_t nThreads = 1) const;
+
+ private:
+  std::vector<const CoordinateFrame*> _frames; /// \brief In topological order
+  std::vector<std::vector<std::size_t> > _children;
+  std::vector<std::size_t> _roots;
 };
 
 
@@ -9,12 +9,13 @@
 #define INCLUDE_ASLAM_BACKEND_L1REGULARIZER_HPP_
 
 #include <aslam/backend/ScalarNonSquaredErrorTerm.hpp>
+#include <aslam/backend/L1NormInterface.hpp>
 #include <aslam/backend/Scalar.hpp>
 
 namespace aslam {
 namespace backend {
 
-class L1Regularizer : public aslam::backend::ScalarNonSquaredErrorTerm {
+class L1Regularizer : public aslam::backend::ScalarNonSquaredErrorTerm, public aslam::backend::L1NormInterface {
 
  public:
   L1Regularizer(const std::vector<Scalar*>& scalarDvs, const double beta);
@@ -22,6 +23,9 @@ class L1Regularizer : public aslam::backend::ScalarNonSquaredErrorTerm {
 
   void setBeta(const double beta) { setWeight(beta); }
 
+  /// \brief The weight of the L1 norm, used by OptimizerOWLQN
+  double getL1NormWeight() const override { return getWeight(); }
+
  private:
   /// \brief evaluate the error term and return the scalar error \f$ e \f$
   double evaluateErrorImplementation() override;
@@ -27,7 +27,7 @@ namespace aslam {
 
       EuclideanExpression toExpression();
 
-        void set(const Eigen::Vector3d & p){ _p = p; _p_p = _p; }
+        void set(const Eigen::Vector3d & p){ _p = p; _p_p = _p; invalidateCache(); }
     private:
       Eigen::Vector3d evaluateImplementation() const override;
 
@@ -29,7 +29,7 @@ namespace aslam {
 
       RotationExpression toExpression();
 
-      void set( const Eigen::Vector4d & q){ _q = q; _p_q = q; }
+      void set( const Eigen::Vector4d & q){ _q = q; _p_q = q; invalidateCache(); }
     private:
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
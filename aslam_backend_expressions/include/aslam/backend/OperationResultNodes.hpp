@@ -8,6 +8,12 @@ namespace aslam {
 namespace backend {
   class ScalarExpressionNode;
 
+/// \brief Operand nodes are only cacheable if they tell so, see GenericMatrixExpressionNode::isCacheable().
+template <typename Node>
+inline bool isCacheableNode(const Node & /* node */) {
+  return false;
+}
+
 namespace internal {
   template <typename Node>
   struct NodeTraits {
@@ -62,6 +68,10 @@ class UnaryOperationResultNodeBase : public TResult::node_t {
   virtual void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override {
     _operand->getDesignVariables(designVariables);
   }
+  /// \brief Overrides GenericMatrixExpressionNode::isCacheableImplementation() for generic matrix results
+  virtual bool isCacheableImplementation() const {
+    return isCacheableNode(*_operand);
+  }
   void evaluateJacobiansWithApplyDiff(JacobianContainer & outJacobians, const typename node_traits_t::differential_t & chainRuleDifferentail) const {
     this->getOperandNode().evaluateJacobians(outJacobians, Diff(*static_cast<const TDerived *>(this), chainRuleDifferentail));
   }
@@ -157,6 +167,10 @@ class BinaryOperationResultNode : public TResult::node_t {
     _lhs->getDesignVariables(designVariables);
     _rhs->getDesignVariables(designVariables);
   }
+  /// \brief Overrides GenericMatrixExpressionNode::isCacheableImplementation() for generic matrix results
+  virtual bool isCacheableImplementation() const {
+    return isCacheableNode(*_lhs) && isCacheableNode(*_rhs);
+  }
   virtual void evaluateJacobiansImplementation(JacobianContainer & outJacobians, const typename node_traits_t::differential_t & diff) const {
     this->getLhsNode().evaluateJacobians(outJacobians, Diff<lhs_t, &TDerived::applyLhsDiff>(*static_cast<const TDerived *>(this), diff));
     this->getRhsNode().evaluateJacobians(outJacobians, Diff<rhs_t, &TDerived::applyRhsDiff>(*static_cast<const TDerived *>(this), diff));
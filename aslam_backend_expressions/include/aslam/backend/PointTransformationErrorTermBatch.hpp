@@ -0,0 +1,127 @@
+#ifndef ASLAM_BACKEND_POINT_TRANSFORMATION_ERROR_TERM_BATCH_HPP
+#define ASLAM_BACKEND_POINT_TRANSFORMATION_ERROR_TERM_BATCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/ErrorTermBatch.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    class RotationQuaternion;
+    class EuclideanPoint;
+
+    /**
+     * \class PointTransformationErrorTermBatch
+     *
+     * \brief A batch of error terms \f$ \mathbf e_i = \mathbf C_k \mathbf p_j + \mathbf t_k - \mathbf y_i \f$
+     *        between poses \f$ (\mathbf C_k, \mathbf t_k) \f$, points \f$ \mathbf p_j \f$ and measurements \f$ \mathbf y_i \f$.
+     *
+     * The error terms are equivalent to ExpressionErrorTerm<EuclideanExpression> of C.toExpression() * p.toExpression()
+     * + t.toExpression() - y, without building and traversing an expression tree per error term. The batch stores
+     * the pose and point indices and the measurements of its error terms as structure of arrays. The errors and the
+     * weighted Jacobians of the runs handed to it by the linear system solvers are evaluated BlockSize error terms at
+     * a time with vectorized kernels.
+     *
+     * The poses and points are referenced by index and must outlive the batch, the batch must outlive its error terms.
+     */
+    class PointTransformationErrorTermBatch : public ErrorTermBatch
+    {
+     public:
+      SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
+
+      /// \brief Number of error terms evaluated by one kernel call
+      enum { BlockSize = 4 };
+
+      /// \brief An error term of the batch
+      class Member : public ErrorTermFs<3>
+      {
+       public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        Member(PointTransformationErrorTermBatch& batch, std::size_t index, const Eigen::Matrix3d& invR);
+
+       protected:
+        double evaluateErrorImplementation() override;
+        void evaluateJacobiansImplementation(JacobianContainer& outJacobians) override;
+
+       private:
+        PointTransformationErrorTermBatch& _batch;
+      };
+      typedef boost::shared_ptr<Member> MemberPtr;
+
+      PointTransformationErrorTermBatch() = default;
+      PointTransformationErrorTermBatch(const PointTransformationErrorTermBatch&) = delete;
+      void operator=(const PointTransformationErrorTermBatch&) = delete;
+
+      /// \brief Add a pose and return its index
+      std::size_t addPose(RotationQuaternion* rotation, EuclideanPoint* translation);
+
+      /// \brief Add a point and return its index
+      std::size_t addPoint(EuclideanPoint* point);
+
+      /// \brief Add the error term between pose \p pose and point \p point measured as \p measurement
+      MemberPtr addErrorTerm(std::size_t pose, std::size_t point, const Eigen::Vector3d& measurement,
+                             const Eigen::Matrix3d& invR = Eigen::Matrix3d::Identity());
+
+      /// \brief Reserve space for \p numErrorTerms error terms
+      void reserve(std::size_t numErrorTerms);
+
+      std::size_t numErrorTerms() const override { return _members.size(); }
+      std::size_t numPoses() const { return _poses.size(); }
+      std::size_t numPoints() const { return _points.size(); }
+
+      /// \brief The error term \p i
+      const MemberPtr& errorTerm(std::size_t i) const;
+
+      /// \brief Evaluate the error terms [begin, end), BlockSize at a time
+      void prefetchErrors(std::size_t begin, std::size_t end) override;
+
+      bool hasBatchJacobians() const override { return true; }
+
+      /// \brief Evaluate the weighted Jacobians of the error terms [begin, end), BlockSize at a time
+      void evaluateJacobians(std::size_t begin, std::size_t end, bool useMEstimator, JacobianSink& sink) override;
+
+     private:
+      typedef std::uint64_t version_t;
+
+      struct Pose {
+        RotationQuaternion* rotation;
+        EuclideanPoint* translation;
+      };
+
+      /// \brief The sum of the update counts of the design variables of error term \p i
+      version_t currentVersion(std::size_t i) const;
+      /// \brief Evaluate error term \p i unless its values are up to date
+      void update(std::size_t i);
+      /// \brief Evaluate error term \p i on its own
+      void evaluate(std::size_t i);
+      /// \brief The square root of the MEstimator weight of error term \p i times the transpose of its sqrtInvR()
+      Eigen::Matrix3d weight(std::size_t i, bool useMEstimator) const;
+      /// \brief Evaluate the weighted Jacobian of error term \p i on its own and pass it to \p sink
+      void evaluateJacobian(std::size_t i, bool useMEstimator, JacobianSink& sink) const;
+
+      std::vector<Pose> _poses;
+      std::vector<EuclideanPoint*> _points;
+      std::vector<MemberPtr> _members;
+
+      /// \brief Inputs of the error terms, the measurements per coordinate
+      std::vector<std::uint32_t> _poseIndices;
+      std::vector<std::uint32_t> _pointIndices;
+      std::vector<double> _measurements[3];
+
+      /// \brief Results of the error terms: the rotated point, the error per coordinate and the version they were computed for
+      std::vector<double> _rotatedPoints[3];
+      std::vector<double> _errors[3];
+      std::vector<version_t> _versions;
+    };
+
+  } // namespace backend
+} // namespace aslam
+
+#endif /* ASLAM_BACKEND_POINT_TRANSFORMATION_ERROR_TERM_BATCH_HPP */
@@ -22,6 +22,9 @@ namespace aslam {
     {
     public:
         SM_DEFINE_EXCEPTION(Exception, std::runtime_error);
+      typedef Eigen::Matrix3d value_t;
+      typedef RotationExpressionNode node_t;
+      enum { Dimension = 3 }; ///< dimension of the tangent space
 
       /// \brief initialize an empty expression.
       RotationExpression() {}
@@ -7,10 +7,12 @@
 #include <boost/shared_ptr.hpp>
 #include <set>
 #include <aslam/backend/TransformationExpressionNode.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
   namespace backend {
     class ExpressionNodeVisitor;
+    class ExpressionTapeBuilder;
 
     /**
      * \class RotationExpressionNode
@@ -25,11 +27,11 @@ namespace aslam {
       virtual ~RotationExpressionNode();
 
       /// \brief Evaluate the rotation matrix.
-      EIGEN_ALWAYS_INLINE Eigen::Matrix3d evaluate() const { return toRotationMatrixImplementation(); }
-      EIGEN_ALWAYS_INLINE Eigen::Matrix3d toRotationMatrix() const { return toRotationMatrixImplementation(); }
+      EIGEN_ALWAYS_INLINE Eigen::Matrix3d evaluate() const { return toRotationMatrix(); }
+      EIGEN_ALWAYS_INLINE Eigen::Matrix3d toRotationMatrix() const { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value); return toRotationMatrixImplementation(); }
       
       /// \brief Evaluate the Jacobians
-      EIGEN_ALWAYS_INLINE void evaluateJacobians(JacobianContainer & outJacobians) const { evaluateJacobiansImplementation(outJacobians); }
+      EIGEN_ALWAYS_INLINE void evaluateJacobians(JacobianContainer & outJacobians) const { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians); evaluateJacobiansImplementation(outJacobians); }
     
       /// \brief Evaluate the Jacobians and apply the chain rule.
       /** The chain rule matrix is assumed to be calculated in the left exponential chart centered at the current value (Phi(w)=Phi_R(w):= exp(w) R)),
@@ -53,6 +55,9 @@ namespace aslam {
 
       void getDesignVariables(DesignVariable::set_t & designVariables) const;
 
+      /// \brief Compile this node into an ExpressionTape and return the slot of its value. By default the node becomes a leaf of the tape.
+      virtual int compileTape(ExpressionTapeBuilder& builder) const;
+
       virtual void accept(ExpressionNodeVisitor& visitor);  //TODO make pure and complete nodes
     protected:        
       // These functions must be implemented by child classes.
@@ -79,6 +84,7 @@ namespace aslam {
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       const Eigen::Matrix3d _C;
     };
@@ -102,6 +108,7 @@ namespace aslam {
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<RotationExpressionNode> _lhs;
       mutable Eigen::Matrix3d _C_lhs;
@@ -127,6 +134,7 @@ namespace aslam {
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<RotationExpressionNode> _dvRotation;
       mutable Eigen::Matrix3d _C;
@@ -143,6 +151,7 @@ namespace aslam {
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<TransformationExpressionNode> _transformation;
     };
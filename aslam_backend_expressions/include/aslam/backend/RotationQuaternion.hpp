@@ -41,6 +41,7 @@ namespace aslam {
       void set(const Eigen::Vector4d & q) {
         _q = q; _p_q = q;
         _C = sm::kinematics::quat2r(q);
+        invalidateCache();
       }
     private:
       Eigen::Matrix3d toRotationMatrixImplementation() const override;
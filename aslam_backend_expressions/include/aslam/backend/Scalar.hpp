@@ -32,7 +32,7 @@ class Scalar : public ScalarExpressionNode, public DesignVariable {
   Eigen::MatrixXd getParameters();
 
   double getValue() const { return _p; }
-  void setValue(double p) { _p = p; }
+  void setValue(double p) { _p = p; invalidateCache(); }
  private:
   double evaluateImplementation() const override;
 
@@ -5,10 +5,13 @@
 #include <boost/shared_ptr.hpp>
 #include <Eigen/Core>
 #include <aslam/backend/VectorExpressionNode.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
   namespace backend {
     class ExpressionNodeVisitor;
+    class ExpressionTapeBuilder;
 
     /**
      * \class ScalarExpressionNode
@@ -42,6 +45,9 @@ namespace aslam {
 
       void getDesignVariables(DesignVariable::set_t & designVariables) const;
 
+      /// \brief Compile this node into an ExpressionTape and return the slot of its value. By default the node becomes a leaf of the tape.
+      virtual int compileTape(ExpressionTapeBuilder& builder) const;
+
       virtual void accept(ExpressionNodeVisitor& visitor);  //TODO make pure and complete nodes
     protected:
       // These functions must be implemented by child classes.
@@ -64,6 +70,7 @@ namespace aslam {
           inline double evaluateImplementation() const override;
           inline void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
           void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           boost::shared_ptr<ScalarExpressionNode> _lhs;
           boost::shared_ptr<ScalarExpressionNode> _rhs;
@@ -81,6 +88,7 @@ namespace aslam {
           inline double evaluateImplementation() const override;
           inline void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
           void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           boost::shared_ptr<ScalarExpressionNode> _lhs;
           boost::shared_ptr<ScalarExpressionNode> _rhs;
@@ -98,6 +106,7 @@ namespace aslam {
           inline double evaluateImplementation() const override;
           inline void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
           void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           boost::shared_ptr<ScalarExpressionNode> _rhs;
     };
@@ -115,6 +124,7 @@ namespace aslam {
           inline double evaluateImplementation() const override;
           inline void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
           void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           boost::shared_ptr<ScalarExpressionNode> _lhs;
           boost::shared_ptr<ScalarExpressionNode> _rhs;
@@ -133,6 +143,7 @@ namespace aslam {
           double evaluateImplementation() const override{return _s;}
           void evaluateJacobiansImplementation(JacobianContainer & /* outJacobians */) const override{}
           void getDesignVariablesImplementation(DesignVariable::set_t & /* designVariables */) const override{}
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           double _s;
       };
@@ -327,6 +338,7 @@ namespace aslam {
           double evaluateImplementation() const override;
           void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
           void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+          int compileTape(ExpressionTapeBuilder& builder) const override;
 
           boost::shared_ptr<VectorExpressionNode<VectorSize> > _lhs;
       };
@@ -353,6 +365,16 @@ namespace aslam {
         _lhs->getDesignVariables(designVariables);
     }
 
+    template <int VectorDim, int ComponentIndex>
+    int ScalarExpressionNodeFromVectorExpression<VectorDim, ComponentIndex>::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      if(!_lhs)
+        return builder.addConstant(0.0);
+      if(VectorDim != 3)
+        return builder.addLeaf(this);
+      return builder.addOperation(ExpressionTape::SCALAR_FROM_EUCLIDEAN, builder.compile(_lhs), -1, ComponentIndex);
+    }
+
   } // namespace backend
 } // namespace aslam
 
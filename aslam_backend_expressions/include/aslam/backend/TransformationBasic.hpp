@@ -22,6 +22,7 @@ namespace aslam {
       Eigen::Matrix4d toTransformationMatrixImplementation() override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       RotationExpression toRotationExpression(const boost::shared_ptr<TransformationExpressionNode> & thisShared) const override;
       EuclideanExpression toEuclideanExpression(const boost::shared_ptr<TransformationExpressionNode> & thisShared) const override;
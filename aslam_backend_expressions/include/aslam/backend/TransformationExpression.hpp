@@ -20,6 +20,9 @@ namespace aslam {
 
     class TransformationExpression {
     public:
+      typedef TransformationExpressionNode node_t;
+      enum { Dimension = 6 }; ///< dimension of the tangent space
+
       TransformationExpression();
       TransformationExpression(const RotationExpression & rotation, const EuclideanExpression & translation);
       TransformationExpression(TransformationExpressionNode * root);
@@ -51,7 +54,7 @@ namespace aslam {
 
       void getDesignVariables(DesignVariable::set_t & designVariables) const;
 
-      boost::shared_ptr<TransformationExpressionNode> root(){ return _root; }
+      boost::shared_ptr<TransformationExpressionNode> root() const { return _root; }
 
       virtual void accept(ExpressionNodeVisitor& visitor) const;
     private:
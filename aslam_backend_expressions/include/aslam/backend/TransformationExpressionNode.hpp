@@ -4,6 +4,7 @@
 #include <Eigen/Core>
 #include <aslam/backend/JacobianContainer.hpp>
 #include <boost/shared_ptr.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 #include <set>
 
 namespace aslam {
@@ -11,6 +12,7 @@ namespace aslam {
     class EuclideanExpression;
     class RotationExpression;
     class ExpressionNodeVisitor;
+    class ExpressionTapeBuilder;
 
     class TransformationExpressionNode {
     public:
@@ -18,8 +20,8 @@ namespace aslam {
       virtual ~TransformationExpressionNode();
 
       /// \brief Evaluate the transformation matrix.
-      Eigen::Matrix4d evaluate() { return toTransformationMatrixImplementation(); }
-      Eigen::Matrix4d toTransformationMatrix() { return toTransformationMatrixImplementation(); }
+      Eigen::Matrix4d evaluate() { return toTransformationMatrix(); }
+      Eigen::Matrix4d toTransformationMatrix() { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value); return toTransformationMatrixImplementation(); }
 
       /// \brief Evaluate the Jacobians
       void evaluateJacobians(JacobianContainer & outJacobians) const;
@@ -29,6 +31,9 @@ namespace aslam {
       }
       void getDesignVariables(DesignVariable::set_t & designVariables) const;
 
+      /// \brief Compile this node into an ExpressionTape and return the slot of its value. By default the node becomes a leaf of the tape.
+      virtual int compileTape(ExpressionTapeBuilder& builder) const;
+
       virtual void accept(ExpressionNodeVisitor& visitor); //TODO make pure and complete nodes
     protected:
       // These functions must be implemented by child classes.
@@ -63,6 +68,7 @@ namespace aslam {
       Eigen::Matrix4d toTransformationMatrixImplementation() override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<TransformationExpressionNode> _lhs;
       Eigen::Matrix4d _T_lhs;
@@ -91,6 +97,7 @@ namespace aslam {
       Eigen::Matrix4d toTransformationMatrixImplementation() override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       boost::shared_ptr<TransformationExpressionNode> _dvTransformation;
       Eigen::Matrix4d _T;
@@ -116,6 +123,7 @@ namespace aslam {
       Eigen::Matrix4d toTransformationMatrixImplementation() override;
       void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const override;
       void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override;
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
 
       Eigen::Matrix4d _T;
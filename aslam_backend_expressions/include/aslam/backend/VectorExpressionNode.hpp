@@ -3,10 +3,12 @@
 #include <aslam/backend/JacobianContainer.hpp>
 #include <aslam/backend/Differential.hpp>
 #include <aslam/backend/ExpressionNodeVisitor.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
   namespace backend {
-    
+    class ExpressionTapeBuilder;
+
     template<int D>
     class VectorExpressionNode
     {
@@ -18,7 +20,7 @@ namespace aslam {
       VectorExpressionNode() = default;
       virtual ~VectorExpressionNode() = default;
       
-      vector_t evaluate() const { return evaluateImplementation(); }
+      vector_t evaluate() const { ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value); return evaluateImplementation(); }
       vector_t toVector() const { return evaluate(); }
       
       void evaluateJacobians(JacobianContainer & outJacobians) const;
@@ -32,6 +34,10 @@ namespace aslam {
 
       virtual int getSize() const { assert(D != Eigen::Dynamic); return D; }
 
+      /// \brief Compile this node into an ExpressionTape and return the slot of its value. By default the node becomes a leaf of the tape.
+      /// Only three dimensional vectors can be compiled.
+      virtual int compileTape(ExpressionTapeBuilder& builder) const;
+
       virtual void accept(ExpressionNodeVisitor& visitor) { visitor.visit("V", this); }; //TODO make pure and complete nodes
     private:
       virtual vector_t evaluateImplementation() const = 0;
@@ -58,6 +64,7 @@ namespace aslam {
 
       ~ConstantVectorExpressionNode() override = default;
       int getSize() const override { return value.rows(); }
+      int compileTape(ExpressionTapeBuilder& builder) const override;
 
       void accept(ExpressionNodeVisitor& visitor) override;
      private:
@@ -0,0 +1,71 @@
+namespace aslam {
+namespace backend {
+
+#define _CLASS AutoDiffErrorTerm<D, Functor, N>
+#define MEMBER(RET, DECL) template<int D, typename Functor, int N> RET _CLASS::DECL
+
+MEMBER(,AutoDiffErrorTerm(const Functor & functor, const std::vector<DesignVariable*> & designVariables))
+    : _functor(functor),
+      _parameterPointers(designVariables.size()),
+      _dualParameterPointers(designVariables.size())
+{
+  this->setDesignVariables(designVariables);
+  _offsets.push_back(0);
+  for (DesignVariable* dv : designVariables) {
+    dv->getParameters(_designVariableParameters);
+    SM_ASSERT_EQ(aslam::InvalidArgumentException, _designVariableParameters.size(), dv->minimalDimensions(),
+                 "AutoDiffErrorTerm requires design variables updated additively in their parameters");
+    _offsets.push_back(_offsets.back() + dv->minimalDimensions());
+  }
+  SM_ASSERT_TRUE(aslam::InvalidArgumentException, N == Eigen::Dynamic || N == _offsets.back(),
+                 "N must be the sum of the minimal dimensions of the design variables, " << _offsets.back());
+  _parameters.resize(_offsets.back());
+  _dualParameters.resize(_offsets.back());
+}
+
+MEMBER(void, getParameters()) {
+  for (std::size_t i = 0; i < this->numDesignVariables(); ++i) {
+    this->designVariable(i)->getParameters(_designVariableParameters);
+    _parameters.segment(_offsets[i], _offsets[i + 1] - _offsets[i]) = Eigen::Map<const Eigen::VectorXd>(_designVariableParameters.data(), _designVariableParameters.size());
+    _parameterPointers[i] = _parameters.data() + _offsets[i];
+    _dualParameterPointers[i] = _dualParameters.data() + _offsets[i];
+  }
+}
+
+MEMBER(double, evaluateErrorImplementation()) {
+  getParameters();
+  typename parent_t::error_t error;
+  _functor(_parameterPointers.data(), error.data());
+  this->setError(error);
+  return this->evaluateChiSquaredError();
+}
+
+MEMBER(void, evaluateJacobiansImplementation(JacobianContainer & outJacobians)) {
+  getParameters();
+  const int n = numDerivatives();
+  for (int k = 0; k < n; ++k)
+    _dualParameters[k] = dual_t::variable(_parameters[k], k, n);
+
+  dual_t error[D];
+  _functor(_dualParameterPointers.data(), error);
+
+  // The value comes for free with the derivatives
+  typename parent_t::error_t value;
+  Eigen::Matrix<double, D, N> J(D, n);
+  for (int r = 0; r < D; ++r) {
+    value[r] = error[r].value();
+    if (error[r].derivatives().size() == 0)
+      J.row(r).setZero();
+    else
+      J.row(r) = error[r].derivatives().transpose();
+  }
+  this->setError(value);
+
+  for (std::size_t i = 0; i < this->numDesignVariables(); ++i)
+    outJacobians.add(this->designVariable(i), J.middleCols(_offsets[i], _offsets[i + 1] - _offsets[i]));
+}
+
+#undef MEMBER
+#undef _CLASS
+}  // namespace backend
+}  // namespace aslam
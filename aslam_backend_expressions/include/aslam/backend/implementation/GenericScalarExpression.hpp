@@ -109,8 +109,8 @@ class GenericScalarExpressionNodeMultiply : public GSEBinRes<Scalar_> {
   }
 
   void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    this->_lhs->evaluateJacobians(outJacobians.apply(this->_rhs->toScalar()));
-    this->_rhs->evaluateJacobians(outJacobians.apply(this->_lhs->toScalar()));
+    this->_lhs->evaluateJacobians(outJacobians.apply(static_cast<double>(this->_rhs->toScalar())));
+    this->_rhs->evaluateJacobians(outJacobians.apply(static_cast<double>(this->_lhs->toScalar())));
   }
 };
 
@@ -128,8 +128,8 @@ class GenericScalarExpressionNodeDivide : public GSEBinRes<Scalar_> {
   }
 
   void evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    this->_lhs->evaluateJacobians(outJacobians.apply(-this->_lhs->toScalar() / (this->_rhs->toScalar() * this->_rhs->toScalar())));
-    this->_rhs->evaluateJacobians(outJacobians.apply(1.0 / this->_rhs->toScalar()));
+    this->_lhs->evaluateJacobians(outJacobians.apply(static_cast<double>(-this->_lhs->toScalar() / (this->_rhs->toScalar() * this->_rhs->toScalar()))));
+    this->_rhs->evaluateJacobians(outJacobians.apply(static_cast<double>(1.0 / this->_rhs->toScalar())));
   }
 };
 
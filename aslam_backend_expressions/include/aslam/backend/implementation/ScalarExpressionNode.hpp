@@ -17,12 +17,14 @@ namespace backend {
 /// \brief Evaluate the scalar matrix.
 double ScalarExpressionNode::toScalar() const
 {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
   return evaluateImplementation();
 }
 
 /// \brief Evaluate the Jacobians
 void ScalarExpressionNode::evaluateJacobians(JacobianContainer & outJacobians) const
 {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
   evaluateJacobiansImplementation(outJacobians);
 }
 
@@ -1,14 +1,18 @@
 
+#include <aslam/backend/ExpressionTape.hpp>
+
 namespace aslam {
 namespace backend {
 
 template<int D>
 void VectorExpressionNode<D>::evaluateJacobians(JacobianContainer & outJacobians) const {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
   evaluateJacobiansImplementation(outJacobians);
 }
 
 template<int D>
 void VectorExpressionNode<D>::evaluateJacobians(JacobianContainer & outJacobians, const differential_t & diff) const {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
   evaluateJacobiansImplementationWithDifferential(outJacobians, diff);
 }
 
@@ -27,6 +31,21 @@ void ConstantVectorExpressionNode<D>::accept(ExpressionNodeVisitor& visitor) {
   visitor.visit("#", this);
 }
 
+template<int D>
+int VectorExpressionNode<D>::compileTape(ExpressionTapeBuilder& builder) const {
+  return builder.addLeaf(this);
+}
+
+template<int D>
+int ConstantVectorExpressionNode<D>::compileTape(ExpressionTapeBuilder& builder) const {
+  return VectorExpressionNode<D>::compileTape(builder);
+}
+
+template<>
+inline int ConstantVectorExpressionNode<3>::compileTape(ExpressionTapeBuilder& builder) const {
+  return builder.addConstant(value);
+}
+
 
 }  // namespace backend
 }  // namespace aslam
@@ -59,8 +59,7 @@ namespace aslam {
 
         void EuclideanDirection::evaluateJacobiansImplementation(JacobianContainer & outJacobians) const
         {
-            Eigen::MatrixXd J(3,2);
-            J.setZero();
+            Eigen::Matrix<double, 3, 2> J;
             J.col(0) = -_C.col(0) * _magnitude;
             J.col(1) = _C.col(1) * _magnitude;
             outJacobians.add(const_cast<EuclideanDirection*>(this), J);
@@ -3,6 +3,7 @@
 #include <sm/kinematics/rotations.hpp>
 #include <sm/kinematics/homogeneous_coordinates.hpp>
 #include <aslam/backend/HomogeneousExpressionNode.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 namespace aslam {
   namespace backend {
       
@@ -265,7 +266,7 @@ namespace aslam {
   }
 
   void EuclideanExpressionNodeTranslation::evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    Eigen::MatrixXd J = Eigen::MatrixXd::Identity(3,6);
+    Eigen::Matrix<double, 3, 6> J = Eigen::Matrix<double, 3, 6>::Identity();
     Eigen::Vector3d p = _operand->toTransformationMatrix().topRightCorner<3,1>();
     J.topRightCorner<3,3>() = sm::kinematics::crossMx(p);
     _operand->evaluateJacobians(outJacobians, J);
@@ -292,7 +293,7 @@ namespace aslam {
   }
 
   void EuclideanExpressionNodeRotationParameters::evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    Eigen::MatrixXd J = _rk->parametersToSMatrix(
+    Eigen::Matrix3d J = _rk->parametersToSMatrix(
         _rk->rotationMatrixToParameters(_operand->toRotationMatrix())).inverse();
     _operand->evaluateJacobians(outJacobians,J);
 
@@ -363,6 +364,42 @@ namespace aslam {
     void EuclideanExpressionNodeAddEuclidean::accept(ExpressionNodeVisitor& visitor) {
       visitor.visit("+", this, _lhs, _rhs);
     }
+
+    int EuclideanExpressionNodeMultiply::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_ROTATE, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
+    int EuclideanExpressionNodeCrossEuclidean::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_CROSS, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
+    int EuclideanExpressionNodeAddEuclidean::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_ADD, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
+    int EuclideanExpressionNodeSubtractEuclidean::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_SUBTRACT, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
+    int EuclideanExpressionNodeSubtractVector::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_SUBTRACT, builder.compile(_lhs), builder.addConstant(_rhs));
+    }
+
+    int EuclideanExpressionNodeNegated::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_NEGATE, builder.compile(_operand));
+    }
+
+    int EuclideanExpressionNodeScalarMultiply::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_SCALE, builder.compile(_p), builder.compile(_s));
+    }
+
+    int EuclideanExpressionNodeTranslation::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_TRANSLATION, builder.compile(_operand));
+    }
+
+    int EuclideanExpressionNodeFromHomogeneous::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::EUCLIDEAN_FROM_HOMOGENEOUS, builder.compile(_root));
+    }
   } // namespace backend
 }  // namespace aslam
 
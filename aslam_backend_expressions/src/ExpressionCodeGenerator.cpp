@@ -0,0 +1,424 @@
+#include <aslam/backend/ExpressionCodeGenerator.hpp>
+
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/VectorExpression.hpp>
+#include <aslam/backend/HomogeneousExpression.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    namespace {
+
+      typedef ExpressionTape Tape;
+
+      const char* valueTypeName(Tape::ValueType type)
+      {
+        switch (type) {
+          case Tape::SCALAR: return "double";
+          case Tape::EUCLIDEAN: return "Eigen::Vector3d";
+          case Tape::HOMOGENEOUS: return "Eigen::Vector4d";
+          case Tape::ROTATION: return "Eigen::Matrix3d";
+          case Tape::TRANSFORMATION: return "Eigen::Matrix4d";
+        }
+        return "";
+      }
+
+      std::string adjointTypeName(int rows, Tape::ValueType type)
+      {
+        std::ostringstream s;
+        s << "Eigen::Matrix<double, " << rows << ", " << Tape::tangentSize(type) << ">";
+        return s.str();
+      }
+
+      std::string v(int slot) { return "v" + std::to_string(slot); }
+      std::string a(int slot) { return "a" + std::to_string(slot); }
+
+      /// \brief A double literal which round trips
+      std::string number(double value)
+      {
+        std::ostringstream s;
+        s << std::setprecision(17) << value;
+        std::string str = s.str();
+        if (str.find_first_of(".en") == std::string::npos)
+          str += ".0";
+        return str;
+      }
+
+    } // namespace anonymous
+
+    ExpressionCodeGenerator::ExpressionCodeGenerator(const std::string& nameSpace) : _nameSpace(nameSpace)
+    {
+
+    }
+
+    void ExpressionCodeGenerator::addErrorTerm(const std::string& className, const ScalarExpression& expression)
+    {
+      addErrorTerm(className, *ExpressionTape::compile(expression), "aslam::backend::ScalarExpression");
+    }
+
+    void ExpressionCodeGenerator::addErrorTerm(const std::string& className, const VectorExpression<3>& expression)
+    {
+      addErrorTerm(className, *ExpressionTape::compile(expression), "aslam::backend::VectorExpression<3>");
+    }
+
+    void ExpressionCodeGenerator::addErrorTerm(const std::string& className, const HomogeneousExpression& expression)
+    {
+      addErrorTerm(className, *ExpressionTape::compile(expression), "aslam::backend::HomogeneousExpression");
+    }
+
+    void ExpressionCodeGenerator::addErrorTerm(const std::string& className, const ExpressionTape& tape, const std::string& expressionType)
+    {
+      std::ostringstream s;
+      generateErrorTerm(tape, className, expressionType, s);
+      _classes.push_back(s.str());
+    }
+
+    void ExpressionCodeGenerator::writeHeader(std::ostream& out, const std::string& includeGuard) const
+    {
+      out << "// This file was generated by aslam::backend::ExpressionCodeGenerator. Do not edit.\n"
+          << "#ifndef " << includeGuard << "\n"
+          << "#define " << includeGuard << "\n\n"
+          << "#include <Eigen/Dense>\n\n"
+          << "#include <sm/assert_macros.hpp>\n"
+          << "#include <sm/kinematics/rotations.hpp>\n"
+          << "#include <sm/kinematics/transformations.hpp>\n"
+          << "#include <sm/kinematics/homogeneous_coordinates.hpp>\n\n"
+          << "#include <aslam/backend/ErrorTerm.hpp>\n"
+          << "#include <aslam/backend/ExpressionTape.hpp>\n"
+          << "#include <aslam/backend/ScalarExpression.hpp>\n"
+          << "#include <aslam/backend/VectorExpression.hpp>\n"
+          << "#include <aslam/backend/HomogeneousExpression.hpp>\n\n";
+
+      std::vector<std::string> namespaces;
+      for (std::size_t begin = 0; !_nameSpace.empty() && begin != std::string::npos; ) {
+        const std::size_t end = _nameSpace.find("::", begin);
+        namespaces.push_back(_nameSpace.substr(begin, end == std::string::npos ? end : end - begin));
+        begin = end == std::string::npos ? end : end + 2;
+      }
+      for (const std::string& ns : namespaces)
+        out << "namespace " << ns << " {\n";
+      if (!namespaces.empty())
+        out << "\n";
+
+      for (const std::string& c : _classes)
+        out << c << "\n";
+
+      for (auto it = namespaces.rbegin(); it != namespaces.rend(); ++it)
+        out << "} // namespace " << *it << "\n";
+      out << "\n#endif /* " << includeGuard << " */\n";
+    }
+
+    void ExpressionCodeGenerator::writeHeader(const std::string& fileName) const
+    {
+      std::string guard;
+      const std::size_t begin = fileName.find_last_of("/\\");
+      for (char c : fileName.substr(begin == std::string::npos ? 0 : begin + 1))
+        guard += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : '_';
+      guard += "_GENERATED";
+
+      std::ofstream out(fileName.c_str());
+      SM_ASSERT_TRUE(Exception, out.good(), "Cannot open " << fileName << " for writing");
+      writeHeader(out, guard);
+      SM_ASSERT_TRUE(Exception, out.good(), "Failed to write " << fileName);
+    }
+
+    void ExpressionCodeGenerator::generateErrorTerm(const ExpressionTape& tape, const std::string& className, const std::string& expressionType, std::ostream& out)
+    {
+      typedef ExpressionTape::Instruction Instruction;
+      SM_ASSERT_FALSE(Exception, className.empty(), "The class name must not be empty");
+      const Tape::ValueType rootType = tape.rootType();
+      SM_ASSERT_TRUE(Exception, rootType == Tape::SCALAR || rootType == Tape::EUCLIDEAN || rootType == Tape::HOMOGENEOUS,
+                     "Only scalar, Euclidean and homogeneous expressions can be generated as error terms");
+      const int rows = tape.rows();
+      const int numSlots = static_cast<int>(tape._slots.size());
+      const std::vector<Instruction>& instructions = tape._instructions;
+
+      // The instruction computing every slot, -1 for constants
+      std::vector<int> producer(numSlots, -1);
+      for (std::size_t i = 0; i < instructions.size(); ++i)
+        producer[instructions[i].out] = static_cast<int>(i);
+      auto isInput = [&](int slot) { return producer[slot] < 0 || instructions[producer[slot]].op == Tape::LEAF; };
+      auto hasAdjoint = [&](int slot) { return slot >= 0 && tape._slots[slot].hasDesignVariables; };
+
+      // The values used by the reverse sweep, mirrors the adjoint code below
+      std::vector<bool> needed(numSlots, false);
+      for (auto it = instructions.rbegin(); it != instructions.rend(); ++it) {
+        const Instruction& in = *it;
+        if (in.op == Tape::LEAF)
+          continue;
+        if (hasAdjoint(in.out)) {
+          const bool a0 = hasAdjoint(in.in0), a1 = hasAdjoint(in.in1);
+          switch (in.op) {
+            case Tape::SCALAR_MULTIPLY:
+            case Tape::EUCLIDEAN_CROSS:
+            case Tape::EUCLIDEAN_SCALE:
+              if (a0) needed[in.in1] = true;
+              if (a1) needed[in.in0] = true;
+              break;
+            case Tape::SCALAR_DIVIDE:
+              if (a0 || a1) needed[in.in1] = true;
+              if (a1) needed[in.in0] = true;
+              break;
+            case Tape::EUCLIDEAN_ROTATE:
+            case Tape::HOMOGENEOUS_TRANSFORM:
+              if (a0) needed[in.out] = true;
+              if (a1) needed[in.in0] = true;
+              break;
+            case Tape::ROTATION_MULTIPLY:
+            case Tape::TRANSFORMATION_MULTIPLY:
+              if (a1) needed[in.in0] = true;
+              break;
+            case Tape::EUCLIDEAN_TRANSLATION:
+            case Tape::ROTATION_INVERSE:
+            case Tape::TRANSFORMATION_INVERSE:
+              if (a0) needed[in.out] = true;
+              break;
+            case Tape::EUCLIDEAN_FROM_HOMOGENEOUS:
+              if (a0) needed[in.in0] = true;
+              break;
+            case Tape::TRANSFORMATION_FROM_ROTATION_TRANSLATION:
+              if (a0) needed[in.in1] = true;
+              break;
+            default:
+              break;
+          }
+        }
+        if (needed[in.out]) {
+          needed[in.in0] = true;
+          if (in.in1 >= 0)
+            needed[in.in1] = true;
+        }
+      }
+
+      // Straight-line code computing the values of the slots in \p emit. Slots are numbered in evaluation order.
+      auto emitForward = [&](const std::vector<bool>& emit) {
+        for (int slot = 0; slot < numSlots; ++slot) {
+          if (!emit[slot])
+            continue;
+          const Tape::ValueType type = tape._slots[slot].type;
+          const std::string T = valueTypeName(type);
+          if (isInput(slot)) {
+            if (type == Tape::SCALAR)
+              out << "    const double " << v(slot) << " = *_tape->slotValue(" << slot << ");\n";
+            else
+              out << "    const " << T << " " << v(slot) << " = Eigen::Map<const " << T << ">(_tape->slotValue(" << slot << "));\n";
+            continue;
+          }
+          const Instruction& in = instructions[producer[slot]];
+          const std::string V = v(slot), V0 = v(in.in0), V1 = v(in.in1);
+          if (in.op == Tape::TRANSFORMATION_FROM_ROTATION_TRANSLATION) {
+            out << "    " << T << " " << V << " = " << T << "::Identity();\n"
+                << "    " << V << ".topLeftCorner<3,3>() = " << V0 << ";\n"
+                << "    " << V << ".topRightCorner<3,1>() = " << V1 << ";\n";
+            continue;
+          }
+          out << "    const " << T << " " << V << " = ";
+          switch (in.op) {
+            case Tape::SCALAR_MULTIPLY:
+            case Tape::EUCLIDEAN_ROTATE:
+            case Tape::EUCLIDEAN_SCALE:
+            case Tape::HOMOGENEOUS_TRANSFORM:
+            case Tape::ROTATION_MULTIPLY:
+            case Tape::TRANSFORMATION_MULTIPLY:
+              out << V0 << " * " << V1;
+              break;
+            case Tape::SCALAR_DIVIDE: out << V0 << " / " << V1; break;
+            case Tape::SCALAR_NEGATE:
+            case Tape::EUCLIDEAN_NEGATE:
+              out << "-" << V0;
+              break;
+            case Tape::SCALAR_ADD:
+              if (in.parameter == 1.0)
+                out << V0 << " + " << V1;
+              else if (in.parameter == -1.0)
+                out << V0 << " - " << V1;
+              else
+                out << V0 << " + " << number(in.parameter) << " * " << V1;
+              break;
+            case Tape::SCALAR_FROM_EUCLIDEAN: out << V0 << "(" << static_cast<int>(in.parameter) << ")"; break;
+            case Tape::EUCLIDEAN_CROSS: out << V0 << ".cross(" << V1 << ")"; break;
+            case Tape::EUCLIDEAN_ADD: out << V0 << " + " << V1; break;
+            case Tape::EUCLIDEAN_SUBTRACT: out << V0 << " - " << V1; break;
+            case Tape::EUCLIDEAN_TRANSLATION: out << V0 << ".topRightCorner<3,1>()"; break;
+            case Tape::EUCLIDEAN_FROM_HOMOGENEOUS: out << "sm::kinematics::fromHomogeneous(" << V0 << ")"; break;
+            case Tape::HOMOGENEOUS_FROM_EUCLIDEAN: out << "(Eigen::Vector4d() << " << V0 << ", 1.0).finished()"; break;
+            case Tape::ROTATION_INVERSE: out << V0 << ".transpose()"; break;
+            case Tape::ROTATION_FROM_TRANSFORMATION: out << V0 << ".topLeftCorner<3,3>()"; break;
+            case Tape::TRANSFORMATION_INVERSE: out << V0 << ".inverse()"; break;
+            case Tape::TRANSFORMATION_FROM_ROTATION_TRANSLATION:
+            case Tape::LEAF:
+              break;
+          }
+          out << ";\n";
+        }
+      };
+
+      // Adjoint propagation, mirrors ExpressionTape::propagateAdjoint()
+      auto emitReverse = [&](const Instruction& in) {
+        const bool a0 = hasAdjoint(in.in0), a1 = hasAdjoint(in.in1);
+        const std::string A = a(in.out), A0 = a(in.in0), A1 = a(in.in1), V = v(in.out), V0 = v(in.in0), V1 = v(in.in1);
+        const std::string indent = "    ";
+        switch (in.op) {
+          case Tape::SCALAR_MULTIPLY:
+          case Tape::EUCLIDEAN_SCALE:
+            if (a0) out << indent << A0 << " += " << A << " * " << V1 << ";\n";
+            if (a1) out << indent << A1 << " += " << A << " * " << V0 << ";\n";
+            break;
+          case Tape::SCALAR_DIVIDE:
+            if (a0) out << indent << A0 << " += " << A << " / " << V1 << ";\n";
+            if (a1) out << indent << A1 << " -= " << A << " * (" << V0 << " / (" << V1 << " * " << V1 << "));\n";
+            break;
+          case Tape::SCALAR_NEGATE:
+          case Tape::EUCLIDEAN_NEGATE:
+            if (a0) out << indent << A0 << " -= " << A << ";\n";
+            break;
+          case Tape::SCALAR_ADD:
+            if (a0) out << indent << A0 << " += " << A << ";\n";
+            if (a1) {
+              if (in.parameter == 1.0)
+                out << indent << A1 << " += " << A << ";\n";
+              else if (in.parameter == -1.0)
+                out << indent << A1 << " -= " << A << ";\n";
+              else
+                out << indent << A1 << " += " << number(in.parameter) << " * " << A << ";\n";
+            }
+            break;
+          case Tape::SCALAR_FROM_EUCLIDEAN:
+            if (a0) out << indent << A0 << ".col(" << static_cast<int>(in.parameter) << ") += " << A << ";\n";
+            break;
+          case Tape::EUCLIDEAN_ROTATE:
+            if (a0) out << indent << A0 << " += " << A << " * sm::kinematics::crossMx(" << V << ");\n";
+            if (a1) out << indent << A1 << " += " << A << " * " << V0 << ";\n";
+            break;
+          case Tape::EUCLIDEAN_CROSS:
+            if (a0) out << indent << A0 << " -= " << A << " * sm::kinematics::crossMx(" << V1 << ");\n";
+            if (a1) out << indent << A1 << " += " << A << " * sm::kinematics::crossMx(" << V0 << ");\n";
+            break;
+          case Tape::EUCLIDEAN_ADD:
+          case Tape::ROTATION_MULTIPLY:
+          case Tape::TRANSFORMATION_MULTIPLY:
+            if (a0) out << indent << A0 << " += " << A << ";\n";
+            if (a1) {
+              if (in.op == Tape::EUCLIDEAN_ADD)
+                out << indent << A1 << " += " << A << ";\n";
+              else if (in.op == Tape::ROTATION_MULTIPLY)
+                out << indent << A1 << " += " << A << " * " << V0 << ";\n";
+              else
+                out << indent << A1 << " += " << A << " * sm::kinematics::boxTimes(" << V0 << ");\n";
+            }
+            break;
+          case Tape::EUCLIDEAN_SUBTRACT:
+            if (a0) out << indent << A0 << " += " << A << ";\n";
+            if (a1) out << indent << A1 << " -= " << A << ";\n";
+            break;
+          case Tape::EUCLIDEAN_TRANSLATION:
+            if (a0) out << indent << A0 << ".leftCols<3>() += " << A << ";\n"
+                        << indent << A0 << ".rightCols<3>() += " << A << " * sm::kinematics::crossMx(" << V << ");\n";
+            break;
+          case Tape::EUCLIDEAN_FROM_HOMOGENEOUS:
+            if (a0) out << indent << "{\n"
+                        << indent << "  Eigen::Matrix<double, 3, 4> J;\n"
+                        << indent << "  sm::kinematics::fromHomogeneous(" << V0 << ", &J);\n"
+                        << indent << "  " << A0 << " += " << A << " * J;\n"
+                        << indent << "}\n";
+            break;
+          case Tape::HOMOGENEOUS_TRANSFORM:
+            if (a0) out << indent << A0 << " += " << A << " * sm::kinematics::boxMinus(" << V << ");\n";
+            if (a1) out << indent << A1 << " += " << A << " * " << V0 << ";\n";
+            break;
+          case Tape::HOMOGENEOUS_FROM_EUCLIDEAN:
+            if (a0) out << indent << A0 << " += " << A << ".leftCols<3>();\n";
+            break;
+          case Tape::ROTATION_INVERSE:
+            if (a0) out << indent << A0 << " -= " << A << " * " << V << ";\n";
+            break;
+          case Tape::ROTATION_FROM_TRANSFORMATION:
+            if (a0) out << indent << A0 << ".rightCols<3>() += " << A << ";\n";
+            break;
+          case Tape::TRANSFORMATION_INVERSE:
+            if (a0) out << indent << A0 << " -= " << A << " * sm::kinematics::boxTimes(" << V << ");\n";
+            break;
+          case Tape::TRANSFORMATION_FROM_ROTATION_TRANSLATION:
+            if (a0) out << indent << A0 << " += " << A << ".rightCols<3>() - " << A << ".leftCols<3>() * sm::kinematics::crossMx(" << V1 << ");\n";
+            if (a1) out << indent << A1 << " += " << A << ".leftCols<3>();\n";
+            break;
+          case Tape::LEAF:
+            break;
+        }
+      };
+
+      const int dimension = Tape::valueSize(rootType);
+      const bool hasJacobians = hasAdjoint(tape._rootSlot);
+
+      out << "/// \\brief Error term generated by aslam::backend::ExpressionCodeGenerator\n"
+          << "class " << className << " : public aslam::backend::ErrorTermFs<" << dimension << ">\n"
+          << "{\n"
+          << " public:\n"
+          << "  EIGEN_MAKE_ALIGNED_OPERATOR_NEW\n\n"
+          << "  typedef aslam::backend::ErrorTermFs<" << dimension << "> parent_t;\n"
+          << "  typedef parent_t::error_t error_t;\n"
+          << "  typedef parent_t::inverse_covariance_t inverse_covariance_t;\n\n"
+          << "  /// \\brief The structure hash of the expressions this class was generated for\n"
+          << "  static std::size_t structureHash() { return static_cast<std::size_t>(0x" << std::hex << tape.structureHash() << std::dec << "ull); }\n\n"
+          << "  " << className << "(const " << expressionType << "& expression, const inverse_covariance_t& invR = inverse_covariance_t::Identity())\n"
+          << "    : _tape(aslam::backend::ExpressionTape::compile(expression))\n"
+          << "  {\n"
+          << "    SM_ASSERT_EQ(aslam::backend::ExpressionTape::Exception, _tape->structureHash(), structureHash(),\n"
+          << "                 \"The expression does not have the topology " << className << " was generated for\");\n"
+          << "    this->setInvR(invR);\n"
+          << "    aslam::backend::DesignVariable::set_t designVariables;\n"
+          << "    expression.getDesignVariables(designVariables);\n"
+          << "    this->setDesignVariablesIterator(designVariables.begin(), designVariables.end());\n"
+          << "  }\n\n"
+          << "  ~" << className << "() override { }\n\n"
+          << "  using parent_t::setInvR;\n"
+          << "  using parent_t::setSqrtInvR;\n\n"
+          << " protected:\n"
+          << "  double evaluateErrorImplementation() override\n"
+          << "  {\n"
+          << "    _tape->evaluateLeaves();\n";
+      emitForward(std::vector<bool>(numSlots, true));
+      out << "    error_t error;\n"
+          << "    error << " << v(tape._rootSlot) << ";\n"
+          << "    this->setError(error);\n"
+          << "    const error_t weightedError = this->sqrtInvR() * error;\n"
+          << "    return weightedError.dot(weightedError);\n"
+          << "  }\n\n";
+
+      out << "  void evaluateJacobiansImplementation(aslam::backend::JacobianContainer& " << (hasJacobians ? "outJacobians" : "/* outJacobians */") << ") override\n"
+          << "  {\n";
+      if (hasJacobians) {
+        bool needsLeaves = false;
+        for (int slot = 0; slot < numSlots; ++slot)
+          needsLeaves |= needed[slot] && producer[slot] >= 0 && instructions[producer[slot]].op == Tape::LEAF;
+        if (needsLeaves)
+          out << "    _tape->evaluateLeaves();\n";
+        emitForward(needed);
+        for (int slot = 0; slot < numSlots; ++slot) {
+          if (!hasAdjoint(slot))
+            continue;
+          const std::string T = adjointTypeName(rows, tape._slots[slot].type);
+          out << "    " << T << " " << a(slot) << " = " << T << (slot == tape._rootSlot ? "::Identity();\n" : "::Zero();\n");
+        }
+        for (auto it = instructions.rbegin(); it != instructions.rend(); ++it) {
+          if (!hasAdjoint(it->out))
+            continue;
+          if (it->op == Tape::LEAF)
+            out << "    _tape->evaluateLeafJacobians(" << it->in0 << ", " << a(it->out) << ".data(), outJacobians);\n";
+          else
+            emitReverse(*it);
+        }
+      }
+      out << "  }\n\n"
+          << " private:\n"
+          << "  aslam::backend::ExpressionTape::Ptr _tape;\n"
+          << "};\n";
+    }
+
+  } // namespace backend
+} // namespace aslam
@@ -0,0 +1,147 @@
+#include <aslam/backend/ExpressionDeduplicator.hpp>
+
+#include <algorithm>
+
+#include <aslam/backend/ExpressionErrorTerm.hpp>
+#include <aslam/backend/OptimizationProblemBase.hpp>
+#include <aslam/backend/CacheExpression.hpp>
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/VectorExpression.hpp>
+#include <aslam/backend/HomogeneousExpression.hpp>
+#include <aslam/backend/RotationExpression.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    namespace {
+
+      /// \brief Wrap \p node of type \p type into a cache expression node
+      boost::shared_ptr<void> toCacheNode(ExpressionTape::ValueType type, const boost::shared_ptr<void>& node)
+      {
+        switch (type) {
+          case ExpressionTape::SCALAR:
+            return toCacheExpression(ScalarExpression(boost::static_pointer_cast<ScalarExpressionNode>(node))).root();
+          case ExpressionTape::EUCLIDEAN:
+            return toCacheExpression(VectorExpression<3>(boost::static_pointer_cast<EuclideanExpressionNode>(node))).root();
+          case ExpressionTape::HOMOGENEOUS:
+            return toCacheExpression(HomogeneousExpression(boost::static_pointer_cast<HomogeneousExpressionNode>(node))).root();
+          case ExpressionTape::ROTATION:
+            return toCacheExpression(RotationExpression(boost::static_pointer_cast<RotationExpressionNode>(node))).root();
+          case ExpressionTape::TRANSFORMATION:
+            return toCacheExpression(TransformationExpression(boost::static_pointer_cast<TransformationExpressionNode>(node))).root();
+        }
+        return boost::shared_ptr<void>();
+      }
+
+    } // namespace anonymous
+
+    void ExpressionDeduplicator::add(ExpressionErrorTermInterface& errorTerm)
+    {
+      _errorTerms.push_back(&errorTerm);
+    }
+
+    std::size_t ExpressionDeduplicator::add(OptimizationProblemBase& problem)
+    {
+      const std::size_t numErrorTerms = _errorTerms.size();
+      for (std::size_t i = 0; i < problem.numErrorTerms(); ++i) {
+        if (auto errorTerm = dynamic_cast<ExpressionErrorTermInterface*>(problem.errorTerm(i)))
+          add(*errorTerm);
+      }
+      for (std::size_t i = 0; i < problem.numNonSquaredErrorTerms(); ++i) {
+        if (auto errorTerm = dynamic_cast<ExpressionErrorTermInterface*>(problem.nonSquaredErrorTerm(i)))
+          add(*errorTerm);
+      }
+      return _errorTerms.size() - numErrorTerms;
+    }
+
+    ExpressionDeduplicator::Statistics ExpressionDeduplicator::apply()
+    {
+      Statistics statistics;
+
+      // Compile all expressions into one tape without Jacobians, identical operations share their slot
+      ExpressionTape analysis;
+      ExpressionTapeBuilder builder(analysis, nullptr, true);
+      std::vector<std::pair<ExpressionErrorTermInterface*, int> > roots;
+      roots.reserve(_errorTerms.size());
+      for (ExpressionErrorTermInterface* errorTerm : _errorTerms) {
+        const int root = errorTerm->compileExpression(builder);
+        if (root >= 0)
+          roots.emplace_back(errorTerm, root);
+      }
+      statistics.numErrorTerms = roots.size();
+
+      const auto& instructions = analysis._instructions;
+      const auto& slots = analysis._slots;
+      std::vector<int> producers(slots.size(), -1);
+      for (std::size_t i = 0; i < instructions.size(); ++i) {
+        if (instructions[i].op != ExpressionTape::LEAF)
+          producers[instructions[i].out] = static_cast<int>(i);
+      }
+
+      // Count the error terms reaching every slot
+      std::vector<std::size_t> termCounts(slots.size(), 0);
+      std::vector<std::size_t> visitedBy(slots.size(), std::size_t(-1));
+      std::vector<bool> isRoot(slots.size(), false);
+      std::vector<int> stack;
+      for (std::size_t t = 0; t < roots.size(); ++t) {
+        isRoot[roots[t].second] = true;
+        stack.push_back(roots[t].second);
+        while (!stack.empty()) {
+          const int slot = stack.back();
+          stack.pop_back();
+          if (visitedBy[slot] == t)
+            continue;
+          visitedBy[slot] = t;
+          ++termCounts[slot];
+          ++statistics.numNodes;
+          if (producers[slot] >= 0) {
+            const auto& instruction = instructions[producers[slot]];
+            stack.push_back(instruction.in0);
+            if (instruction.in1 >= 0)
+              stack.push_back(instruction.in1);
+          }
+        }
+      }
+
+      // A shared operation is cached unless all its parents are shared by the same error terms and cached instead
+      std::vector<std::size_t> minParentCounts(slots.size(), std::size_t(-1));
+      for (const auto& instruction : instructions) {
+        if (instruction.op == ExpressionTape::LEAF || termCounts[instruction.out] == 0)
+          continue;
+        for (int in : { instruction.in0, instruction.in1 }) {
+          if (in >= 0)
+            minParentCounts[in] = std::min(minParentCounts[in], termCounts[instruction.out]);
+        }
+      }
+
+      std::vector<boost::shared_ptr<void> > cacheNodes(slots.size());
+      for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+        if (termCounts[slot] == 0)
+          continue;
+        ++statistics.numUniqueNodes;
+        if (producers[slot] < 0 || !slots[slot].hasDesignVariables || termCounts[slot] < 2)
+          continue;
+        if (!isRoot[slot] && minParentCounts[slot] >= termCounts[slot])
+          continue;
+        const boost::shared_ptr<void> node = builder.slotNode(static_cast<int>(slot));
+        if (!node)
+          continue;
+        cacheNodes[slot] = toCacheNode(slots[slot].type, node);
+        ++statistics.numCacheNodes;
+      }
+
+      // Every node compiled into a cached slot is replaced by the cache node
+      ExpressionTape::NodeSubstitutions substitutions;
+      for (const auto& nodeSlot : builder._nodeSlots) {
+        if (cacheNodes[nodeSlot.second])
+          substitutions.emplace(nodeSlot.first, cacheNodes[nodeSlot.second]);
+      }
+      for (const auto& root : roots) {
+        SM_ASSERT_TRUE(Exception, root.first->compileExpressionTape(substitutions), "Failed to recompile an error term");
+      }
+      return statistics;
+    }
+
+  } // namespace backend
+} // namespace aslam
@@ -0,0 +1,264 @@
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <typeindex>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace aslam {
+namespace backend {
+
+namespace {
+
+typedef std::pair<std::type_index, ExpressionNodeProfiler::Operation> Key;
+
+/// \brief A node of the call tree of one thread
+struct CallNode {
+  CallNode(const std::type_info * type, ExpressionNodeProfiler::Operation operation, CallNode * parent)
+      : type(type), operation(operation), parent(parent) {}
+
+  CallNode * child(const std::type_info & childType, ExpressionNodeProfiler::Operation childOperation) {
+    // Few distinct operands per node, a linear search is fastest
+    for (auto & c : children)
+      if (*c->type == childType && c->operation == childOperation)
+        return c.get();
+    children.emplace_back(new CallNode(&childType, childOperation, this));
+    return children.back().get();
+  }
+
+  Key key() const { return Key(std::type_index(*type), operation); }
+
+  const std::type_info * type;
+  ExpressionNodeProfiler::Operation operation;
+  CallNode * parent;
+  std::vector<std::unique_ptr<CallNode> > children;
+  std::size_t calls = 0;
+  std::chrono::steady_clock::duration inclusive = std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration childInclusive = std::chrono::steady_clock::duration::zero();
+  std::size_t inclusiveAllocations = 0;
+  std::size_t childAllocations = 0;
+};
+
+struct ThreadData {
+  ThreadData() : root(&typeid(void), ExpressionNodeProfiler::NumOperations, nullptr), current(&root) {}
+  CallNode root;
+  CallNode * current;
+};
+
+/// \brief The call trees of all threads that ever profiled, kept after their threads ended
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadData> > threads;
+};
+
+Registry & registry() {
+  static Registry registry;
+  return registry;
+}
+
+ThreadData & threadData() {
+  static thread_local ThreadData * data = nullptr;
+  if (data == nullptr) {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.emplace_back(new ThreadData());
+    data = r.threads.back().get();
+  }
+  return *data;
+}
+
+// Plain thread local counter such that countAllocation() never allocates
+thread_local std::size_t allocationCount = 0;
+
+std::string demangle(const char * mangled) {
+#ifdef __GNUG__
+  int status = 0;
+  char * name = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+  if (status == 0 && name != nullptr) {
+    std::string result(name);
+    std::free(name);
+    return result;
+  }
+#endif
+  return mangled;
+}
+
+std::string demangle(const std::type_info & type) {
+  return demangle(type.name());
+}
+
+double toSeconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+std::string frameName(const CallNode & node) {
+  return demangle(*node.type) + "::" + ExpressionNodeProfiler::toString(node.operation);
+}
+
+/// \brief Accumulate the statistics of the subtree of \p node, \p active counts the keys on the current path
+void accumulate(const CallNode & node, std::map<Key, ExpressionNodeProfiler::Statistics> & statistics, std::map<Key, int> & active) {
+  const Key key = node.key();
+  ExpressionNodeProfiler::Statistics & s = statistics.emplace(key, ExpressionNodeProfiler::Statistics{demangle(*node.type), node.operation, 0, 0.0, 0.0, 0, 0}).first->second;
+  s.calls += node.calls;
+  s.exclusiveSeconds += toSeconds(node.inclusive - node.childInclusive);
+  s.exclusiveAllocations += node.inclusiveAllocations - node.childAllocations;
+  // Recursive calls are already contained in the outermost one
+  if (active[key]++ == 0) {
+    s.inclusiveSeconds += toSeconds(node.inclusive);
+    s.inclusiveAllocations += node.inclusiveAllocations;
+  }
+  for (auto & c : node.children)
+    accumulate(*c, statistics, active);
+  --active[key];
+}
+
+void writeFolded(const CallNode & node, const std::string & prefix, std::ostream & out) {
+  const std::string stack = prefix.empty() ? frameName(node) : prefix + ";" + frameName(node);
+  const long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(node.inclusive - node.childInclusive).count();
+  if (nanoseconds > 0)
+    out << stack << " " << nanoseconds << "\n";
+  for (auto & c : node.children)
+    writeFolded(*c, stack, out);
+}
+
+struct Edge {
+  std::size_t calls = 0;
+  std::chrono::steady_clock::duration inclusive = std::chrono::steady_clock::duration::zero();
+};
+
+void collectEdges(const CallNode & node, std::map<std::pair<Key, Key>, Edge> & edges) {
+  for (auto & c : node.children) {
+    if (node.parent != nullptr) {
+      Edge & e = edges[std::make_pair(node.key(), c->key())];
+      e.calls += c->calls;
+      e.inclusive += c->inclusive;
+    }
+    collectEdges(*c, edges);
+  }
+}
+
+} // namespace
+
+std::atomic<bool> ExpressionNodeProfiler::_enabled(false);
+
+void ExpressionNodeProfiler::Scope::enter(const std::type_info & type, Operation operation) {
+  const std::size_t allocations = allocationCount;
+  ThreadData & data = threadData();
+  CallNode * node = data.current->child(type, operation);
+  data.current = node;
+  // Hide the allocations of the profiler itself
+  allocationCount = allocations;
+  _node = node;
+  _startAllocations = allocationCount;
+  _start = std::chrono::steady_clock::now();
+}
+
+void ExpressionNodeProfiler::Scope::leave() {
+  const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - _start;
+  const std::size_t allocations = allocationCount - _startAllocations;
+  CallNode * node = static_cast<CallNode *>(_node);
+  ++node->calls;
+  node->inclusive += elapsed;
+  node->inclusiveAllocations += allocations;
+  node->parent->childInclusive += elapsed;
+  node->parent->childAllocations += allocations;
+  threadData().current = node->parent;
+}
+
+void ExpressionNodeProfiler::reset() {
+  Registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto & data : r.threads) {
+    data->root.children.clear();
+    data->current = &data->root;
+  }
+}
+
+void ExpressionNodeProfiler::countAllocation() noexcept {
+  ++allocationCount;
+}
+
+std::vector<ExpressionNodeProfiler::Statistics> ExpressionNodeProfiler::statistics() {
+  std::map<Key, Statistics> statistics;
+  {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto & data : r.threads) {
+      for (auto & c : data->root.children) {
+        std::map<Key, int> active;
+        accumulate(*c, statistics, active);
+      }
+    }
+  }
+  std::vector<Statistics> result;
+  for (auto & s : statistics)
+    result.push_back(s.second);
+  std::sort(result.begin(), result.end(), [](const Statistics & a, const Statistics & b) { return a.exclusiveSeconds > b.exclusiveSeconds; });
+  return result;
+}
+
+void ExpressionNodeProfiler::print(std::ostream & out) {
+  out << "Expression node profile (times in ms):\n";
+  out << std::setw(12) << "calls" << std::setw(14) << "exclusive" << std::setw(14) << "inclusive"
+      << std::setw(12) << "excl.alloc" << std::setw(12) << "incl.alloc" << "  node\n";
+  for (const Statistics & s : statistics()) {
+    out << std::setw(12) << s.calls << std::setw(14) << 1e3 * s.exclusiveSeconds << std::setw(14) << 1e3 * s.inclusiveSeconds
+        << std::setw(12) << s.exclusiveAllocations << std::setw(12) << s.inclusiveAllocations
+        << "  " << s.nodeType << "::" << toString(s.operation) << "\n";
+  }
+}
+
+void ExpressionNodeProfiler::writeFoldedStacks(std::ostream & out) {
+  Registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto & data : r.threads)
+    for (auto & c : data->root.children)
+      writeFolded(*c, "", out);
+}
+
+void ExpressionNodeProfiler::writeGraphviz(std::ostream & out) {
+  const std::vector<Statistics> nodes = statistics();
+  std::map<std::pair<Key, Key>, Edge> edges;
+  {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto & data : r.threads)
+      collectEdges(data->root, edges);
+  }
+
+  out << "digraph ExpressionNodeProfile {\n  node [shape=box];\n";
+  std::map<std::string, std::size_t> ids;
+  for (const Statistics & s : nodes) {
+    const std::string name = s.nodeType + "::" + toString(s.operation);
+    const std::size_t id = ids.size();
+    ids[name] = id;
+    out << "  n" << id << " [label=\"" << name << "\\n" << s.calls << " calls\\nexclusive " << 1e3 * s.exclusiveSeconds
+        << " ms\\ninclusive " << 1e3 * s.inclusiveSeconds << " ms\\n" << s.exclusiveAllocations << " allocations\"];\n";
+  }
+  for (auto & e : edges) {
+    const std::string from = demangle(e.first.first.first.name()) + "::" + toString(e.first.first.second);
+    const std::string to = demangle(e.first.second.first.name()) + "::" + toString(e.first.second.second);
+    out << "  n" << ids[from] << " -> n" << ids[to] << " [label=\"" << e.second.calls << " calls\\n"
+        << 1e3 * toSeconds(e.second.inclusive) << " ms\"];\n";
+  }
+  out << "}\n";
+}
+
+const char * ExpressionNodeProfiler::toString(Operation operation) {
+  switch (operation) {
+    case Value: return "value";
+    case Jacobians: return "jacobians";
+    default: return "unknown";
+  }
+}
+
+}  // namespace backend
+}  // namespace aslam
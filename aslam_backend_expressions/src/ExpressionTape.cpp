@@ -0,0 +1,652 @@
+#include <aslam/backend/ExpressionTape.hpp>
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+
+#include <Eigen/Dense>
+
+#include <sm/kinematics/rotations.hpp>
+#include <sm/kinematics/transformations.hpp>
+#include <sm/kinematics/homogeneous_coordinates.hpp>
+
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/ScalarExpressionNode.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/EuclideanExpressionNode.hpp>
+#include <aslam/backend/HomogeneousExpression.hpp>
+#include <aslam/backend/HomogeneousExpressionNode.hpp>
+#include <aslam/backend/RotationExpression.hpp>
+#include <aslam/backend/RotationExpressionNode.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+#include <aslam/backend/TransformationExpressionNode.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    namespace {
+
+      typedef Eigen::Map<Eigen::Vector3d> MapVector3;
+      typedef Eigen::Map<const Eigen::Vector3d> ConstMapVector3;
+      typedef Eigen::Map<Eigen::Vector4d> MapVector4;
+      typedef Eigen::Map<const Eigen::Vector4d> ConstMapVector4;
+      typedef Eigen::Map<Eigen::Matrix3d> MapMatrix3;
+      typedef Eigen::Map<const Eigen::Matrix3d> ConstMapMatrix3;
+      typedef Eigen::Map<Eigen::Matrix4d> MapMatrix4;
+      typedef Eigen::Map<const Eigen::Matrix4d> ConstMapMatrix4;
+
+      /// \brief Adjoint of a slot with \p Cols tangent dimensions, the number of rows is the root tangent dimension
+      template <int Cols>
+      using AdjointMap = Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Cols> >;
+      template <int Cols>
+      using ConstAdjointMap = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Cols> >;
+
+      struct OpSignature {
+        ExpressionTape::ValueType out;
+        int numInputs;
+        ExpressionTape::ValueType in[2];
+      };
+
+      OpSignature signature(ExpressionTape::OpCode op)
+      {
+        typedef ExpressionTape T;
+        switch (op) {
+          case T::SCALAR_MULTIPLY:
+          case T::SCALAR_DIVIDE:
+          case T::SCALAR_ADD:
+            return { T::SCALAR, 2, { T::SCALAR, T::SCALAR } };
+          case T::SCALAR_NEGATE:
+            return { T::SCALAR, 1, { T::SCALAR, T::SCALAR } };
+          case T::SCALAR_FROM_EUCLIDEAN:
+            return { T::SCALAR, 1, { T::EUCLIDEAN, T::EUCLIDEAN } };
+          case T::EUCLIDEAN_ROTATE:
+            return { T::EUCLIDEAN, 2, { T::ROTATION, T::EUCLIDEAN } };
+          case T::EUCLIDEAN_CROSS:
+          case T::EUCLIDEAN_ADD:
+          case T::EUCLIDEAN_SUBTRACT:
+            return { T::EUCLIDEAN, 2, { T::EUCLIDEAN, T::EUCLIDEAN } };
+          case T::EUCLIDEAN_NEGATE:
+            return { T::EUCLIDEAN, 1, { T::EUCLIDEAN, T::EUCLIDEAN } };
+          case T::EUCLIDEAN_SCALE:
+            return { T::EUCLIDEAN, 2, { T::EUCLIDEAN, T::SCALAR } };
+          case T::EUCLIDEAN_TRANSLATION:
+            return { T::EUCLIDEAN, 1, { T::TRANSFORMATION, T::TRANSFORMATION } };
+          case T::EUCLIDEAN_FROM_HOMOGENEOUS:
+            return { T::EUCLIDEAN, 1, { T::HOMOGENEOUS, T::HOMOGENEOUS } };
+          case T::HOMOGENEOUS_TRANSFORM:
+            return { T::HOMOGENEOUS, 2, { T::TRANSFORMATION, T::HOMOGENEOUS } };
+          case T::HOMOGENEOUS_FROM_EUCLIDEAN:
+            return { T::HOMOGENEOUS, 1, { T::EUCLIDEAN, T::EUCLIDEAN } };
+          case T::ROTATION_MULTIPLY:
+            return { T::ROTATION, 2, { T::ROTATION, T::ROTATION } };
+          case T::ROTATION_INVERSE:
+            return { T::ROTATION, 1, { T::ROTATION, T::ROTATION } };
+          case T::ROTATION_FROM_TRANSFORMATION:
+            return { T::ROTATION, 1, { T::TRANSFORMATION, T::TRANSFORMATION } };
+          case T::TRANSFORMATION_MULTIPLY:
+            return { T::TRANSFORMATION, 2, { T::TRANSFORMATION, T::TRANSFORMATION } };
+          case T::TRANSFORMATION_INVERSE:
+            return { T::TRANSFORMATION, 1, { T::TRANSFORMATION, T::TRANSFORMATION } };
+          case T::TRANSFORMATION_FROM_ROTATION_TRANSLATION:
+            return { T::TRANSFORMATION, 2, { T::ROTATION, T::EUCLIDEAN } };
+          case T::LEAF:
+            break;
+        }
+        SM_THROW(ExpressionTape::Exception, "Operation " << op << " is not a valid tape operation");
+      }
+
+      template <typename NODE>
+      bool dependsOnDesignVariables(const NODE* node)
+      {
+        DesignVariable::set_t designVariables;
+        node->getDesignVariables(designVariables);
+        return !designVariables.empty();
+      }
+
+    } // namespace anonymous
+
+    ////////////////////////////////////////////
+    // ExpressionTape
+    ////////////////////////////////////////////
+
+    int ExpressionTape::valueSize(ValueType type)
+    {
+      switch (type) {
+        case SCALAR: return 1;
+        case EUCLIDEAN: return 3;
+        case HOMOGENEOUS: return 4;
+        case ROTATION: return 9;
+        case TRANSFORMATION: return 16;
+      }
+      return 0;
+    }
+
+    int ExpressionTape::tangentSize(ValueType type)
+    {
+      switch (type) {
+        case SCALAR: return 1;
+        case EUCLIDEAN: return 3;
+        case HOMOGENEOUS: return 4;
+        case ROTATION: return 3;
+        case TRANSFORMATION: return 6;
+      }
+      return 0;
+    }
+
+    template <typename NODE>
+    ExpressionTape::Ptr ExpressionTape::compileRoot(const boost::shared_ptr<NODE>& root, ValueType type, const NodeSubstitutions& substitutions)
+    {
+      SM_ASSERT_TRUE(Exception, root.get() != nullptr, "Cannot compile an empty expression");
+      Ptr tape(new ExpressionTape());
+      tape->_rows = tangentSize(type);
+      ExpressionTapeBuilder builder(*tape, &substitutions);
+      tape->_rootSlot = builder.compile(root);
+      SM_ASSERT_EQ(Exception, tape->rootType(), type, "The root of the tape has the wrong type");
+      tape->_root = root;
+      return tape;
+    }
+
+    ExpressionTape::Ptr ExpressionTape::compile(const ScalarExpression& expression, const NodeSubstitutions& substitutions)
+    {
+      return compileRoot(expression.root(), SCALAR, substitutions);
+    }
+
+    ExpressionTape::Ptr ExpressionTape::compile(const VectorExpression<3>& expression, const NodeSubstitutions& substitutions)
+    {
+      return compileRoot(expression.root(), EUCLIDEAN, substitutions);
+    }
+
+    ExpressionTape::Ptr ExpressionTape::compile(const HomogeneousExpression& expression, const NodeSubstitutions& substitutions)
+    {
+      return compileRoot(expression.root(), HOMOGENEOUS, substitutions);
+    }
+
+    ExpressionTape::Ptr ExpressionTape::compile(const RotationExpression& expression, const NodeSubstitutions& substitutions)
+    {
+      return compileRoot(expression.root(), ROTATION, substitutions);
+    }
+
+    ExpressionTape::Ptr ExpressionTape::compile(const TransformationExpression& expression, const NodeSubstitutions& substitutions)
+    {
+      return compileRoot(expression.root(), TRANSFORMATION, substitutions);
+    }
+
+    void ExpressionTape::evaluate()
+    {
+      for (const Instruction& instruction : _instructions)
+        evaluateInstruction(instruction);
+    }
+
+    void ExpressionTape::evaluateJacobians(JacobianContainer& outJacobians)
+    {
+      const Slot& root = _slots[_rootSlot];
+      if (!root.hasDesignVariables)
+        return;
+
+      std::fill(_adjoints.begin(), _adjoints.end(), 0.0);
+      AdjointMap<Eigen::Dynamic>(_adjoints.data() + root.adjoint, _rows, _rows).setIdentity();
+
+      for (auto it = _instructions.rbegin(); it != _instructions.rend(); ++it) {
+        const Slot& out = _slots[it->out];
+        if (!out.hasDesignVariables)
+          continue;
+        if (it->op == LEAF)
+          evaluateLeafJacobians(_leaves[it->in0], _adjoints.data() + out.adjoint, tangentSize(out.type), outJacobians);
+        else
+          propagateAdjoint(*it);
+      }
+    }
+
+    std::size_t ExpressionTape::structureHash() const
+    {
+      std::size_t hash = 0;
+      boost::hash_combine(hash, _rows);
+      boost::hash_combine(hash, _rootSlot);
+      for (const Slot& slot : _slots) {
+        boost::hash_combine(hash, static_cast<int>(slot.type));
+        boost::hash_combine(hash, slot.hasDesignVariables);
+      }
+      for (const Instruction& instruction : _instructions) {
+        boost::hash_combine(hash, static_cast<int>(instruction.op));
+        boost::hash_combine(hash, instruction.out);
+        boost::hash_combine(hash, instruction.in0);
+        boost::hash_combine(hash, instruction.in1);
+        boost::hash_combine(hash, instruction.parameter);
+      }
+      return hash;
+    }
+
+    void ExpressionTape::evaluateLeaves()
+    {
+      for (const Leaf& leaf : _leaves)
+        evaluateLeaf(leaf, _values.data() + _slots[leaf.slot].value);
+    }
+
+    void ExpressionTape::evaluateLeafJacobians(std::size_t leaf, const double* adjoint, JacobianContainer& outJacobians) const
+    {
+      SM_ASSERT_LT(Exception, leaf, _leaves.size(), "Invalid leaf index");
+      const Leaf& l = _leaves[leaf];
+      evaluateLeafJacobians(l, adjoint, tangentSize(l.type), outJacobians);
+    }
+
+    void ExpressionTape::evaluateLeaf(const Leaf& leaf, double* value)
+    {
+      switch (leaf.type) {
+        case SCALAR:
+          *value = static_cast<const ScalarExpressionNode*>(leaf.node)->evaluate();
+          break;
+        case EUCLIDEAN: {
+          MapVector3 result(value);
+          result = static_cast<const EuclideanExpressionNode*>(leaf.node)->evaluate();
+          break;
+        }
+        case HOMOGENEOUS: {
+          MapVector4 result(value);
+          result = static_cast<const HomogeneousExpressionNode*>(leaf.node)->toHomogeneous();
+          break;
+        }
+        case ROTATION: {
+          MapMatrix3 result(value);
+          result = static_cast<const RotationExpressionNode*>(leaf.node)->evaluate();
+          break;
+        }
+        case TRANSFORMATION: {
+          // the transformation nodes cache their operands during evaluation and are therefore not const
+          MapMatrix4 result(value);
+          result = const_cast<TransformationExpressionNode*>(static_cast<const TransformationExpressionNode*>(leaf.node))->evaluate();
+          break;
+        }
+      }
+    }
+
+    void ExpressionTape::evaluateLeafJacobians(const Leaf& leaf, const double* adjoint, int cols, JacobianContainer& outJacobians) const
+    {
+      switch (leaf.type) {
+        case SCALAR:
+          static_cast<const ScalarExpressionNode*>(leaf.node)->evaluateJacobians(outJacobians, ConstAdjointMap<1>(adjoint, _rows, cols));
+          break;
+        case EUCLIDEAN:
+          static_cast<const EuclideanExpressionNode*>(leaf.node)->evaluateJacobians(outJacobians, ConstAdjointMap<3>(adjoint, _rows, cols));
+          break;
+        case HOMOGENEOUS:
+          static_cast<const HomogeneousExpressionNode*>(leaf.node)->evaluateJacobians(outJacobians, ConstAdjointMap<4>(adjoint, _rows, cols));
+          break;
+        case ROTATION:
+          static_cast<const RotationExpressionNode*>(leaf.node)->evaluateJacobians(outJacobians, ConstAdjointMap<3>(adjoint, _rows, cols));
+          break;
+        case TRANSFORMATION:
+          static_cast<const TransformationExpressionNode*>(leaf.node)->evaluateJacobians(outJacobians, ConstAdjointMap<6>(adjoint, _rows, cols));
+          break;
+      }
+    }
+
+    void ExpressionTape::evaluateInstruction(const Instruction& instruction)
+    {
+      double* out = _values.data() + _slots[instruction.out].value;
+      if (instruction.op == LEAF) {
+        evaluateLeaf(_leaves[instruction.in0], out);
+        return;
+      }
+
+      const double* v0 = _values.data() + _slots[instruction.in0].value;
+      const double* v1 = instruction.in1 >= 0 ? _values.data() + _slots[instruction.in1].value : nullptr;
+
+      switch (instruction.op) {
+        case SCALAR_MULTIPLY:
+          out[0] = v0[0] * v1[0];
+          break;
+        case SCALAR_DIVIDE:
+          out[0] = v0[0] / v1[0];
+          break;
+        case SCALAR_NEGATE:
+          out[0] = -v0[0];
+          break;
+        case SCALAR_ADD:
+          out[0] = v0[0] + instruction.parameter * v1[0];
+          break;
+        case SCALAR_FROM_EUCLIDEAN:
+          out[0] = v0[static_cast<int>(instruction.parameter)];
+          break;
+        case EUCLIDEAN_ROTATE: {
+          MapVector3 result(out);
+          result.noalias() = ConstMapMatrix3(v0) * ConstMapVector3(v1);
+          break;
+        }
+        case EUCLIDEAN_CROSS: {
+          MapVector3 result(out);
+          result.noalias() = sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(v0))) * ConstMapVector3(v1);
+          break;
+        }
+        case EUCLIDEAN_ADD: {
+          MapVector3 result(out);
+          result = ConstMapVector3(v0) + ConstMapVector3(v1);
+          break;
+        }
+        case EUCLIDEAN_SUBTRACT: {
+          MapVector3 result(out);
+          result = ConstMapVector3(v0) - ConstMapVector3(v1);
+          break;
+        }
+        case EUCLIDEAN_NEGATE: {
+          MapVector3 result(out);
+          result = -ConstMapVector3(v0);
+          break;
+        }
+        case EUCLIDEAN_SCALE: {
+          MapVector3 result(out);
+          result = ConstMapVector3(v0) * v1[0];
+          break;
+        }
+        case EUCLIDEAN_TRANSLATION: {
+          MapVector3 result(out);
+          result = ConstMapMatrix4(v0).topRightCorner<3,1>();
+          break;
+        }
+        case EUCLIDEAN_FROM_HOMOGENEOUS: {
+          MapVector3 result(out);
+          result = sm::kinematics::fromHomogeneous(Eigen::Vector4d(ConstMapVector4(v0)));
+          break;
+        }
+        case HOMOGENEOUS_TRANSFORM: {
+          MapVector4 result(out);
+          result.noalias() = ConstMapMatrix4(v0) * ConstMapVector4(v1);
+          break;
+        }
+        case HOMOGENEOUS_FROM_EUCLIDEAN: {
+          MapVector4 result(out);
+          result << ConstMapVector3(v0), 1.0;
+          break;
+        }
+        case ROTATION_MULTIPLY: {
+          MapMatrix3 result(out);
+          result.noalias() = ConstMapMatrix3(v0) * ConstMapMatrix3(v1);
+          break;
+        }
+        case ROTATION_INVERSE: {
+          MapMatrix3 result(out);
+          result = ConstMapMatrix3(v0).transpose();
+          break;
+        }
+        case ROTATION_FROM_TRANSFORMATION: {
+          MapMatrix3 result(out);
+          result = ConstMapMatrix4(v0).topLeftCorner<3,3>();
+          break;
+        }
+        case TRANSFORMATION_MULTIPLY: {
+          MapMatrix4 result(out);
+          result.noalias() = ConstMapMatrix4(v0) * ConstMapMatrix4(v1);
+          break;
+        }
+        case TRANSFORMATION_INVERSE: {
+          MapMatrix4 result(out);
+          result = ConstMapMatrix4(v0).inverse();
+          break;
+        }
+        case TRANSFORMATION_FROM_ROTATION_TRANSLATION: {
+          MapMatrix4 T(out);
+          T.setIdentity();
+          T.topLeftCorner<3,3>() = ConstMapMatrix3(v0);
+          T.topRightCorner<3,1>() = ConstMapVector3(v1);
+          break;
+        }
+        case LEAF:
+          break;
+      }
+    }
+
+    void ExpressionTape::propagateAdjoint(const Instruction& instruction)
+    {
+      const Slot& outSlot = _slots[instruction.out];
+      const double* out = _values.data() + outSlot.value;
+      const double* A = _adjoints.data() + outSlot.adjoint;
+
+      const Slot& slot0 = _slots[instruction.in0];
+      const double* v0 = _values.data() + slot0.value;
+      double* a0 = slot0.hasDesignVariables ? _adjoints.data() + slot0.adjoint : nullptr;
+
+      const double* v1 = nullptr;
+      double* a1 = nullptr;
+      if (instruction.in1 >= 0) {
+        const Slot& slot1 = _slots[instruction.in1];
+        v1 = _values.data() + slot1.value;
+        a1 = slot1.hasDesignVariables ? _adjoints.data() + slot1.adjoint : nullptr;
+      }
+
+      const int R = _rows;
+      switch (instruction.op) {
+        case SCALAR_MULTIPLY:
+          if (a0) AdjointMap<1>(a0, R, 1) += ConstAdjointMap<1>(A, R, 1) * v1[0];
+          if (a1) AdjointMap<1>(a1, R, 1) += ConstAdjointMap<1>(A, R, 1) * v0[0];
+          break;
+        case SCALAR_DIVIDE: {
+          const double rec = 1./v1[0];
+          if (a0) AdjointMap<1>(a0, R, 1) += ConstAdjointMap<1>(A, R, 1) * rec;
+          if (a1) AdjointMap<1>(a1, R, 1) += ConstAdjointMap<1>(A, R, 1) * (-v0[0] * rec * rec);
+          break;
+        }
+        case SCALAR_NEGATE:
+          if (a0) AdjointMap<1>(a0, R, 1) -= ConstAdjointMap<1>(A, R, 1);
+          break;
+        case SCALAR_ADD:
+          if (a0) AdjointMap<1>(a0, R, 1) += ConstAdjointMap<1>(A, R, 1);
+          if (a1) AdjointMap<1>(a1, R, 1) += instruction.parameter * ConstAdjointMap<1>(A, R, 1);
+          break;
+        case SCALAR_FROM_EUCLIDEAN:
+          if (a0) AdjointMap<3>(a0, R, 3).col(static_cast<int>(instruction.parameter)) += ConstAdjointMap<1>(A, R, 1);
+          break;
+        case EUCLIDEAN_ROTATE:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<3>(A, R, 3) * sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(out)));
+          if (a1) AdjointMap<3>(a1, R, 3) += ConstAdjointMap<3>(A, R, 3) * ConstMapMatrix3(v0);
+          break;
+        case EUCLIDEAN_CROSS:
+          if (a0) AdjointMap<3>(a0, R, 3) -= ConstAdjointMap<3>(A, R, 3) * sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(v1)));
+          if (a1) AdjointMap<3>(a1, R, 3) += ConstAdjointMap<3>(A, R, 3) * sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(v0)));
+          break;
+        case EUCLIDEAN_ADD:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<3>(A, R, 3);
+          if (a1) AdjointMap<3>(a1, R, 3) += ConstAdjointMap<3>(A, R, 3);
+          break;
+        case EUCLIDEAN_SUBTRACT:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<3>(A, R, 3);
+          if (a1) AdjointMap<3>(a1, R, 3) -= ConstAdjointMap<3>(A, R, 3);
+          break;
+        case EUCLIDEAN_NEGATE:
+          if (a0) AdjointMap<3>(a0, R, 3) -= ConstAdjointMap<3>(A, R, 3);
+          break;
+        case EUCLIDEAN_SCALE:
+          if (a0) AdjointMap<3>(a0, R, 3) += v1[0] * ConstAdjointMap<3>(A, R, 3);
+          if (a1) AdjointMap<1>(a1, R, 1) += ConstAdjointMap<3>(A, R, 3) * ConstMapVector3(v0);
+          break;
+        case EUCLIDEAN_TRANSLATION:
+          if (a0) {
+            AdjointMap<6> adj(a0, R, 6);
+            adj.leftCols<3>() += ConstAdjointMap<3>(A, R, 3);
+            adj.rightCols<3>() += ConstAdjointMap<3>(A, R, 3) * sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(out)));
+          }
+          break;
+        case EUCLIDEAN_FROM_HOMOGENEOUS:
+          if (a0) {
+            Eigen::Matrix<double,3,4> Jh;
+            sm::kinematics::fromHomogeneous(Eigen::Vector4d(ConstMapVector4(v0)), &Jh);
+            AdjointMap<4>(a0, R, 4) += ConstAdjointMap<3>(A, R, 3) * Jh;
+          }
+          break;
+        case HOMOGENEOUS_TRANSFORM:
+          if (a0) AdjointMap<6>(a0, R, 6) += ConstAdjointMap<4>(A, R, 4) * sm::kinematics::boxMinus(Eigen::Vector4d(ConstMapVector4(out)));
+          if (a1) AdjointMap<4>(a1, R, 4) += ConstAdjointMap<4>(A, R, 4) * ConstMapMatrix4(v0);
+          break;
+        case HOMOGENEOUS_FROM_EUCLIDEAN:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<4>(A, R, 4).leftCols<3>();
+          break;
+        case ROTATION_MULTIPLY:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<3>(A, R, 3);
+          if (a1) AdjointMap<3>(a1, R, 3) += ConstAdjointMap<3>(A, R, 3) * ConstMapMatrix3(v0);
+          break;
+        case ROTATION_INVERSE:
+          if (a0) AdjointMap<3>(a0, R, 3) -= ConstAdjointMap<3>(A, R, 3) * ConstMapMatrix3(out);
+          break;
+        case ROTATION_FROM_TRANSFORMATION:
+          if (a0) AdjointMap<6>(a0, R, 6).rightCols<3>() += ConstAdjointMap<3>(A, R, 3);
+          break;
+        case TRANSFORMATION_MULTIPLY:
+          if (a0) AdjointMap<6>(a0, R, 6) += ConstAdjointMap<6>(A, R, 6);
+          if (a1) AdjointMap<6>(a1, R, 6) += ConstAdjointMap<6>(A, R, 6) * sm::kinematics::boxTimes(Eigen::Matrix4d(ConstMapMatrix4(v0)));
+          break;
+        case TRANSFORMATION_INVERSE:
+          if (a0) AdjointMap<6>(a0, R, 6) -= ConstAdjointMap<6>(A, R, 6) * sm::kinematics::boxTimes(Eigen::Matrix4d(ConstMapMatrix4(out)));
+          break;
+        case TRANSFORMATION_FROM_ROTATION_TRANSLATION:
+          if (a0) AdjointMap<3>(a0, R, 3) += ConstAdjointMap<6>(A, R, 6).rightCols<3>()
+              - ConstAdjointMap<6>(A, R, 6).leftCols<3>() * sm::kinematics::crossMx(Eigen::Vector3d(ConstMapVector3(v1)));
+          if (a1) AdjointMap<3>(a1, R, 3) += ConstAdjointMap<6>(A, R, 6).leftCols<3>();
+          break;
+        case LEAF:
+          break;
+      }
+    }
+
+    ////////////////////////////////////////////
+    // ExpressionTapeBuilder
+    ////////////////////////////////////////////
+
+    template <typename NODE>
+    int ExpressionTapeBuilder::compileNode(const boost::shared_ptr<NODE>& node)
+    {
+      SM_ASSERT_TRUE(Exception, node.get() != nullptr, "Cannot compile an empty expression node");
+      auto it = _nodeSlots.find(node.get());
+      if (it != _nodeSlots.end())
+        return it->second;
+      if (_substitutions) {
+        auto substitution = _substitutions->find(node.get());
+        if (substitution != _substitutions->end()) {
+          _tape._substitutedNodes.push_back(substitution->second);
+          const int slot = compileNode(boost::static_pointer_cast<NODE>(substitution->second));
+          _nodeSlots.emplace(node.get(), slot);
+          return slot;
+        }
+      }
+      const int slot = node->compileTape(*this);
+      _nodeSlots.emplace(node.get(), slot);
+      if (static_cast<int>(_slotNodes.size()) <= slot)
+        _slotNodes.resize(slot + 1);
+      if (!_slotNodes[slot])
+        _slotNodes[slot] = node;
+      return slot;
+    }
+
+    boost::shared_ptr<void> ExpressionTapeBuilder::slotNode(int slot) const
+    {
+      return slot < static_cast<int>(_slotNodes.size()) ? _slotNodes[slot] : boost::shared_ptr<void>();
+    }
+
+    int ExpressionTapeBuilder::compile(const boost::shared_ptr<ScalarExpressionNode>& node) { return compileNode(node); }
+    int ExpressionTapeBuilder::compile(const boost::shared_ptr<EuclideanExpressionNode>& node) { return compileNode(node); }
+    int ExpressionTapeBuilder::compile(const boost::shared_ptr<HomogeneousExpressionNode>& node) { return compileNode(node); }
+    int ExpressionTapeBuilder::compile(const boost::shared_ptr<RotationExpressionNode>& node) { return compileNode(node); }
+    int ExpressionTapeBuilder::compile(const boost::shared_ptr<TransformationExpressionNode>& node) { return compileNode(node); }
+
+    int ExpressionTapeBuilder::addSlot(ExpressionTape::ValueType type, bool hasDesignVariables)
+    {
+      ExpressionTape::Slot slot;
+      slot.type = type;
+      slot.value = static_cast<int>(_tape._values.size());
+      slot.adjoint = hasDesignVariables ? static_cast<int>(_tape._adjoints.size()) : -1;
+      slot.hasDesignVariables = hasDesignVariables;
+      _tape._values.resize(_tape._values.size() + ExpressionTape::valueSize(type), 0.0);
+      if (hasDesignVariables)
+        _tape._adjoints.resize(_tape._adjoints.size() + _tape._rows*ExpressionTape::tangentSize(type), 0.0);
+      _tape._slots.push_back(slot);
+      return static_cast<int>(_tape._slots.size()) - 1;
+    }
+
+    int ExpressionTapeBuilder::addLeaf(ExpressionTape::ValueType type, const void* node, bool hasDesignVariables)
+    {
+      const int slot = addSlot(type, hasDesignVariables);
+      _tape._instructions.push_back({ ExpressionTape::LEAF, slot, static_cast<int>(_tape._leaves.size()), -1, 0.0 });
+      _tape._leaves.push_back({ type, node, slot });
+      return slot;
+    }
+
+    int ExpressionTapeBuilder::addLeaf(const ScalarExpressionNode* node)
+    {
+      return addLeaf(ExpressionTape::SCALAR, node, dependsOnDesignVariables(node));
+    }
+
+    int ExpressionTapeBuilder::addLeaf(const EuclideanExpressionNode* node)
+    {
+      return addLeaf(ExpressionTape::EUCLIDEAN, node, dependsOnDesignVariables(node));
+    }
+
+    int ExpressionTapeBuilder::addLeaf(const HomogeneousExpressionNode* node)
+    {
+      return addLeaf(ExpressionTape::HOMOGENEOUS, node, dependsOnDesignVariables(node));
+    }
+
+    int ExpressionTapeBuilder::addLeaf(const RotationExpressionNode* node)
+    {
+      return addLeaf(ExpressionTape::ROTATION, node, dependsOnDesignVariables(node));
+    }
+
+    int ExpressionTapeBuilder::addLeaf(const TransformationExpressionNode* node)
+    {
+      return addLeaf(ExpressionTape::TRANSFORMATION, node, dependsOnDesignVariables(node));
+    }
+
+    int ExpressionTapeBuilder::addConstant(ExpressionTape::ValueType type, const double* value)
+    {
+      std::pair<int, std::vector<double> > key;
+      if (_hashConsing) {
+        key = std::make_pair(static_cast<int>(type), std::vector<double>(value, value + ExpressionTape::valueSize(type)));
+        auto it = _constantSlots.find(key);
+        if (it != _constantSlots.end())
+          return it->second;
+      }
+      const int slot = addSlot(type, false);
+      std::copy(value, value + ExpressionTape::valueSize(type), _tape._values.begin() + _tape._slots[slot].value);
+      if (_hashConsing)
+        _constantSlots.emplace(key, slot);
+      return slot;
+    }
+
+    int ExpressionTapeBuilder::addConstant(double value) { return addConstant(ExpressionTape::SCALAR, &value); }
+    int ExpressionTapeBuilder::addConstant(const Eigen::Vector3d& value) { return addConstant(ExpressionTape::EUCLIDEAN, value.data()); }
+    int ExpressionTapeBuilder::addConstant(const Eigen::Vector4d& value) { return addConstant(ExpressionTape::HOMOGENEOUS, value.data()); }
+    int ExpressionTapeBuilder::addConstant(const Eigen::Matrix3d& value) { return addConstant(ExpressionTape::ROTATION, value.data()); }
+    int ExpressionTapeBuilder::addConstant(const Eigen::Matrix4d& value) { return addConstant(ExpressionTape::TRANSFORMATION, value.data()); }
+
+    int ExpressionTapeBuilder::addOperation(ExpressionTape::OpCode op, int in0, int in1, double parameter)
+    {
+      const OpSignature sig = signature(op);
+      const int inputs[2] = { in0, in1 };
+      bool hasDesignVariables = false;
+      for (int i = 0; i < 2; ++i) {
+        if (i >= sig.numInputs) {
+          SM_ASSERT_EQ(Exception, inputs[i], -1, "Operation " << op << " takes " << sig.numInputs << " operand(s)");
+          continue;
+        }
+        SM_ASSERT_GE(Exception, inputs[i], 0, "Invalid operand slot of operation " << op);
+        SM_ASSERT_LT(Exception, inputs[i], static_cast<int>(_tape._slots.size()), "Invalid operand slot of operation " << op);
+        SM_ASSERT_EQ(Exception, _tape._slots[inputs[i]].type, sig.in[i], "Operand " << i << " of operation " << op << " has the wrong type");
+        hasDesignVariables |= _tape._slots[inputs[i]].hasDesignVariables;
+      }
+      if (op == ExpressionTape::SCALAR_FROM_EUCLIDEAN) {
+        SM_ASSERT_GE(Exception, parameter, 0.0, "Component index out of range");
+        SM_ASSERT_LT(Exception, parameter, 3.0, "Component index out of range");
+      }
+
+      const std::tuple<int, int, int, double> key(static_cast<int>(op), in0, in1, parameter);
+      if (_hashConsing) {
+        auto it = _operationSlots.find(key);
+        if (it != _operationSlots.end())
+          return it->second;
+      }
+
+      const int slot = addSlot(sig.out, hasDesignVariables);
+      _tape._instructions.push_back({ op, slot, in0, in1, parameter });
+      if (_hashConsing)
+        _operationSlots.emplace(key, slot);
+      return slot;
+    }
+
+  } // namespace backend
+} // namespace aslam
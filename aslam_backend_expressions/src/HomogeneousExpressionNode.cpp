@@ -2,6 +2,8 @@
 #include <sm/kinematics/transformations.hpp>
 #include <sm/kinematics/homogeneous_coordinates.hpp>
 #include <aslam/backend/EuclideanExpressionNode.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
   namespace backend {
@@ -20,6 +22,7 @@ namespace aslam {
     /// \brief Evaluate the homogeneous matrix.
     Eigen::Vector4d HomogeneousExpressionNode::toHomogeneous() const
     {
+      ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
       return toHomogeneousImplementation();
     }
 
@@ -27,6 +30,7 @@ namespace aslam {
     /// \brief Evaluate the Jacobians
     void HomogeneousExpressionNode::evaluateJacobians(JacobianContainer & outJacobians) const
     {
+      ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
       evaluateJacobiansImplementation(outJacobians);
     }
    
@@ -35,6 +39,11 @@ namespace aslam {
       getDesignVariablesImplementation(designVariables);
     }
 
+    int HomogeneousExpressionNode::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      return builder.addLeaf(this);
+    }
+
 
 
 
@@ -73,6 +82,11 @@ namespace aslam {
       _rhs->getDesignVariables(designVariables);
     }
 
+    int HomogeneousExpressionNodeMultiply::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      return builder.addOperation(ExpressionTape::HOMOGENEOUS_TRANSFORM, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
 
 
 
@@ -100,13 +114,17 @@ namespace aslam {
   }
 
   void HomogeneousExpressionNodeEuclidean::evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    _p->evaluateJacobians( outJacobians, Eigen::MatrixXd::Identity(4,3) );
+    _p->evaluateJacobians( outJacobians, Eigen::Matrix<double, 4, 3>::Identity() );
   }
 
   void HomogeneousExpressionNodeEuclidean::getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const {
     return _p->getDesignVariables(designVariables);
   }
 
+  int HomogeneousExpressionNodeEuclidean::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addOperation(ExpressionTape::HOMOGENEOUS_FROM_EUCLIDEAN, builder.compile(_p));
+  }
+
 
 
   } // namespace backend
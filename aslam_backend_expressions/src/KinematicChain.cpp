@@ -1,5 +1,9 @@
 #include <aslam/backend/KinematicChain.hpp>
 
+#include <algorithm>
+#include <aslam/Exceptions.hpp>
+#include <aslam/backend/util/ThreadedRangeProcessor.hpp>
+
 namespace aslam {
 namespace backend {
 
@@ -14,17 +18,102 @@ void aslam::backend::CoordinateFrame::initGlobalsWithoutParent() {
 
 const aslam::backend::EuclideanExpression& CoordinateFrame::getVG() const {
   if (pp && vG.isEmpty()) {
-    vG = pp->getVG() + pp->getR_G_L() * v + pp->getOmegaG().cross(pp->getR_G_L() * p);  //TODO have a caching variable for (pp->getR_G_L() * p)!
+    vG = cached(pp->getVG() + pp->getR_G_L() * v + pp->getOmegaG().cross(pp->getR_G_L() * p));  //TODO have a caching variable for (pp->getR_G_L() * p)!
   }
   return vG;
 }
 
 const aslam::backend::EuclideanExpression& CoordinateFrame::getAG() const {
   if (pp && aG.isEmpty()) {
-    aG = pp->getAG() + pp->getR_G_L() * a + pp->getOmegaG().cross(pp->getR_G_L() * v) + pp->getAlphaG().cross(pp->getR_G_L() * p) + pp->getOmegaG().cross(pp->getOmegaG().cross(pp->getR_G_L() * p));
+    aG = cached(pp->getAG() + pp->getR_G_L() * a + pp->getOmegaG().cross(pp->getR_G_L() * v) + pp->getAlphaG().cross(pp->getR_G_L() * p) + pp->getOmegaG().cross(pp->getOmegaG().cross(pp->getR_G_L() * p)));
   }
   return aG;
 }
 
+void CoordinateFrame::cacheGlobals() {
+  _cacheGlobals = true;
+  R_G_L = cached(R_G_L);
+  pG = cached(pG);
+  vG = cached(vG);
+  aG = cached(aG);
+  omegaG = cached(omegaG);
+  alphaG = cached(alphaG);
+  getR_G_L();
+  getPG();
+  getVG();
+  getAG();
+  getOmegaG();
+  getAlphaG();
+}
+
+namespace {
+template <typename Expression>
+void updateCache(const Expression & e) {
+  if (!e.isEmpty())
+    dynamic_cast<const CacheInterface&>(*e.root()).updateCache();
+}
+}
+
+void CoordinateFrame::updateGlobalCaches() const {
+  SM_ASSERT_TRUE(aslam::InvalidArgumentException, _cacheGlobals, "The global expressions of the frame are not cached");
+  // Only reads the members, such that frames can be updated concurrently
+  updateCache(R_G_L);
+  updateCache(pG);
+  updateCache(omegaG);
+  updateCache(vG);
+  updateCache(alphaG);
+  updateCache(aG);
+}
+
+void KinematicTree::addFrame(CoordinateFrame & frame) {
+  SM_ASSERT_TRUE(aslam::InvalidArgumentException, std::find(_frames.begin(), _frames.end(), &frame) == _frames.end(), "The frame was already added");
+  const CoordinateFrame * parent = frame.getParent().get();
+  const std::size_t index = _frames.size();
+  if (parent == nullptr) {
+    _roots.push_back(index);
+  } else {
+    auto it = std::find(_frames.begin(), _frames.end(), parent);
+    SM_ASSERT_TRUE(aslam::InvalidArgumentException, it != _frames.end(), "The parent of a frame must be added before the frame");
+    _children[it - _frames.begin()].push_back(index);
+  }
+  frame.cacheGlobals();
+  _frames.push_back(&frame);
+  _children.emplace_back();
+}
+
+void KinematicTree::evaluate(std::size_t nThreads) const {
+  SM_ASSERT_GT(aslam::InvalidArgumentException, nThreads, 0, "");
+  // Split the tree into a trunk evaluated first and independent subtrees evaluated in parallel afterwards,
+  // expanding the largest subtree until there are enough for all threads
+  std::vector<std::size_t> trunk, subtrees(_roots), sizes(_frames.size(), 1);
+  for (std::size_t i = _frames.size(); i-- > 0; )
+    for (std::size_t c : _children[i])
+      sizes[i] += sizes[c];
+  while (nThreads > 1 && subtrees.size() < nThreads) {
+    auto largest = std::max_element(subtrees.begin(), subtrees.end(), [&](std::size_t a, std::size_t b) { return sizes[a] < sizes[b]; });
+    if (largest == subtrees.end() || _children[*largest].empty())
+      break;
+    const std::size_t root = *largest;
+    subtrees.erase(largest);
+    trunk.push_back(root);
+    subtrees.insert(subtrees.end(), _children[root].begin(), _children[root].end());
+  }
+  for (std::size_t i : trunk)
+    _frames[i]->updateGlobalCaches();
+  util::runThreadedJob([&](std::size_t /* threadId */, std::size_t start, std::size_t end) {
+    std::vector<std::size_t> stack;
+    for (std::size_t s = start; s < end; ++s) {
+      // Parents before their children
+      stack.assign(1, subtrees[s]);
+      while (!stack.empty()) {
+        const std::size_t i = stack.back();
+        stack.pop_back();
+        _frames[i]->updateGlobalCaches();
+        stack.insert(stack.end(), _children[i].begin(), _children[i].end());
+      }
+    }
+  }, subtrees.size(), nThreads);
+}
+
 }  // namespace backend
 }  // namespace aslam
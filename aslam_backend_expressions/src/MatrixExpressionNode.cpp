@@ -1,4 +1,5 @@
 #include <aslam/backend/MatrixExpressionNode.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 namespace aslam {
 namespace backend {
@@ -13,10 +14,12 @@ MatrixExpressionNode::~MatrixExpressionNode() {
 }
 
 Eigen::Matrix3d MatrixExpressionNode::evaluate() {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
   return evaluateImplementation();
 }
 
 void MatrixExpressionNode::evaluateJacobians(JacobianContainer & outJacobians, const Eigen::MatrixXd & applyChainRule) const {
+  ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
   evaluateJacobiansImplementation(outJacobians, applyChainRule);
 }
 
@@ -0,0 +1,254 @@
+#include <aslam/backend/PointTransformationErrorTermBatch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <sm/kinematics/rotations.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+
+namespace aslam {
+  namespace backend {
+
+    PointTransformationErrorTermBatch::Member::Member(PointTransformationErrorTermBatch& batch, std::size_t index, const Eigen::Matrix3d& invR)
+        : _batch(batch)
+    {
+      const Pose& pose = batch._poses[batch._poseIndices[index]];
+      setDesignVariables(pose.rotation, pose.translation, batch._points[batch._pointIndices[index]]);
+      setInvR(invR);
+    }
+
+    double PointTransformationErrorTermBatch::Member::evaluateErrorImplementation()
+    {
+      const std::size_t i = batchIndex();
+      _batch.update(i);
+      setError(Eigen::Vector3d(_batch._errors[0][i], _batch._errors[1][i], _batch._errors[2][i]));
+      return evaluateChiSquaredError();
+    }
+
+    void PointTransformationErrorTermBatch::Member::evaluateJacobiansImplementation(JacobianContainer& outJacobians)
+    {
+      const std::size_t i = batchIndex();
+      _batch.update(i);
+      const Pose& pose = _batch._poses[_batch._poseIndices[i]];
+      const Eigen::Vector3d Cp(_batch._rotatedPoints[0][i], _batch._rotatedPoints[1][i], _batch._rotatedPoints[2][i]);
+      outJacobians.add(pose.rotation, sm::kinematics::crossMx(Cp));
+      outJacobians.add(pose.translation, Eigen::Matrix3d::Identity());
+      outJacobians.add(_batch._points[_batch._pointIndices[i]], pose.rotation->toRotationMatrix());
+    }
+
+    std::size_t PointTransformationErrorTermBatch::addPose(RotationQuaternion* rotation, EuclideanPoint* translation)
+    {
+      SM_ASSERT_TRUE(Exception, rotation != nullptr && translation != nullptr, "The pose must not be null");
+      _poses.push_back(Pose{rotation, translation});
+      return _poses.size() - 1;
+    }
+
+    std::size_t PointTransformationErrorTermBatch::addPoint(EuclideanPoint* point)
+    {
+      SM_ASSERT_TRUE(Exception, point != nullptr, "The point must not be null");
+      _points.push_back(point);
+      return _points.size() - 1;
+    }
+
+    PointTransformationErrorTermBatch::MemberPtr PointTransformationErrorTermBatch::addErrorTerm(std::size_t pose, std::size_t point,
+                                                                                                 const Eigen::Vector3d& measurement, const Eigen::Matrix3d& invR)
+    {
+      SM_ASSERT_LT(Exception, pose, _poses.size(), "Unknown pose");
+      SM_ASSERT_LT(Exception, point, _points.size(), "Unknown point");
+      SM_ASSERT_LT(Exception, _members.size(), std::size_t(std::numeric_limits<std::uint32_t>::max()), "Too many error terms");
+      const std::size_t index = _members.size();
+      _poseIndices.push_back(static_cast<std::uint32_t>(pose));
+      _pointIndices.push_back(static_cast<std::uint32_t>(point));
+      for (int r = 0; r < 3; ++r) {
+        _measurements[r].push_back(measurement[r]);
+        _rotatedPoints[r].push_back(0.0);
+        _errors[r].push_back(0.0);
+      }
+      _versions.push_back(std::numeric_limits<version_t>::max());
+      _members.emplace_back(new Member(*this, index, invR));
+      setMember(*_members.back(), index);
+      return _members.back();
+    }
+
+    void PointTransformationErrorTermBatch::reserve(std::size_t numErrorTerms)
+    {
+      _members.reserve(numErrorTerms);
+      _poseIndices.reserve(numErrorTerms);
+      _pointIndices.reserve(numErrorTerms);
+      for (int r = 0; r < 3; ++r) {
+        _measurements[r].reserve(numErrorTerms);
+        _rotatedPoints[r].reserve(numErrorTerms);
+        _errors[r].reserve(numErrorTerms);
+      }
+      _versions.reserve(numErrorTerms);
+    }
+
+    const PointTransformationErrorTermBatch::MemberPtr& PointTransformationErrorTermBatch::errorTerm(std::size_t i) const
+    {
+      SM_ASSERT_LT_DBG(Exception, i, _members.size(), "Index out of bounds");
+      return _members[i];
+    }
+
+    PointTransformationErrorTermBatch::version_t PointTransformationErrorTermBatch::currentVersion(std::size_t i) const
+    {
+      const Pose& pose = _poses[_poseIndices[i]];
+      return pose.rotation->updateCount() + pose.translation->updateCount() + _points[_pointIndices[i]]->updateCount();
+    }
+
+    void PointTransformationErrorTermBatch::update(std::size_t i)
+    {
+      if (_versions[i] != currentVersion(i))
+        evaluate(i);
+    }
+
+    void PointTransformationErrorTermBatch::evaluate(std::size_t i)
+    {
+      const Pose& pose = _poses[_poseIndices[i]];
+      const Eigen::Vector3d Cp = pose.rotation->toRotationMatrix() * _points[_pointIndices[i]]->toEuclidean();
+      const Eigen::Vector3d t = pose.translation->toEuclidean();
+      for (int r = 0; r < 3; ++r) {
+        _rotatedPoints[r][i] = Cp[r];
+        _errors[r][i] = Cp[r] + t[r] - _measurements[r][i];
+      }
+      _versions[i] = currentVersion(i);
+    }
+
+    void PointTransformationErrorTermBatch::prefetchErrors(std::size_t begin, std::size_t end)
+    {
+      SM_ASSERT_LE_DBG(Exception, end, _members.size(), "Index out of bounds");
+      typedef Eigen::Array<double, BlockSize, 1> Lanes;
+
+      // Consecutive error terms usually share their pose
+      std::size_t lastPose = std::numeric_limits<std::size_t>::max();
+      Eigen::Matrix3d C;
+      Eigen::Vector3d t;
+
+      std::size_t block = begin;
+      for (; block + BlockSize <= end; block += BlockSize) {
+        // Gather the inputs
+        Lanes CLanes[9], tLanes[3], pLanes[3], yLanes[3];
+        for (std::size_t l = 0; l < std::size_t(BlockSize); ++l) {
+          const std::size_t i = block + l;
+          if (_poseIndices[i] != lastPose) {
+            lastPose = _poseIndices[i];
+            C = _poses[lastPose].rotation->toRotationMatrix();
+            t = _poses[lastPose].translation->toEuclidean();
+          }
+          const Eigen::Vector3d& p = _points[_pointIndices[i]]->toEuclidean();
+          for (int k = 0; k < 9; ++k)
+            CLanes[k][l] = C.data()[k];
+          for (int r = 0; r < 3; ++r) {
+            tLanes[r][l] = t[r];
+            pLanes[r][l] = p[r];
+            yLanes[r][l] = _measurements[r][i];
+          }
+        }
+
+        // e = C p + t - y for all lanes, C is column major
+        for (int r = 0; r < 3; ++r) {
+          const Lanes Cp = CLanes[r] * pLanes[0] + CLanes[r + 3] * pLanes[1] + CLanes[r + 6] * pLanes[2];
+          const Lanes e = Cp + tLanes[r] - yLanes[r];
+          for (std::size_t l = 0; l < std::size_t(BlockSize); ++l) {
+            _rotatedPoints[r][block + l] = Cp[l];
+            _errors[r][block + l] = e[l];
+          }
+        }
+        for (std::size_t l = 0; l < std::size_t(BlockSize); ++l)
+          _versions[block + l] = currentVersion(block + l);
+      }
+      // The remainder of a partial block
+      for (; block < end; ++block)
+        evaluate(block);
+    }
+
+    Eigen::Matrix3d PointTransformationErrorTermBatch::weight(std::size_t i, bool useMEstimator) const
+    {
+      const Member& member = *_members[i];
+      const double sqrtWeight = useMEstimator ? std::sqrt(member.getMEstimatorWeight(member.getRawSquaredError())) : 1.0;
+      return sqrtWeight * member.sqrtInvR().transpose();
+    }
+
+    void PointTransformationErrorTermBatch::evaluateJacobian(std::size_t i, bool useMEstimator, JacobianSink& sink) const
+    {
+      const Eigen::Matrix3d W = weight(i, useMEstimator);
+      const Eigen::Vector3d Cp(_rotatedPoints[0][i], _rotatedPoints[1][i], _rotatedPoints[2][i]);
+      const Eigen::Vector3d e(_errors[0][i], _errors[1][i], _errors[2][i]);
+      // The design variables are ordered as rotation, translation, point
+      Eigen::Matrix<double, 3, 9> J;
+      J.leftCols<3>() = W * sm::kinematics::crossMx(Cp);
+      J.middleCols<3>(3) = W;
+      J.rightCols<3>() = W * _poses[_poseIndices[i]].rotation->toRotationMatrix();
+      sink.write(i, J, W * e);
+    }
+
+    void PointTransformationErrorTermBatch::evaluateJacobians(std::size_t begin, std::size_t end, bool useMEstimator, JacobianSink& sink)
+    {
+      SM_ASSERT_LE_DBG(Exception, end, _members.size(), "Index out of bounds");
+      typedef Eigen::Array<double, BlockSize, 1> Lanes;
+
+      // The errors are usually up to date, as they are evaluated before the Jacobians
+      for (std::size_t i = begin; i < end; ++i)
+        update(i);
+
+      std::size_t lastPose = std::numeric_limits<std::size_t>::max();
+      Eigen::Matrix3d C;
+      Eigen::Matrix<double, 3, 9> J;
+      Eigen::Vector3d we;
+
+      std::size_t block = begin;
+      for (; block + BlockSize <= end; block += BlockSize) {
+        // Gather the weights W, the rotations, the rotated points and the errors, all matrices are column major
+        Lanes WLanes[9], CLanes[9], CpLanes[3], eLanes[3];
+        for (std::size_t l = 0; l < std::size_t(BlockSize); ++l) {
+          const std::size_t i = block + l;
+          if (_poseIndices[i] != lastPose) {
+            lastPose = _poseIndices[i];
+            C = _poses[lastPose].rotation->toRotationMatrix();
+          }
+          const Eigen::Matrix3d W = weight(i, useMEstimator);
+          for (int k = 0; k < 9; ++k) {
+            WLanes[k][l] = W.data()[k];
+            CLanes[k][l] = C.data()[k];
+          }
+          for (int r = 0; r < 3; ++r) {
+            CpLanes[r][l] = _rotatedPoints[r][i];
+            eLanes[r][l] = _errors[r][i];
+          }
+        }
+
+        // Row r of W crossMx(Cp), W, W C and W e for all lanes
+        Lanes JLanes[3][9], weLanes[3];
+        for (int r = 0; r < 3; ++r) {
+          const Lanes& W0 = WLanes[r];
+          const Lanes& W1 = WLanes[r + 3];
+          const Lanes& W2 = WLanes[r + 6];
+          JLanes[r][0] = W1 * CpLanes[2] - W2 * CpLanes[1];
+          JLanes[r][1] = W2 * CpLanes[0] - W0 * CpLanes[2];
+          JLanes[r][2] = W0 * CpLanes[1] - W1 * CpLanes[0];
+          JLanes[r][3] = W0;
+          JLanes[r][4] = W1;
+          JLanes[r][5] = W2;
+          for (int c = 0; c < 3; ++c)
+            JLanes[r][6 + c] = W0 * CLanes[3 * c] + W1 * CLanes[3 * c + 1] + W2 * CLanes[3 * c + 2];
+          weLanes[r] = W0 * eLanes[0] + W1 * eLanes[1] + W2 * eLanes[2];
+        }
+
+        // Hand the Jacobians to the sink, which writes them in bulk
+        for (std::size_t l = 0; l < std::size_t(BlockSize); ++l) {
+          for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 9; ++c)
+              J(r, c) = JLanes[r][c][l];
+            we[r] = weLanes[r][l];
+          }
+          sink.write(block + l, J, we);
+        }
+      }
+      // The remainder of a partial block
+      for (; block < end; ++block)
+        evaluateJacobian(block, useMEstimator, sink);
+    }
+
+  } // namespace backend
+} // namespace aslam
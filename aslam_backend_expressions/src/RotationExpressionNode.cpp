@@ -1,5 +1,6 @@
 #include <aslam/backend/ExpressionNodeVisitor.hpp>
 #include <aslam/backend/RotationExpressionNode.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 
 namespace aslam {
   namespace backend {
@@ -20,6 +21,11 @@ namespace aslam {
       visitor.visit("C", this);
     }
 
+    int RotationExpressionNode::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      return builder.addLeaf(this);
+    }
+
     /////////////////////////////////////////////////
     // ConstantRotationExpression: A container for a contant matrix
     /////////////////////////////////////////////////
@@ -42,6 +48,10 @@ namespace aslam {
     void ConstantRotationExpressionNode::getDesignVariablesImplementation(DesignVariable::set_t & /* designVariables */) const {
     }
 
+    int ConstantRotationExpressionNode::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addConstant(_C);
+    }
+
 
 
     /////////////////////////////////////////////////
@@ -74,6 +84,10 @@ namespace aslam {
       _rhs->getDesignVariables(designVariables);
     }
 
+    int RotationExpressionNodeMultiply::compileTape(ExpressionTapeBuilder& builder) const {
+      return builder.addOperation(ExpressionTape::ROTATION_MULTIPLY, builder.compile(_lhs), builder.compile(_rhs));
+    }
+
 
     ////////////////////////////////////////////////////
     // RotationExpressionNodeInverse: A container for C^T
@@ -102,6 +116,11 @@ namespace aslam {
       _dvRotation->getDesignVariables(designVariables);
     }
 
+    int RotationExpressionNodeInverse::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      return builder.addOperation(ExpressionTape::ROTATION_INVERSE, builder.compile(_dvRotation));
+    }
+
 
   RotationExpressionNodeTransformation::RotationExpressionNodeTransformation(boost::shared_ptr<TransformationExpressionNode> transformation) :
       _transformation(transformation) {
@@ -119,7 +138,7 @@ namespace aslam {
   }
 
   void RotationExpressionNodeTransformation::evaluateJacobiansImplementation(JacobianContainer & outJacobians) const {
-    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(3,6);
+    Eigen::Matrix<double, 3, 6> J = Eigen::Matrix<double, 3, 6>::Zero();
     J.topRightCorner<3,3>() = Eigen::Matrix3d::Identity();
     _transformation->evaluateJacobians(outJacobians, J);
   }
@@ -128,6 +147,10 @@ namespace aslam {
     _transformation->getDesignVariables(designVariables);
   }
 
+  int RotationExpressionNodeTransformation::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addOperation(ExpressionTape::ROTATION_FROM_TRANSFORMATION, builder.compile(_transformation));
+  }
+
 
   
   } // namespace backend
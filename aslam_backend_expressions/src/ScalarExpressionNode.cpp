@@ -1,5 +1,6 @@
 #include <aslam/backend/ExpressionNodeVisitor.hpp>
 #include <aslam/backend/ScalarExpressionNode.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 #include <sm/kinematics/rotations.hpp>
 
 namespace aslam {
@@ -313,6 +314,30 @@ namespace aslam {
         void ScalarExpressionNodeConstant::accept(ExpressionNodeVisitor& visitor) {
           visitor.visit("#", this);
         }
+
+        int ScalarExpressionNode::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addLeaf(this);
+        }
+
+        int ScalarExpressionNodeMultiply::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addOperation(ExpressionTape::SCALAR_MULTIPLY, builder.compile(_lhs), builder.compile(_rhs));
+        }
+
+        int ScalarExpressionNodeDivide::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addOperation(ExpressionTape::SCALAR_DIVIDE, builder.compile(_lhs), builder.compile(_rhs));
+        }
+
+        int ScalarExpressionNodeNegated::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addOperation(ExpressionTape::SCALAR_NEGATE, builder.compile(_rhs));
+        }
+
+        int ScalarExpressionNodeAdd::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addOperation(ExpressionTape::SCALAR_ADD, builder.compile(_lhs), builder.compile(_rhs), _multiplyRhs);
+        }
+
+        int ScalarExpressionNodeConstant::compileTape(ExpressionTapeBuilder& builder) const {
+          return builder.addConstant(_s);
+        }
     } // namespace backend
 }  // namespace aslam
 
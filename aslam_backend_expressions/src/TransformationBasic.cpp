@@ -2,6 +2,7 @@
 #include <aslam/backend/RotationExpressionNode.hpp>
 #include <aslam/backend/EuclideanExpressionNode.hpp>
 #include <sm/kinematics/rotations.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 
 namespace aslam {
   namespace backend {
@@ -59,6 +60,13 @@ namespace aslam {
 
 
 
+    int TransformationBasic::compileTape(ExpressionTapeBuilder& builder) const
+    {
+      const int rotation = _rotation ? builder.compile(_rotation) : builder.addConstant(Eigen::Matrix3d::Identity().eval());
+      const int translation = _translation ? builder.compile(_translation) : builder.addConstant(Eigen::Vector3d::Zero().eval());
+      return builder.addOperation(ExpressionTape::TRANSFORMATION_FROM_ROTATION_TRANSLATION, rotation, translation);
+    }
+
     TransformationExpression TransformationBasic::toExpression()
     {
       return TransformationExpression(this);
@@ -3,6 +3,7 @@
 #include <aslam/backend/EuclideanExpression.hpp>
 #include <aslam/backend/EuclideanExpressionNode.hpp>
 #include <aslam/backend/ExpressionNodeVisitor.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
 #include <aslam/backend/RotationExpression.hpp>
 #include <aslam/backend/RotationExpressionNode.hpp>
 #include <Eigen/Dense>
@@ -19,6 +20,7 @@ namespace aslam {
 
     void TransformationExpressionNode::evaluateJacobians(JacobianContainer & outJacobians) const
     {
+      ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Jacobians);
       evaluateJacobiansImplementation(outJacobians);
     }      
       
@@ -118,5 +120,21 @@ namespace aslam {
     visitor.visit("#", this);
   }
 
+  int TransformationExpressionNode::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addLeaf(this);
+  }
+
+  int TransformationExpressionNodeMultiply::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addOperation(ExpressionTape::TRANSFORMATION_MULTIPLY, builder.compile(_lhs), builder.compile(_rhs));
+  }
+
+  int TransformationExpressionNodeInverse::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addOperation(ExpressionTape::TRANSFORMATION_INVERSE, builder.compile(_dvTransformation));
+  }
+
+  int TransformationExpressionNodeConstant::compileTape(ExpressionTapeBuilder& builder) const {
+    return builder.addConstant(_T);
+  }
+
   } // namespace backend
 }  // namespace aslam
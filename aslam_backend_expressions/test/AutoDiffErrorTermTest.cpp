@@ -0,0 +1,126 @@
+#include <sm/eigen/gtest.hpp>
+#include <aslam/backend/AutoDiffErrorTerm.hpp>
+#include <aslam/backend/DualNumber.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/GenericScalar.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/Scalar.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+
+using namespace aslam::backend;
+
+namespace {
+
+/// \brief e = (s p_x sin(p_y) - y_0, exp(s p_z) / (1 + p_x^2) - y_1)
+struct TestFunctor {
+  template <typename T>
+  void operator()(const T* const* parameters, T* error) const {
+    using std::sin;
+    using std::exp;
+    const T* p = parameters[0];
+    const T& s = parameters[1][0];
+    error[0] = s * p[0] * sin(p[1]) - y[0];
+    error[1] = exp(s * p[2]) / (1.0 + p[0] * p[0]) - y[1];
+  }
+  Eigen::Vector2d y;
+};
+
+template <int N>
+void testAutoDiffErrorTerm() {
+  EuclideanPoint p(Eigen::Vector3d::Random());
+  Scalar s(0.5);
+  TestFunctor functor;
+  functor.y = Eigen::Vector2d::Random();
+
+  AutoDiffErrorTerm<2, TestFunctor, N> errorTerm(functor, { &p, &s });
+  EXPECT_EQ(4, errorTerm.numDerivatives());
+
+  const Eigen::Vector3d pv = p.toEuclidean();
+  errorTerm.evaluateError();
+  const Eigen::Vector2d expected(0.5 * pv[0] * sin(pv[1]) - functor.y[0], exp(0.5 * pv[2]) / (1.0 + pv[0] * pv[0]) - functor.y[1]);
+  sm::eigen::assertNear(expected, errorTerm.error(), 1e-12, SM_SOURCE_FILE_POS);
+
+  // The Jacobians match finite differences and the error evaluated with them
+  SCOPED_TRACE("");
+  testErrorTerm(errorTerm);
+  JacobianContainerSparse<> J(2);
+  errorTerm.evaluateJacobians(J);
+  sm::eigen::assertNear(expected, errorTerm.error(), 1e-12, SM_SOURCE_FILE_POS);
+}
+
+} // namespace
+
+TEST(AutoDiffErrorTermTestSuite, testDualNumber)
+{
+  typedef DualNumber<double, 2> Dual;
+  const double xv = 0.3, yv = 0.7;
+  const Dual x = Dual::variable(xv, 0), y = Dual::variable(yv, 1);
+
+  auto expectNear = [](const Dual& actual, double value, double dx, double dy) {
+    EXPECT_NEAR(value, actual.value(), 1e-12);
+    EXPECT_NEAR(dx, actual.derivatives()[0], 1e-12);
+    EXPECT_NEAR(dy, actual.derivatives()[1], 1e-12);
+  };
+  expectNear(x * y + 2.0, xv * yv + 2.0, yv, xv);
+  expectNear(x / y, xv / yv, 1.0 / yv, -xv / (yv * yv));
+  expectNear(1.0 / x - y, 1.0 / xv - yv, -1.0 / (xv * xv), -1.0);
+  expectNear(sqrt(x), std::sqrt(xv), 0.5 / std::sqrt(xv), 0.0);
+  expectNear(sin(x) * cos(y), std::sin(xv) * std::cos(yv), std::cos(xv) * std::cos(yv), -std::sin(xv) * std::sin(yv));
+  expectNear(atan2(y, x), std::atan2(yv, xv), -yv / (xv * xv + yv * yv), xv / (xv * xv + yv * yv));
+  expectNear(pow(x, y), std::pow(xv, yv), yv * std::pow(xv, yv - 1), std::pow(xv, yv) * std::log(xv));
+  expectNear(log(exp(x)), xv, 1.0, 0.0);
+  expectNear(abs(-x), xv, 1.0, 0.0);
+  EXPECT_TRUE(x < y);
+  EXPECT_TRUE(y > 0.5);
+
+  // Integer operands convert to the scalar type
+  expectNear(2 * x, 2 * xv, 2.0, 0.0);
+  expectNear(y * 2, 2 * yv, 0.0, 2.0);
+  expectNear(x + 1 - y / 2, xv + 1 - yv / 2, 1.0, -0.5);
+  expectNear(1 - x, 1 - xv, -1.0, 0.0);
+  EXPECT_TRUE(x < 1);
+  EXPECT_DOUBLE_EQ(xv, static_cast<double>(x));
+
+  // Constants have no derivatives with a dynamic number of variables
+  typedef DualNumber<double> DynamicDual;
+  const DynamicDual a = DynamicDual::variable(xv, 1, 3), c(2.0);
+  EXPECT_EQ(0, c.derivatives().size());
+  const DynamicDual b = c * a - c + a;
+  EXPECT_NEAR(3 * xv - 2, b.value(), 1e-12);
+  sm::eigen::assertNear(Eigen::Vector3d(0, 3, 0), b.derivatives(), 1e-12, SM_SOURCE_FILE_POS);
+
+  // Eigen matrices of dual numbers
+  Eigen::Matrix<Dual, 2, 2> M;
+  M << x, y, 1.0, x * y;
+  const Eigen::Matrix<Dual, 2, 1> v = M * Eigen::Matrix<Dual, 2, 1>(y, Dual(2.0));
+  expectNear(v[0], xv * yv + 2 * yv, yv, xv + 2);
+  expectNear(v[1], yv + 2 * xv * yv, 2 * yv, 1 + 2 * xv);
+}
+
+TEST(AutoDiffErrorTermTestSuite, testGenericScalar)
+{
+  typedef DualNumber<double, 1> Dual;
+  GenericScalar<Dual> s(Dual::variable(2.0, 0));
+  const Dual value = (s.toExpression() * s.toExpression()).evaluate();
+  EXPECT_DOUBLE_EQ(4.0, value.value());
+  EXPECT_DOUBLE_EQ(4.0, value.derivatives()[0]);
+  const double dx = 1.0;
+  s.update(&dx, 1);
+  EXPECT_DOUBLE_EQ(3.0, (double)s.getValue());
+}
+
+TEST(AutoDiffErrorTermTestSuite, testAutoDiffErrorTerm)
+{
+  try {
+    {
+      SCOPED_TRACE("Fixed number of derivatives");
+      testAutoDiffErrorTerm<4>();
+    }
+    {
+      SCOPED_TRACE("Dynamic number of derivatives");
+      testAutoDiffErrorTerm<Eigen::Dynamic>();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
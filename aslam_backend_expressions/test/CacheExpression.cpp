@@ -8,6 +8,8 @@
 #include <sm/eigen/gtest.hpp>
 #include <sm/random.hpp>
 
+#include <boost/thread.hpp>
+
 #include <aslam/backend/JacobianContainerSparse.hpp>
 #include <aslam/backend/Scalar.hpp>
 #include <aslam/backend/ScalarExpression.hpp>
@@ -17,6 +19,9 @@
 #include <aslam/backend/DesignVariableVector.hpp>
 #include <aslam/backend/VectorExpressionToGenericMatrixTraits.hpp>
 #include <aslam/backend/CacheExpression.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <sm/kinematics/quaternion_algebra.hpp>
 
 #include <aslam/backend/test/ExpressionTests.hpp>
 #include <aslam/backend/test/GenericScalarExpressionTests.hpp>
@@ -65,6 +70,24 @@ TEST(CacheExpressionTestSuites, testCachedExpression)
     EXPECT_EQ(expr2.evaluate(), cexpr2.evaluate());// make sure setParameter() method resets cache
     sm::eigen::assertEqual(evaluateJacobian(expr2), evaluateJacobian(cexpr2), SM_SOURCE_FILE_POS);
 
+    point.setValue(sm::random::rand());
+    EXPECT_EQ(expr2.evaluate(), cexpr2.evaluate());// make sure setValue() method resets cache
+
+    // ************************************** //
+    // Rotation and homogeneous point caches  //
+    // ************************************** //
+    RotationQuaternion quat(sm::kinematics::quatRandom());
+    RotationExpression cquat = toCacheExpression(quat.toExpression());
+    sm::eigen::assertEqual(quat.toRotationMatrix(), cquat.toRotationMatrix(), SM_SOURCE_FILE_POS);
+    quat.set(sm::kinematics::quatRandom());
+    sm::eigen::assertEqual(quat.toRotationMatrix(), cquat.toRotationMatrix(), SM_SOURCE_FILE_POS);// make sure set() method resets cache
+
+    EuclideanPoint euclidean(Eigen::Vector3d::Random());
+    HomogeneousExpression ceuclidean = toCacheExpression(euclidean.toHomogeneousExpression());
+    sm::eigen::assertEqual((Eigen::Vector4d() << euclidean.getValue(), 1.0).finished(), ceuclidean.toHomogeneous(), SM_SOURCE_FILE_POS);
+    euclidean.set(Eigen::Vector3d::Random());
+    sm::eigen::assertEqual((Eigen::Vector4d() << euclidean.getValue(), 1.0).finished(), ceuclidean.toHomogeneous(), SM_SOURCE_FILE_POS);// make sure set() method resets cache
+
     // ***************************** //
     // GenericMatrixExpression cache //
     // ***************************** //
@@ -106,3 +129,42 @@ TEST(CacheExpressionTestSuites, testCachedExpression)
   }
 
 }
+
+TEST(CacheExpressionTestSuites, testConcurrentEvaluation)
+{
+  try
+  {
+    Scalar point(sm::random::rand());
+    point.setBlockIndex(0);
+    point.setColumnBase(0);
+    point.setActive(true);
+    ScalarExpression expr = log(point.toExpression()*point.toExpression() + 1.0);
+    ScalarExpression cexpr = toCacheExpression(expr);
+
+    const int numThreads = 8;
+    for (int round = 0; round < 10; ++round) {
+      const double expected = expr.evaluate();
+      const Eigen::MatrixXd expectedJacobian = evaluateJacobian(expr);
+      std::vector<double> values(numThreads);
+      std::vector<Eigen::MatrixXd> jacobians(numThreads);
+      boost::thread_group threads;
+      for (int t = 0; t < numThreads; ++t) {
+        threads.create_thread([&, t]() {
+          values[t] = cexpr.evaluate();
+          jacobians[t] = evaluateJacobian(cexpr);
+        });
+      }
+      threads.join_all();
+      for (int t = 0; t < numThreads; ++t) {
+        EXPECT_EQ(expected, values[t]);
+        sm::eigen::assertEqual(expectedJacobian, jacobians[t], SM_SOURCE_FILE_POS);
+      }
+      const double dx = sm::random::randn();
+      point.update(&dx, 1);
+    }
+  }
+  catch(std::exception const & e)
+  {
+    FAIL() << e.what();
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef ASLAM_BACKEND_TEST_CODE_GENERATION_EXPRESSIONS_HPP
+#define ASLAM_BACKEND_TEST_CODE_GENERATION_EXPRESSIONS_HPP
+
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/HomogeneousPoint.hpp>
+#include <aslam/backend/Scalar.hpp>
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/HomogeneousExpression.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+
+// Prototype expressions shared by the generator of the test error terms and test/ExpressionCodeGenerator.cpp
+
+struct CodeGenerationDesignVariables {
+  CodeGenerationDesignVariables()
+      : q0(sm::kinematics::quatRandom()), q1(sm::kinematics::quatRandom()),
+        t0(Eigen::Vector3d::Random()), t1(Eigen::Vector3d::Random()), p(Eigen::Vector3d::Random()),
+        h(Eigen::Vector4d::Random()), s(2.0)
+  {
+  }
+
+  void activate() {
+    std::vector<aslam::backend::DesignVariable*> dvs = { &q0, &q1, &t0, &t1, &p, &h, &s };
+    int columnBase = 0;
+    for (std::size_t i = 0; i < dvs.size(); ++i) {
+      dvs[i]->setActive(true);
+      dvs[i]->setBlockIndex(i);
+      dvs[i]->setColumnBase(columnBase);
+      columnBase += dvs[i]->minimalDimensions();
+    }
+  }
+
+  aslam::backend::RotationQuaternion q0, q1;
+  aslam::backend::EuclideanPoint t0, t1, p;
+  aslam::backend::HomogeneousPoint h;
+  aslam::backend::Scalar s;
+};
+
+/// \brief A landmark transformed into a camera frame compared to a measurement
+inline aslam::backend::EuclideanExpression reprojectionExpression(CodeGenerationDesignVariables& dvs, const Eigen::Vector3d& measurement) {
+  aslam::backend::TransformationExpression T_wc(dvs.q0.toExpression(), dvs.t0.toExpression());
+  return T_wc.inverse() * dvs.p.toExpression() - measurement;
+}
+
+inline aslam::backend::HomogeneousExpression homogeneousExpression(CodeGenerationDesignVariables& dvs) {
+  aslam::backend::TransformationExpression T0(dvs.q0.toExpression(), dvs.t0.toExpression());
+  aslam::backend::TransformationExpression T1(dvs.q1.toExpression(), dvs.t1.toExpression());
+  return T1 * T0.inverse() * dvs.h.toExpression();
+}
+
+inline aslam::backend::ScalarExpression scalarExpression(CodeGenerationDesignVariables& dvs, double measurement) {
+  aslam::backend::ScalarExpression s = dvs.s.toExpression();
+  return s * s / (s + 1.0) - measurement;
+}
+
+#endif /* ASLAM_BACKEND_TEST_CODE_GENERATION_EXPRESSIONS_HPP */
@@ -0,0 +1,120 @@
+#include <sstream>
+
+#include <sm/eigen/gtest.hpp>
+#include <aslam/backend/ExpressionCodeGenerator.hpp>
+#include <aslam/backend/ExpressionErrorTerm.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/RotationExpression.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+
+#include "CodeGenerationExpressions.hpp"
+#include <GeneratedTestErrorTerms.hpp>
+
+using namespace aslam::backend;
+
+TEST(ExpressionCodeGeneratorTestSuite, testReprojectionErrorTerm)
+{
+  try {
+    CodeGenerationDesignVariables dvs;
+    dvs.activate();
+
+    for (int i = 0; i < 3; ++i) {
+      // every instance reads its own measurement from the expression
+      const Eigen::Vector3d measurement = Eigen::Vector3d::Random();
+      EuclideanExpression expression = reprojectionExpression(dvs, measurement);
+      EXPECT_EQ(generated::ReprojectionErrorTerm::structureHash(), ExpressionTape::compile(expression)->structureHash());
+
+      auto tree = toErrorTerm(expression);
+      generated::ReprojectionErrorTerm generatedTerm(expression);
+      EXPECT_NEAR(tree->evaluateError(), generatedTerm.evaluateError(), 1e-10);
+      sm::eigen::assertNear(tree->error(), generatedTerm.error(), 1e-10, SM_SOURCE_FILE_POS);
+      EXPECT_EQ(tree->numDesignVariables(), generatedTerm.numDesignVariables());
+
+      JacobianContainerSparse<3> treeJacobians(3), generatedJacobians(3);
+      tree->evaluateJacobians(treeJacobians);
+      generatedTerm.evaluateJacobians(generatedJacobians);
+      sm::eigen::assertNear(treeJacobians.asDenseMatrix(), generatedJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+      {
+        SCOPED_TRACE("");
+        testErrorTerm(generatedTerm, 1e-5);
+      }
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionCodeGeneratorTestSuite, testHomogeneousErrorTerm)
+{
+  try {
+    CodeGenerationDesignVariables dvs;
+    dvs.activate();
+    HomogeneousExpression expression = homogeneousExpression(dvs);
+
+    generated::HomogeneousErrorTerm generatedTerm(expression);
+    generatedTerm.evaluateError();
+    sm::eigen::assertNear(expression.evaluate(), generatedTerm.error(), 1e-10, SM_SOURCE_FILE_POS);
+
+    JacobianContainerSparse<4> treeJacobians(4), generatedJacobians(4);
+    expression.evaluateJacobians(treeJacobians);
+    generatedTerm.evaluateJacobians(generatedJacobians);
+    sm::eigen::assertNear(treeJacobians.asDenseMatrix(), generatedJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+    {
+      SCOPED_TRACE("");
+      testErrorTerm(generatedTerm, 1e-5);
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionCodeGeneratorTestSuite, testScalarErrorTerm)
+{
+  try {
+    CodeGenerationDesignVariables dvs;
+    dvs.activate();
+    ScalarExpression expression = scalarExpression(dvs, 0.5);
+
+    generated::ScalarErrorTerm generatedTerm(expression, 4.0 * Eigen::Matrix<double, 1, 1>::Identity());
+    const double error = expression.evaluate();
+    EXPECT_NEAR(4.0 * error * error, generatedTerm.evaluateError(), 1e-10);
+
+    JacobianContainerSparse<1> treeJacobians(1), generatedJacobians(1);
+    expression.evaluateJacobians(treeJacobians);
+    generatedTerm.evaluateJacobians(generatedJacobians);
+    sm::eigen::assertNear(treeJacobians.asDenseMatrix(), generatedJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+    {
+      SCOPED_TRACE("");
+      testErrorTerm(generatedTerm, 1e-5);
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionCodeGeneratorTestSuite, testTopologyMismatch)
+{
+  CodeGenerationDesignVariables dvs;
+  dvs.activate();
+  EXPECT_THROW(generated::ReprojectionErrorTerm(dvs.p.toExpression() - Eigen::Vector3d::Zero()), ExpressionTape::Exception);
+  EXPECT_THROW(generated::ScalarErrorTerm(dvs.s.toExpression() * dvs.s.toExpression()), ExpressionTape::Exception);
+}
+
+TEST(ExpressionCodeGeneratorTestSuite, testWriteHeader)
+{
+  CodeGenerationDesignVariables dvs;
+  ExpressionCodeGenerator generator("my::generated");
+  generator.addErrorTerm("MyErrorTerm", reprojectionExpression(dvs, Eigen::Vector3d::Zero()));
+
+  std::ostringstream header;
+  EXPECT_THROW(ExpressionCodeGenerator::generateErrorTerm(*ExpressionTape::compile(dvs.q0.toExpression()), "MyRotationErrorTerm",
+                                                          "aslam::backend::RotationExpression", header), ExpressionCodeGenerator::Exception);
+  generator.writeHeader(header, "MY_GUARD");
+  const std::string code = header.str();
+  EXPECT_NE(std::string::npos, code.find("#ifndef MY_GUARD"));
+  EXPECT_NE(std::string::npos, code.find("namespace my {"));
+  EXPECT_NE(std::string::npos, code.find("namespace generated {"));
+  EXPECT_NE(std::string::npos, code.find("class MyErrorTerm : public aslam::backend::ErrorTermFs<3>"));
+  // the interior of the expression does not go through the expression nodes
+  EXPECT_EQ(std::string::npos, code.find("ExpressionNode"));
+}
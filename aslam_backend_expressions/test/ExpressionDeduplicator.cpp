@@ -0,0 +1,148 @@
+#include <sm/eigen/gtest.hpp>
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <aslam/backend/ExpressionDeduplicator.hpp>
+#include <aslam/backend/ExpressionErrorTerm.hpp>
+#include <aslam/backend/OptimizationProblem.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/Scalar.hpp>
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+
+using namespace aslam::backend;
+using sm::kinematics::quatRandom;
+
+namespace {
+
+struct Scene {
+  static constexpr int numPoints = 4;
+
+  Scene() : q0(quatRandom()), q1(quatRandom()), t0(Eigen::Vector3d::Random()), t1(Eigen::Vector3d::Random()), s(0.5)
+  {
+    for (int i = 0; i < numPoints; ++i)
+      points.emplace_back(new EuclideanPoint(Eigen::Vector3d::Random()));
+    int blockIndex = 0, columnBase = 0;
+    for (DesignVariable* dv : designVariables()) {
+      dv->setActive(true);
+      dv->setBlockIndex(blockIndex++);
+      dv->setColumnBase(columnBase);
+      columnBase += dv->minimalDimensions();
+    }
+  }
+
+  std::vector<DesignVariable*> designVariables() {
+    std::vector<DesignVariable*> dvs = { &q0, &q1, &t0, &t1, &s };
+    for (auto& p : points)
+      dvs.push_back(p.get());
+    return dvs;
+  }
+
+  void update() {
+    for (DesignVariable* dv : designVariables()) {
+      const Eigen::VectorXd dx = 0.1*Eigen::VectorXd::Random(dv->minimalDimensions());
+      dv->update(dx.data(), dx.size());
+    }
+  }
+
+  /// \brief Builds the camera pose from new nodes for every call, as independently written error terms do
+  TransformationExpression cameraPose() {
+    TransformationExpression T_wb(q0.toExpression(), t0.toExpression());
+    TransformationExpression T_bc(q1.toExpression(), t1.toExpression());
+    return T_wb * T_bc;
+  }
+
+  EuclideanExpression reprojection(int i) {
+    return cameraPose().inverse() * points[i]->toExpression() - Eigen::Vector3d(1.0, 2.0, 3.0);
+  }
+
+  ScalarExpression prior() {
+    return s.toExpression() * s.toExpression();
+  }
+
+  RotationQuaternion q0, q1;
+  EuclideanPoint t0, t1;
+  Scalar s;
+  std::vector<boost::shared_ptr<EuclideanPoint> > points;
+};
+
+template <typename ErrorTermPtr>
+void expectErrorTermsNear(const std::vector<ErrorTermPtr>& expected, const std::vector<ErrorTermPtr>& actual)
+{
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    const int rows = expected[i]->dimension();
+    EXPECT_NEAR(expected[i]->evaluateError(), actual[i]->evaluateError(), 1e-10);
+    JacobianContainerSparse<> expectedJacobians(rows), actualJacobians(rows);
+    expected[i]->evaluateJacobians(expectedJacobians);
+    actual[i]->evaluateJacobians(actualJacobians);
+    sm::eigen::assertNear(expectedJacobians.asDenseMatrix(), actualJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+  }
+}
+
+} // namespace
+
+TEST(ExpressionDeduplicatorTestSuite, testSharedCameraPose)
+{
+  try {
+    Scene scene;
+    typedef boost::shared_ptr<ExpressionErrorTerm<EuclideanExpression> > ErrorTermPtr;
+    std::vector<ErrorTermPtr> tree, shared;
+    ExpressionDeduplicator deduplicator;
+    for (int i = 0; i < Scene::numPoints; ++i) {
+      tree.push_back(toErrorTerm(scene.reprojection(i)));
+      shared.push_back(toErrorTerm(scene.reprojection(i)));
+      deduplicator.add(*shared.back());
+    }
+    EXPECT_EQ(std::size_t(Scene::numPoints), deduplicator.numErrorTerms());
+
+    const ExpressionDeduplicator::Statistics statistics = deduplicator.apply();
+    EXPECT_EQ(std::size_t(Scene::numPoints), statistics.numErrorTerms);
+    // Only the inverse camera pose is cached, its operands are not shared beyond it
+    EXPECT_EQ(1u, statistics.numCacheNodes);
+    EXPECT_LT(statistics.numUniqueNodes, statistics.numNodes);
+    EXPECT_GT(statistics.deduplicationRatio(), 1.0);
+
+    for (int k = 0; k < 3; ++k) {
+      for (auto& errorTerm : shared)
+        EXPECT_TRUE(errorTerm->usesExpressionTape());
+      expectErrorTermsNear(tree, shared);
+      scene.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionDeduplicatorTestSuite, testOptimizationProblem)
+{
+  try {
+    Scene scene;
+    OptimizationProblem problem;
+    std::vector<boost::shared_ptr<ErrorTerm> > tree, shared;
+    for (int i = 0; i < Scene::numPoints; ++i) {
+      tree.push_back(toErrorTerm(scene.reprojection(i)));
+      shared.push_back(toErrorTerm(scene.reprojection(i)));
+      problem.addErrorTerm(shared.back());
+    }
+    tree.push_back(toErrorTerm(scene.prior()));
+    shared.push_back(toErrorTerm(scene.prior()));
+    problem.addErrorTerm(shared.back());
+    problem.addErrorTerm(toScalarNonSquaredErrorTerm(scene.prior()));
+
+    ExpressionDeduplicator deduplicator;
+    EXPECT_EQ(std::size_t(Scene::numPoints + 2), deduplicator.add(problem));
+    const ExpressionDeduplicator::Statistics statistics = deduplicator.apply();
+    EXPECT_EQ(std::size_t(Scene::numPoints + 2), statistics.numErrorTerms);
+    // The camera pose and the prior shared by the squared and the non-squared error term
+    EXPECT_EQ(2u, statistics.numCacheNodes);
+
+    for (int k = 0; k < 3; ++k) {
+      expectErrorTermsNear(tree, shared);
+      scene.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
@@ -0,0 +1,107 @@
+#include <sstream>
+#include <gtest/gtest.h>
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+
+using namespace aslam::backend;
+
+namespace {
+
+const ExpressionNodeProfiler::Statistics* find(const std::vector<ExpressionNodeProfiler::Statistics>& statistics,
+                                               const std::string& nodeType, ExpressionNodeProfiler::Operation operation)
+{
+  for (auto& s : statistics)
+    if (s.nodeType == nodeType && s.operation == operation)
+      return &s;
+  return nullptr;
+}
+
+struct ProfilerGuard {
+  ProfilerGuard() { ExpressionNodeProfiler::reset(); }
+  ~ProfilerGuard() { ExpressionNodeProfiler::disable(); ExpressionNodeProfiler::reset(); }
+};
+
+} // namespace
+
+TEST(ExpressionNodeProfilerTestSuite, testStatistics)
+{
+  ProfilerGuard guard;
+  RotationQuaternion q(sm::kinematics::quatRandom());
+  EuclideanPoint p(Eigen::Vector3d::Random());
+  q.setActive(true);
+  q.setBlockIndex(0);
+  p.setActive(true);
+  p.setBlockIndex(1);
+  // Nested additions of the same node type
+  EuclideanExpression e = (q.toExpression() * p.toExpression() + p.toExpression()) + p.toExpression();
+
+  // Nothing is recorded while disabled
+  e.evaluate();
+  EXPECT_TRUE(ExpressionNodeProfiler::statistics().empty());
+
+  ExpressionNodeProfiler::enable();
+  const int n = 5;
+  for (int i = 0; i < n; ++i) {
+    e.evaluate();
+    JacobianContainerSparse<3> J(3);
+    e.evaluateJacobians(J);
+  }
+  ExpressionNodeProfiler::disable();
+
+  const std::vector<ExpressionNodeProfiler::Statistics> statistics = ExpressionNodeProfiler::statistics();
+  const ExpressionNodeProfiler::Statistics* add = find(statistics, "aslam::backend::EuclideanExpressionNodeAddEuclidean", ExpressionNodeProfiler::Value);
+  const ExpressionNodeProfiler::Statistics* multiply = find(statistics, "aslam::backend::EuclideanExpressionNodeMultiply", ExpressionNodeProfiler::Jacobians);
+  const ExpressionNodeProfiler::Statistics* point = find(statistics, "aslam::backend::EuclideanPoint", ExpressionNodeProfiler::Value);
+  ASSERT_TRUE(add != nullptr);
+  ASSERT_TRUE(multiply != nullptr);
+  ASSERT_TRUE(point != nullptr);
+  EXPECT_EQ(std::size_t(2 * n), add->calls);
+  EXPECT_EQ(std::size_t(n), multiply->calls);
+  EXPECT_GE(point->calls, std::size_t(3 * n));
+  for (auto& s : statistics) {
+    EXPECT_GE(s.inclusiveSeconds, s.exclusiveSeconds - 1e-12) << s.nodeType;
+    EXPECT_GE(s.inclusiveAllocations, s.exclusiveAllocations) << s.nodeType;
+  }
+
+  std::ostringstream folded, graphviz, table;
+  ExpressionNodeProfiler::writeFoldedStacks(folded);
+  ExpressionNodeProfiler::writeGraphviz(graphviz);
+  ExpressionNodeProfiler::print(table);
+  std::istringstream lines(folded.str());
+  for (std::string line; std::getline(lines, line); ) {
+    const std::size_t space = line.rfind(' ');
+    ASSERT_NE(std::string::npos, space) << line;
+    EXPECT_GT(std::stoll(line.substr(space + 1)), 0) << line;
+  }
+  EXPECT_NE(std::string::npos, folded.str().find("aslam::backend::EuclideanExpressionNodeAddEuclidean::value;aslam::backend::EuclideanExpressionNodeAddEuclidean::value"));
+  EXPECT_EQ(0u, graphviz.str().find("digraph"));
+  EXPECT_NE(std::string::npos, graphviz.str().find("->"));
+  EXPECT_NE(std::string::npos, table.str().find("aslam::backend::EuclideanExpressionNodeMultiply::jacobians"));
+
+  ExpressionNodeProfiler::reset();
+  EXPECT_TRUE(ExpressionNodeProfiler::statistics().empty());
+}
+
+TEST(ExpressionNodeProfilerTestSuite, testAllocations)
+{
+  ProfilerGuard guard;
+  EuclideanPoint p(Eigen::Vector3d::Random());
+  EuclideanExpression e = p.toExpression() + p.toExpression();
+  ExpressionNodeProfiler::enable();
+  {
+    // Allocations are attributed to the innermost open scope
+    ASLAM_BACKEND_PROFILE_EXPRESSION_NODE(Value);
+    ExpressionNodeProfiler::countAllocation();
+    e.evaluate();
+  }
+  ExpressionNodeProfiler::disable();
+  const auto statistics = ExpressionNodeProfiler::statistics();
+  const ExpressionNodeProfiler::Statistics* self = find(statistics, "ExpressionNodeProfilerTestSuite_testAllocations_Test", ExpressionNodeProfiler::Value);
+  ASSERT_TRUE(self != nullptr);
+  EXPECT_EQ(1u, self->exclusiveAllocations);
+  EXPECT_EQ(1u, self->inclusiveAllocations);
+}
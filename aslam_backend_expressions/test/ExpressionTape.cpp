@@ -0,0 +1,202 @@
+#include <sm/eigen/gtest.hpp>
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
+#include <aslam/backend/ExpressionErrorTerm.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/HomogeneousPoint.hpp>
+#include <aslam/backend/Scalar.hpp>
+#include <aslam/backend/ScalarExpression.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/HomogeneousExpression.hpp>
+#include <aslam/backend/RotationExpression.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+
+using namespace aslam::backend;
+using sm::kinematics::quatRandom;
+
+namespace {
+
+struct TestDesignVariables {
+  TestDesignVariables()
+      : q0(quatRandom()), q1(quatRandom()),
+        p0(Eigen::Vector3d::Random()), p1(Eigen::Vector3d::Random()),
+        h0(Eigen::Vector4d::Random()), s0(2.5)
+  {
+    int blockIndex = 0, columnBase = 0;
+    for (DesignVariable* dv : designVariables()) {
+      dv->setActive(true);
+      dv->setBlockIndex(blockIndex++);
+      dv->setColumnBase(columnBase);
+      columnBase += dv->minimalDimensions();
+    }
+  }
+
+  std::vector<DesignVariable*> designVariables() {
+    return { &q0, &q1, &p0, &p1, &h0, &s0 };
+  }
+
+  void update() {
+    for (DesignVariable* dv : designVariables()) {
+      const Eigen::VectorXd dx = 0.1*Eigen::VectorXd::Random(dv->minimalDimensions());
+      dv->update(dx.data(), dx.size());
+    }
+  }
+
+  RotationQuaternion q0, q1;
+  EuclideanPoint p0, p1;
+  HomogeneousPoint h0;
+  Scalar s0;
+};
+
+template <typename Expression>
+void expectJacobiansNear(const Expression& expression, ExpressionTape& tape)
+{
+  JacobianContainerSparse<> treeJacobians(tape.rows()), tapeJacobians(tape.rows());
+  expression.evaluateJacobians(treeJacobians);
+  tape.evaluateJacobians(tapeJacobians);
+  ASSERT_EQ(treeJacobians.numDesignVariables(), tapeJacobians.numDesignVariables());
+  sm::eigen::assertNear(treeJacobians.asDenseMatrix(), tapeJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+}
+
+} // namespace
+
+TEST(ExpressionTapeTestSuite, testTransformation)
+{
+  try {
+    TestDesignVariables dvs;
+    TransformationExpression T0(dvs.q0.toExpression(), dvs.p0.toExpression());
+    TransformationExpression T1(dvs.q1.toExpression(), dvs.p1.toExpression());
+    TransformationExpression T = T0 * T1.inverse() * T0 * TransformationExpression(Eigen::Matrix4d(Eigen::Matrix4d::Identity()));
+
+    ExpressionTape::Ptr tape = ExpressionTape::compile(T);
+    EXPECT_EQ(ExpressionTape::TRANSFORMATION, tape->rootType());
+    EXPECT_EQ(6, tape->rows());
+    // T0 is shared, only the design variables are leaves
+    EXPECT_EQ(4u, tape->numLeaves());
+
+    for (int i = 0; i < 3; ++i) {
+      tape->evaluate();
+      sm::eigen::assertNear(T.toTransformationMatrix(), Eigen::Map<const Eigen::Matrix4d>(tape->rootValue()), 1e-10, SM_SOURCE_FILE_POS);
+      expectJacobiansNear(T, *tape);
+      dvs.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionTapeTestSuite, testRotation)
+{
+  try {
+    TestDesignVariables dvs;
+    TransformationExpression T0(dvs.q0.toExpression(), dvs.p0.toExpression());
+    TransformationExpression T1(dvs.q1.toExpression(), dvs.p1.toExpression());
+    RotationExpression C = dvs.q0.toExpression() * dvs.q1.toExpression().inverse() * (T0 * T1).toRotationExpression();
+
+    ExpressionTape::Ptr tape = ExpressionTape::compile(C);
+    EXPECT_EQ(3, tape->rows());
+    for (int i = 0; i < 3; ++i) {
+      tape->evaluate();
+      sm::eigen::assertNear(C.toRotationMatrix(), Eigen::Map<const Eigen::Matrix3d>(tape->rootValue()), 1e-10, SM_SOURCE_FILE_POS);
+      expectJacobiansNear(C, *tape);
+      dvs.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionTapeTestSuite, testEuclideanAndHomogeneous)
+{
+  try {
+    TestDesignVariables dvs;
+    TransformationExpression T0(dvs.q0.toExpression(), dvs.p0.toExpression());
+    TransformationExpression T1(dvs.q1.toExpression(), dvs.p1.toExpression());
+    EuclideanExpression p0 = dvs.p0.toExpression(), p1 = dvs.p1.toExpression();
+    EuclideanExpression p = dvs.q0.toExpression() * p0.cross(p1) + T0 * p1 - p0 * dvs.s0.toExpression()
+        + (T0 * T1).toEuclideanExpression() - Eigen::Vector3d(1.0, 2.0, 3.0)
+        - (T1 * dvs.h0.toExpression()).toEuclideanExpression() + EuclideanExpression(Eigen::Vector3d(Eigen::Vector3d::Ones()));
+    HomogeneousExpression h = T0.inverse() * dvs.h0.toExpression();
+
+    ExpressionTape::Ptr tape = ExpressionTape::compile(-p);
+    ExpressionTape::Ptr homogeneousTape = ExpressionTape::compile(h);
+    EXPECT_EQ(6u, tape->numLeaves());
+    for (int i = 0; i < 3; ++i) {
+      tape->evaluate();
+      sm::eigen::assertNear(-p.evaluate(), Eigen::Map<const Eigen::Vector3d>(tape->rootValue()), 1e-10, SM_SOURCE_FILE_POS);
+      expectJacobiansNear(-p, *tape);
+
+      homogeneousTape->evaluate();
+      sm::eigen::assertNear(h.evaluate(), Eigen::Map<const Eigen::Vector4d>(homogeneousTape->rootValue()), 1e-10, SM_SOURCE_FILE_POS);
+      expectJacobiansNear(h, *homogeneousTape);
+      dvs.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionTapeTestSuite, testScalar)
+{
+  try {
+    TestDesignVariables dvs;
+    ScalarExpression s = dvs.s0.toExpression();
+    // log is not compiled and becomes a leaf evaluated by the tree interpreter
+    ScalarExpression e = log(s) * s / (s + 1.0) - (-s) * ScalarExpression(3.0);
+
+    ExpressionTape::Ptr tape = ExpressionTape::compile(e);
+    EXPECT_EQ(2u, tape->numLeaves());
+    for (int i = 0; i < 3; ++i) {
+      tape->evaluate();
+      EXPECT_NEAR(e.evaluate(), *tape->rootValue(), 1e-10);
+      expectJacobiansNear(e, *tape);
+      dvs.update();
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(ExpressionTapeTestSuite, testErrorTerms)
+{
+  try {
+    TestDesignVariables dvs;
+    TransformationExpression T0(dvs.q0.toExpression(), dvs.p0.toExpression());
+    EuclideanExpression p = T0.inverse() * dvs.p1.toExpression() - dvs.p0.toExpression() * dvs.s0.toExpression();
+
+    auto tree = toErrorTerm(p);
+    auto tape = toErrorTerm(p);
+    EXPECT_FALSE(tape->usesExpressionTape());
+    EXPECT_TRUE(tape->compileExpressionTape());
+    EXPECT_TRUE(tape->usesExpressionTape());
+
+    EXPECT_NEAR(tree->evaluateError(), tape->evaluateError(), 1e-10);
+    JacobianContainerSparse<3> treeJacobians(3), tapeJacobians(3);
+    tree->evaluateJacobians(treeJacobians);
+    tape->evaluateJacobians(tapeJacobians);
+    sm::eigen::assertNear(treeJacobians.asDenseMatrix(), tapeJacobians.asDenseMatrix(), 1e-10, SM_SOURCE_FILE_POS);
+    {
+      SCOPED_TRACE("");
+      testErrorTerm(tape, 1e-5);
+    }
+
+    auto scalarTerm = toScalarNonSquaredErrorTerm(dvs.s0.toExpression() * dvs.s0.toExpression(), 2.0);
+    const double scalarError = scalarTerm->evaluateError();
+    scalarTerm->compileExpressionTape();
+    EXPECT_TRUE(scalarTerm->usesExpressionTape());
+    EXPECT_NEAR(scalarError, scalarTerm->evaluateError(), 1e-10);
+    {
+      SCOPED_TRACE("");
+      testErrorTerm(scalarTerm, 1e-5);
+    }
+
+    tape->clearExpressionTape();
+    EXPECT_FALSE(tape->usesExpressionTape());
+    EXPECT_NEAR(tree->evaluateError(), tape->evaluateError(), 1e-10);
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
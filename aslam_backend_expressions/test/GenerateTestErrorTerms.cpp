@@ -0,0 +1,29 @@
+// Writes the error terms used by test/ExpressionCodeGenerator.cpp, see CMakeLists.txt
+
+#include <cstdlib>
+#include <iostream>
+
+#include <aslam/backend/ExpressionCodeGenerator.hpp>
+
+#include "CodeGenerationExpressions.hpp"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <output header>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    CodeGenerationDesignVariables dvs;
+    aslam::backend::ExpressionCodeGenerator generator("aslam::backend::generated");
+    generator.addErrorTerm("ReprojectionErrorTerm", reprojectionExpression(dvs, Eigen::Vector3d::Zero()));
+    generator.addErrorTerm("HomogeneousErrorTerm", homogeneousExpression(dvs));
+    generator.addErrorTerm("ScalarErrorTerm", scalarExpression(dvs, 0.0));
+    generator.writeHeader(argv[1]);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
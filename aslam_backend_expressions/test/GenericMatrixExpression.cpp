@@ -2,6 +2,7 @@
 #include <sm/eigen/NumericalDiff.hpp>
 #include <sm/kinematics/rotations.hpp>
 #include <Eigen/Geometry>
+#include <thread>
 #include <aslam/backend/DesignVariableGenericVector.hpp>
 #include <aslam/backend/Scalar.hpp>
 #include <aslam/backend/GenericMatrixExpression.hpp>
@@ -518,3 +519,142 @@ TEST(GenericMatrixExpressionNodeTestSuites, testSquaredNorm) {
     FAIL() << e.what();
   }
 }
+
+namespace {
+/// \brief Counts the evaluations of its operand
+class CountingNode : public GenericMatrixExpressionNode<2, 1, double> {
+ public:
+  CountingNode(DesignVariableGenericVector<2> & dv) : _dv(dv) { }
+  mutable int numEvaluations = 0;
+ protected:
+  void evaluateImplementation() const override {
+    ++numEvaluations;
+    _currentValue = _dv.evaluate();
+  }
+  void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override {
+    _dv.getDesignVariables(designVariables);
+  }
+  void evaluateJacobiansImplementation(JacobianContainer & outJacobians, const differential_t & chainRuleDifferential) const override {
+    _dv.evaluateJacobians(outJacobians, chainRuleDifferential);
+  }
+  /// \brief The value only depends on the design variable
+  bool isCacheableImplementation() const override {
+    return true;
+  }
+ private:
+  DesignVariableGenericVector<2> & _dv;
+};
+
+/// \brief A node adding a vector that is not a design variable
+class OffsetNode : public GenericMatrixExpressionNode<2, 1, double> {
+ public:
+  OffsetNode(DesignVariableGenericVector<2> & dv, const Eigen::Vector2d & offset) : _dv(dv), _offset(offset) { }
+ protected:
+  void evaluateImplementation() const override {
+    _currentValue = _dv.evaluate() + _offset;
+  }
+  void getDesignVariablesImplementation(DesignVariable::set_t & designVariables) const override {
+    _dv.getDesignVariables(designVariables);
+  }
+  void evaluateJacobiansImplementation(JacobianContainer & outJacobians, const differential_t & chainRuleDifferential) const override {
+    _dv.evaluateJacobians(outJacobians, chainRuleDifferential);
+  }
+ private:
+  DesignVariableGenericVector<2> & _dv;
+  const Eigen::Vector2d & _offset;
+};
+}
+
+TEST(GenericMatrixExpressionNodeTestSuites, testIncrementalEvaluation) {
+  try {
+    typedef GenericMatrixExpression<2, 1, double> GVec;
+    DesignVariableGenericVector<2> dv0(Eigen::Vector2d::Random()), dv1(Eigen::Vector2d::Random());
+    boost::shared_ptr<CountingNode> n0(new CountingNode(dv0)), n1(new CountingNode(dv1));
+    GVec e0(n0), e1(n1);
+    auto expr = (e0 + e1).transpose() * e1;
+
+    EXPECT_DOUBLE_EQ((dv0.value() + dv1.value()).dot(dv1.value()), expr.evaluate()(0, 0));
+    EXPECT_EQ(1, n0->numEvaluations);
+    EXPECT_EQ(1, n1->numEvaluations);
+
+    // nothing changed
+    expr.evaluate();
+    EXPECT_EQ(1, n0->numEvaluations);
+    EXPECT_EQ(1, n1->numEvaluations);
+
+    // only the path from dv0 to the root is recomputed
+    const Eigen::Vector2d dx = Eigen::Vector2d::Random();
+    dv0.update(dx.data(), dx.size());
+    EXPECT_DOUBLE_EQ((dv0.value() + dv1.value()).dot(dv1.value()), expr.evaluate()(0, 0));
+    EXPECT_EQ(2, n0->numEvaluations);
+    EXPECT_EQ(1, n1->numEvaluations);
+
+    dv1.update(dx.data(), dx.size());
+    dv0.revertUpdate();
+    EXPECT_DOUBLE_EQ((dv0.value() + dv1.value()).dot(dv1.value()), expr.evaluate()(0, 0));
+    EXPECT_EQ(3, n0->numEvaluations);
+    EXPECT_EQ(2, n1->numEvaluations);
+
+    // invalidate() forces the recomputation of the node, its parents do not know about it
+    n1->invalidate();
+    n1->evaluate();
+    EXPECT_EQ(3, n0->numEvaluations);
+    EXPECT_EQ(3, n1->numEvaluations);
+  }
+  catch(std::exception const & e)
+  {
+    FAIL() << e.what();
+  }
+}
+
+TEST(GenericMatrixExpressionNodeTestSuites, testUncountedStateIsNotCached) {
+  try {
+    typedef GenericMatrixExpression<2, 1, double> GVec;
+    DesignVariableGenericVector<2> dv(Eigen::Vector2d::Random());
+    Eigen::Vector2d offset = Eigen::Vector2d::Random();
+    boost::shared_ptr<OffsetNode> n(new OffsetNode(dv, offset));
+    GVec e(n);
+    auto expr = e.transpose() * GVec(&dv);
+    EXPECT_FALSE(n->isCacheable());
+    EXPECT_FALSE(expr.root()->isCacheable());
+    EXPECT_TRUE((GVec(&dv).transpose() * GVec(&dv)).root()->isCacheable());
+
+    EXPECT_DOUBLE_EQ((dv.value() + offset).dot(dv.value()), expr.evaluate()(0, 0));
+    // the offset changes without an update of the design variable
+    offset = Eigen::Vector2d::Random();
+    EXPECT_DOUBLE_EQ((dv.value() + offset).dot(dv.value()), expr.evaluate()(0, 0));
+  }
+  catch(std::exception const & e)
+  {
+    FAIL() << e.what();
+  }
+}
+
+TEST(GenericMatrixExpressionNodeTestSuites, testConcurrentIncrementalEvaluation) {
+  try {
+    typedef GenericMatrixExpression<2, 1, double> GVec;
+    DesignVariableGenericVector<2> dv(Eigen::Vector2d::Random());
+    boost::shared_ptr<CountingNode> n(new CountingNode(dv));
+    GVec e(n);
+    auto expr = e.transpose() * e;
+    const int numThreads = 4;
+    for (int i = 0; i < 20; ++i) {
+      const Eigen::Vector2d dx = Eigen::Vector2d::Random();
+      dv.update(dx.data(), dx.size());
+      std::vector<double> values(numThreads);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < numThreads; ++t)
+        threads.emplace_back([&expr, &values, t]() { values[t] = expr.evaluate()(0, 0); });
+      for (std::thread & thread : threads)
+        thread.join();
+      // one thread refreshes the value of the new version, the others wait for it
+      EXPECT_EQ(i + 1, n->numEvaluations);
+      for (double value : values)
+        EXPECT_DOUBLE_EQ(dv.value().squaredNorm(), value);
+    }
+  }
+  catch(std::exception const & e)
+  {
+    FAIL() << e.what();
+  }
+}
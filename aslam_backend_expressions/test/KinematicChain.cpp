@@ -3,6 +3,8 @@
 #include <sm/eigen/NumericalDiff.hpp>
 #include <aslam/backend/KinematicChain.hpp>
 #include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <sm/kinematics/quaternion_algebra.hpp>
 #include <aslam/backend/EuclideanExpression.hpp>
 #include <aslam/backend/test/ExpressionTests.hpp>
 
@@ -143,3 +145,81 @@ TEST(KinematicChainTestSuites, testTheoreticallyThreeFrames) {
     sm::eigen::assertEqual(C.getAG().toValue(), (X * -2).eval(), SM_SOURCE_FILE_POS, msg);
   }
 }
+
+namespace {
+
+template <typename Expression>
+void expectSameExpression(const Expression& cached, const Expression& uncached, const std::vector<int>& colBlockIndices, const std::string& msg) {
+  sm::eigen::assertNear(uncached.evaluate(), cached.evaluate(), 1e-12, SM_SOURCE_FILE_POS, msg);
+  JacobianContainerSparse<> Jcached(3), Juncached(3);
+  cached.evaluateJacobians(Jcached);
+  uncached.evaluateJacobians(Juncached);
+  sm::eigen::assertNear(Juncached.asDenseMatrix(colBlockIndices), Jcached.asDenseMatrix(colBlockIndices), 1e-12, SM_SOURCE_FILE_POS, msg);
+}
+
+void expectSameFrame(const CoordinateFrame& cached, const CoordinateFrame& uncached, const std::vector<int>& colBlockIndices) {
+  expectSameExpression(cached.getR_G_L(), uncached.getR_G_L(), colBlockIndices, "R_G_L");
+  expectSameExpression(cached.getPG(), uncached.getPG(), colBlockIndices, "pG");
+  expectSameExpression(cached.getVG(), uncached.getVG(), colBlockIndices, "vG");
+  expectSameExpression(cached.getAG(), uncached.getAG(), colBlockIndices, "aG");
+  expectSameExpression(cached.getOmegaG(), uncached.getOmegaG(), colBlockIndices, "omegaG");
+  expectSameExpression(cached.getAlphaG(), uncached.getAlphaG(), colBlockIndices, "alphaG");
+}
+
+} // namespace
+
+TEST(KinematicChainTestSuites, testKinematicTree) {
+  // Base B with the branches B -> L1 -> L2 and B -> R1
+  const int numFrames = 4;
+  std::vector<boost::shared_ptr<RotationQuaternion> > q;
+  std::vector<boost::shared_ptr<EuclideanPoint> > t, w;
+  std::vector<DesignVariable*> dvs;
+  for (int i = 0; i < numFrames; ++i) {
+    q.emplace_back(new RotationQuaternion(sm::kinematics::quatRandom()));
+    t.emplace_back(new EuclideanPoint(Eigen::Vector3d::Random()));
+    w.emplace_back(new EuclideanPoint(Eigen::Vector3d::Random()));
+    dvs.insert(dvs.end(), { q.back().get(), t.back().get(), w.back().get() });
+  }
+  std::vector<int> colBlockIndices;
+  for (size_t i = 0; i < dvs.size(); ++i) {
+    dvs[i]->setActive(true);
+    dvs[i]->setBlockIndex(i);
+    colBlockIndices.push_back(3 * (i + 1));
+  }
+
+  CoordinateFrame B(q[0]->toExpression(), t[0]->toExpression(), w[0]->toExpression(), Ones, X);
+  CoordinateFrame L1(B, q[1]->toExpression(), t[1]->toExpression(), w[1]->toExpression(), Y);
+  CoordinateFrame L2(L1, q[2]->toExpression(), t[2]->toExpression(), w[2]->toExpression());
+  CoordinateFrame R1(B, q[3]->toExpression(), t[3]->toExpression(), w[3]->toExpression(), Z, Ones);
+
+  CoordinateFrame cB(q[0]->toExpression(), t[0]->toExpression(), w[0]->toExpression(), Ones, X);
+  CoordinateFrame cL1(cB, q[1]->toExpression(), t[1]->toExpression(), w[1]->toExpression(), Y);
+  CoordinateFrame cL2(cL1, q[2]->toExpression(), t[2]->toExpression(), w[2]->toExpression());
+  CoordinateFrame cR1(cB, q[3]->toExpression(), t[3]->toExpression(), w[3]->toExpression(), Z, Ones);
+
+  KinematicTree tree;
+  EXPECT_ANY_THROW(tree.addFrame(cL1));
+  tree.addFrame(cB);
+  tree.addFrame(cL1);
+  tree.addFrame(cR1);
+  tree.addFrame(cL2);
+  EXPECT_ANY_THROW(tree.addFrame(cL2));
+  EXPECT_EQ(4u, tree.numFrames());
+  EXPECT_TRUE(cL2.isCachingGlobals());
+  EXPECT_TRUE(dynamic_cast<const CacheInterface*>(cL2.getAG().root().get()) != nullptr);
+
+  for (size_t nThreads : { 1, 2, 3, 8 }) {
+    SCOPED_TRACE(::testing::Message() << nThreads << " threads");
+    tree.evaluate(nThreads);
+    expectSameFrame(cB, B, colBlockIndices);
+    expectSameFrame(cL1, L1, colBlockIndices);
+    expectSameFrame(cL2, L2, colBlockIndices);
+    expectSameFrame(cR1, R1, colBlockIndices);
+
+    // The caches follow the updates of the design variables
+    for (DesignVariable* dv : dvs) {
+      const Eigen::VectorXd dx = 0.1 * Eigen::VectorXd::Random(dv->minimalDimensions());
+      dv->update(dx.data(), dx.size());
+    }
+  }
+}
@@ -0,0 +1,231 @@
+#include <boost/make_shared.hpp>
+#include <sm/eigen/gtest.hpp>
+#include <sm/kinematics/quaternion_algebra.hpp>
+#include <aslam/backend/PointTransformationErrorTermBatch.hpp>
+#include <aslam/backend/ExpressionErrorTerm.hpp>
+#include <aslam/backend/JacobianContainerSparse.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/BlockCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/SparseCholeskyLinearSystemSolver.hpp>
+#include <aslam/backend/MEstimatorPolicies.hpp>
+#include <aslam/backend/test/ErrorTermTester.hpp>
+
+using namespace aslam::backend;
+using sm::kinematics::quatRandom;
+
+namespace {
+
+struct Scene {
+  static constexpr int numPoses = 3;
+  static constexpr int numPoints = 7;
+  // Not a multiple of the block size to cover partial blocks
+  static constexpr int numErrorTerms = 2 * numPoints + 3;
+
+  Scene() {
+    for (int k = 0; k < numPoses; ++k) {
+      rotations.emplace_back(new RotationQuaternion(quatRandom()));
+      translations.emplace_back(new EuclideanPoint(Eigen::Vector3d::Random()));
+      batch.addPose(rotations.back().get(), translations.back().get());
+    }
+    for (int j = 0; j < numPoints; ++j) {
+      points.emplace_back(new EuclideanPoint(Eigen::Vector3d::Random()));
+      batch.addPoint(points.back().get());
+    }
+    int blockIndex = 0, columnBase = 0;
+    for (DesignVariable* dv : designVariables()) {
+      dv->setActive(true);
+      dv->setBlockIndex(blockIndex++);
+      dv->setColumnBase(columnBase);
+      columnBase += dv->minimalDimensions();
+    }
+
+    batch.reserve(numErrorTerms);
+    int rowBase = 0;
+    for (int i = 0; i < numErrorTerms; ++i) {
+      // Error terms grouped by pose as for observations ordered by frame
+      const int k = i * numPoses / numErrorTerms, j = (i * 5) % numPoints;
+      const Eigen::Vector3d y = Eigen::Vector3d::Random();
+      // Diagonal as ExpressionErrorTerm::evaluateError() weights with sqrtInvR() instead of its transpose
+      const Eigen::Matrix3d invR = (Eigen::Vector3d::Random().array() + 2.0).matrix().asDiagonal();
+
+      batched.push_back(batch.addErrorTerm(k, j, y, invR));
+      EuclideanExpression e = rotations[k]->toExpression() * points[j]->toExpression() + translations[k]->toExpression() - y;
+      tree.push_back(toErrorTerm(e, invR));
+      batched.back()->setRowBase(rowBase);
+      tree.back()->setRowBase(rowBase);
+      rowBase += 3;
+    }
+  }
+
+  std::vector<DesignVariable*> designVariables() {
+    std::vector<DesignVariable*> dvs;
+    for (int k = 0; k < numPoses; ++k) {
+      dvs.push_back(rotations[k].get());
+      dvs.push_back(translations[k].get());
+    }
+    for (auto& p : points)
+      dvs.push_back(p.get());
+    return dvs;
+  }
+
+  template <typename ERROR_TERM_PTR>
+  static std::vector<ErrorTerm*> rawPointers(const std::vector<ERROR_TERM_PTR>& errorTerms) {
+    std::vector<ErrorTerm*> pointers;
+    for (auto& errorTerm : errorTerms)
+      pointers.push_back(errorTerm.get());
+    return pointers;
+  }
+
+  void setMEstimator() {
+    for (size_t i = 0; i < batched.size(); ++i) {
+      batched[i]->setMEstimatorPolicy(boost::make_shared<CauchyMEstimator>(1.0));
+      tree[i]->setMEstimatorPolicy(boost::make_shared<CauchyMEstimator>(1.0));
+    }
+  }
+
+  void update() {
+    for (DesignVariable* dv : designVariables()) {
+      const Eigen::VectorXd dx = 0.1*Eigen::VectorXd::Random(dv->minimalDimensions());
+      dv->update(dx.data(), dx.size());
+    }
+  }
+
+  std::vector<boost::shared_ptr<RotationQuaternion> > rotations;
+  std::vector<boost::shared_ptr<EuclideanPoint> > translations;
+  std::vector<boost::shared_ptr<EuclideanPoint> > points;
+  PointTransformationErrorTermBatch batch;
+  std::vector<PointTransformationErrorTermBatch::MemberPtr> batched;
+  std::vector<boost::shared_ptr<ExpressionErrorTerm<EuclideanExpression> > > tree;
+};
+
+template <typename SOLVER>
+void compareWithTree(Scene& scene, int nThreads, bool useMEstimator)
+{
+  SOLVER batchedSolver, treeSolver;
+  batchedSolver.initMatrixStructure(scene.designVariables(), Scene::rawPointers(scene.batched), false);
+  treeSolver.initMatrixStructure(scene.designVariables(), Scene::rawPointers(scene.tree), false);
+  for (int k = 0; k < 3; ++k) {
+    EXPECT_NEAR(treeSolver.evaluateError(nThreads, useMEstimator), batchedSolver.evaluateError(nThreads, useMEstimator), 1e-9);
+    sm::eigen::assertNear(treeSolver.e(), batchedSolver.e(), 1e-9, SM_SOURCE_FILE_POS, "Checking the error vectors");
+    treeSolver.buildSystem(nThreads, useMEstimator);
+    batchedSolver.buildSystem(nThreads, useMEstimator);
+    sm::eigen::assertNear(treeSolver.rhs(), batchedSolver.rhs(), 1e-9, SM_SOURCE_FILE_POS, "Checking the right-hand sides");
+    if (treeSolver.Hessian() != nullptr) {
+      Eigen::MatrixXd treeH, batchedH;
+      treeSolver.Hessian()->toDenseInto(treeH);
+      batchedSolver.Hessian()->toDenseInto(batchedH);
+      sm::eigen::assertNear(treeH, batchedH, 1e-9, SM_SOURCE_FILE_POS, "Checking the Hessians");
+    }
+    scene.update();
+  }
+}
+
+/// \brief Collects the Jacobians evaluated by a batch
+struct CollectingSink : public ErrorTermBatch::JacobianSink {
+  void write(std::size_t member, const Eigen::Ref<const Eigen::MatrixXd>& J, const Eigen::Ref<const Eigen::VectorXd>& weightedError) override {
+    members.push_back(member);
+    jacobians.push_back(J);
+    weightedErrors.push_back(weightedError);
+  }
+  std::vector<std::size_t> members;
+  std::vector<Eigen::MatrixXd> jacobians;
+  std::vector<Eigen::VectorXd> weightedErrors;
+};
+
+} // namespace
+
+TEST(PointTransformationErrorTermBatchTestSuite, testErrorTerms)
+{
+  try {
+    Scene scene;
+    EXPECT_EQ(std::size_t(Scene::numErrorTerms), scene.batch.numErrorTerms());
+    for (int k = 0; k < 2; ++k) {
+      // Evaluated on their own and prefetched
+      for (bool prefetch : { false, true }) {
+        if (prefetch)
+          scene.batch.prefetchErrors(0, scene.batch.numErrorTerms());
+        for (int i = 0; i < Scene::numErrorTerms; ++i) {
+          EXPECT_EQ(&scene.batch, scene.batched[i]->batch());
+          EXPECT_EQ(std::size_t(i), scene.batched[i]->batchIndex());
+          EXPECT_NEAR(scene.tree[i]->evaluateError(), scene.batched[i]->evaluateError(), 1e-9);
+          sm::eigen::assertNear(scene.tree[i]->error(), scene.batched[i]->error(), 1e-9, SM_SOURCE_FILE_POS);
+          JacobianContainerSparse<> expectedJacobians(3), actualJacobians(3);
+          scene.tree[i]->evaluateJacobians(expectedJacobians);
+          scene.batched[i]->evaluateJacobians(actualJacobians);
+          sm::eigen::assertNear(expectedJacobians.asDenseMatrix(), actualJacobians.asDenseMatrix(), 1e-9, SM_SOURCE_FILE_POS);
+        }
+      }
+      scene.update();
+    }
+    // Renumbers the block indices of the design variables of the error term
+    SCOPED_TRACE("");
+    testErrorTerm(scene.batched.front());
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(PointTransformationErrorTermBatchTestSuite, testLinearSystemSolvers)
+{
+  try {
+    for (int nThreads : { 1, 4 }) {
+      Scene scene;
+      {
+        SCOPED_TRACE("BlockCholeskyLinearSystemSolver");
+        compareWithTree<BlockCholeskyLinearSystemSolver>(scene, nThreads, false);
+      }
+      {
+        SCOPED_TRACE("SparseCholeskyLinearSystemSolver");
+        compareWithTree<SparseCholeskyLinearSystemSolver>(scene, nThreads, false);
+      }
+      scene.setMEstimator();
+      {
+        SCOPED_TRACE("BlockCholeskyLinearSystemSolver with MEstimator");
+        compareWithTree<BlockCholeskyLinearSystemSolver>(scene, nThreads, true);
+      }
+      {
+        SCOPED_TRACE("SparseCholeskyLinearSystemSolver with MEstimator");
+        compareWithTree<SparseCholeskyLinearSystemSolver>(scene, nThreads, true);
+      }
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
+
+TEST(PointTransformationErrorTermBatchTestSuite, testBatchJacobians)
+{
+  try {
+    Scene scene;
+    scene.setMEstimator();
+    for (bool useMEstimator : { false, true }) {
+      for (int i = 0; i < Scene::numErrorTerms; ++i)
+        scene.batched[i]->evaluateError();
+      // Starting at an offset to cover a full and a partial block
+      const std::size_t begin = 1;
+      CollectingSink sink;
+      scene.batch.evaluateJacobians(begin, scene.batch.numErrorTerms(), useMEstimator, sink);
+      ASSERT_EQ(scene.batch.numErrorTerms() - begin, sink.members.size());
+      for (std::size_t k = 0; k < sink.members.size(); ++k) {
+        const std::size_t i = begin + k;
+        ASSERT_EQ(i, sink.members[k]);
+        PointTransformationErrorTermBatch::Member& member = *scene.batched[i];
+        JacobianContainerSparse<> expectedJacobians(3);
+        member.getWeightedJacobians(expectedJacobians, useMEstimator);
+        int col = 0;
+        for (DesignVariable* dv : member.designVariables()) {
+          sm::eigen::assertNear(expectedJacobians.Jacobian(dv), sink.jacobians[k].middleCols(col, dv->minimalDimensions()), 1e-9, SM_SOURCE_FILE_POS);
+          col += dv->minimalDimensions();
+        }
+        EXPECT_EQ(col, sink.jacobians[k].cols());
+        Eigen::VectorXd expectedError;
+        member.getWeightedError(expectedError, useMEstimator);
+        sm::eigen::assertNear(expectedError, sink.weightedErrors[k], 1e-9, SM_SOURCE_FILE_POS);
+      }
+    }
+  } catch (const std::exception& e) {
+    FAIL() << e.what();
+  }
+}
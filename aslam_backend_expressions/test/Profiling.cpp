@@ -6,11 +6,16 @@
  */
 
 // standard includes
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <new>
 #include <vector>
 #include <string>
 
 // boost includes
 #include <boost/program_options.hpp>
+#include <boost/thread.hpp>
 
 // Schweizer Messer includes
 #include <sm/logging.hpp>
@@ -26,11 +31,26 @@
 #include <aslam/backend/DesignVariableVector.hpp>
 #include <aslam/backend/VectorExpressionToGenericMatrixTraits.hpp>
 #include <aslam/backend/CacheExpression.hpp>
+#include <aslam/backend/RotationQuaternion.hpp>
+#include <aslam/backend/EuclideanPoint.hpp>
+#include <aslam/backend/TransformationExpression.hpp>
+#include <aslam/backend/EuclideanExpression.hpp>
+#include <aslam/backend/ExpressionTape.hpp>
+#include <aslam/backend/ExpressionNodeProfiler.hpp>
 
 
 using namespace std;
 using namespace aslam::backend;
 
+// Count the allocations of the expression nodes for the ExpressionNodeProfiler
+void* operator new(std::size_t size) {
+  ExpressionNodeProfiler::countAllocation();
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+
 template <typename Expression>
 void evaluateJacobian(const Expression& expr, JacobianContainer& jc) {
   expr.evaluateJacobians(jc);
@@ -45,11 +65,14 @@ int main(int argc, char** argv)
     bool disableDefaultStream = false;
     size_t nIterations = 100000;
     size_t updateDvEach = 1;
+    size_t nThreads = 16;
     bool useSparseJacobianContainer = false;
     bool useCaching = false, noUpdateDv = false;
     bool noDense = false, noSparse = false, noScalar = false,
          noMatrix = false, noError = false, noJacobian = false,
-         noCached = false, noNonCached = false;
+         noCached = false, noNonCached = false, noTape = false,
+         noContention = false;
+    string profileNodes;
 
     namespace po = boost::program_options;
     po::options_description desc("local_planner options");
@@ -71,6 +94,10 @@ int main(int argc, char** argv)
       ("no-cached", po::bool_switch(&noCached), "Don't profile cached expressions")
       ("no-noncached", po::bool_switch(&noNonCached), "Don't profile non-cached expressions")
       ("no-update-dv", po::bool_switch(&noUpdateDv), "Don't update the design variables after each call")
+      ("no-tape", po::bool_switch(&noTape), "Don't profile compiled expression tapes against the tree interpreter")
+      ("num-threads", po::value(&nThreads)->default_value(nThreads), "Number of threads sharing a cached expression")
+      ("no-contention", po::bool_switch(&noContention), "Don't profile cached expressions shared by several threads")
+      ("profile-nodes", po::value(&profileNodes), "Profile the expression node types and write <arg>.folded (flamegraph.pl input) and <arg>.dot")
     ;
     po::variables_map vm;
     po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
@@ -84,6 +111,8 @@ int main(int argc, char** argv)
       sm::logging::enableNamedStream(stream);
     if (disableDefaultStream)
       sm::logging::disableNamedStream("sm");
+    if (!profileNodes.empty())
+      ExpressionNodeProfiler::enable();
 
     // ********************** //
     //    ScalarExpression    //
@@ -236,8 +265,154 @@ int main(int argc, char** argv)
       }
     } // GenericMatrixExpression
 
+    // ************************************* //
+    //    Expression tape vs. tree interpreter //
+    // ************************************* //
+    {
+      // A kinematic chain of three frames mapping a point
+      RotationQuaternion q0(Eigen::Vector4d(0.0, 0.0, 0.0, 1.0)), q1(Eigen::Vector4d(0.0, 0.0, 0.0, 1.0)), q2(Eigen::Vector4d(0.0, 0.0, 0.0, 1.0));
+      EuclideanPoint t0(Eigen::Vector3d::Random()), t1(Eigen::Vector3d::Random()), t2(Eigen::Vector3d::Random()), p(Eigen::Vector3d::Random());
+      std::vector<DesignVariable*> dvs = { &q0, &t0, &q1, &t1, &q2, &t2, &p };
+      int columnBase = 0;
+      for (size_t i = 0; i < dvs.size(); ++i) {
+        dvs[i]->setActive(true);
+        dvs[i]->setBlockIndex(i);
+        dvs[i]->setColumnBase(columnBase);
+        columnBase += dvs[i]->minimalDimensions();
+      }
+      TransformationExpression T0(q0.toExpression(), t0.toExpression());
+      TransformationExpression T1(q1.toExpression(), t1.toExpression());
+      TransformationExpression T2(q2.toExpression(), t2.toExpression());
+      EuclideanExpression expr = (T0 * T1 * T2.inverse()) * p.toExpression() - t0.toExpression();
+      ExpressionTape::Ptr tape = ExpressionTape::compile(expr);
+
+      Eigen::MatrixXd J = Eigen::MatrixXd::Zero(3, columnBase);
+      JacobianContainerDense<Eigen::MatrixXd&, 3> jcDense(J);
+      JacobianContainerSparse<3> jcSparse(3);
+      const Eigen::VectorXd dx = 1e-3*Eigen::VectorXd::Ones(6);
+      auto updateDvs = [&]() {
+        for (DesignVariable* dv : dvs)
+          dv->update(dx.data(), dv->minimalDimensions());
+      };
+
+      // Test error evaluation, tree interpreter
+      if (!noError && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tree: Error", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          expr.evaluate();
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+
+      // Test error evaluation, expression tape
+      if (!noError && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tape: Error", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          tape->evaluate();
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+
+      // Test error and Jacobian evaluation, tree interpreter, sparse container
+      if (!noJacobian && !noSparse && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tree/Sparse: Error+Jacobian", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          expr.evaluate();
+          jcSparse.clear();
+          evaluateJacobian(expr, jcSparse);
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+
+      // Test error and Jacobian evaluation, expression tape, sparse container
+      if (!noJacobian && !noSparse && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tape/Sparse: Error+Jacobian", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          tape->evaluate();
+          jcSparse.clear();
+          tape->evaluateJacobians(jcSparse);
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+
+      // Test error and Jacobian evaluation, tree interpreter, dense container
+      if (!noJacobian && !noDense && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tree/Dense: Error+Jacobian", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          expr.evaluate();
+          J.setZero();
+          evaluateJacobian(expr, jcDense);
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+
+      // Test error and Jacobian evaluation, expression tape, dense container
+      if (!noJacobian && !noDense && !noTape) {
+        sm::timing::Timer timer("KinematicChain -- Tape/Dense: Error+Jacobian", false);
+        for (size_t i=0; i<nIterations; ++i) {
+          tape->evaluate();
+          J.setZero();
+          tape->evaluateJacobians(jcDense);
+          if (!noUpdateDv && i % updateDvEach == 0) updateDvs();
+        }
+      }
+    } // Expression tape
+
+    // ****************************************** //
+    //    Cached expression shared by many threads //
+    // ****************************************** //
+    if (!noCached && !noContention && nThreads > 0) {
+      RotationQuaternion q0(Eigen::Vector4d(0.0, 0.0, 0.0, 1.0)), q1(Eigen::Vector4d(0.0, 0.0, 0.0, 1.0));
+      EuclideanPoint t0(Eigen::Vector3d::Random()), t1(Eigen::Vector3d::Random()), p(Eigen::Vector3d::Random());
+      std::vector<DesignVariable*> dvs = { &q0, &t0, &q1, &t1, &p };
+      int columnBase = 0;
+      for (size_t i = 0; i < dvs.size(); ++i) {
+        dvs[i]->setActive(true);
+        dvs[i]->setBlockIndex(i);
+        dvs[i]->setColumnBase(columnBase);
+        columnBase += dvs[i]->minimalDimensions();
+      }
+      TransformationExpression T0(q0.toExpression(), t0.toExpression());
+      TransformationExpression T1(q1.toExpression(), t1.toExpression());
+      EuclideanExpression cexpr = toCacheExpression(EuclideanExpression(T0 * T1.inverse() * p.toExpression()));
+
+      const Eigen::VectorXd dx = 1e-3*Eigen::VectorXd::Ones(6);
+      auto updateDvs = [&]() {
+        for (DesignVariable* dv : dvs)
+          dv->update(dx.data(), dv->minimalDimensions());
+      };
+
+      // The design variables are updated between rounds, all threads evaluate the same cache within a round
+      const size_t nRounds = std::max<size_t>(1, nIterations / 1000);
+      const size_t nPerThread = std::max<size_t>(1, nIterations / (nRounds * nThreads));
+      sm::timing::Timer timer("CacheExpression -- " + std::to_string(nThreads) + " threads: Error+Jacobian", false);
+      for (size_t r = 0; r < nRounds; ++r) {
+        boost::thread_group threads;
+        for (size_t t = 0; t < nThreads; ++t) {
+          threads.create_thread([&]() {
+            JacobianContainerSparse<3> jc(3);
+            for (size_t i = 0; i < nPerThread; ++i) {
+              cexpr.evaluate();
+              jc.clear();
+              cexpr.evaluateJacobians(jc);
+            }
+          });
+        }
+        threads.join_all();
+        if (!noUpdateDv) updateDvs();
+      }
+    } // Cached expression shared by many threads
+
     sm::timing::Timing::print(cout, sm::timing::SortType::SORT_BY_TOTAL);
 
+    if (!profileNodes.empty()) {
+      ExpressionNodeProfiler::disable();
+      ExpressionNodeProfiler::print(cout);
+      ofstream folded(profileNodes + ".folded"), dot(profileNodes + ".dot");
+      ExpressionNodeProfiler::writeFoldedStacks(folded);
+      ExpressionNodeProfiler::writeGraphviz(dot);
+    }
+
   }
   catch (exception& e)
   {
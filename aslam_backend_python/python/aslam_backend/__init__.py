@@ -9,6 +9,7 @@ from .libaslam_backend_python import *
 # typedefs
 class OptimizerStatusRprop(OptimizerStatus): pass
 class OptimizerStatusBFGS(OptimizerStatus): pass
+class OptimizerStatusLBFGS(OptimizerStatus): pass
 
 class TransformationDv(object):
     def __init__(self, transformation, rotationActive=True, translationActive=True ):
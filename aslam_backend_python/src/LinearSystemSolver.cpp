@@ -5,6 +5,7 @@
 #include <aslam/backend/SparseCholeskyLinearSystemSolver.hpp>
 #include <aslam/backend/SparseQrLinearSystemSolver.hpp>
 #include <aslam/backend/DenseQrLinearSystemSolver.hpp>
+#include <aslam/backend/MixedPrecisionCholeskyLinearSystemSolver.hpp>
 #include <aslam/backend/OptimizerCallbackManager.hpp>
 
 
@@ -68,6 +69,7 @@ void exportLinearSystemSolver()
         ;
 
     SparseQRLinearSolverOptions& (SparseQrLinearSystemSolver::*getOptions)() = &SparseQrLinearSystemSolver::getOptions;
+    MixedPrecisionCholeskyLinearSolverOptions& (MixedPrecisionCholeskyLinearSystemSolver::*getMixedPrecisionOptions)() = &MixedPrecisionCholeskyLinearSystemSolver::getOptions;
       /// Sets the options
 
 
@@ -80,6 +82,18 @@ void exportLinearSystemSolver()
     class_<DenseQrLinearSystemSolver, boost::shared_ptr<DenseQrLinearSystemSolver>, bases<LinearSystemSolver> >("DenseQrLinearSystemSolver", init<>());
     class_<BlockCholeskyLinearSystemSolver, boost::shared_ptr<BlockCholeskyLinearSystemSolver>, bases<LinearSystemSolver> >("BlockCholeskyLinearSystemSolver", init<>());
     class_<SparseCholeskyLinearSystemSolver, boost::shared_ptr<SparseCholeskyLinearSystemSolver>, bases<LinearSystemSolver> >("SparseCholeskyLinearSystemSolver", init<>());
+    class_<MixedPrecisionCholeskyLinearSolverOptions>("MixedPrecisionCholeskyLinearSolverOptions", init<>())
+        .def_readwrite("maxRefinementSteps", &MixedPrecisionCholeskyLinearSolverOptions::maxRefinementSteps)
+        .def_readwrite("refinementTolerance", &MixedPrecisionCholeskyLinearSolverOptions::refinementTolerance)
+        .def_readwrite("verbose", &MixedPrecisionCholeskyLinearSolverOptions::verbose)
+        ;
+    class_<MixedPrecisionCholeskyLinearSystemSolver, boost::shared_ptr<MixedPrecisionCholeskyLinearSystemSolver>, bases<LinearSystemSolver> >("MixedPrecisionCholeskyLinearSystemSolver", init<>())
+        .def(init<const MixedPrecisionCholeskyLinearSolverOptions&>())
+        .def("getNumRefinementSteps", &MixedPrecisionCholeskyLinearSystemSolver::getNumRefinementSteps)
+        .def("getRelativeResidual", &MixedPrecisionCholeskyLinearSystemSolver::getRelativeResidual)
+        .def("getOptions", getMixedPrecisionOptions, return_internal_reference<>())
+        .def("setOptions", &MixedPrecisionCholeskyLinearSystemSolver::setOptions)
+        ;
     class_<SparseQrLinearSystemSolver, boost::shared_ptr<SparseQrLinearSystemSolver>, bases<LinearSystemSolver> >("SparseQrLinearSystemSolver", init<>())
         .def("getJacobianTranspose", &SparseQrLinearSystemSolver::getJacobianTranspose, return_internal_reference<>())
         .def("getRank", &SparseQrLinearSystemSolver::getRank)
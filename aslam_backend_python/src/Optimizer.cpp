@@ -6,6 +6,10 @@
 #include <aslam/backend/Optimizer2.hpp>
 #include <aslam/backend/OptimizerRprop.hpp>
 #include <aslam/backend/OptimizerBFGS.hpp>
+#include <aslam/backend/OptimizerLBFGS.hpp>
+#include <aslam/backend/OptimizerOWLQN.hpp>
+#include <aslam/backend/OptimizerNCG.hpp>
+#include <aslam/backend/OptimizerStochastic.hpp>
 #include <aslam/backend/ScalarNonSquaredErrorTerm.hpp>
 #include <aslam/python/ExportOptimizerCallbackEvent.hpp>
 #include <boost/shared_ptr.hpp>
@@ -207,6 +211,9 @@ void exportOptimizer()
         .def_readwrite("numIterations",&OptimizerStatus::numIterations)
         .def_readwrite("numJacobianEvaluations",&OptimizerStatus::numJacobianEvaluations)
         .def_readwrite("numErrorEvaluations",&OptimizerStatus::numErrorEvaluations)
+        .def_readwrite("numLineSearches",&OptimizerStatus::numLineSearches)
+        .def_readwrite("numLineSearchErrorEvaluations",&OptimizerStatus::numLineSearchErrorEvaluations)
+        .def_readwrite("numLineSearchGradientEvaluations",&OptimizerStatus::numLineSearchGradientEvaluations)
         .def_readwrite("gradientNorm",&OptimizerStatus::gradientNorm)
         .def_readwrite("maxDeltaX",&OptimizerStatus::maxDeltaX)
         .def_readwrite("error",&OptimizerStatus::error)
@@ -297,6 +304,7 @@ void exportOptimizer()
         .def_readwrite("nMaxIterWolfe1", &LineSearchOptions::nMaxIterWolfe1)
         .def_readwrite("nMaxIterWolfe2", &LineSearchOptions::nMaxIterWolfe2)
         .def_readwrite("nMaxIterZoom", &LineSearchOptions::nMaxIterZoom)
+        .def_readwrite("lazyGradientEvaluation", &LineSearchOptions::lazyGradientEvaluation)
         .def("__str__", &toString<LineSearchOptions>)
         ;
 
@@ -313,5 +321,106 @@ void exportOptimizer()
         ;
     implicitly_convertible< boost::shared_ptr<OptimizerBFGS>, boost::shared_ptr<const OptimizerBFGS> >();
 
+    class_<OptimizerOptionsLBFGS, boost::shared_ptr<OptimizerOptionsLBFGS>, bases<OptimizerOptionsBase> >("OptimizerOptionsLBFGS", init<>())
+        .def_readwrite("linesearch", &OptimizerOptionsLBFGS::linesearch)
+        .def_readwrite("useDenseJacobianContainer", &OptimizerOptionsLBFGS::useDenseJacobianContainer)
+        .def_readwrite("historySize", &OptimizerOptionsLBFGS::historySize)
+        .def("__str__", &toString<OptimizerOptionsLBFGS>)
+        ;
+
+    class_<OptimizerLBFGS, boost::shared_ptr<OptimizerLBFGS>, bases<OptimizerProblemManagerBase> >("OptimizerLBFGS", init<>("OptimizerLBFGS(): Constructor with default options"))
+        .def(init<const OptimizerOptionsLBFGS&>("OptimizerLBFGS(OptimizerOptionsLBFGS options): Constructor with custom options"))
+        .def(init<const sm::PropertyTree&>("OptimizerLBFGS(PropertyTree propertyTree): Constructor from sm::PropertyTree"))
+        .def("getHistorySize", &OptimizerLBFGS::getHistorySize)
+        ;
+    implicitly_convertible< boost::shared_ptr<OptimizerLBFGS>, boost::shared_ptr<const OptimizerLBFGS> >();
+
+    class_<OptimizerOptionsOWLQN, boost::shared_ptr<OptimizerOptionsOWLQN>, bases<OptimizerOptionsBase> >("OptimizerOptionsOWLQN", init<>())
+        .def_readwrite("useDenseJacobianContainer", &OptimizerOptionsOWLQN::useDenseJacobianContainer)
+        .def_readwrite("historySize", &OptimizerOptionsOWLQN::historySize)
+        .def_readwrite("armijoFactor", &OptimizerOptionsOWLQN::armijoFactor)
+        .def_readwrite("backtrackingFactor", &OptimizerOptionsOWLQN::backtrackingFactor)
+        .def_readwrite("maxBacktrackingSteps", &OptimizerOptionsOWLQN::maxBacktrackingSteps)
+        .def_readwrite("regularizer", &OptimizerOptionsOWLQN::regularizer)
+        .def("__str__", &toString<OptimizerOptionsOWLQN>)
+        ;
+
+    class_<OptimizerStatusOWLQN, boost::shared_ptr<OptimizerStatusOWLQN>, bases<OptimizerStatus> >("OptimizerStatusOWLQN", init<>())
+        .def_readonly("numL1Parameters", &OptimizerStatusOWLQN::numL1Parameters)
+        .def_readonly("numZeroParameters", &OptimizerStatusOWLQN::numZeroParameters)
+        .def_readonly("numBacktrackingSteps", &OptimizerStatusOWLQN::numBacktrackingSteps)
+        .def("__str__", &toString<OptimizerStatusOWLQN>)
+        ;
+
+    class_<OptimizerOWLQN, boost::shared_ptr<OptimizerOWLQN>, bases<OptimizerProblemManagerBase> >("OptimizerOWLQN", init<>("OptimizerOWLQN(): Constructor with default options"))
+        .def(init<const OptimizerOptionsOWLQN&>("OptimizerOWLQN(OptimizerOptionsOWLQN options): Constructor with custom options"))
+        .def(init<const sm::PropertyTree&>("OptimizerOWLQN(PropertyTree propertyTree): Constructor from sm::PropertyTree"))
+        .def("getHistorySize", &OptimizerOWLQN::getHistorySize)
+        .add_property("statusOWLQN", make_function(&OptimizerOWLQN::getStatus, return_internal_reference<>()))
+        ;
+    implicitly_convertible< boost::shared_ptr<OptimizerOWLQN>, boost::shared_ptr<const OptimizerOWLQN> >();
+
+    enum_<OptimizerOptionsNCG::Method>("NCGMethod")
+        .value("POLAK_RIBIERE_PLUS", OptimizerOptionsNCG::Method::POLAK_RIBIERE_PLUS)
+        .value("HAGER_ZHANG", OptimizerOptionsNCG::Method::HAGER_ZHANG)
+        ;
+
+    class_<OptimizerOptionsNCG, boost::shared_ptr<OptimizerOptionsNCG>, bases<OptimizerOptionsBase> >("OptimizerOptionsNCG", init<>())
+        .def_readwrite("linesearch", &OptimizerOptionsNCG::linesearch)
+        .def_readwrite("useDenseJacobianContainer", &OptimizerOptionsNCG::useDenseJacobianContainer)
+        .def_readwrite("method", &OptimizerOptionsNCG::method)
+        .def_readwrite("restartInterval", &OptimizerOptionsNCG::restartInterval)
+        .def_readwrite("restartOrthogonalityThreshold", &OptimizerOptionsNCG::restartOrthogonalityThreshold)
+        .def_readwrite("hagerZhangEta", &OptimizerOptionsNCG::hagerZhangEta)
+        .def("__str__", &toString<OptimizerOptionsNCG>)
+        ;
+
+    class_<OptimizerStatusNCG, boost::shared_ptr<OptimizerStatusNCG>, bases<OptimizerStatus> >("OptimizerStatusNCG", init<>())
+        .def_readonly("numRestarts", &OptimizerStatusNCG::numRestarts)
+        ;
+
+    class_<OptimizerNCG, boost::shared_ptr<OptimizerNCG>, bases<OptimizerProblemManagerBase> >("OptimizerNCG", init<>("OptimizerNCG(): Constructor with default options"))
+        .def(init<const OptimizerOptionsNCG&>("OptimizerNCG(OptimizerOptionsNCG options): Constructor with custom options"))
+        .def(init<const sm::PropertyTree&>("OptimizerNCG(PropertyTree propertyTree): Constructor from sm::PropertyTree"))
+        .add_property("statusNCG", make_function(&OptimizerNCG::getStatus, return_internal_reference<>()))
+        ;
+    implicitly_convertible< boost::shared_ptr<OptimizerNCG>, boost::shared_ptr<const OptimizerNCG> >();
+
+    enum_<OptimizerOptionsStochastic::Method>("StochasticMethod")
+        .value("SGD_MOMENTUM", OptimizerOptionsStochastic::Method::SGD_MOMENTUM)
+        .value("ADAM", OptimizerOptionsStochastic::Method::ADAM)
+        .value("SVRG", OptimizerOptionsStochastic::Method::SVRG)
+        ;
+
+    class_<OptimizerOptionsStochastic, boost::shared_ptr<OptimizerOptionsStochastic>, bases<OptimizerOptionsBase> >("OptimizerOptionsStochastic", init<>())
+        .def_readwrite("method", &OptimizerOptionsStochastic::method)
+        .def_readwrite("batchSize", &OptimizerOptionsStochastic::batchSize)
+        .def_readwrite("learningRate", &OptimizerOptionsStochastic::learningRate)
+        .def_readwrite("learningRateDecay", &OptimizerOptionsStochastic::learningRateDecay)
+        .def_readwrite("momentum", &OptimizerOptionsStochastic::momentum)
+        .def_readwrite("beta1", &OptimizerOptionsStochastic::beta1)
+        .def_readwrite("beta2", &OptimizerOptionsStochastic::beta2)
+        .def_readwrite("epsilon", &OptimizerOptionsStochastic::epsilon)
+        .def_readwrite("seed", &OptimizerOptionsStochastic::seed)
+        .def_readwrite("useDenseJacobianContainer", &OptimizerOptionsStochastic::useDenseJacobianContainer)
+        .def_readwrite("polishingOptimizer", &OptimizerOptionsStochastic::polishingOptimizer)
+        .def("__str__", &toString<OptimizerOptionsStochastic>)
+        ;
+
+    class_<OptimizerStatusStochastic, boost::shared_ptr<OptimizerStatusStochastic>, bases<OptimizerStatus> >("OptimizerStatusStochastic", init<>())
+        .def_readonly("numBatches", &OptimizerStatusStochastic::numBatches)
+        .def_readonly("numErrorTermGradients", &OptimizerStatusStochastic::numErrorTermGradients)
+        .def_readonly("termsPerSecond", &OptimizerStatusStochastic::termsPerSecond)
+        .def_readonly("numPolishingIterations", &OptimizerStatusStochastic::numPolishingIterations)
+        .def("__str__", &toString<OptimizerStatusStochastic>)
+        ;
+
+    class_<OptimizerStochastic, boost::shared_ptr<OptimizerStochastic>, bases<OptimizerProblemManagerBase> >("OptimizerStochastic", init<>("OptimizerStochastic(): Constructor with default options"))
+        .def(init<const OptimizerOptionsStochastic&>("OptimizerStochastic(OptimizerOptionsStochastic options): Constructor with custom options"))
+        .def(init<const sm::PropertyTree&>("OptimizerStochastic(PropertyTree propertyTree): Constructor from sm::PropertyTree"))
+        .add_property("statusStochastic", make_function(&OptimizerStochastic::getStatus, return_internal_reference<>()))
+        ;
+    implicitly_convertible< boost::shared_ptr<OptimizerStochastic>, boost::shared_ptr<const OptimizerStochastic> >();
+
 }
 
@@ -26,6 +26,12 @@ void exportOptimizerOptions()
 
   using namespace boost::python;
   using namespace aslam::backend;
+  enum_<LinearSystemSolver::JacobianUpdate>("JacobianUpdate")
+    .value("FULL", LinearSystemSolver::JACOBIAN_FULL)
+    .value("BROYDEN", LinearSystemSolver::JACOBIAN_BROYDEN)
+    .value("PARTIAL", LinearSystemSolver::JACOBIAN_PARTIAL)
+    ;
+
   class_<Optimizer2Options>("Optimizer2Options", init<>())
     .def_readwrite("convergenceDeltaError",&Optimizer2Options::convergenceDeltaError)
     .def_readwrite("convergenceDeltaX",&Optimizer2Options::convergenceDeltaX)
@@ -36,6 +42,17 @@ void exportOptimizerOptions()
     .def_readwrite("numThreadsJacobian", &Optimizer2Options::numThreadsJacobian)
     .def_readwrite("linearSolver",&Optimizer2Options::linearSystemSolver)
     .def_readwrite("trustRegionPolicy", &Optimizer2Options::trustRegionPolicy)
+    .def_readwrite("jacobianUpdate", &Optimizer2Options::jacobianUpdate)
+    .def_readwrite("maxJacobianAge", &Optimizer2Options::maxJacobianAge)
+    .def_readwrite("jacobianStallRatio", &Optimizer2Options::jacobianStallRatio)
+    .def_readwrite("jacobianRefreshTolerance", &Optimizer2Options::jacobianRefreshTolerance)
+    .def_readwrite("useActiveSet", &Optimizer2Options::useActiveSet)
+    .def_readwrite("activeSetFreezeThreshold", &Optimizer2Options::activeSetFreezeThreshold)
+    .def_readwrite("activeSetFreezeIterations", &Optimizer2Options::activeSetFreezeIterations)
+    .def_readwrite("activeSetReactivationThreshold", &Optimizer2Options::activeSetReactivationThreshold)
+    .def_readwrite("activeSetUpdateInterval", &Optimizer2Options::activeSetUpdateInterval)
+    .def_readwrite("activeSetMinFreezeFraction", &Optimizer2Options::activeSetMinFreezeFraction)
+    .def_readwrite("mEstimatorWeightThreshold", &Optimizer2Options::mEstimatorWeightThreshold)
     ;
 
 }
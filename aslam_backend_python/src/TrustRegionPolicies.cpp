@@ -3,6 +3,7 @@
 #include <aslam/backend/TrustRegionPolicy.hpp>
 #include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
 #include <aslam/backend/LevenbergMarquardtTrustRegionPolicy.hpp>
+#include <aslam/backend/GeodesicAccelerationTrustRegionPolicy.hpp>
 #include <aslam/backend/DogLegTrustRegionPolicy.hpp>
 #include <aslam/backend/LineSearchTrustRegionPolicy.hpp>
 
@@ -24,6 +25,16 @@ void exportTrustRegionPolicies() {
   // LM
   class_<LevenbergMarquardtTrustRegionPolicy, boost::shared_ptr<LevenbergMarquardtTrustRegionPolicy>, bases< TrustRegionPolicy >, boost::noncopyable >("LevenbergMarquardtTrustRegionPolicy", init<>() )
       .def(init<double>("LevenbergMarquardtTrustRegionPolicy( double initalLambda )"))
+      .add_property("numLambdaCandidates", &LevenbergMarquardtTrustRegionPolicy::getNumLambdaCandidates, &LevenbergMarquardtTrustRegionPolicy::setNumLambdaCandidates)
+      ;
+
+  // LM with geodesic acceleration
+  class_<GeodesicAccelerationTrustRegionPolicy, boost::shared_ptr<GeodesicAccelerationTrustRegionPolicy>, bases< LevenbergMarquardtTrustRegionPolicy >, boost::noncopyable >("GeodesicAccelerationTrustRegionPolicy", init<>() )
+      .def(init<double, optional<double, double> >("GeodesicAccelerationTrustRegionPolicy( double initalLambda, double finiteDifferenceStep, double maxAccelerationRatio )"))
+      .add_property("finiteDifferenceStep", &GeodesicAccelerationTrustRegionPolicy::getFiniteDifferenceStep, &GeodesicAccelerationTrustRegionPolicy::setFiniteDifferenceStep)
+      .add_property("maxAccelerationRatio", &GeodesicAccelerationTrustRegionPolicy::getMaxAccelerationRatio, &GeodesicAccelerationTrustRegionPolicy::setMaxAccelerationRatio)
+      .add_property("numAcceleratedSteps", &GeodesicAccelerationTrustRegionPolicy::getNumAcceleratedSteps)
+      .add_property("numRejectedAccelerations", &GeodesicAccelerationTrustRegionPolicy::getNumRejectedAccelerations)
       ;
 
   // DL